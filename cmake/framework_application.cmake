@@ -236,6 +236,40 @@ if(PICO_HTTP_ENABLE_LITTLEFS)
     endif()
 endif()
 
+# ----------------------------------------------------------------------------------
+# KvStore partition (optional): raw flash directly below the LittleFS partition, or at
+# the end of flash without LittleFS. Set KV_PARTITION_SIZE (multiple of 4KB, at least
+# 3 sectors) to enable it.
+# ----------------------------------------------------------------------------------
+
+if(DEFINED KV_PARTITION_SIZE AND NOT ${KV_PARTITION_SIZE} EQUAL 0)
+    if(NOT DEFINED FLASH_TOTAL_SIZE)
+        set(FLASH_TOTAL_SIZE 0x200000)  # 2MB default for pico_w
+        if(${PICO_BOARD} STREQUAL "pico2_w")
+            set(FLASH_TOTAL_SIZE 0x400000)  # 4MB
+        endif()
+    endif()
+
+    math(EXPR KV_CHECK "${KV_PARTITION_SIZE} % 4096")
+    if(NOT KV_CHECK EQUAL 0 OR ${KV_PARTITION_SIZE} LESS 12288)
+        message(FATAL_ERROR "KV_PARTITION_SIZE must be a multiple of 4096 and at least 3 sectors (12288).")
+    endif()
+
+    if(PICO_HTTP_ENABLE_LITTLEFS)
+        math(EXPR KV_FLASH_END "${FLASH_TOTAL_SIZE} - ${LFS_PARTITION_SIZE}")
+    else()
+        set(KV_FLASH_END ${FLASH_TOTAL_SIZE})
+    endif()
+    math(EXPR KV_FLASH_OFFSET "${KV_FLASH_END} - ${KV_PARTITION_SIZE}" OUTPUT_FORMAT HEXADECIMAL)
+    math(EXPR KV_PARTITION_SIZE_HEX "${KV_PARTITION_SIZE}" OUTPUT_FORMAT HEXADECIMAL)
+
+    message(STATUS "Using KvStore partition: offset ${KV_FLASH_OFFSET}, size ${KV_PARTITION_SIZE_HEX}")
+    target_compile_definitions(${APP_NAME} PUBLIC
+        KV_STORE_FLASH_OFFSET=${KV_FLASH_OFFSET}
+        KV_STORE_FLASH_SIZE=${KV_PARTITION_SIZE_HEX}
+    )
+endif()
+
 
 # ----------------------------------------------------------------------------------
 # Includes
@@ -67,23 +67,27 @@ void LogController::onEvent(const Event& event) {
             break;
         }
         case UserNotification::RunZoneCompleted: {
-            const RunZone* rz = static_cast<const RunZone*>(event.data);
-            snprintf(msg, sizeof(msg), "[RunZoneCompleted] Zone \"%s\" completed", rz->zone.c_str());
+            const char* name = event.payloadAs<char>(); // owned copy posted by ZoneModel, null if the payload pool was exhausted
+            snprintf(msg, sizeof(msg), "[RunZoneCompleted] Zone \"%s\" completed", name ? name : "?");
             break;
         }
         case UserNotification::ZoneStarted: {
-            const std::string* name = static_cast<const std::string*>(event.data);
-            snprintf(msg, sizeof(msg), "[ZoneStarted] Zone \"%s\" started", name->c_str());
+            const char* name = event.payloadAs<char>();
+            snprintf(msg, sizeof(msg), "[ZoneStarted] Zone \"%s\" started", name ? name : "?");
             break;
         }
         case UserNotification::ZoneStopped: {
-            const std::string* name = static_cast<const std::string*>(event.data);
-            snprintf(msg, sizeof(msg), "[ZoneStopped] Zone \"%s\" stopped", name->c_str());
+            const char* name = event.payloadAs<char>();
+            snprintf(msg, sizeof(msg), "[ZoneStopped] Zone \"%s\" stopped", name ? name : "?");
             break;
         }
         case UserNotification::RunZoneStarted: {
-            const RunZone* zone = static_cast<const RunZone*>(event.data);
-            snprintf(msg, sizeof(msg), "[RunZoneStarted] RunZone \"%s\" started for %d seconds", zone->zone.c_str(), zone->duration);
+            const RunZoneStartedInfo* rz = event.payloadAs<RunZoneStartedInfo>();
+            if (rz) {
+                snprintf(msg, sizeof(msg), "[RunZoneStarted] RunZone \"%s\" started for %u seconds", rz->zone, (unsigned)rz->duration);
+            } else {
+                snprintf(msg, sizeof(msg), "[RunZoneStarted] RunZone started");
+            }
             break;
         }
         case UserNotification::RunProgram: {
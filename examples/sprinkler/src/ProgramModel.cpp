@@ -199,7 +199,7 @@ bool ProgramModel::load() {
             }
 
             programs.push_back(p);
-            collection.push_back(p);
+            collection.push_back(FrameworkJson(nlohmann::json(p)));
         } else {
             printf("Invalid program entry in collection\n");
         }
@@ -213,7 +213,7 @@ bool ProgramModel::load() {
 bool ProgramModel::save() {
     collection.clear();
     for (const auto& program : programs) {
-        collection.push_back(program);  // relies on to_json for SprinklerProgram
+        collection.push_back(FrameworkJson(nlohmann::json(program)));  // relies on to_json for SprinklerProgram
     }
     return FrameworkModel::save();
 }
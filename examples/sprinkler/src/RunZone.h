@@ -9,6 +9,12 @@ struct RunZone {
     uint32_t duration;    ///< Duration in seconds
 };
 
+/// @brief Owned payload of a RunZoneStarted event (trivially copyable, so it is copied into the event).
+struct RunZoneStartedInfo {
+    uint32_t duration;    ///< Duration in seconds
+    char zone[32];        ///< Zone name, truncated if longer
+};
+
 inline void to_json(nlohmann::json &j, const RunZone &z) {
     j = nlohmann::json{{"zone", z.zone}, {"duration", z.duration}};
 }
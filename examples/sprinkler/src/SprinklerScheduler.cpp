@@ -150,7 +150,10 @@ void SprinklerScheduler::initRoutes()
 
 void SprinklerScheduler::rescheduleAll()
 {
-    // No cancel needed — jobId reuse overwrites
+    auto& timerService = *AppContext::get<TimerService>();
+    for (const auto& [name, jobId] : programJobs)
+        timerService.cancel(jobId);
+    programJobs.clear();
     scheduleAllPrograms();
 }
 
@@ -181,7 +184,10 @@ void SprinklerScheduler::scheduleAllPrograms()
             {
                 Event e(static_cast<uint8_t>(UserNotification::RunProgram), &program.name, sizeof(program.name));
                 printf("[Scheduler] Scheduling program: %s at %s\n", program.name.c_str(), PicoTime::formatIso8601(ts).c_str());
-                timerService.scheduleAt(ts, e, program.name);  // use name as job ID
+                auto it = programJobs.find(program.name);
+                if (it != programJobs.end())
+                    timerService.cancel(it->second); // replace any pending start for this program
+                programJobs[program.name] = timerService.scheduleAt(ts, e);
                 break;
             }
         }
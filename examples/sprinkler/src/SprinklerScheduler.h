@@ -11,6 +11,7 @@
 #pragma once
 
 #include "framework/FrameworkController.h"
+#include <map>
 #include <queue>
 #include "ProgramModel.h"
 #include "time/PicoTime.h"
@@ -51,6 +52,7 @@ private:
     std::string runningProgramName;
     std::string lastProgramRunName;
     std::queue<const RunZone*> zoneQueue;
+    std::map<std::string, TimerJobId> programJobs; ///< Pending start job per program name
 
     /**
      * @brief Check all programs and schedule their start times.
@@ -26,14 +26,16 @@ bool ZoneModel::startZone(const std::string& name) {
     gpio_put(z->gpioPin, 1);
     z->active = true;
 
-    AppContext::get<EventManager>()->postEvent(userEvent(UserNotification::ZoneStarted, name));
+    AppContext::get<EventManager>()->postEvent(ownedUserEvent(UserNotification::ZoneStarted, name));
     return true;
 }
 
 
 bool ZoneModel::startZone(const std::string& name, uint32_t durationSeconds) {
     if (!startZone(name)) return false;
-    AppContext::get<EventManager>()->postEvent(userEvent(UserNotification::RunZoneStarted, name));
+    RunZoneStartedInfo started{durationSeconds, {}};
+    snprintf(started.zone, sizeof(started.zone), "%s", name.c_str());
+    AppContext::get<EventManager>()->postEvent(ownedUserEvent(UserNotification::RunZoneStarted, started));
     time_t when = PicoTime::now() + durationSeconds;
     time_t now = PicoTime::now();
 
@@ -42,7 +44,7 @@ bool ZoneModel::startZone(const std::string& name, uint32_t durationSeconds) {
 
     std::function<void()> stopCallback = [this, name]() {
         this->stopZone(name);
-        AppContext::get<EventManager>()->postEvent(userEvent(UserNotification::RunZoneCompleted, name));
+        AppContext::get<EventManager>()->postEvent(ownedUserEvent(UserNotification::RunZoneCompleted, name));
     };
     AppContext::get<TimerService>()->scheduleCallbackAt(when, stopCallback);
     return true;
@@ -59,7 +61,7 @@ bool ZoneModel::stopZone(const std::string& name) {
     gpio_put(z->gpioPin, 0);
     z->active = false;
 
-    AppContext::get<EventManager>()->postEvent(userEvent(UserNotification::ZoneStopped, name));
+    AppContext::get<EventManager>()->postEvent(ownedUserEvent(UserNotification::ZoneStopped, name).withPriority(EventPriority::High));
     return true;
 }
 
@@ -138,7 +140,7 @@ bool ZoneModel::load() {
 
         printf("ZoneModel: Loaded zone id: %s, %s (GPIO %d), image: %s\n", z.id.c_str(), z.name.c_str(), z.gpioPin, z.image.c_str());
         zones.push_back(z);
-        collection.push_back(z);  // keep collection in sync
+        collection.push_back(FrameworkJson(nlohmann::json(z)));  // keep collection in sync; to_json targets nlohmann::json
     }
 
     rebuildNameIndex();
@@ -149,7 +151,7 @@ bool ZoneModel::load() {
 bool ZoneModel::save() {
     collection.clear();
     for (const auto& zone : zones) {
-        collection.push_back(zone);  // uses to_json from NLOHMANN_DEFINE_TYPE_INTRUSIVE
+        collection.push_back(FrameworkJson(nlohmann::json(zone)));  // uses to_json from NLOHMANN_DEFINE_TYPE_INTRUSIVE
     }
     return FrameworkModel::save();
 }
@@ -9,12 +9,13 @@
  * - Per-module control (`TRACE_<MODULE>` in framework_config.h)
  * - Level filtering (`TRACE_LEVEL_MIN`)
  * - Optional timestamp
- * - Optional SD file redirection via FatFsStorageManager
+ * - Optional file redirection, buffered and written in the background by a LogSink
+ * - Optional deferred binary mode (`TRACE_DEFERRED`), decoded on the host
  *
  * Controlled via `framework_config.h`. SD output is enabled if `TRACE_USE_SD` is set to 1.
  *
- * @version 0.3
- * @date 2025-03-31
+ * @version 0.4
+ * @date 2025-04-22
  * @license MIT License
  * @copyright Copyright (c) 2025, Ian Archbell
  */
@@ -30,6 +31,8 @@
 #include "storage/StorageManager.h"
 #include "framework/AppContext.h"
 #include "time/TimeManager.h"
+#include "utility/LogSink.h"
+#include "DeferredTrace.h"
 
 #define TRACE_LVL_INFO 0
 #define TRACE_LVL_WARN 1
@@ -39,19 +42,28 @@
 #define TRACE_INCLUDE_TIMESTAMP 1
 #endif
 
-// File trace output (set by framework setup)
-static inline std::string tracePath;
-static inline bool traceToFile = false;
+// File trace output (set by framework setup), shared by every translation unit
+inline std::string tracePath;
+inline bool traceToFile = false;
 
 /**
- * @brief Set trace output to SD file using FatFsStorageManager.
+ * @brief Buffered writer for the trace file.
+ */
+inline LogSink &traceLogSink()
+{
+    static LogSink sink;
+    return sink;
+}
+
+/**
+ * @brief Set trace output to a file through the storage manager.
  * @param sm Storage manager (or nullptr for console only)
  * @param path File path (e.g. "/log/trace.txt")
  */
 inline void setTraceOutputToFile(StorageManager *sm, const std::string &path)
 {
     tracePath = path;
-    traceToFile = (sm != nullptr && !path.empty());
+    traceToFile = (sm != nullptr && !path.empty()) && traceLogSink().open(path);
 }
 
 /**
@@ -105,7 +117,6 @@ inline std::string getFormattedTimestamp()
 
     if (tm)
     {
-        std::string formatted = tm->currentTimeForTrace();
         return tm->currentTimeForTrace();
     }
     else
@@ -137,30 +148,51 @@ inline void traceLog(const char *module, int level, const char *file, int line,
     va_start(args, format);
     vsnprintf(msgBuf, sizeof(msgBuf), format, args);
     va_end(args);
-    std::string formatted;
-    std::string timestamp = "";
 
 #if TRACE_INCLUDE_TIMESTAMP
-    timestamp = getFormattedTimestamp();
+    std::string timestamp = getFormattedTimestamp();
+#else
+    const std::string timestamp;
+#endif
 
-    formatted = timestamp + "[" + traceLevelToString(level) + "] [" +
-                module + "] " + fileBuf + ":" + std::to_string(line) +
-                " (" + func + "): " + msgBuf + "\n";
+    char formatted[384];
+    int len = snprintf(formatted, sizeof(formatted), "%s[%s] [%s] %s:%d (%s): %s\n", timestamp.c_str(),
+                       traceLevelToString(level), module, fileBuf, line, func, msgBuf);
+    if (len <= 0)
+        return;
+    size_t n = len < (int)sizeof(formatted) ? len : sizeof(formatted) - 1;
 
-#endif
     if (traceToFile)
     {
-        auto *storage = AppContext::getInstance().getService<StorageManager>();
-        if (storage)
-        {
-            storage->appendToFile(tracePath, reinterpret_cast<const uint8_t *>(formatted.c_str()), formatted.length());
-        }
+        traceLogSink().write(formatted, n); // never blocks; dropped if the buffer is full
     }
     else
     {
+        fwrite(formatted, 1, n, stdout);
+    }
+}
+
+/**
+ * @brief Deferred trace: record the call in binary for host-side decoding (see DeferredTrace.h).
+ *
+ * Records go to the trace file's LogSink when file output is enabled, otherwise to a RAM
+ * ring that traceDumpDeferred() prints.
+ */
+template <typename... Args>
+inline void traceDeferred(const char *module, int level, int line, const char *format, Args... args)
+{
+    if (level < TRACE_LEVEL_MIN)
+        return;
 
-        fputs(formatted.c_str(), stdout);
-        fflush(stdout);
+    DeferredTraceRecord rec;
+    deferredTraceEncode(rec, module, level, line, format, args...);
+    if (traceToFile)
+    {
+        traceLogSink().write(reinterpret_cast<const char *>(rec.bytes), rec.len);
+    }
+    else
+    {
+        deferredTraceStore(rec.bytes, rec.len);
     }
 }
 
@@ -174,12 +206,21 @@ inline void traceLog(const char *module, int level, const char *file, int line,
 /**
  * @brief Core trace macro with level support.
  */
+#if TRACE_DEFERRED
+#define TRACEF(level, ...)                                                \
+    do                                                                    \
+    {                                                                     \
+        if (TRACE_ENABLED && (level) >= TRACE_LEVEL_MIN)                  \
+            traceDeferred(TRACE_MODULE, level, __LINE__, __VA_ARGS__);    \
+    } while (0)
+#else
 #define TRACEF(level, ...)                                                            \
     do                                                                                \
     {                                                                                 \
         if (TRACE_ENABLED && (level) >= TRACE_LEVEL_MIN)                              \
             traceLog(TRACE_MODULE, level, __FILE__, __LINE__, __func__, __VA_ARGS__); \
     } while (0)
+#endif
 
 /**
  * @brief Default trace (INFO level).
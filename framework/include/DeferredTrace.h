@@ -0,0 +1,233 @@
+/**
+ * @file DeferredTrace.h
+ * @author Ian Archbell
+ * @brief Binary trace records for DebugTrace's deferred mode (TRACE_DEFERRED).
+ *
+ * Part of the PicoFramework application framework.
+ * Instead of formatting text on the device, a trace call stores the addresses of its
+ * module name and format string, a microsecond timestamp, the source line and the raw
+ * argument values. Formatting happens later on the host with tools/trace_decode.py, which
+ * resolves the addresses from the application's ELF file. A record costs a few stores
+ * and one short copy, so tracing can stay on in timing-sensitive paths such as HTTP.
+ *
+ * Record layout (little-endian):
+ * | bytes | field                                                    |
+ * |-------|----------------------------------------------------------|
+ * | 1     | 0xA5 sync byte                                           |
+ * | 1     | total record length                                      |
+ * | 1     | trace level                                              |
+ * | 1     | flags: bit 0 set if trailing arguments were cut off      |
+ * | 4     | module name address                                      |
+ * | 4     | format string address                                    |
+ * | 4     | time_us_32() timestamp                                   |
+ * | 2     | source line                                              |
+ * | ...   | arguments in order: 32-bit integers and pointers as 4    |
+ * |       | bytes, 64-bit integers and floating point (as double) as |
+ * |       | 8, strings as a length byte plus up to                   |
+ * |       | TRACE_DEFERRED_MAX_STRING bytes                          |
+ *
+ * Format strings must be literals so that their address is in the ELF file.
+ *
+ * @version 0.1
+ * @date 2025-04-22
+ * @license MIT License
+ * @copyright Copyright (c) 2025, Ian Archbell
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+#include <FreeRTOS.h>
+#include <task.h>
+#include "pico/stdlib.h"
+#include "framework_config.h"
+
+#define TRACE_DEFERRED_SYNC 0xA5
+
+/**
+ * @brief Builds one record in a stack buffer.
+ */
+struct DeferredTraceRecord
+{
+    static constexpr size_t MaxSize = 128;
+
+    uint8_t bytes[MaxSize];
+    size_t len = 0;
+    bool truncated = false;
+
+    // Once an argument doesn't fit, later ones are dropped too, so the record always holds a
+    // prefix of the arguments that the decoder can walk
+    void put(const void *src, size_t n)
+    {
+        if (truncated || len + n > MaxSize)
+        {
+            truncated = true;
+            return;
+        }
+        memcpy(bytes + len, src, n);
+        len += n;
+    }
+
+    void putString(const char *s)
+    {
+        if (truncated || len == MaxSize)
+        {
+            truncated = true;
+            return;
+        }
+        size_t n = s ? strnlen(s, TRACE_DEFERRED_MAX_STRING) : 0;
+        bool clamped = 1 + n > MaxSize - len;
+        if (clamped)
+        {
+            n = MaxSize - len - 1; // keep what fits; the length byte matches the body
+        }
+        uint8_t n8 = static_cast<uint8_t>(n);
+        put(&n8, 1);
+        if (n)
+        {
+            put(s, n);
+        }
+        truncated = clamped;
+    }
+
+    template <typename T>
+    void putArg(T value)
+    {
+        using U = std::decay_t<T>;
+        if constexpr (std::is_same_v<U, const char *> || std::is_same_v<U, char *>)
+        {
+            putString(value);
+        }
+        else if constexpr (std::is_floating_point_v<U>)
+        {
+            double d = static_cast<double>(value);
+            put(&d, sizeof(d));
+        }
+        else if constexpr (std::is_pointer_v<U>)
+        {
+            uint32_t p = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(value));
+            put(&p, sizeof(p));
+        }
+        else if constexpr (sizeof(U) > 4)
+        {
+            uint64_t v = static_cast<uint64_t>(value);
+            put(&v, sizeof(v));
+        }
+        else
+        {
+            uint32_t v = static_cast<uint32_t>(value); // sign-extended for %d by the decoder
+            put(&v, sizeof(v));
+        }
+    }
+};
+
+/**
+ * @brief RAM ring of records kept when tracing to the console.
+ *
+ * Records are dropped whole when the ring is full; traceDumpDeferred() prints and empties it.
+ */
+struct DeferredTraceRing
+{
+    uint8_t buffer[TRACE_DEFERRED_BUFFER_SIZE];
+    size_t head = 0;
+    size_t tail = 0;
+    uint32_t dropped = 0;
+};
+
+inline DeferredTraceRing &deferredTraceRing()
+{
+    static DeferredTraceRing ring;
+    return ring;
+}
+
+/**
+ * @brief Store a record in the console ring.
+ */
+inline void deferredTraceStore(const uint8_t *data, size_t len)
+{
+    DeferredTraceRing &ring = deferredTraceRing();
+    taskENTER_CRITICAL();
+    if (len <= sizeof(ring.buffer) - (ring.head - ring.tail))
+    {
+        for (size_t i = 0; i < len; ++i)
+        {
+            ring.buffer[(ring.head + i) % sizeof(ring.buffer)] = data[i];
+        }
+        ring.head += len;
+    }
+    else
+    {
+        ring.dropped++;
+    }
+    taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief Print and empty the console ring as `TRC <hex>` lines, one record per line.
+ *
+ * Capture the console output and pass it to tools/trace_decode.py with the ELF file.
+ * Call from a task (for example a CLI command or a controller's poll()), not from an ISR.
+ */
+inline void traceDumpDeferred()
+{
+    DeferredTraceRing &ring = deferredTraceRing();
+    uint8_t record[DeferredTraceRecord::MaxSize];
+    for (;;)
+    {
+        taskENTER_CRITICAL();
+        size_t available = ring.head - ring.tail;
+        size_t len = available >= 2 ? ring.buffer[(ring.tail + 1) % sizeof(ring.buffer)] : 0;
+        if (len && len <= available)
+        {
+            for (size_t i = 0; i < len; ++i)
+            {
+                record[i] = ring.buffer[(ring.tail + i) % sizeof(ring.buffer)];
+            }
+            ring.tail += len;
+        }
+        else
+        {
+            len = 0;
+        }
+        taskEXIT_CRITICAL();
+
+        if (!len)
+        {
+            break;
+        }
+        fputs("TRC ", stdout);
+        for (size_t i = 0; i < len; ++i)
+        {
+            printf("%02x", record[i]);
+        }
+        fputc('\n', stdout);
+    }
+    if (ring.dropped)
+    {
+        printf("TRC dropped %lu\n", static_cast<unsigned long>(ring.dropped));
+        ring.dropped = 0;
+    }
+}
+
+/**
+ * @brief Encode a trace call into @p rec.
+ */
+template <typename... Args>
+inline void deferredTraceEncode(DeferredTraceRecord &rec, const char *module, int level, int line,
+                                const char *format, Args... args)
+{
+    uint8_t header[4] = {TRACE_DEFERRED_SYNC, 0, static_cast<uint8_t>(level), 0};
+    uint32_t addrs[3] = {static_cast<uint32_t>(reinterpret_cast<uintptr_t>(module)),
+                         static_cast<uint32_t>(reinterpret_cast<uintptr_t>(format)),
+                         time_us_32()};
+    uint16_t line16 = static_cast<uint16_t>(line);
+    rec.put(header, sizeof(header));
+    rec.put(addrs, sizeof(addrs));
+    rec.put(&line16, sizeof(line16));
+    (rec.putArg(args), ...);
+    rec.bytes[1] = static_cast<uint8_t>(rec.len);
+    rec.bytes[3] = rec.truncated ? 1 : 0;
+}
@@ -12,24 +12,58 @@
 #include <cstddef>
 #include <type_traits>
 #include <string>
+#include <cstring>
+#include "framework_config.h"
 #include "events/Notification.h"
 #include "events/GpioEvent.h"
+#include "events/EventPayloadPool.h"
 
 class FrameworkTask;
 
+/**
+ * @brief How an event's payload is stored.
+ */
+enum class PayloadKind : uint8_t {
+    Borrowed, ///< `data` points at memory owned by the producer
+    Inline,   ///< Copied into the event itself (up to EVENT_INLINE_PAYLOAD_SIZE bytes)
+    Pooled    ///< Copied into a reference-counted EventPayloadPool block
+};
+
+/**
+ * @brief Queue lane an event is delivered in.
+ *
+ * Each controller drains its High lane before its Normal lane, and the lanes fill
+ * independently, so a burst of normal events cannot delay or crowd out a high one.
+ */
+enum class EventPriority : uint8_t {
+    Normal, ///< Default lane (EVENT_QUEUE_LENGTH deep)
+    High    ///< Critical events (EVENT_HIGH_QUEUE_LENGTH deep), e.g. NetworkDown or a stop command
+};
+
 /**
  * @brief Represents a framework event, optionally carrying payload data.
+ *
+ * Payloads are either borrowed (`data` must stay valid until every subscriber has
+ * handled the event) or owned, via setPayload() or ownedUserEvent(). Owned payloads are
+ * copied into the event when small, otherwise into a pooled block that is released when
+ * the last subscriber's queue entry has been consumed. Read owned payloads through payload().
+ *
+ * An event with a pooled payload must be posted exactly once; EventManager takes over the
+ * producer's reference.
  */
 struct Event
 {
     Notification notification;       ///< Notification identifier (system or user)
     union {
         GpioEvent gpioEvent;         ///< Inline data if GpioChange
-        const void* data;            ///< For user use
+        const void* data;            ///< For user use (also the block address of a pooled payload)
+        uint8_t inlinePayload[EVENT_INLINE_PAYLOAD_SIZE]; ///< Owned payload stored in the event
     };
     size_t size = 0;                 ///< Size of payload data  
     void *source = nullptr;          ///< Optional source (e.g. controller that generated the event)
     FrameworkTask *target = nullptr; ///< Optional specific target (for directed delivery)
+    PayloadKind payloadKind = PayloadKind::Borrowed; ///< Storage used for the payload
+    EventPriority priority = EventPriority::Normal;  ///< Queue lane used by subscribers
 
     /**
      * @brief Default constructor (creates a SystemNotification::None event).
@@ -77,6 +111,54 @@ struct Event
         : notification(userCode), data(data), size(size), source(source), target(target) {}
 
 
+    /**
+     * @brief Copy a payload into storage owned by the event.
+     *
+     * @param src  Payload bytes.
+     * @param len  Payload size.
+     * @return false if the payload is larger than a pool block or the pool is exhausted
+     *         (the event is then left without a payload).
+     */
+    bool setPayload(const void *src, size_t len) {
+        if (len <= sizeof(inlinePayload)) {
+            memcpy(inlinePayload, src, len);
+            payloadKind = PayloadKind::Inline;
+            size = len;
+            return true;
+        }
+        data = EventPayloadPool::acquire(src, len);
+        payloadKind = data ? PayloadKind::Pooled : PayloadKind::Borrowed;
+        size = data ? len : 0;
+        return data != nullptr;
+    }
+
+    /// @brief Set the delivery lane, e.g. `postEvent(Event(...).withPriority(EventPriority::High))`
+    inline Event &withPriority(EventPriority p) {
+        priority = p;
+        return *this;
+    }
+
+    /// @brief Payload address, whichever way it is stored
+    inline const void *payload() const {
+        return payloadKind == PayloadKind::Inline ? static_cast<const void *>(inlinePayload) : data;
+    }
+
+    /// @brief Payload viewed as a T (owned payloads are copies, so T must be trivially copyable)
+    template<typename T>
+    inline const T *payloadAs() const {
+        return static_cast<const T *>(payload());
+    }
+
+    /// @brief Take another reference to a pooled payload (used by EventManager per queued copy)
+    inline void retain() const {
+        if (payloadKind == PayloadKind::Pooled) EventPayloadPool::retain(data);
+    }
+
+    /// @brief Drop a reference to a pooled payload once this copy has been handled
+    inline void release() const {
+        if (payloadKind == PayloadKind::Pooled) EventPayloadPool::release(data);
+    }
+
     /// @brief Returns true if this is a user-defined event
     inline bool isUser() const {
         return notification.kind == NotificationKind::User;
@@ -120,3 +202,28 @@ inline Event userEvent(Enum e, const char* data, size_t size) {
     static_assert(std::is_enum<Enum>::value, "Enum type required");
     return Event(static_cast<uint8_t>(e), data, size);
 }
+
+/**
+ * @brief Create a user event that carries its own copy of @p value.
+ *
+ * Unlike userEvent(), the value may go out of scope as soon as the event is posted.
+ */
+template<typename Enum, typename T>
+inline Event ownedUserEvent(Enum e, const T& value) {
+    static_assert(std::is_trivially_copyable<T>::value, "Owned payloads are copied bytewise; use a trivially copyable type");
+    Event evt(static_cast<uint8_t>(e));
+    evt.setPayload(&value, sizeof(T));
+    return evt;
+}
+
+/**
+ * @brief Create a user event that carries a NUL-terminated copy of a string.
+ *
+ * Read it back with `event.payloadAs<char>()`.
+ */
+template<typename Enum>
+inline Event ownedUserEvent(Enum e, const std::string& text) {
+    Event evt(static_cast<uint8_t>(e));
+    evt.setPayload(text.c_str(), text.size() + 1);
+    return evt;
+}
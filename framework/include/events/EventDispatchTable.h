@@ -0,0 +1,113 @@
+/**
+ * @file EventDispatchTable.h
+ * @author Ian Archbell
+ * @brief Per-notification-code subscriber table used by EventManager.
+ *
+ * Part of the PicoFramework application framework.
+ * Each notification code has its own fixed row of subscribers, so posting an event only
+ * visits the controllers interested in that code. Rows are append-only: a writer fills
+ * the slot first and then publishes the new count, which lets posts (including posts from
+ * an ISR) read the table without taking a lock while subscriptions are still arriving.
+ *
+ * @version 0.1
+ * @date 2025-04-22
+ * @license MIT License
+ * @copyright Copyright (c) 2025, Ian Archbell
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Fixed-capacity, append-only map from notification code to subscribers.
+ *
+ * @tparam T Subscriber type (stored by pointer).
+ * @tparam MaxPerCode Maximum subscribers for any one code.
+ *
+ * add() must be serialized by the caller; forEach() and contains() may run concurrently with it.
+ */
+template <typename T, size_t MaxPerCode>
+class EventDispatchTable
+{
+public:
+    static constexpr size_t NumCodes = 32; ///< One row per bit of a 32-bit event mask
+
+    /**
+     * @brief Add a subscriber to every code set in @p mask.
+     * @return false if any row was full (the subscriber is still added to the others).
+     */
+    bool add(uint32_t mask, T *subscriber)
+    {
+        bool ok = true;
+        for (size_t code = 0; code < NumCodes; ++code)
+        {
+            if (!(mask & (1u << code)) || contains(code, subscriber))
+            {
+                continue;
+            }
+            uint8_t n = counts[code].load(std::memory_order_relaxed);
+            if (n >= MaxPerCode)
+            {
+                ok = false;
+                continue;
+            }
+            rows[code][n] = subscriber;
+            counts[code].store(n + 1, std::memory_order_release);
+        }
+        return ok;
+    }
+
+    /**
+     * @brief Call @p fn for each subscriber of @p code.
+     */
+    template <typename Fn>
+    void forEach(uint8_t code, Fn &&fn) const
+    {
+        if (code >= NumCodes)
+        {
+            return;
+        }
+        uint8_t n = counts[code].load(std::memory_order_acquire);
+        for (uint8_t i = 0; i < n; ++i)
+        {
+            fn(rows[code][i]);
+        }
+    }
+
+    /**
+     * @brief True if @p subscriber is registered for @p code.
+     */
+    bool contains(uint8_t code, const T *subscriber) const
+    {
+        if (code >= NumCodes)
+        {
+            return false;
+        }
+        uint8_t n = counts[code].load(std::memory_order_acquire);
+        for (uint8_t i = 0; i < n; ++i)
+        {
+            if (rows[code][i] == subscriber)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Number of subscribers for @p code.
+     */
+    size_t count(uint8_t code) const
+    {
+        return code < NumCodes ? counts[code].load(std::memory_order_acquire) : 0;
+    }
+
+private:
+    static_assert(MaxPerCode <= 255, "MaxPerCode must fit in a uint8_t count");
+
+    T *rows[NumCodes][MaxPerCode] = {};
+    std::atomic<uint8_t> counts[NumCodes] = {};
+};
@@ -44,7 +44,10 @@
 #include <task.h>
 #include <semphr.h>
 #include <queue.h>
+#include "framework_config.h"
 #include "events/Event.h"
+#include "events/EventDispatchTable.h"
+#include "events/EventRing.h"
 #include "framework/FrameworkController.h"
 
 // Forward declaration
@@ -87,17 +90,20 @@ public:
      * @param eventMask Bitmask of `(1 << event.notification.code())`.
      * @param controller Pointer to the FrameworkController to notify.
      *
-     * @note All EventManager::subscribe() for thread safety, calls must complete before interrupts are enabled."
+     * Subscribing adds the controller to the row of each code in the mask, so posting an
+     * event only visits the controllers interested in it. Subscribing the same controller
+     * to a code twice has no effect. At most EVENT_MAX_SUBSCRIBERS_PER_CODE controllers
+     * can subscribe to any one code.
      */
     void subscribe(uint32_t eventMask, FrameworkController *controller);
 
     /**
      * @brief Post a notification to the queue and notify matching subscribers.
      *
-     * Safe to call from task or ISR context.
+     * Safe to call from task or ISR context. From an ISR the event is pushed into a
+     * lock-free ring and delivered by the EventManager dispatcher task.
      *
-     * @param n The notification to post.
-     * @param target Optional specific controller to notify (nullptr for all).
+     * @param e The event to post.
      */
     void postEvent(const Event &e);
 
@@ -128,6 +134,22 @@ public:
      */
     bool hasPendingEvents(FrameworkController *controller) const;
 
+    /**
+     * @brief Counters for events posted from interrupt context.
+     */
+    struct IsrIngressStats
+    {
+        uint32_t posted;  ///< Events accepted into the ISR ring
+        uint32_t dropped; ///< Events lost because the ring was full
+        size_t pending;   ///< Events waiting for the dispatcher task
+        size_t capacity;  ///< Ring size (EVENT_ISR_RING_SIZE)
+    };
+
+    /**
+     * @brief Snapshot of the ISR ingress counters, for monitoring.
+     */
+    IsrIngressStats getIsrIngressStats() const;
+
     template<typename Enum, typename... Rest>
     inline void subscribeTo(FrameworkController* ctrl, Enum first, Rest... rest) {
         static_assert(
@@ -139,24 +161,45 @@ public:
     }
 
 private:
-    struct Subscriber
+    SemaphoreHandle_t lock; ///< Serializes subscribe(); posting is lock-free
+    static StaticSemaphore_t lockBuffer_;
+
+    /// Subscribers indexed by notification code
+    EventDispatchTable<FrameworkController, EVENT_MAX_SUBSCRIBERS_PER_CODE> dispatch_;
+
+    /// What an ISR asked for; the dispatcher task performs it in task context
+    enum class Delivery : uint8_t
     {
-        uint32_t eventMask;              ///< Bitmask of subscribed event codes
-        FrameworkController *controller; ///< Target controller to notify
+        Queue,        ///< enqueue()
+        Notification, ///< postNotification()
+        Both          ///< postEvent()
     };
 
-    SemaphoreHandle_t lock;
-    static StaticSemaphore_t lockBuffer_;
+    struct IsrEvent
+    {
+        Event event;
+        Delivery delivery;
+    };
+
+    /**
+     * @brief Push an ISR post into the ring and wake the dispatcher. Never blocks.
+     */
+    void postFromISR(const Event &event, Delivery delivery);
 
-    std::vector<Subscriber> subscribers_;
+    /**
+     * @brief Deliver an event to the subscribers of its code from task context.
+     */
+    void deliver(const Event &event, Delivery delivery);
 
-    void withSubscribers(const std::function<void(std::vector<Subscriber> &)> &fn);
     /**
-     * @brief Provides read-only access to subscribers from ISR context (no locking).
-     *
-     * WARNING: Call only from ISR context. Must not modify the list.
+     * @brief Dispatcher task: drains the ISR ring whenever it is notified.
      */
-    void withSubscribersFromISR(const std::function<void(std::vector<Subscriber> &)> &fn);
+    static void dispatcherTask(void *param);
+
+    EventRing<IsrEvent, EVENT_ISR_RING_SIZE> isrRing_;
+    TaskHandle_t dispatcher_ = nullptr;
+    StaticTask_t dispatcherBuffer_;
+    StackType_t dispatcherStack_[EVENT_DISPATCH_STACK_SIZE];
 };
 
 #endif // EVENT_MANAGER_H
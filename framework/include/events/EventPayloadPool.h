@@ -0,0 +1,70 @@
+/**
+ * @file EventPayloadPool.h
+ * @author Ian Archbell
+ * @brief Reference-counted fixed-block pool for event payloads too large to store inline.
+ *
+ * Part of the PicoFramework application framework.
+ * An owned Event payload that does not fit in the event itself is copied into one block of
+ * this pool. EventManager takes a reference for every queue the event is placed on, and
+ * each consuming controller drops its reference after onEvent() returns, so the block is
+ * recycled when the last subscriber has seen it. All operations are lock-free and may be
+ * used from an ISR.
+ *
+ * @version 0.1
+ * @date 2025-04-22
+ * @license MIT License
+ * @copyright Copyright (c) 2025, Ian Archbell
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "framework_config.h"
+
+/**
+ * @brief Usage counters for the payload pool.
+ */
+struct EventPayloadStats
+{
+    size_t blocksInUse;     ///< Blocks currently referenced by an event
+    size_t blockCount;      ///< EVENT_PAYLOAD_BLOCKS
+    size_t blockSize;       ///< EVENT_PAYLOAD_BLOCK_SIZE
+    uint32_t allocFailures; ///< Payloads dropped because every block was in use or the payload was too large
+};
+
+/**
+ * @brief Static pool of EVENT_PAYLOAD_BLOCKS blocks of EVENT_PAYLOAD_BLOCK_SIZE bytes.
+ */
+class EventPayloadPool
+{
+public:
+    /**
+     * @brief Claim a free block and copy @p size bytes into it. The block starts with one reference.
+     * @return Pointer to the block data, or nullptr if the payload is too large or the pool is exhausted.
+     */
+    static void *acquire(const void *src, size_t size);
+
+    /**
+     * @brief Add a reference to the block holding @p data.
+     */
+    static void retain(const void *data);
+
+    /**
+     * @brief Drop a reference; the block is free again when the count reaches zero.
+     */
+    static void release(const void *data);
+
+    /**
+     * @brief Snapshot of pool usage.
+     */
+    static EventPayloadStats getStats();
+
+private:
+    static int indexOf(const void *data);
+
+    alignas(8) static uint8_t blocks[EVENT_PAYLOAD_BLOCKS][EVENT_PAYLOAD_BLOCK_SIZE];
+    static std::atomic<uint8_t> refs[EVENT_PAYLOAD_BLOCKS];
+    static std::atomic<uint32_t> failures;
+};
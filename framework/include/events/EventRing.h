@@ -0,0 +1,126 @@
+/**
+ * @file EventRing.h
+ * @author Ian Archbell
+ * @brief Bounded lock-free multi-producer, single-consumer ring for interrupt event ingress.
+ *
+ * Part of the PicoFramework application framework.
+ * Producers (ISRs on either core, or tasks) claim a slot by advancing an atomic head with
+ * compare-and-swap, copy the value in and publish it through the slot's sequence number.
+ * The single consumer (the EventManager dispatcher task) reads slots in order. Neither
+ * side blocks or masks interrupts; when the ring is full push() fails and the drop is counted.
+ *
+ * On RP2040 (Cortex-M0+) the 32-bit atomic operations are provided by the SDK's
+ * pico_atomic library; on RP2350 they compile to exclusive load/store instructions.
+ *
+ * @version 0.1
+ * @date 2025-04-22
+ * @license MIT License
+ * @copyright Copyright (c) 2025, Ian Archbell
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Fixed-size MPSC ring of @p T values.
+ *
+ * @tparam T Trivially copyable element type.
+ * @tparam N Capacity, a power of two.
+ */
+template <typename T, size_t N>
+class EventRing
+{
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "EventRing capacity must be a power of two");
+
+public:
+    EventRing()
+    {
+        for (size_t i = 0; i < N; ++i)
+        {
+            slots[i].seq.store(static_cast<uint32_t>(i), std::memory_order_relaxed);
+        }
+    }
+
+    EventRing(const EventRing &) = delete;
+    EventRing &operator=(const EventRing &) = delete;
+
+    /**
+     * @brief Append a value. Safe from any number of ISRs and tasks concurrently.
+     * @return false if the ring was full (the value is dropped and counted).
+     */
+    bool push(const T &value)
+    {
+        uint32_t pos = head.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Slot &slot = slots[pos & (N - 1)];
+            uint32_t seq = slot.seq.load(std::memory_order_acquire);
+            int32_t diff = static_cast<int32_t>(seq - pos);
+            if (diff == 0)
+            {
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    slot.value = value;
+                    slot.seq.store(pos + 1, std::memory_order_release);
+                    pushed.fetch_add(1, std::memory_order_relaxed);
+                    return true;
+                }
+                // pos was reloaded by the failed exchange
+            }
+            else if (diff < 0)
+            {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return false; // consumer has not freed this slot yet: full
+            }
+            else
+            {
+                pos = head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * @brief Remove the oldest value. Single consumer only.
+     * @return false if the ring is empty or the oldest slot is still being written.
+     */
+    bool pop(T &out)
+    {
+        uint32_t pos = tail.load(std::memory_order_relaxed);
+        Slot &slot = slots[pos & (N - 1)];
+        if (slot.seq.load(std::memory_order_acquire) != pos + 1)
+        {
+            return false;
+        }
+        out = slot.value;
+        slot.seq.store(pos + N, std::memory_order_release);
+        tail.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /// @brief Values successfully pushed since start.
+    uint32_t pushedCount() const { return pushed.load(std::memory_order_relaxed); }
+
+    /// @brief Values dropped because the ring was full.
+    uint32_t droppedCount() const { return dropped.load(std::memory_order_relaxed); }
+
+    /// @brief Approximate number of values waiting to be popped.
+    size_t pending() const { return head.load(std::memory_order_relaxed) - tail.load(std::memory_order_relaxed); }
+
+    static constexpr size_t capacity() { return N; }
+
+private:
+    struct Slot
+    {
+        std::atomic<uint32_t> seq;
+        T value;
+    };
+
+    Slot slots[N];
+    std::atomic<uint32_t> head{0};
+    std::atomic<uint32_t> tail{0}; ///< Written only by the consumer
+    std::atomic<uint32_t> pushed{0};
+    std::atomic<uint32_t> dropped{0};
+};
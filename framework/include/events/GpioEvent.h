@@ -13,3 +13,16 @@ struct GpioEvent {
     uint16_t edge;
 };
 
+
+/**
+ * @brief Coalesced edge activity on one pin over a pulse-counting period.
+ * Posted as SystemNotification::GpioPulse with the struct copied into the event's inline payload.
+ * Timestamps are the low 32 bits of the microsecond timer (time_us_32()).
+ */
+struct GpioPulseEvent {
+    uint16_t pin;
+    uint16_t edges;    ///< OR of the edge types seen during the period
+    uint32_t count;    ///< Number of edges counted
+    uint32_t firstUs;  ///< Time of the first counted edge
+    uint32_t lastUs;   ///< Time of the last counted edge
+};
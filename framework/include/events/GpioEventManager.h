@@ -1,7 +1,14 @@
 /**
  * @file GpioEventManager.h
  * @brief Posts GPIO change events (rising/falling edge) via EventManager.
- * @version 1.1
+ *
+ * Each pin can have a debounce window, which drops edges arriving too soon after the
+ * last accepted one, and can be switched to pulse counting, where edges are counted in
+ * the interrupt handler and one GpioPulse event is posted per period instead of a
+ * GpioChange event per edge. Both keep noisy or fast inputs from flooding the
+ * EVENT_QUEUE_LENGTH subscriber queues.
+ *
+ * @version 1.2
  * @date 2025-04-09
  * @copyright Copyright (c) 2025, Ian Archbell
  * @license MIT
@@ -9,11 +16,13 @@
 
 #pragma once
 #include "pico/stdlib.h"
+#include "hardware/sync.h"
 #include <map>
 #include <vector>
 #include <functional>
 #include "EventManager.h"
 #include "GpioEvent.h"
+#include "framework_config.h"
 
 /**
  * @brief GpioEventManager registers interrupts and posts GpioChange events to multiple listeners per pin.
@@ -75,11 +84,64 @@ public:
      */
     void unregisterAll(uint pin);
 
+    /**
+     * @brief Ignore edges on a pin that arrive within @p windowUs of the last accepted edge.
+     *
+     * Applies to listeners, GpioChange events and pulse counting alike. A window of 0
+     * (the GPIO_DEBOUNCE_DEFAULT_US default) accepts every edge.
+     *
+     * @param pin The GPIO pin number.
+     * @param windowUs Debounce window in microseconds.
+     */
+    void setDebounce(uint pin, uint32_t windowUs);
+
+    /**
+     * @brief Count edges on a pin and post one coalesced event per period.
+     *
+     * The first edge after an idle spell starts a period of @p periodMs. Edges during the
+     * period are only counted; when it ends a SystemNotification::GpioPulse event is posted
+     * carrying a GpioPulseEvent (count, edge types, first and last timestamps). Per-edge
+     * listeners and GpioChange events are not raised for the pin while counting.
+     *
+     * @param pin The GPIO pin number.
+     * @param periodMs Coalescing period in milliseconds, or 0 to return to per-edge events.
+     */
+    void setPulseCounting(uint pin, uint32_t periodMs);
+
+    /**
+     * @brief Number of edges on a pin dropped by its debounce window since start.
+     */
+    uint32_t getSuppressedCount(uint pin) const;
+
 private:
     GpioEventManager() = default;
     bool handler_set = false;
     
     static void gpio_event_handler(uint gpio, uint32_t events);
 
+    /// Pico SDK alarm callback that ends a pulse-counting period and posts the GpioPulse event
+    static int64_t flushPulses(alarm_id_t id, void *userData);
+
+    /// Per-pin filter state, written by the IRQ handler and the flush alarm under filterLock
+    struct PinFilter
+    {
+        uint32_t debounceUs = GPIO_DEBOUNCE_DEFAULT_US;
+        uint32_t periodMs = 0;   ///< Pulse-counting period, 0 when posting per edge
+        uint32_t lastEdgeUs = 0; ///< Last accepted edge, for debouncing
+        bool seenEdge = false;
+        uint32_t suppressed = 0;
+        bool armed = false;      ///< A flush alarm is pending for the open period
+        GpioPulseEvent pulse = {};
+    };
+
+    static PinFilter filters[NUM_BANK0_GPIOS];
+    static inline spin_lock_t *filterLock = nullptr;
+
+    /// Claim the hardware spin lock guarding filters (task context, before interrupts are enabled)
+    static void initFilterLock();
+
     static inline std::map<uint, std::vector<GpioCallback>> listeners;
+
+    /// Resolved in task context so the IRQ handler never goes through AppContext's mutex
+    static inline EventManager *eventManager = nullptr;
 };
@@ -26,6 +26,7 @@ enum class SystemNotification : uint8_t {
     WaitForTimeout,
     HttpServerStarted,
     GpioChange,
+    GpioPulse,
     Count
 };
 
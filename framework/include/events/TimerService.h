@@ -10,27 +10,29 @@
  * start/stop event durations. Integrates with FreeRTOS timers and the
  * EventManager to deliver events in an event-driven, non-blocking manner.
  *
- * @version 0.1
- * @date 2025-03-31
+ * @version 0.2
+ * @date 2025-04-22
  *
  * @license MIT License
  * @copyright Copyright (c) 2025, Ian Archbell
  */
 
 /**
- * @note Memory & Timer Lifetime (v0.1):
+ * @note Job storage (v0.2):
  *
- * - One-shot timers (`scheduleAt`, `scheduleDailyAt`, `scheduleDuration`) dynamically allocate an `Event` using `new`
- *   and clean it up automatically after posting (inside the timer callback).
+ * - Jobs are held in a TimingWheel of TIMER_SERVICE_MAX_JOBS pooled nodes; scheduling never touches
+ *   the heap (beyond what a large std::function capture needs) and fails with a 0 job ID when the pool is full.
  *
- * - Repeating timers (`scheduleEvery`) also allocate an `Event`, which is reused on each invocation.
- *   It is not deleted automatically and is assumed to remain valid for the lifetime of the timer.
+ * - Every schedule call returns an integer TimerJobId that can be passed to cancel().
  *
- *  It is now possible to cancel scheduled jobs using a job ID which will delete the timer and free the associated event.
+ * - A single TimerService task advances the wheel, sleeping until the next job is due, and posts the
+ *   events or runs the callbacks itself. Callbacks therefore run in that task, not the FreeRTOS timer daemon.
  *
- * @todo Possibles for v0.2+:
+ * - An event with an owned (pooled) payload is handed to the service: a one-shot job posts it once,
+ *   a repeating job takes a new reference per post, and cancel() drops the service's reference.
+ *
+ * @todo Possibles for v0.3+:
  * - Persistent job tracking (scheduled jobs stored and reloaded)
- * - Named job handles for cancellation or status checks
  * - Automatic recovery of missed events after reboot
  */
 
@@ -39,13 +41,14 @@
 #include <cstdint>
 #include <ctime>
 #include <string>
-#include <unordered_map>
 #include <functional>
 #include <FreeRTOS.h>
 #include <semphr.h>
-#include <timers.h>
+#include <task.h>
 
+#include "framework_config.h"
 #include "events/Event.h"
+#include "events/TimingWheel.h"
 #include "time/TimeOfDay.h"
 #include "time/DaysOfWeek.h"
 
@@ -69,14 +72,11 @@ struct TimerJob
 class TimerService
 {
 public:
-
-
     TimerService();
     ~TimerService() = default;
 
     void withLock(const std::function<void()>& fn);
 
-
     /**
      * @brief Access the singleton instance.
      */
@@ -87,18 +87,18 @@ public:
      *
      * @param unixTime Epoch time in seconds.
      * @param event Event to trigger.
+     * @return Job ID, or 0 if no job slot was free.
      */
-    void scheduleAt(time_t unixTime, const Event &event);
-    void scheduleAt(time_t unixTime, const Event &event, const std::string &jobId);
+    TimerJobId scheduleAt(time_t unixTime, const Event &event);
 
     /**
      * @brief Schedule a repeating event at fixed intervals.
      *
      * @param intervalMs Interval in milliseconds.
      * @param event Event to trigger repeatedly.
+     * @return Job ID, or 0 if no job slot was free.
      */
-    void scheduleEvery(uint32_t intervalMs, const Event &event);
-    void scheduleEvery(uint32_t intervalMs, const Event &event, const std::string &jobId);
+    TimerJobId scheduleEvery(uint32_t intervalMs, const Event &event);
 
     /**
      * @brief Schedule a recurring event based on time-of-day and day mask.
@@ -106,9 +106,18 @@ public:
      * @param time Time of day to trigger.
      * @param days Days to run (bitmask).
      * @param event Event to trigger.
+     * @return Job ID, or 0 if no job slot was free.
+     */
+    TimerJobId scheduleDailyAt(TimeOfDay time, DaysOfWeek days, const Event &event);
+
+    /**
+     * @brief Job IDs of a start/stop pair scheduled by scheduleDuration().
      */
-    void scheduleDailyAt(TimeOfDay time, DaysOfWeek days, const Event &event);
-    void scheduleDailyAt(TimeOfDay time, DaysOfWeek days, const Event &event, const std::string &jobId);
+    struct DurationJobs
+    {
+        TimerJobId start; ///< 0 if it could not be scheduled
+        TimerJobId stop;  ///< 0 if it could not be scheduled
+    };
 
     /**
      * @brief Schedule a start event and stop event with a delay between them.
@@ -119,10 +128,8 @@ public:
      * @param startEvent Event to post at start.
      * @param stopEvent Event to post after duration.
      */
-    void scheduleDuration(TimeOfDay start, DaysOfWeek days, uint32_t durationMs,
-                          const Event &startEvent, const Event &stopEvent);
-    void scheduleDuration(TimeOfDay start, DaysOfWeek days, uint32_t durationMs,
-                          const Event &startEvent, const Event &stopEvent, const std::string &baseJobId);
+    DurationJobs scheduleDuration(TimeOfDay start, DaysOfWeek days, uint32_t durationMs,
+                                  const Event &startEvent, const Event &stopEvent);
 
     /**
      * @brief Detect and fire any missed events after a reboot (TBD).
@@ -131,24 +138,48 @@ public:
      */
     void checkMissedEvents(time_t now);
 
-    bool cancel(const std::string &jobId);
+    /**
+     * @brief Cancel a scheduled job.
+     * @return false if the job has already fired (one-shot) or was never scheduled.
+     */
+    bool cancel(TimerJobId jobId);
 
     /// @brief Schedule a one-shot callback at a given absolute time.
     /// @param unixTime The absolute time to invoke the callback (in seconds).
-    /// @param callback The callback to execute.
-    void scheduleCallbackAt(time_t unixTime, std::function<void()> callback);
+    /// @param callback The callback to execute (on the TimerService task).
+    /// @return Job ID, or 0 if the time has passed or no job slot was free.
+    TimerJobId scheduleCallbackAt(time_t unixTime, std::function<void()> callback);
 
+    /// @brief Number of jobs currently scheduled
+    size_t activeJobs();
 
 private:
+    /// What a job does when it falls due
+    struct TimerAction
+    {
+        Event event;
+        std::function<void()> callback; ///< Run instead of posting `event` when set
+        bool repeating = false;
+    };
 
     SemaphoreHandle_t lock_;
     static StaticSemaphore_t lockBuffer_;
 
-    std::unordered_map<std::string, TimerHandle_t> scheduledJobs; ///< Map of job IDs to TimerHandles
-    // Note: TimerHandles are created and managed by FreeRTOS.
-    // They will automatically clean up after firing if pdFALSE is passed to xTimerDelete.
-    // If pdTRUE is passed, the timer will be deleted immediately after firing.
-    // This is useful for one-shot timers.
+    TimingWheel<TimerAction, TIMER_SERVICE_MAX_JOBS> wheel_; ///< One wheel tick per FreeRTOS tick
+    TickType_t lastTick_ = 0;                                ///< Tick count the wheel was last advanced to
+
+    TaskHandle_t task_ = nullptr;
+    StaticTask_t taskBuffer_;
+    StackType_t taskStack_[TIMER_SERVICE_STACK_SIZE];
+
+    /// File a job @p delayMs from now and wake the task; releases the event's payload on failure
+    TimerJobId schedule(uint32_t delayMs, uint32_t periodMs, TimerAction action);
+
+    /// Advance the wheel, fire due jobs and sleep until the next one
+    static void timerTask(void *param);
+
+    /// Post the event or run the callback of a due job
+    void fire(TimerAction &action);
 
     /**
      * @brief Placeholder for persistence/rescheduling in the future.
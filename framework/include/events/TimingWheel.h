@@ -0,0 +1,365 @@
+/**
+ * @file TimingWheel.h
+ * @author Ian Archbell
+ * @brief Hierarchical timing wheel with pooled job nodes, used by TimerService.
+ *
+ * Part of the PicoFramework application framework.
+ * Jobs live in a fixed pool and are linked into one of five levels of 64 slots; level L
+ * covers delays up to 64^(L+1) ticks, so schedule and cancel are O(1) and a job only moves
+ * when its level's slot comes round (at most once per level). Delays beyond the top level
+ * are parked in its furthest slot and re-filed when that slot is reached. advance() skips
+ * empty stretches using per-level occupancy bitmaps, so the cost of a long sleep is the
+ * number of occupied slots passed rather than the number of ticks.
+ *
+ * The wheel is not thread-safe; TimerService serializes access with its mutex.
+ *
+ * @version 0.1
+ * @date 2025-04-22
+ * @license MIT License
+ * @copyright Copyright (c) 2025, Ian Archbell
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+/// Job handle: pool index in the low 16 bits, generation in the high 16. Never 0 for a live job.
+using TimerJobId = uint32_t;
+
+/**
+ * @brief Fixed-capacity hierarchical timing wheel.
+ *
+ * @tparam T        Payload stored with each job.
+ * @tparam Capacity Maximum number of scheduled jobs (at most 65535).
+ */
+template <typename T, size_t Capacity>
+class TimingWheel
+{
+    static_assert(Capacity > 0 && Capacity < 0xFFFF, "TimingWheel capacity must fit a 16-bit index");
+
+public:
+    static constexpr unsigned SlotBits = 6;
+    static constexpr unsigned Slots = 1u << SlotBits;
+    static constexpr unsigned Levels = 5;
+    static constexpr uint64_t MaxDelta = (1ull << (SlotBits * Levels)) - 1; ///< Longest delay filed directly
+
+    TimingWheel()
+    {
+        for (auto &head : heads)
+        {
+            head = Nil;
+        }
+        for (size_t i = 0; i < Capacity; ++i)
+        {
+            nodes[i].next = (i + 1 < Capacity) ? static_cast<uint16_t>(i + 1) : Nil;
+            nodes[i].where = Free;
+        }
+        freeHead = 0;
+    }
+
+    TimingWheel(const TimingWheel &) = delete;
+    TimingWheel &operator=(const TimingWheel &) = delete;
+
+    /**
+     * @brief Schedule @p value to become due at absolute tick @p expires.
+     *
+     * @param expires Due tick; values not after now() are due on the next tick.
+     * @param period  Re-arm interval in ticks for repeating jobs, 0 for one-shot.
+     * @return Job ID, or 0 if the pool is exhausted.
+     */
+    TimerJobId schedule(uint64_t expires, uint32_t period, T value)
+    {
+        if (freeHead == Nil)
+        {
+            return 0;
+        }
+        uint16_t index = freeHead;
+        Node &node = nodes[index];
+        freeHead = node.next;
+
+        node.value = std::move(value);
+        node.expires = expires > now_ ? expires : now_ + 1;
+        node.period = period;
+        insert(index);
+        ++count;
+        return (static_cast<TimerJobId>(node.generation) << 16) | index;
+    }
+
+    /**
+     * @brief Remove a job, whether it is still pending or already due.
+     * @param removed If not null, receives the job's payload.
+     * @return false if @p id is not a live job.
+     */
+    bool cancel(TimerJobId id, T *removed = nullptr)
+    {
+        uint16_t index = static_cast<uint16_t>(id & 0xFFFF);
+        if (index >= Capacity || nodes[index].where == Free || nodes[index].generation != (id >> 16))
+        {
+            return false;
+        }
+        unlink(index);
+        if (removed)
+        {
+            *removed = std::move(nodes[index].value);
+        }
+        release(index);
+        return true;
+    }
+
+    /**
+     * @brief Move the wheel forward to tick @p to, moving every job due by then to the due list.
+     */
+    void advance(uint64_t to)
+    {
+        while (now_ < to)
+        {
+            uint64_t step = ticksUntilNext();
+            if (step == 0 || now_ + step > to)
+            {
+                now_ = to; // nothing is filed before `to`, so the slot indices stay valid
+                return;
+            }
+            now_ += step;
+            processTick();
+        }
+    }
+
+    /**
+     * @brief Take the oldest due job.
+     *
+     * One-shot jobs are freed and their payload moved out; repeating jobs are copied out
+     * and re-filed one period after their previous due time (or after now() if that has
+     * already passed).
+     *
+     * @return false if nothing is due.
+     */
+    bool popDue(T &out, TimerJobId *id = nullptr)
+    {
+        if (dueHead == Nil)
+        {
+            return false;
+        }
+        uint16_t index = dueHead;
+        Node &node = nodes[index];
+        unlink(index);
+        if (id)
+        {
+            *id = (static_cast<TimerJobId>(node.generation) << 16) | index;
+        }
+        if (node.period)
+        {
+            out = node.value;
+            node.expires += node.period;
+            if (node.expires <= now_)
+            {
+                node.expires = now_ + node.period;
+            }
+            insert(index);
+        }
+        else
+        {
+            out = std::move(node.value);
+            release(index);
+        }
+        return true;
+    }
+
+    /**
+     * @brief Ticks from now() until the wheel next has work (a due slot or a cascade).
+     * @return 0 if no job is scheduled.
+     */
+    uint64_t ticksUntilNext() const
+    {
+        uint64_t best = 0;
+        for (unsigned level = 0; level < Levels; ++level)
+        {
+            if (!occupied[level])
+            {
+                continue;
+            }
+            unsigned shift = SlotBits * level;
+            unsigned current = static_cast<unsigned>((now_ >> shift) & (Slots - 1));
+            unsigned dist = firstSetAfter(occupied[level], current);
+            uint64_t at = ((now_ >> shift) + dist) << shift;
+            uint64_t delta = at - now_;
+            if (best == 0 || delta < best)
+            {
+                best = delta;
+            }
+        }
+        return best;
+    }
+
+    /// @brief True if at least one job is waiting in the due list
+    bool hasDue() const { return dueHead != Nil; }
+
+    /// @brief Current wheel time in ticks
+    uint64_t now() const { return now_; }
+
+    /// @brief Jobs scheduled or due
+    size_t size() const { return count; }
+
+    static constexpr size_t capacity() { return Capacity; }
+
+private:
+    static constexpr uint16_t Nil = 0xFFFF;
+    static constexpr uint16_t DueList = Levels * Slots; ///< `where` value for the due list
+    static constexpr uint16_t Free = DueList + 1;       ///< `where` value for a free node
+
+    struct Node
+    {
+        T value{};
+        uint64_t expires = 0;
+        uint32_t period = 0;
+        uint16_t next = Nil;
+        uint16_t prev = Nil;
+        uint16_t where = Free;     ///< Slot list index, DueList or Free
+        uint16_t generation = 1;
+    };
+
+    /// File a node in the slot matching its expiry relative to now_
+    void insert(uint16_t index)
+    {
+        Node &node = nodes[index];
+        uint64_t delta = node.expires > now_ ? node.expires - now_ : 0;
+        uint64_t placeAt = delta > MaxDelta ? now_ + MaxDelta : node.expires;
+        if (delta > MaxDelta)
+        {
+            delta = MaxDelta;
+        }
+
+        unsigned level = 0;
+        while (level + 1 < Levels && delta >= (1ull << (SlotBits * (level + 1))))
+        {
+            ++level;
+        }
+        unsigned slot = static_cast<unsigned>((placeAt >> (SlotBits * level)) & (Slots - 1));
+        pushFront(static_cast<uint16_t>(level * Slots + slot), index);
+        occupied[level] |= 1ull << slot;
+    }
+
+    void pushFront(uint16_t list, uint16_t index)
+    {
+        Node &node = nodes[index];
+        node.where = list;
+        node.prev = Nil;
+        node.next = heads[list];
+        if (node.next != Nil)
+        {
+            nodes[node.next].prev = index;
+        }
+        heads[list] = index;
+    }
+
+    void unlink(uint16_t index)
+    {
+        Node &node = nodes[index];
+        if (node.prev != Nil)
+        {
+            nodes[node.prev].next = node.next;
+        }
+        else if (node.where == DueList)
+        {
+            dueHead = node.next;
+        }
+        else
+        {
+            heads[node.where] = node.next;
+            if (node.next == Nil)
+            {
+                occupied[node.where / Slots] &= ~(1ull << (node.where % Slots));
+            }
+        }
+
+        if (node.next != Nil)
+        {
+            nodes[node.next].prev = node.prev;
+        }
+        else if (node.where == DueList)
+        {
+            dueTail = node.prev;
+        }
+        node.next = node.prev = Nil;
+    }
+
+    void release(uint16_t index)
+    {
+        Node &node = nodes[index];
+        node.value = T{};
+        node.where = Free;
+        node.generation = static_cast<uint16_t>(node.generation + 1) ? static_cast<uint16_t>(node.generation + 1) : 1;
+        node.next = freeHead;
+        freeHead = index;
+        --count;
+    }
+
+    /// Cascade any level whose slot boundary is now_, then move level 0's current slot to the due list
+    void processTick()
+    {
+        for (unsigned level = 1; level < Levels; ++level)
+        {
+            if (now_ & ((1ull << (SlotBits * level)) - 1))
+            {
+                break;
+            }
+            unsigned slot = static_cast<unsigned>((now_ >> (SlotBits * level)) & (Slots - 1));
+            uint16_t list = static_cast<uint16_t>(level * Slots + slot);
+            uint16_t index = heads[list];
+            heads[list] = Nil;
+            occupied[level] &= ~(1ull << slot);
+            while (index != Nil)
+            {
+                uint16_t next = nodes[index].next;
+                insert(index);
+                index = next;
+            }
+        }
+
+        unsigned slot = static_cast<unsigned>(now_ & (Slots - 1));
+        uint16_t index = heads[slot];
+        heads[slot] = Nil;
+        occupied[0] &= ~(1ull << slot);
+        while (index != Nil)
+        {
+            uint16_t next = nodes[index].next;
+            appendDue(index);
+            index = next;
+        }
+    }
+
+    void appendDue(uint16_t index)
+    {
+        Node &node = nodes[index];
+        node.where = DueList;
+        node.next = Nil;
+        node.prev = dueTail;
+        if (dueTail != Nil)
+        {
+            nodes[dueTail].next = index;
+        }
+        else
+        {
+            dueHead = index;
+        }
+        dueTail = index;
+    }
+
+    /// Distance (1..64) from @p current to the next set bit of @p bits, wrapping
+    static unsigned firstSetAfter(uint64_t bits, unsigned current)
+    {
+        unsigned start = (current + 1) & (Slots - 1);
+        uint64_t rotated = (bits >> start) | (start ? bits << (Slots - start) : 0);
+        return static_cast<unsigned>(__builtin_ctzll(rotated)) + 1;
+    }
+
+    Node nodes[Capacity];
+    uint16_t heads[Levels * Slots];
+    uint64_t occupied[Levels] = {};
+    uint16_t freeHead = Nil;
+    uint16_t dueHead = Nil;
+    uint16_t dueTail = Nil;
+    size_t count = 0;
+    uint64_t now_ = 0;
+};
@@ -23,7 +23,11 @@
  * Intended to be subclassed. You override `onStart()`, `onEvent()`, and `poll()`
  * to define your application's behavior.
  *
- * @version 0.1
+ * The controller task sleeps until the earliest of its next event, the next periodic
+ * job registered with addPeriodicJob(), and the next poll. A controller that does not
+ * override poll() is never woken just to poll.
+ *
+ * @version 0.2
  * @date 2025-03-31
  * @license MIT License
  * @copyright Copyright (c) 2025, Ian Archbell
@@ -32,11 +36,13 @@
 #pragma once
 
 #include "FrameworkTask.h"
-#include <unordered_map>
+#include <atomic>
 #include <functional>
 #include <string>
 #include <FreeRTOS.h>
 #include <task.h>
+#include <queue.h>
+#include "framework_config.h"
 #include "events/Event.h"
 #include "http/Router.h"
 
@@ -48,7 +54,8 @@
  * - `onEvent()` – called when an event is received
  * - `poll()` – called periodically for background work
  *
- * It also includes a utility `runEvery()` to call a function at regular intervals.
+ * Periodic work can be registered with `addPeriodicJob()`, or done from `poll()` with
+ * the `runEvery()` utility.
  */
 class FrameworkController : public FrameworkTask
 {
@@ -75,9 +82,10 @@ public:
      * @brief Main task loop.
      *
      * Calls `onStart()` once, then enters a loop that:
-     * - Waits for an event (or timeout)
-     * - Dispatches it to `onEvent()`
-     * - Calls `poll()` to perform non-blocking logic
+     * - Waits for an event, or until the next periodic job or poll is due
+     * - Dispatches the event to `onEvent()`
+     * - Runs the periodic jobs that are due
+     * - Calls `poll()` when its interval has elapsed
      */
     void run() override final;
 
@@ -115,27 +123,53 @@ protected:
     /**
      * @brief Returns the polling interval in ticks used in run().
      * Override this in subclasses if different polling frequency is needed.
+     * Return portMAX_DELAY to poll only when a runEvery() function is due; a controller
+     * with nothing to poll then only wakes for events and periodic jobs.
      */
     virtual TickType_t getPollIntervalTicks() {
         return pdMS_TO_TICKS(100); // Default: 100ms
     }
 
     /**
-     * @brief Called during every loop iteration for non-blocking background logic.
+     * @brief Called for non-blocking background logic every getPollIntervalTicks().
      *
-     * Runs after waitAndDispatch() — useful for polling sensors or internal FSMs.
+     * Also called when a function passed to runEvery() from here is due — useful for
+     * polling sensors or internal FSMs. The default does nothing; return portMAX_DELAY from
+     * getPollIntervalTicks() to stop a controller waking just to call it.
      */
     virtual void poll();
 
     /**
      * @brief Run a function periodically with millisecond resolution.
      *
+     * Call from poll(); the controller wakes for poll() when the function is next due.
+     * Prefer addPeriodicJob() for new code.
+     *
      * @param intervalMs Time interval in milliseconds.
      * @param fn Function to run.
-     * @param id Unique ID for this timed function (used to track last execution).
+     * @param id Unique ID for this timed function (used to track last execution). The pointer
+     *           is kept, so pass a string literal or other string that outlives the controller.
+     * @note At most CONTROLLER_MAX_RUN_EVERY IDs are tracked. Beyond that configASSERT fires; with
+     *       asserts disabled the function runs on every poll and a warning is printed once.
      */
     void runEvery(uint32_t intervalMs, const std::function<void()> &fn, const char *id);
 
+    /**
+     * @brief Register a function to run on this controller's task every @p intervalMs.
+     *
+     * The first run is one interval from now. Call from the controller's own task
+     * (onStart(), onEvent() or poll()); up to CONTROLLER_MAX_PERIODIC_JOBS jobs.
+     *
+     * @return Job ID for removePeriodicJob(), or -1 if every slot is in use.
+     */
+    int addPeriodicJob(uint32_t intervalMs, std::function<void()> fn);
+
+    /**
+     * @brief Stop a job registered with addPeriodicJob().
+     * @return false if @p id is not a registered job.
+     */
+    bool removePeriodicJob(int id);
+
     Router& router;    ///< Handles path-to-handler mapping - reference to shared Router instance
 
 public:
@@ -144,49 +178,95 @@ public:
     /**
      * @brief Enable the event queue for this controller.
      *
-     * Creates a FreeRTOS queue to hold events if it doesn't already exist.
-     * The queue depth can be specified, defaulting to 8.
+     * Creates a FreeRTOS queue per priority lane (Normal @p depth deep, High
+     * EVENT_HIGH_QUEUE_LENGTH deep) and a queue set to wait on both, if they don't already exist.
      *
-     * @param depth Maximum number of events in the queue.
+     * @param depth Maximum number of events in the Normal lane.
      */
-    void enableEventQueue(size_t depth = 8) {
-        if (!eventQueue_) {
-            eventQueue_ = xQueueCreate(depth, sizeof(Event));
-        }
-    }
+    void enableEventQueue(size_t depth = EVENT_QUEUE_LENGTH);
+
     /**
-     * @brief Get the event queue for this controller.
+     * @brief Get the Normal lane queue for this controller.
      *
-     * Returns the FreeRTOS queue handle used to hold events.
-     * This queue is used to post events from other tasks or ISRs.
+     * Post through queueEvent() so the event's priority and the drop counters are honoured.
      */
     QueueHandle_t getEventQueue() const {
         return eventQueue_;
     }
 
     /**
-     * @brief Check if there are any pending events in the queue.   
-     * @param controller Pointer to the controller to check.
-     * @return True if there are pending events, false otherwise.
+     * @brief Place an event in the lane matching its priority. Never blocks.
+     * @return false if the lane was full (the drop is counted) or the queue is not enabled.
+     */
+    bool queueEvent(const Event &event);
+
+    /**
+     * @brief Events dropped because @p lane was full.
+     */
+    uint32_t getDroppedEvents(EventPriority lane) const {
+        return dropped_[static_cast<size_t>(lane)].load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Receive the next event, High lane first.
+     * @param event Receives the event.
+     * @param timeoutMs Maximum time to wait in milliseconds.
+     * @return True if an event was received, false on timeout.
+     * @note Call event.release() once a received event has been handled, so pooled payloads are recycled.
      */
     bool getNextEvent(Event& event, uint32_t timeoutMs) {
-        return eventQueue_ && xQueueReceive(eventQueue_, &event, pdMS_TO_TICKS(timeoutMs)) == pdTRUE;
+        return receiveEvent(event, pdMS_TO_TICKS(timeoutMs));
     }
 
 
 private:
-    std::unordered_map<std::string, TickType_t> _timers; ///< Stores last-execution timestamps per ID
+    /// A function registered with addPeriodicJob()
+    struct PeriodicJob
+    {
+        std::function<void()> fn; ///< Empty when the slot is free
+        TickType_t interval = 0;
+        TickType_t next = 0;      ///< Tick at which it is next due
+    };
+
+    /// Last execution of a runEvery() function, keyed by its ID
+    struct RunEveryTimer
+    {
+        const char *id;  ///< As passed to runEvery()
+        uint32_t idHash; ///< Checked before comparing the strings
+        TickType_t last;
+    };
+
+    PeriodicJob periodicJobs_[CONTROLLER_MAX_PERIODIC_JOBS];
+    RunEveryTimer runEveryTimers_[CONTROLLER_MAX_RUN_EVERY];
+    size_t runEveryCount_ = 0;
+    bool runEveryOverflowWarned_ = false;
+
+    TickType_t nextPoll_ = 0;                ///< Tick at which poll() is next due
+    TickType_t runEveryDue_ = portMAX_DELAY; ///< Ticks until the soonest runEvery() function, gathered during poll()
+    bool pollScheduled_ = true;              ///< False with no poll interval and no runEvery() due
     
-    QueueHandle_t eventQueue_ = nullptr; // FreeRTOS queue for pending events
+    QueueHandle_t eventQueue_ = nullptr;     // FreeRTOS queue for pending Normal events
+    QueueHandle_t highQueue_ = nullptr;      // FreeRTOS queue for pending High events
+    QueueSetHandle_t queueSet_ = nullptr;    // Wakes the task when either lane has an event
+    std::atomic<uint32_t> dropped_[2] = {};  // Per-lane drop counters, indexed by EventPriority
+
+    /// Wait up to @p timeoutTicks for an event, taking from the High lane first
+    bool receiveEvent(Event &event, TickType_t timeoutTicks);
 
     /**
      * @brief Waits for an event and dispatches it to `onEvent()` if applicable.
      *
      * If the event is targeted at this controller (or has no target), it will be passed to `onEvent()`.
      *
-     * @param timeoutMs Maximum time to wait for an event in milliseconds.
+     * @param timeoutTicks Maximum time to wait for an event in ticks.
      */
-    void waitAndDispatch(uint32_t timeoutMs = portMAX_DELAY);
+    void waitAndDispatch(TickType_t timeoutTicks = portMAX_DELAY);
+
+    /// Ticks until the next periodic job or poll is due (portMAX_DELAY if none)
+    TickType_t ticksUntilNextDeadline(TickType_t now) const;
+
+    /// Run every periodic job whose deadline has passed
+    void runDuePeriodicJobs(TickType_t now);
 };
 
 // --- Timing convenience macro ---
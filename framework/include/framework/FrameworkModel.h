@@ -171,7 +171,7 @@ protected:
      */
     virtual std::string getIdField() const { return "id"; }
 
-    nlohmann::json collection = nlohmann::json::array(); ///< In-memory array of records
+    FrameworkJson collection = FrameworkJson::array(); ///< In-memory array of records (pooled when FRAMEWORK_JSON_POOL is set)
 
 private:
     JsonService* jsonService = nullptr; ///< Underlying JSON persistence layer       
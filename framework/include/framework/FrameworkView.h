@@ -32,6 +32,14 @@
       */
      virtual std::string getContentType() const = 0;
  
+     /**
+      * @brief Optional hook to write the body directly to the response instead of returning it.
+      * @return false if the view does not stream; the caller then sends render(context).
+      */
+     virtual bool stream(HttpResponse& response, const std::map<std::string, std::string>& context) const {
+         return false;
+     }
+ 
      /**
       * @brief Optional hook to set response headers (e.g., Content-Disposition).
       */
@@ -0,0 +1,100 @@
+/**
+ * @file HtmlTemplate.h
+ * @author Ian Archbell
+ * @brief Compiled {{key}} template used by HtmlTemplateView and HttpResponse::renderTemplate.
+ *
+ * Part of the PicoFramework application framework.
+ * A template is scanned once into a list of literal runs and placeholder slots. Rendering
+ * walks that list, so its cost is linear in the output and independent of how many keys
+ * the context holds. File templates are cached by path and reloaded when the file size changes.
+ *
+ * @version 0.1
+ * @date 2025-04-30
+ * @license MIT License
+ * @copyright Copyright (c) 2025, Ian Archbell
+ */
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "framework_config.h"
+
+class HttpResponse;
+
+/**
+ * @brief Immutable compiled template. Placeholders missing from the context are emitted unchanged.
+ */
+class HtmlTemplate
+{
+public:
+    using Context = std::map<std::string, std::string>;
+
+    /**
+     * @brief Compile template text into segments.
+     * @param text Template source containing {{key}} placeholders.
+     */
+    static std::shared_ptr<const HtmlTemplate> compile(std::string text);
+
+    /**
+     * @brief Get the compiled template for a file, compiling and caching it on first use.
+     *
+     * The cached copy is reused while the file size reported by the StorageManager is
+     * unchanged. Call invalidate() after rewriting a template with the same size.
+     * When HTML_TEMPLATE_CACHE_ENTRIES are cached, the least recently loaded one is dropped.
+     *
+     * @param path Template path in storage.
+     * @return Compiled template, or nullptr if the file could not be read.
+     */
+    static std::shared_ptr<const HtmlTemplate> load(const std::string &path);
+
+    /**
+     * @brief Drop the cached copy of a file template.
+     */
+    static void invalidate(const std::string &path);
+
+    /**
+     * @brief Drop all cached file templates.
+     */
+    static void clearCache();
+
+    /**
+     * @brief Exact length of the output for a context, without rendering it.
+     */
+    size_t renderedLength(const Context &context) const;
+
+    /**
+     * @brief Render to a string (reserved once to the final size).
+     */
+    std::string render(const Context &context) const;
+
+    /**
+     * @brief Stream the rendered output as the response body with a Content-Length header.
+     *
+     * Output is staged in an HTML_TEMPLATE_BUFFER_SIZE buffer; no full-page string is built.
+     *
+     * @param res Response to write to. Its status code and headers are sent first.
+     * @param context Placeholder values.
+     * @param contentType MIME type for the response.
+     */
+    void stream(HttpResponse &res, const Context &context, const std::string &contentType = "text/html") const;
+
+private:
+    /// A literal run of the source, or a placeholder when key is non-empty
+    struct Segment
+    {
+        size_t offset; ///< Start of the literal (or of the whole "{{key}}") in source
+        size_t length; ///< Length of the literal (or of the whole "{{key}}")
+        std::string key;
+    };
+
+    explicit HtmlTemplate(std::string text);
+
+    /// Text to emit for a segment under a context
+    const char *resolve(const Segment &seg, const Context &context, size_t &length) const;
+
+    std::string source;
+    std::vector<Segment> segments;
+};
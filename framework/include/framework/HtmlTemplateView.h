@@ -5,6 +5,7 @@
  *
  * Supports simple {{key}} substitution for embedded or file-loaded HTML templates.
  * Compatible with the FrameworkView interface and HttpResponse::send(view, context).
+ * Templates are compiled once (see HtmlTemplate) and streamed straight to the response.
  *
  * @version 0.3
  * @date 2025-04-30
@@ -13,6 +14,8 @@
 
  #pragma once
  #include "framework/FrameworkView.h"
+ #include "framework/HtmlTemplate.h"
+ #include <memory>
  #include <string>
  #include "http/HttpRequest.h"
  #include "http/HttpResponse.h"
@@ -28,16 +31,19 @@
  
      std::string render(const std::map<std::string, std::string>& context = {}) const override;
 
+     bool stream(HttpResponse& res, const std::map<std::string, std::string>& context) const override;
+
      void render(HttpRequest& req, HttpResponse& res) {
-        res.setContentType("text/html");
-        res.send(render());
+        stream(res, {});
     }
     
      std::string getContentType() const override;
  
  private:
-     std::string templateSource_;   // Used if mode == Inline
+     /// Compiled template: the inline one, or the cached file template (fallback page if missing)
+     std::shared_ptr<const HtmlTemplate> getTemplate() const;
+
+     std::shared_ptr<const HtmlTemplate> inline_; // Used if mode == Inline
      std::string filePath_;         // Used if mode == FromFile
      TemplateSource mode_;
  };
- 
\ No newline at end of file
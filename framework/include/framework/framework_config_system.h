@@ -34,6 +34,67 @@
 #define EVENT_QUEUE_LENGTH 8 // Default max bufferred events in the queues
 #endif
 
+#ifndef EVENT_HIGH_QUEUE_LENGTH
+#define EVENT_HIGH_QUEUE_LENGTH 4 ///< Depth of each controller's EventPriority::High lane
+#endif
+
+#ifndef CONTROLLER_MAX_PERIODIC_JOBS
+#define CONTROLLER_MAX_PERIODIC_JOBS 4 ///< Jobs per controller registered with FrameworkController::addPeriodicJob
+#endif
+
+#ifndef CONTROLLER_MAX_RUN_EVERY
+#define CONTROLLER_MAX_RUN_EVERY 8 ///< Distinct runEvery() IDs tracked per controller
+#endif
+
+#ifndef EVENT_MAX_SUBSCRIBERS_PER_CODE
+#define EVENT_MAX_SUBSCRIBERS_PER_CODE 8 ///< Maximum controllers subscribed to any one notification code
+#endif
+
+/**
+ * @brief Owned event payloads
+ * Payloads up to EVENT_INLINE_PAYLOAD_SIZE bytes are copied into the Event (every queue slot grows by this much),
+ * larger ones into one of EVENT_PAYLOAD_BLOCKS reference-counted blocks of EVENT_PAYLOAD_BLOCK_SIZE bytes
+ */
+#ifndef EVENT_INLINE_PAYLOAD_SIZE
+#define EVENT_INLINE_PAYLOAD_SIZE 16
+#endif
+
+#ifndef EVENT_PAYLOAD_BLOCK_SIZE
+#define EVENT_PAYLOAD_BLOCK_SIZE 128
+#endif
+
+#ifndef EVENT_PAYLOAD_BLOCKS
+#define EVENT_PAYLOAD_BLOCKS 8
+#endif
+
+/**
+ * @brief Events posted from interrupts are buffered in a lock-free ring and delivered by a dispatcher task
+ * The ring size must be a power of two. Posts made while the ring is full are dropped and counted.
+ */
+#ifndef EVENT_ISR_RING_SIZE
+#define EVENT_ISR_RING_SIZE 32
+#endif
+
+#ifndef EVENT_DISPATCH_STACK_SIZE
+#define EVENT_DISPATCH_STACK_SIZE 512 ///< Stack size of the EventManager dispatcher task in words
+#endif
+
+#ifndef EVENT_DISPATCH_PRIORITY
+#define EVENT_DISPATCH_PRIORITY (configMAX_PRIORITIES - 1) ///< Dispatcher task priority, highest so ISR events are delivered promptly
+#endif
+
+#ifndef TIMER_SERVICE_MAX_JOBS
+#define TIMER_SERVICE_MAX_JOBS 32 ///< Pooled TimerService jobs (scheduled events and callbacks)
+#endif
+
+#ifndef TIMER_SERVICE_STACK_SIZE
+#define TIMER_SERVICE_STACK_SIZE 1024 ///< Stack size of the TimerService task in words; scheduled callbacks run on it
+#endif
+
+#ifndef TIMER_SERVICE_PRIORITY
+#define TIMER_SERVICE_PRIORITY (configMAX_PRIORITIES - 2) ///< TimerService task priority, just below the event dispatcher
+#endif
+
 /**
  * @brief This setting defines the retry timeout for WiFi connection
  * The default is 15000 ms (15 seconds)
@@ -77,6 +138,38 @@
 #ifndef MULTIPART_UPLOAD_PATH
 #define MULTIPART_UPLOAD_PATH "/uploads"
 #endif
+#ifndef MULTIPART_MAX_FIELD_SIZE
+#define MULTIPART_MAX_FIELD_SIZE 256 ///< Longest form field value kept by MultipartParser
+#endif
+
+/**
+ * @brief Indentation used by JsonService when saving text JSON files
+ * -1 writes compact JSON (smallest files, fastest to write), 2 pretty-prints
+ */
+#ifndef JSON_SERVICE_INDENT
+#define JSON_SERVICE_INDENT -1
+#endif
+
+/**
+ * @brief Pooled allocation for framework JSON documents
+ * When 1, JsonService and FrameworkModel store their documents in size-class slabs
+ * (see JsonPool.h) and each HTTP request gets a scratch arena for ScratchJson values
+ */
+#ifndef FRAMEWORK_JSON_POOL
+#define FRAMEWORK_JSON_POOL 0
+#endif
+
+#ifndef JSON_POOL_SLAB_SIZE
+#define JSON_POOL_SLAB_SIZE 1024 ///< Bytes taken from the heap each time a JSON size class runs dry
+#endif
+
+#ifndef JSON_SCRATCH_SIZE
+#define JSON_SCRATCH_SIZE 4096 ///< Default JsonScratch arena size for ScratchJson documents
+#endif
+
+#ifndef JSON_SCRATCH_TLS_INDEX
+#define JSON_SCRATCH_TLS_INDEX 2 ///< FreeRTOS thread local storage slot holding the task's scratch arena (FAT uses 1)
+#endif
 
 // Note that files of any length can be streamed from the server or uploaded multipart. 
 // This is just the maximum size of the HTTP body that can be processed in one go.
@@ -99,10 +192,58 @@
 #define HTTP_RECEIVE_TIMEOUT 2000 ///< Timeout for receiving HTTP data in milliseconds
 #endif
 
+/**
+ * @brief Idle keep-alive connections held by HttpClient for reuse (0 closes every connection)
+ * Each idle TLS connection keeps its mbedTLS session and buffers, so keep this small
+ */
+#ifndef HTTP_CLIENT_POOL_SIZE
+#define HTTP_CLIENT_POOL_SIZE 2
+#endif
+
+#ifndef HTTP_CLIENT_POOL_PER_HOST
+#define HTTP_CLIENT_POOL_PER_HOST 1 ///< Idle connections held for any one host and port
+#endif
+
+#ifndef HTTP_CLIENT_KEEPALIVE_MS
+#define HTTP_CLIENT_KEEPALIVE_MS 15000 ///< Close a pooled connection idle for longer than this
+#endif
+
 #ifndef HTTP_BUFFER_SIZE
 #define HTTP_BUFFER_SIZE 1460 ///< Size of the HTTP buffer for request/response data
 #endif
 
+/**
+ * @brief Output buffer used by JsonStreamWriter
+ * Responses that fit are sent with Content-Length, larger ones are flushed as chunks of this size
+ */
+#ifndef JSON_STREAM_BUFFER_SIZE
+#define JSON_STREAM_BUFFER_SIZE 512
+#endif
+
+#ifndef JSON_STREAM_MAX_DEPTH
+#define JSON_STREAM_MAX_DEPTH 16 ///< Maximum object/array nesting for JsonStreamWriter
+#endif
+
+/**
+ * @brief Entries per page of /api/v1/ls
+ * A request may ask for fewer or more with ?limit=, up to LIST_DIRECTORY_MAX_PAGE_SIZE
+ */
+#ifndef LIST_DIRECTORY_PAGE_SIZE
+#define LIST_DIRECTORY_PAGE_SIZE 64
+#endif
+
+#ifndef LIST_DIRECTORY_MAX_PAGE_SIZE
+#define LIST_DIRECTORY_MAX_PAGE_SIZE 256 ///< Largest ?limit= honoured by /api/v1/ls
+#endif
+
+#ifndef HTML_TEMPLATE_BUFFER_SIZE
+#define HTML_TEMPLATE_BUFFER_SIZE 512 ///< Staging buffer used when streaming a rendered template
+#endif
+
+#ifndef HTML_TEMPLATE_CACHE_ENTRIES
+#define HTML_TEMPLATE_CACHE_ENTRIES 8 ///< Maximum number of compiled file templates kept in memory
+#endif
+
 // === Framework configuration file ===
 // This file contains various configuration settings for the framework.
 #ifndef STREAM_SEND_DELAY_MS
@@ -130,6 +271,140 @@
 #define GPIO_EVENT_HANDLING GPIO_EVENTS_AND_NOTIFICATIONS
 #endif
 
+#ifndef GPIO_DEBOUNCE_DEFAULT_US
+#define GPIO_DEBOUNCE_DEFAULT_US 0 ///< Initial debounce window for every pin (0 = off), see GpioEventManager::setDebounce
+#endif
+
+// === Storage ===
+#ifndef FILE_READER_BUFFER_SIZE
+#define FILE_READER_BUFFER_SIZE 512 ///< Read-ahead buffer per open StorageFileReader
+#endif
+#ifndef STORAGE_STAT_CACHE_ENTRIES
+#define STORAGE_STAT_CACHE_ENTRIES 8 ///< Paths whose stat results LittleFsStorageManager keeps (at least 1)
+#endif
+#ifndef RAM_STORAGE_BUDGET
+#define RAM_STORAGE_BUDGET (16 * 1024) ///< Default byte budget (contents and names) of a RamStorageManager
+#endif
+#ifndef FATFS_IO_BUFFER_SIZE
+#define FATFS_IO_BUFFER_SIZE 4096 ///< SD transfer size for FatFs streaming and writers (a multiple of 512)
+#endif
+#ifndef FATFS_APPEND_HOLD_MS
+#define FATFS_APPEND_HOLD_MS 1000 ///< How long FatFs appendToFile() keeps the file open for more appends, 0 = close every time
+#endif
+#ifndef FATFS_APPEND_CLOSER_STACK_SIZE
+#define FATFS_APPEND_CLOSER_STACK_SIZE 1024 ///< Stack in words of the task that closes a held append file (created on first append)
+#endif
+#ifndef FATFS_APPEND_CLOSER_PRIORITY
+#define FATFS_APPEND_CLOSER_PRIORITY (tskIDLE_PRIORITY + 1) ///< Priority of the task that closes a held append file
+#endif
+
+// Storage cache: AppContext puts a CachingStorageManager in front of the storage when the budget is set
+#ifndef STORAGE_CACHE_BUDGET
+#define STORAGE_CACHE_BUDGET 0 ///< Bytes of cached contents and names, 0 = no cache
+#endif
+#ifndef STORAGE_CACHE_MAX_FILE_SIZE
+#define STORAGE_CACHE_MAX_FILE_SIZE 4096 ///< Largest file cached whole; also the most appended data held per file
+#endif
+#ifndef STORAGE_CACHE_WRITE_BACK_RETRIES
+#define STORAGE_CACHE_WRITE_BACK_RETRIES 3 ///< Failed write-backs in a row before cached data is discarded
+#endif
+#ifndef STORAGE_CACHE_FLUSH_INTERVAL_MS
+#define STORAGE_CACHE_FLUSH_INTERVAL_MS 5000 ///< Longest written data waits in RAM, 0 = only on flush() or eviction
+#endif
+#ifndef STORAGE_CACHE_STACK_SIZE
+#define STORAGE_CACHE_STACK_SIZE 512 ///< Stack size of the write-back task in words
+#endif
+#ifndef STORAGE_CACHE_PRIORITY
+#define STORAGE_CACHE_PRIORITY (tskIDLE_PRIORITY + 1) ///< Write-back task priority
+#endif
+
+// Uploads and downloads are written through StreamingFileWriter: two block buffers, one being
+// filled from the network while a writer task programs the other
+#ifndef STREAM_WRITER_BLOCK_SIZE
+#define STREAM_WRITER_BLOCK_SIZE 2048 ///< Size of each of the two buffers per transfer
+#endif
+#ifndef STREAM_WRITER_QUEUE_LENGTH
+#define STREAM_WRITER_QUEUE_LENGTH 4 ///< Transfers that can have a block waiting for the writer task at once
+#endif
+#ifndef STREAM_WRITER_STACK_SIZE
+#define STREAM_WRITER_STACK_SIZE 1024 ///< Stack size of the file writer task in words
+#endif
+#ifndef STREAM_WRITER_PRIORITY
+#define STREAM_WRITER_PRIORITY 4 ///< File writer task priority, same as the HTTP client handler tasks
+#endif
+
+// On multicore builds LittleFS programs and erases go through FlashOpService: a task pinned to
+// one core that batches contiguous page programs into fewer flash_safe_execute() calls
+#ifndef FLASH_OP_BATCH_SIZE
+#define FLASH_OP_BATCH_SIZE 1024 ///< Bytes of page programs collected before writing (multiple of FLASH_PAGE_SIZE)
+#endif
+#ifndef FLASH_OP_QUEUE_LENGTH
+#define FLASH_OP_QUEUE_LENGTH 2 ///< Operations that can wait for the flash task
+#endif
+#ifndef FLASH_OP_STACK_SIZE
+#define FLASH_OP_STACK_SIZE 512 ///< Stack size of the flash task in words
+#endif
+#ifndef FLASH_OP_PRIORITY
+#define FLASH_OP_PRIORITY (configMAX_PRIORITIES - 3) ///< Flash task priority, callers are blocked until it runs
+#endif
+#ifndef FLASH_OP_CORE
+#define FLASH_OP_CORE 1 ///< Core the flash task is pinned to (needs configUSE_CORE_AFFINITY)
+#endif
+#ifndef FLASH_OP_NOTIFY_INDEX
+#define FLASH_OP_NOTIFY_INDEX 3 ///< Task notification index callers wait on (Tcp uses 0-2)
+#endif
+#ifndef FLASH_OP_TIMEOUT_MS
+#define FLASH_OP_TIMEOUT_MS 1000 ///< flash_safe_execute() timeout for pausing the other core
+#endif
+
+// KvStore: log-structured key-value store on a raw flash partition. The partition is reserved by
+// framework_application.cmake (KV_PARTITION_SIZE), which defines the offset and size; 0 disables it
+#ifndef KV_STORE_FLASH_OFFSET
+#define KV_STORE_FLASH_OFFSET 0 ///< Partition start from the beginning of flash, sector aligned
+#endif
+#ifndef KV_STORE_FLASH_SIZE
+#define KV_STORE_FLASH_SIZE 0 ///< Partition size in bytes (at least 3 sectors), 0 = no KvStore
+#endif
+#ifndef KV_STORE_MAX_KEY_LEN
+#define KV_STORE_MAX_KEY_LEN 32 ///< Longest key in bytes (at most 254)
+#endif
+#ifndef KV_STORE_MAX_VALUE_LEN
+#define KV_STORE_MAX_VALUE_LEN 1024 ///< Longest value in bytes (at most 4040 - KV_STORE_MAX_KEY_LEN)
+#endif
+#ifndef KV_STORE_STACK_SIZE
+#define KV_STORE_STACK_SIZE 512 ///< Stack size of the background compaction task in words
+#endif
+#ifndef KV_STORE_PRIORITY
+#define KV_STORE_PRIORITY (tskIDLE_PRIORITY + 1) ///< Compaction task priority
+#endif
+
+// === Log file writer (Logger and DebugTrace file output) ===
+// Lines are buffered in RAM and appended by a low-priority task in blocks, see LogSink
+#ifndef LOG_SINK_BUFFER_SIZE
+#define LOG_SINK_BUFFER_SIZE 2048 ///< Heap buffer per log file, taken when it is opened; lines that don't fit are dropped and counted
+#endif
+#ifndef LOG_SINK_FLUSH_BYTES
+#define LOG_SINK_FLUSH_BYTES 512 ///< Block size of each append, and the fill level that wakes the writer early
+#endif
+#ifndef LOG_SINK_FLUSH_INTERVAL_MS
+#define LOG_SINK_FLUSH_INTERVAL_MS 2000 ///< Longest a buffered line waits before being written
+#endif
+#ifndef LOG_SINK_MAX_SINKS
+#define LOG_SINK_MAX_SINKS 2 ///< Log files that can be open at once (Logger and trace)
+#endif
+#ifndef LOG_FILE_MAX_SIZE
+#define LOG_FILE_MAX_SIZE (32 * 1024) ///< Rotate a log file once it would exceed this size (0 = never)
+#endif
+#ifndef LOG_FILE_MAX_FILES
+#define LOG_FILE_MAX_FILES 2 ///< Rotated copies kept (<path>.1 .. <path>.N)
+#endif
+#ifndef LOG_WRITER_STACK_SIZE
+#define LOG_WRITER_STACK_SIZE 1024 ///< Stack size of the log writer task in words (created when a log file is first opened)
+#endif
+#ifndef LOG_WRITER_PRIORITY
+#define LOG_WRITER_PRIORITY (tskIDLE_PRIORITY + 1) ///< Log writer task priority
+#endif
+
 // === Debug Trace Configuration ===
 
 //#define QUIET_MODE ///< Set to disable all normal behavior print output, don't define to print
@@ -152,6 +427,15 @@
 #ifndef TRACE_USE_SD
 #define TRACE_USE_SD              0   ///< Set to 1 to use SD card for trace output, 0 for UART
 #endif
+#ifndef TRACE_DEFERRED
+#define TRACE_DEFERRED            0   ///< Set to 1 to record binary traces for tools/trace_decode.py instead of formatting text
+#endif
+#ifndef TRACE_DEFERRED_BUFFER_SIZE
+#define TRACE_DEFERRED_BUFFER_SIZE 2048 ///< RAM ring for deferred records when tracing to the console
+#endif
+#ifndef TRACE_DEFERRED_MAX_STRING
+#define TRACE_DEFERRED_MAX_STRING 24  ///< Bytes of each %s argument kept in a deferred record
+#endif
 
 //#define LFS_TRACE_YES // set to enable LittleFS trace output, comment out to disable
 
@@ -180,6 +464,9 @@
 #ifndef TRACE_FrameworkManager
 #define TRACE_FrameworkManager    0
 #endif
+#ifndef TRACE_HtmlTemplate
+#define TRACE_HtmlTemplate        0
+#endif
 #ifndef TRACE_HttpClient
 #define TRACE_HttpClient          0
 #endif
@@ -207,9 +494,15 @@
 #ifndef TRACE_JsonRequestHelper
 #define TRACE_JsonRequestHelper   0
 #endif
+#ifndef TRACE_JsonStreamWriter
+#define TRACE_JsonStreamWriter    0
+#endif
 #ifndef TRACE_JsonService
 #define TRACE_JsonService         0
 #endif
+#ifndef TRACE_KvStore
+#define TRACE_KvStore             0
+#endif
 #ifndef TRACE_JwtAuthenticator
 #define TRACE_JwtAuthenticator    0
 #endif
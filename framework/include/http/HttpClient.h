@@ -1,7 +1,14 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
 #include "HttpRequest.h"
 #include "HttpResponse.h"
 
+class Tcp;
+
 /// @cond INTERNAL
 class HttpClient {
 public:
@@ -12,5 +19,12 @@ private:
 
     bool sendRequest(const HttpRequest& request, HttpResponse& response); // common helper
 
+    /// Open a new connection to the request's host
+    static std::unique_ptr<Tcp> connect(const HttpRequest& request, uint16_t port, bool useTls);
+
+    /// How long the connection may be kept for the next request once the body is read, 0 to close it
+    static uint32_t keepAliveMs(const std::string& rawHeader, const std::map<std::string, std::string>& headers,
+                                bool noBody, size_t leftover);
+
 };
-/// @endcond
\ No newline at end of file
+/// @endcond
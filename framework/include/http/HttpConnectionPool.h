@@ -0,0 +1,115 @@
+/**
+ * @file HttpConnectionPool.h
+ * @author Ian Archbell
+ * @brief Idle keep-alive connections kept by HttpClient for reuse.
+ *
+ * Part of the PicoFramework HTTP client.
+ * Opening a connection costs a DNS lookup, a TCP handshake and, for https, a TLS handshake
+ * that takes far longer than the request itself on an RP2040. HttpClient asks for
+ * "Connection: keep-alive", and once a response has been read in full hands the connection
+ * back here; the next request to the same host takes it instead of connecting again.
+ *
+ * At most HTTP_CLIENT_POOL_SIZE connections are held, HTTP_CLIENT_POOL_PER_HOST for any one
+ * host, and none for longer than HTTP_CLIENT_KEEPALIVE_MS or the server's own keep-alive
+ * timeout. Expired connections are closed whenever the pool is used, or by evictIdle().
+ *
+ * @version 0.1
+ * @date 2025-04-22
+ * @license MIT License
+ * @copyright Copyright (c) 2025, Ian Archbell
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <FreeRTOS.h>
+#include <semphr.h>
+#include "network/Tcp.h"
+#include "framework_config.h"
+
+/**
+ * @brief Process-wide set of idle client connections, keyed by host, port and TLS settings.
+ *
+ * A connection is owned by one request at a time: acquire() removes it from the pool and
+ * release() puts it back.
+ */
+class HttpConnectionPool
+{
+public:
+    /// @brief What a connection was opened to; only an exact match is reused
+    struct Key
+    {
+        std::string host;   ///< Host name as connected (and sent for SNI)
+        uint16_t port;      ///< Server port
+        bool tls;           ///< https
+        std::string rootCa; ///< Root CA the server was verified against, compared in full
+
+        bool operator==(const Key &other) const
+        {
+            return port == other.port && tls == other.tls && host == other.host && rootCa == other.rootCa;
+        }
+    };
+
+    /**
+     * @brief Access the singleton instance.
+     */
+    static HttpConnectionPool &instance();
+
+    /**
+     * @brief Take the most recently used idle connection for @p key.
+     *
+     * Connections the server has closed, or that have unread data, are closed and skipped.
+     * @return The connection, or null if a new one must be opened.
+     */
+    std::unique_ptr<Tcp> acquire(const Key &key);
+
+    /**
+     * @brief Hold a connection whose last response was read in full.
+     *
+     * If the host or pool limit is reached, the connection idle longest is closed to make room.
+     * @param key What the connection was opened to.
+     * @param socket The connection.
+     * @param keepAliveMs How long it may stay idle (0 closes it now).
+     */
+    void release(const Key &key, std::unique_ptr<Tcp> socket, uint32_t keepAliveMs);
+
+    /**
+     * @brief Close connections idle longer than their keep-alive time.
+     */
+    void evictIdle();
+
+    /**
+     * @brief Close every idle connection, e.g. before the network goes down.
+     */
+    void clear();
+
+    /**
+     * @brief Number of idle connections held.
+     */
+    size_t size();
+
+private:
+    HttpConnectionPool();
+    HttpConnectionPool(const HttpConnectionPool &) = delete;
+    HttpConnectionPool &operator=(const HttpConnectionPool &) = delete;
+
+    struct Idle
+    {
+        Key key;
+        std::unique_ptr<Tcp> socket;
+        TickType_t since;     ///< When it was released
+        TickType_t keepAlive; ///< How long it may stay idle
+    };
+
+    /// Move expired connections to @p closing. Called with lock_ held.
+    void takeExpired(TickType_t now, std::vector<std::unique_ptr<Tcp>> &closing);
+
+    std::vector<Idle> idle_; ///< Oldest first
+
+    SemaphoreHandle_t lock_ = nullptr;
+    StaticSemaphore_t lockBuffer_;
+};
@@ -15,6 +15,7 @@
 
 #include <string>
 #include <vector>
+#include <functional>
 
 #include "http/HttpRequest.h"
 #include "http/HttpResponse.h"
@@ -44,6 +45,19 @@ public:
      */
     bool listDirectory(const std::string& path, std::vector<FileInfo>& out);
 
+    /**
+     * @brief Visit a window of a directory's entries without building a list.
+     * @param path Directory path to list.
+     * @param cursor Where to start: 0, or a previous @p next (see StorageManager::forEachDirectoryEntry).
+     * @param limit Most entries to visit (0 = all).
+     * @param visitor Called per entry; return false to stop.
+     * @param next If not null, receives the cursor for the first entry not consumed.
+     * @return false if the directory could not be read.
+     */
+    bool forEachDirectoryEntry(const std::string& path, uint32_t cursor, size_t limit,
+                               const std::function<bool(const FileInfo&)>& visitor,
+                               uint32_t* next = nullptr);
+
     /**
      * @brief Serve a file to the client via the HttpResponse object.
      * @param res HTTP response object.
@@ -82,6 +96,12 @@ public:
 
     /**
      * @brief Handle requests to list directory contents.
+     *
+     * `?limit=N` caps a page at N entries (default LIST_DIRECTORY_PAGE_SIZE, at most
+     * LIST_DIRECTORY_MAX_PAGE_SIZE). The response's `nextCursor` is an opaque token passed back
+     * as `?cursor=` to fetch the next page, and is null on the last one. On LittleFS it is a
+     * directory position the next page seeks to directly; backends that can't seek fall back
+     * to an entry count. A directory changed between pages may skip or repeat entries.
      * @param req The HTTP request object.
      * @param res The HTTP response object.
      * @param params Route parameters (unused).
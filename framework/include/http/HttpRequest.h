@@ -274,14 +274,13 @@ public:
     /**
      * @brief Safely parse the request body as JSON (non-throwing).
      *
-     * Returns an empty object if parsing fails.
+     * The body is parsed once on first access and the result is cached on the request,
+     * so repeated calls (and JsonRequestHelper lookups) do not re-parse it. The cache is
+     * dropped whenever the body changes.
      *
-     * @return nlohmann::json Parsed JSON object or empty on failure.
+     * @return Parsed JSON document, or a discarded value if parsing failed.
      */
-    inline nlohmann::json json() const
-    {
-        return nlohmann::json::parse(getBody(), nullptr, false);
-    }
+    const nlohmann::json &json() const;
 
     // ─────────────────────────────────────────────────────────────────────────────
     // Method / URL / Path Accessors
@@ -474,6 +473,9 @@ private:
     size_t headerEnd = 0;
     bool bodyTruncated = false;
     std::string outputFilePath;
+
+    mutable nlohmann::json parsedBody;  ///< Cached result of json()
+    mutable bool bodyParsed = false;    ///< True once parsedBody reflects body
 };
 
 #endif // HTTPREQUEST_H
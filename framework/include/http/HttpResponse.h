@@ -178,10 +178,41 @@ public:
     void writeChunk(const char *data, size_t length);
 
     /**
-     * @brief Finish the response (placeholder for potential finalization).
+     * @brief Begin a chunked response (Transfer-Encoding: chunked) by sending headers.
+     *
+     * Used when the body length is not known up front. Follow with sendChunk()
+     * calls and terminate with finish().
+     *
+     * @param code HTTP status code.
+     * @param contentType MIME type.
+     */
+    void startChunked(int code, const std::string &contentType = "application/json");
+
+    /**
+     * @brief Send one chunk of a chunked response, framed with its hex length.
+     * @param data Pointer to data buffer.
+     * @param length Size of the data (zero-length chunks are skipped).
+     */
+    void sendChunk(const char *data, size_t length);
+
+    /**
+     * @brief Finish the response. Sends the terminating chunk for chunked responses.
      */
     void finish();
 
+    /**
+     * @brief Abandon a response whose body can't be completed by closing the connection.
+     *
+     * No terminating chunk is sent, so the client sees the body as truncated rather than
+     * complete.
+     */
+    void abort();
+
+    /**
+     * @brief Check whether the response is using chunked transfer encoding.
+     */
+    bool isChunked() const { return chunked; }
+
     // ------------------------------------------------------------------------
     // Common Helpers
     // ------------------------------------------------------------------------
@@ -221,6 +252,14 @@ public:
      * @return Reference to this HttpResponse object.
      */
     HttpResponse &json(const std::string &jsonString);
+
+    /**
+     * @brief Send a JSON object, streamed through a JsonStreamWriter without a dump() string.
+     *
+     * Documents nested deeper than JSON_STREAM_MAX_DEPTH are sent from dump() instead.
+     * @param jsonObj JSON value to send.
+     * @return Reference to this HttpResponse object.
+     */
     HttpResponse &json(const nlohmann::json &jsonObj);
     HttpResponse &jsonFormatted(const nlohmann::json &jsonObj);
 
@@ -346,6 +385,7 @@ private:
     Tcp *tcp;                ///< Pointer to the Tcp object for socket operations
     int status_code = 200;   ///< HTTP status code
     bool headerSent = false; ///< Tracks whether headers have already been sent
+    bool chunked = false;    ///< True once startChunked() has been called
     bool bodyTruncated = false;
 
     std::map<std::string, std::string> headers; ///< Response headers (server+client)
@@ -11,11 +11,30 @@
  #pragma once
 
  #include <string>
+ #include <variant>
+ #include <initializer_list>
  #include <nlohmann/json.hpp>
  
  using json = nlohmann::json;
  
  class HttpRequest;
+
+ /**
+  * @brief Destination for a field filled by JsonRequestHelper::extract().
+  */
+ using JsonFieldTarget = std::variant<std::string *, int *, double *, bool *, json *>;
+
+ /**
+  * @brief One field to extract: a path and where to store its value.
+  *
+  * The path is either a JSON pointer ("/user/name", "/zones/0") or a
+  * dot-separated key path ("user.name").
+  */
+ struct JsonField
+ {
+     const char *path;
+     JsonFieldTarget target;
+ };
  
  /**
   * @brief Utility class for working with JSON content in HTTP requests.
@@ -74,6 +93,34 @@
       */
      static bool getBool(const HttpRequest& req, const std::string& key, bool def = false);
  
+     /**
+      * @brief Locate a value in the request body without copying it.
+      *
+      * Uses the JSON document cached on the request, so the body is parsed at most once.
+      *
+      * @param req The incoming request object.
+      * @param path JSON pointer ("/a/b") or dot-separated path ("a.b").
+      * @return Pointer into the cached document, or nullptr if not found.
+      */
+     static const json *find(const HttpRequest& req, const std::string& path);
+
+     /**
+      * @brief Fill several fields from the request body in one call.
+      *
+      * Each target is only written if the value exists and has a matching type
+      * (any value converts to std::string as for getString(), any value to json).
+      *
+      * @code
+      * std::string name; int pin = 0; bool active = false;
+      * JSON::extract(req, {{"/name", &name}, {"/gpioPin", &pin}, {"/active", &active}});
+      * @endcode
+      *
+      * @param req HttpRequest containing JSON body.
+      * @param fields Paths and destinations.
+      * @return Number of fields that were found and assigned.
+      */
+     static size_t extract(const HttpRequest& req, std::initializer_list<JsonField> fields);
+
      /**
       * @brief Parse and return the full JSON body from the request.
       * @param req The HTTP request object.
@@ -99,11 +146,11 @@
  
  private:
      /**
-      * @brief Parse the raw body into a JSON object.
+      * @brief Get the cached body document, or nullptr if the request is not JSON.
       * @param req HttpRequest containing JSON body.
-      * @return Parsed JSON object, or `{}` on failure.
+      * @return Parsed document owned by the request.
       */
-     static json parseJsonBody(const HttpRequest& req);
+     static const json *document(const HttpRequest& req);
  };
 
  /// @brief Shorthand macro for JsonRequestHelper static methods.
@@ -0,0 +1,171 @@
+/**
+ * @file JsonStreamWriter.h
+ * @author Ian Archbell
+ * @brief SAX-style JSON writer that streams a response body straight to the connection.
+ *
+ * Part of the PicoFramework HTTP server.
+ * Values are escaped into a small fixed buffer which is flushed to the client as it fills,
+ * so large arrays never exist as a nlohmann::json tree plus a dump() string at the same time.
+ * If the whole document fits in the buffer it is sent as a normal Content-Length response,
+ * otherwise the response switches to chunked transfer encoding on the first flush.
+ *
+ * @version 0.1
+ * @date 2025-04-04
+ * @license MIT License
+ * @copyright Copyright (c) 2025, Ian Archbell
+ */
+
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <nlohmann/json.hpp>
+#include "framework_config.h"
+#include "json/JsonPool.h"
+
+class HttpResponse;
+
+/**
+ * @brief Streams JSON to an HttpResponse using begin/end, key and value calls.
+ *
+ * Example:
+ * @code
+ * JsonStreamWriter w(res);
+ * w.beginObject().key("items").beginArray();
+ * for (auto &zone : zones) w.value(zone);
+ * w.endArray().endObject().end();
+ * @endcode
+ *
+ * Commas and quoting are handled by the writer. Nesting deeper than
+ * JSON_STREAM_MAX_DEPTH marks the writer as failed: later output is discarded and end()
+ * sends a 500 instead, or, if part of the body has already been streamed, closes the
+ * connection without completing it.
+ */
+class JsonStreamWriter
+{
+public:
+    /**
+     * @brief Construct a writer for a response. Nothing is sent until the buffer fills or end() is called.
+     * @param res Response to write to.
+     * @param statusCode HTTP status code to send.
+     */
+    explicit JsonStreamWriter(HttpResponse &res, int statusCode = 200);
+
+    /**
+     * @brief Finishes the response if end() was not called.
+     */
+    ~JsonStreamWriter();
+
+    JsonStreamWriter(const JsonStreamWriter &) = delete;
+    JsonStreamWriter &operator=(const JsonStreamWriter &) = delete;
+
+    /// @brief Open an object ("{").
+    JsonStreamWriter &beginObject();
+
+    /// @brief Close the current object ("}").
+    JsonStreamWriter &endObject();
+
+    /// @brief Open an array ("[").
+    JsonStreamWriter &beginArray();
+
+    /// @brief Close the current array ("]").
+    JsonStreamWriter &endArray();
+
+    /**
+     * @brief Write an object member name. Must be followed by a value or begin call.
+     * @param name Member name (escaped as needed).
+     */
+    JsonStreamWriter &key(const char *name);
+    JsonStreamWriter &key(const std::string &name) { return key(name.c_str()); }
+
+    /// @brief Write a string value.
+    JsonStreamWriter &value(const char *str);
+    JsonStreamWriter &value(const std::string &str);
+
+    /// @brief Write a boolean value.
+    JsonStreamWriter &value(bool b);
+
+    /// @brief Write an integer value.
+    JsonStreamWriter &value(int v) { return signedValue(v); }
+    JsonStreamWriter &value(unsigned int v) { return unsignedValue(v); }
+    JsonStreamWriter &value(long v) { return signedValue(v); }
+    JsonStreamWriter &value(unsigned long v) { return unsignedValue(v); }
+    JsonStreamWriter &value(long long v) { return signedValue(v); }
+    JsonStreamWriter &value(unsigned long long v) { return unsignedValue(v); }
+
+    /// @brief Write a floating point value (non-finite values are written as null).
+    JsonStreamWriter &value(double d);
+
+    /// @brief Write a null value.
+    JsonStreamWriter &value(std::nullptr_t);
+
+    /**
+     * @brief Stream an existing nlohmann::json value without building its dump() string.
+     * @param j Value to write (objects and arrays are walked recursively).
+     */
+    JsonStreamWriter &value(const nlohmann::json &j);
+
+    /**
+     * @brief Stream a PooledJson or ScratchJson value (see JsonPool.h).
+     */
+    template <typename BasicJson,
+              typename std::enable_if<nlohmann::detail::is_basic_json<BasicJson>::value &&
+                                          !std::is_same<BasicJson, nlohmann::json>::value,
+                                      int>::type = 0>
+    JsonStreamWriter &value(const BasicJson &j) { return jsonValue(j); }
+
+    /**
+     * @brief Write pre-serialized JSON verbatim as the next value.
+     * @param json Valid JSON text.
+     * @param length Length of the text.
+     */
+    JsonStreamWriter &rawValue(const char *json, size_t length);
+
+    /**
+     * @brief Flush remaining output and complete the response.
+     *
+     * If the writer has failed, sends a 500 error, or aborts the connection once streaming
+     * has started, so a truncated document is never delivered as a complete one.
+     */
+    void end();
+
+    /**
+     * @brief True unless nesting was exceeded or the writer was misused.
+     */
+    bool ok() const { return !failed; }
+
+    /**
+     * @brief Total number of body bytes produced so far.
+     */
+    size_t bytesWritten() const { return total; }
+
+private:
+    JsonStreamWriter &signedValue(long long v);
+    JsonStreamWriter &unsignedValue(unsigned long long v);
+
+    template <typename BasicJson>
+    JsonStreamWriter &jsonValue(const BasicJson &j);
+
+    void beginValue();
+    void open(char c);
+    void close(char c);
+    void write(const char *data, size_t length);
+    void put(char c);
+    void writeString(const char *str, size_t length);
+    void flush();
+
+    HttpResponse &res;
+    int statusCode;
+
+    char buffer[JSON_STREAM_BUFFER_SIZE]; ///< Output staging buffer
+    size_t used = 0;                      ///< Bytes currently in buffer
+    size_t total = 0;                     ///< Bytes produced overall
+
+    uint8_t depth = 0;                     ///< Current nesting depth
+    bool needComma[JSON_STREAM_MAX_DEPTH + 1] = {}; ///< Per-level "a value was already written" flag
+    bool afterKey = false;                 ///< A key was written and awaits its value
+    bool started = false;                  ///< Chunked response headers have been sent
+    bool ended = false;
+    bool failed = false;
+};
@@ -4,11 +4,12 @@
  * @brief Parser for handling multipart/form-data file uploads.
  * Part of the PicoFramework HTTP server.
  * This module provides the MultipartParser class, which is responsible for
- * processing multipart/form-data uploads over HTTP. It handles detecting
- * boundaries, parsing headers, extracting filenames, and writing file data
- * to storage (e.g., an SD card). It also sends appropriate HTTP responses
- * based on the success or failure of the upload process.
- * @version 0.1
+ * processing multipart/form-data uploads over HTTP. It streams the body through
+ * a fixed window buffer, finds part delimiters with a Boyer-Moore-Horspool search,
+ * parses part headers, writes file parts to storage (e.g., an SD card) and collects
+ * form fields. It also sends appropriate HTTP responses based on the success or
+ * failure of the upload process.
+ * @version 0.2
  * @date 2025-03-26
  *
  * @license MIT License
@@ -18,36 +19,37 @@
 #define MULTIPART_PARSER_HPP
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <unordered_map>
+#include <vector>
+#include "framework_config.h"
 #include "http/HttpRequest.h"
 #include "network/Tcp.h"
-
-enum State
-{
-    SEARCHING_FOR_BOUNDARY,
-    FOUND_BOUNDARY,
-    FOUND_DATA_START,
-    COMPLETE
-};
+#include "storage/StreamingFileWriter.h"
 
 /**
  * @brief Parses and processes multipart/form-data uploads over HTTP.
  *
  * MultipartParser is responsible for:
  * - Detecting boundaries and parsing multipart headers
- * - Extracting uploaded filenames
- * - Writing uploaded file data to SD or other storage
+ * - Writing each uploaded file part to MULTIPART_UPLOAD_PATH
+ * - Collecting the values of non-file form fields
  * - Sending appropriate HTTP responses
+ *
+ * Data is received straight into a fixed window. The delimiter search never
+ * rescans bytes it has already ruled out, and a delimiter split across two reads is
+ * found once the rest arrives; only that partial delimiter is ever moved. File data
+ * goes from the window to a StreamingFileWriter, which programs one block while the
+ * next is being received.
+ *
+ * Holds the receive window and the writer's buffers, so allocate it on the heap.
  */
 class MultipartParser
 {
 public:
     /**
      * @brief Construct a new Multipart Parser object.
-     *
-     * @param clientSocket The socket for the HTTP client connection.
-     * @param request The full HTTP request object.
      */
     MultipartParser();
 
@@ -55,10 +57,10 @@ public:
      * @brief Begin processing the multipart upload from the socket.
      *
      * This method reads from the client socket in chunks, processes headers and boundaries,
-     * and writes file contents to storage.
+     * writes file contents to storage and sends the response.
      *
      * @return true if upload succeeds.
-     * @return false on failure (mazlformed request, existing file, or write error).
+     * @return false on failure (malformed request, existing file, or write error).
      */
     bool handleMultipart(HttpRequest& req, HttpResponse& res); // external interface for handling multipart uploads
 
@@ -68,66 +70,129 @@ public:
      */
     void setBoundaryFromContentType(const std::string& contentType);
 
+    /**
+     * @brief Set the boundary and reset the window ready for a new body.
+     * handleMultipart() calls this; a body can also be fed directly, without a
+     * connection, in which case failures are only reported by feed().
+     * @param contentType The Content-Type header value.
+     * @return false if there is no usable boundary.
+     */
+    bool begin(const std::string& contentType);
+
+    /**
+     * @brief Copy body bytes into the window, processing as it fills.
+     * @return false if the upload failed.
+     */
+    bool feed(const char* data, size_t len);
+
+    /**
+     * @brief True once the closing delimiter has been received.
+     */
+    bool isComplete() const { return state == State::Complete; }
+
+    /**
+     * @brief Form fields (parts without a filename) received, by name.
+     * Values longer than MULTIPART_MAX_FIELD_SIZE are truncated.
+     */
+    const std::unordered_map<std::string, std::string>& getFields() const { return fields; }
+
+    /**
+     * @brief Storage paths of the files written, in upload order.
+     */
+    const std::vector<std::string>& getFiles() const { return files; }
+
 private:
-    Tcp* tcp; ///< The client TCP connection
+    enum class State
+    {
+        Preamble,       ///< Skipping anything before the first delimiter
+        AfterDelimiter, ///< Deciding between "--" (end) and CRLF (next part)
+        Headers,        ///< Waiting for the blank line ending the part headers
+        Body,           ///< Streaming part content up to the next delimiter
+        Complete,
+        Failed
+    };
+
+    static constexpr size_t MaxBoundary = 70; ///< RFC 2046 limit
+    static constexpr size_t WindowSize = HTTP_BUFFER_SIZE + MaxBoundary + 8;
+
+    Tcp* tcp = nullptr; ///< The client TCP connection
     std::string boundary;
-    std::string filename;
-    std::string leftoverData;
-    std::string buffer;
+    std::string delimiter;        ///< "\r\n--" + boundary
+    uint8_t skip[256];            ///< Boyer-Moore-Horspool bad-character shifts for delimiter
+
+    uint8_t window[WindowSize];   ///< Received bytes not yet consumed
+    size_t start = 0;             ///< First unconsumed byte in window
+    size_t end = 0;               ///< One past the last received byte
+    size_t scanFrom = 0;          ///< Delimiter can't start before this offset
+    State state = State::Preamble;
+    bool responseSent = false;
+
+    std::string filename;         ///< Path of the file part being written, empty for a field
+    StreamingFileWriter writer;   ///< Open on filename while a file part is being received
+    std::string fieldName;        ///< Name of the field part being read
+    std::unordered_map<std::string, std::string> fields;
+    std::vector<std::string> files;
 
+    /**
+     * @brief Advance the state machine over the bytes in the window.
+     * @return false if the upload failed.
+     */
+    bool process();
 
-    static State currentState;
+    /// Move the unconsumed bytes to the front of the window
+    void compact();
 
     /**
-     * @brief Extract the filename from a Content-Disposition header.
-     * @param contentDisposition The raw header line.
-     * @return true if a valid filename is found.
+     * @brief Find the delimiter in window[scanFrom, end) using Boyer-Moore-Horspool.
+     * On a miss, scanFrom is advanced past every position ruled out.
+     * @return Offset in window of the match, or SIZE_MAX if there is none.
      */
-    bool extractFilename(const std::string &contentDisposition);
+    size_t findDelimiter();
 
     /**
-     * @brief Append a chunk of file data to the output file.
-     * @param fileData Data to append.
-     * @return true on success.
+     * @brief Parse one part's header block and start the part.
+     * @param headers Header lines, CRLF separated.
+     * @return false if the part can't be accepted.
      */
-    bool processFileData(const std::string &fileData);
+    bool beginPart(const std::string& headers);
 
     /**
-     * @brief Handle an incoming chunk of multipart data.
-     * @param chunkData The raw data received.
-     * @return true if processing should continue.
+     * @brief Hand part content to the current file or field.
+     * @param data Content bytes.
+     * @param len Bytes available.
+     * @param last True if this is the end of the part.
+     * @return Bytes consumed, or SIZE_MAX on error.
      */
-    bool handleChunk(std::string &chunkData);
+    size_t partData(const uint8_t* data, size_t len, bool last);
 
     /**
-     * @brief Append file data to storage (e.g., SD card).
-     * @param filename Name of the file to write to.
-     * @param data Pointer to raw data.
-     * @param size Length of the data buffer.
-     * @return 0 on success, non-zero on failure.
+     * @brief Extract a parameter such as name or filename from a Content-Disposition header.
+     * @param header The header line.
+     * @param key Parameter name.
+     * @param value Receives the unquoted value.
+     * @return true if the parameter is present.
      */
-    int appendFileToSD(const char *filename, const char *data, size_t size);
+    static bool headerParam(const std::string& header, const char* key, std::string& value);
 
     /**
-     * @brief Check if a file already exists in storage.
-     * @param filename Name of the file to check.
-     * @return 1 if exists, 0 if not.
+     * @brief Check the upload directory and that the target file does not exist yet, then open it.
+     * @param name Filename from the part headers.
+     * @return true if the file is open for writing.
      */
-    int file_exists(const std::string& filename);
+    bool beginFile(const std::string& name);
 
     /**
-     * @brief Find the start of the file content in a chunk (after headers).
-     * @param currentData The buffer containing headers + data.
-     * @return Byte offset of start of data, or -1 if not found.
+     * @brief Queue file data for writing to storage (e.g., SD card).
+     * @param data Pointer to raw data.
+     * @param size Length of the data buffer.
+     * @return true on success.
      */
-    int findDataStart(std::string &currentData);
+    bool processFileData(const uint8_t* data, size_t size);
 
     /**
-     * @brief Detect and handle the final multipart boundary.
-     * @param fileData The current chunk of file data.
-     * @return true if final boundary was found and handled.
+     * @brief Remove a partly written file after a failure.
      */
-    bool handleFinalBoundary(std::string &fileData);
+    void discardFile();
 
     /**
      * @brief Send a simple HTTP response to the client.
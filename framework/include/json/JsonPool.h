@@ -0,0 +1,264 @@
+/**
+ * @file JsonPool.h
+ * @author Ian Archbell
+ * @brief Size-class pool and scratch-arena allocators for nlohmann::json.
+ *
+ * Part of the PicoFramework application framework.
+ * nlohmann::json allocates every object node and array buffer separately. On a small
+ * FreeRTOS heap the resulting mix of short- and long-lived blocks fragments the heap
+ * over time. These allocators keep JSON allocations out of the general heap:
+ *
+ * - JsonPool serves small blocks from per-size-class slabs that are recycled, never
+ *   returned, so the heap only ever sees slab-sized requests.
+ * - JsonScratch is a bump arena for short-lived documents, reset wholesale when the
+ *   JsonScratchScope that activated it ends. A handler that builds a large throwaway
+ *   document binds one for the duration of the request; nothing is allocated otherwise.
+ *
+ * `FrameworkJson` is the document type used by JsonService and FrameworkModel. It is
+ * plain nlohmann::json unless FRAMEWORK_JSON_POOL is set to 1. When it is, values are
+ * converted to and from nlohmann::json implicitly; hand-written to_json() overloads that
+ * take nlohmann::json& need an explicit nlohmann::json(value) at the call site.
+ *
+ * @version 0.1
+ * @date 2025-04-04
+ * @license MIT License
+ * @copyright Copyright (c) 2025, Ian Archbell
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "framework_config.h"
+
+/**
+ * @brief Snapshot of pool usage and general heap fragmentation.
+ */
+struct JsonPoolStats
+{
+    static constexpr size_t NumClasses = 5;
+
+    size_t classSize[NumClasses];   ///< Block size of each class in bytes
+    size_t blocksInUse[NumClasses]; ///< Blocks currently handed out per class
+    size_t blocksFree[NumClasses];  ///< Blocks on the free list per class
+    size_t slabs;                   ///< Slabs obtained from the heap
+    size_t slabBytes;               ///< Bytes held in slabs
+    size_t largeAllocs;             ///< Live allocations too big for any class
+    size_t largeBytes;              ///< Bytes held by large allocations
+    size_t scratchFallbacks;        ///< Scratch requests that overflowed into the pool
+
+    size_t heapFree;              ///< Free bytes in the general heap
+    size_t heapLargestFreeBlock;  ///< Largest contiguous free block in the general heap
+    size_t heapFreeBlocks;        ///< Number of free blocks in the general heap
+    uint8_t heapFragmentationPct; ///< 100 * (1 - largest / free); 0 means one contiguous free region
+};
+
+/**
+ * @brief Process-wide size-class pool used by JsonPoolAllocator.
+ *
+ * Requests up to the largest class are rounded up to a class and served from that
+ * class's free list, refilled one JSON_POOL_SLAB_SIZE slab at a time. Larger requests
+ * go straight to the heap. All operations are O(1) and guarded by a short critical section.
+ */
+class JsonPool
+{
+public:
+    /**
+     * @brief Allocate a block of at least @p size bytes.
+     * @return Pointer to the block, or nullptr if the heap is exhausted.
+     */
+    static void *allocate(size_t size);
+
+    /**
+     * @brief Return a block. @p size must match the size passed to allocate().
+     */
+    static void deallocate(void *ptr, size_t size);
+
+    /**
+     * @brief Fill @p out with the current pool and heap statistics.
+     */
+    static void getStats(JsonPoolStats &out);
+
+    /**
+     * @brief Print the current statistics to stdout.
+     */
+    static void printStats();
+
+    /**
+     * @brief Report an allocation failure and halt, as the global operator new does.
+     */
+    [[noreturn]] static void outOfMemory(size_t size);
+};
+
+/**
+ * @brief Bump-pointer arena for short-lived JSON documents.
+ *
+ * Allocations are never freed individually; reset() releases everything at once.
+ * When the arena is full, further requests fall back to JsonPool.
+ * The arena must outlive every ScratchJson built in it.
+ */
+class JsonScratch
+{
+public:
+    /**
+     * @brief Create an arena with its own buffer taken from the heap.
+     * @param capacity Size of the arena in bytes.
+     */
+    explicit JsonScratch(size_t capacity = JSON_SCRATCH_SIZE);
+    ~JsonScratch();
+
+    JsonScratch(const JsonScratch &) = delete;
+    JsonScratch &operator=(const JsonScratch &) = delete;
+
+    void *allocate(size_t size);
+    void deallocate(void *ptr, size_t size);
+
+    /** @brief Discard all allocations. Documents allocated here must no longer be used. */
+    void reset() { used = 0; }
+
+    /** @brief True if @p ptr lies inside this arena's buffer. */
+    bool owns(const void *ptr) const
+    {
+        auto p = static_cast<const uint8_t *>(ptr);
+        return buffer && p >= buffer && p < buffer + capacity;
+    }
+
+    size_t bytesUsed() const { return used; }
+    size_t highWater() const { return peak; }
+
+    /** @brief The arena bound to the calling task, or nullptr. */
+    static JsonScratch *current();
+
+    /**
+     * @brief Free a block from JsonScratchAllocator, whichever arena it came from.
+     *
+     * Blocks in a live arena are left for its reset(); anything else goes back to JsonPool.
+     * Asserts if the owning arena is not the calling task's current one.
+     */
+    static void release(void *ptr, size_t size);
+
+private:
+    friend class JsonScratchScope;
+    static void setCurrent(JsonScratch *scratch);
+
+    uint8_t *buffer = nullptr;
+    size_t capacity = 0;
+    size_t used = 0;
+    size_t peak = 0;
+    JsonScratch *nextLive = nullptr; ///< Next arena in the list of live arenas
+};
+
+/**
+ * @brief Binds a scratch arena to the calling task for the lifetime of the scope.
+ *
+ * ScratchJson values created inside the scope are allocated from the arena, which is
+ * reset when the scope ends. Copy anything that must outlive the scope into a
+ * FrameworkJson (or nlohmann::json) first; conversion allocates fresh storage.
+ * Destroying a ScratchJson under another task's or a nested scope's arena asserts.
+ *
+ * @code
+ * JsonScratch scratch;            // buffer taken here, returned when the handler exits
+ * JsonScratchScope scope(scratch);
+ * ScratchJson report = buildReport();
+ * res.json(nlohmann::json(report));
+ * @endcode
+ */
+class JsonScratchScope
+{
+public:
+    explicit JsonScratchScope(JsonScratch &scratch);
+    ~JsonScratchScope();
+
+    JsonScratchScope(const JsonScratchScope &) = delete;
+    JsonScratchScope &operator=(const JsonScratchScope &) = delete;
+
+private:
+    JsonScratch &scratch;
+    JsonScratch *previous;
+};
+
+/**
+ * @brief Stateless std allocator backed by JsonPool.
+ */
+template <typename T>
+struct JsonPoolAllocator
+{
+    using value_type = T;
+
+    JsonPoolAllocator() noexcept = default;
+    template <typename U>
+    JsonPoolAllocator(const JsonPoolAllocator<U> &) noexcept {}
+
+    T *allocate(std::size_t n)
+    {
+        void *p = JsonPool::allocate(n * sizeof(T));
+        if (!p)
+        {
+            JsonPool::outOfMemory(n * sizeof(T));
+        }
+        return static_cast<T *>(p);
+    }
+
+    void deallocate(T *p, std::size_t n) noexcept
+    {
+        JsonPool::deallocate(p, n * sizeof(T));
+    }
+
+    template <typename U>
+    bool operator==(const JsonPoolAllocator<U> &) const noexcept { return true; }
+    template <typename U>
+    bool operator!=(const JsonPoolAllocator<U> &) const noexcept { return false; }
+};
+
+/**
+ * @brief Stateless std allocator that uses the calling task's scratch arena, or JsonPool if none.
+ */
+template <typename T>
+struct JsonScratchAllocator
+{
+    using value_type = T;
+
+    JsonScratchAllocator() noexcept = default;
+    template <typename U>
+    JsonScratchAllocator(const JsonScratchAllocator<U> &) noexcept {}
+
+    T *allocate(std::size_t n)
+    {
+        JsonScratch *scratch = JsonScratch::current();
+        void *p = scratch ? scratch->allocate(n * sizeof(T)) : JsonPool::allocate(n * sizeof(T));
+        if (!p)
+        {
+            JsonPool::outOfMemory(n * sizeof(T));
+        }
+        return static_cast<T *>(p);
+    }
+
+    void deallocate(T *p, std::size_t n) noexcept
+    {
+        // Ownership is decided by address, not by the scope current at free time
+        JsonScratch::release(p, n * sizeof(T));
+    }
+
+    template <typename U>
+    bool operator==(const JsonScratchAllocator<U> &) const noexcept { return true; }
+    template <typename U>
+    bool operator!=(const JsonScratchAllocator<U> &) const noexcept { return false; }
+};
+
+/// @brief JSON document whose nodes live in the size-class pools.
+using PooledJson = nlohmann::basic_json<std::map, std::vector, std::string, bool,
+                                        std::int64_t, std::uint64_t, double, JsonPoolAllocator>;
+
+/// @brief JSON document for request-scoped data, allocated from the active JsonScratchScope.
+using ScratchJson = nlohmann::basic_json<std::map, std::vector, std::string, bool,
+                                         std::int64_t, std::uint64_t, double, JsonScratchAllocator>;
+
+#if FRAMEWORK_JSON_POOL
+using FrameworkJson = PooledJson;
+#else
+using FrameworkJson = nlohmann::json;
+#endif
@@ -118,6 +118,13 @@ public:
      */
     bool isConnected() const { return connected; }
 
+    /**
+     * @brief Check that a client connection between requests is still open and has no unread data.
+     *
+     * Does not block. Used before sending another request on a kept-alive connection.
+     */
+    bool isIdle();
+
     /**
      * @brief Get the raw socket file descriptor (may be -1 for TLS-only connection).
      */
@@ -141,6 +148,7 @@ private:
 
     int sockfd = -1;
     bool connected = false;
+    bool peer_closed = false; ///< Remote end closed or reset the connection
     bool use_tls = false;
     bool is_server_socket = false;
     int connectResult = ERR_OK;
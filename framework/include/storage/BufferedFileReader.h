@@ -0,0 +1,81 @@
+/**
+ * @file BufferedFileReader.h
+ * @author Ian Archbell
+ * @brief Read-ahead buffer shared by the StorageFileReader implementations.
+ *
+ * Part of the PicoFramework application framework.
+ * The filesystem is read in blocks of FILE_READER_BUFFER_SIZE bytes and lines are
+ * found with memchr over the buffer, so readLine() costs about a memcpy per line instead
+ * of one filesystem call per byte. Subclasses only supply raw block reads and seeks.
+ *
+ * @version 0.1
+ * @date 2025-04-22
+ * @license MIT License
+ * @copyright Copyright (c) 2025, Ian Archbell
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "storage/StorageFileReader.h"
+#include "framework_config.h"
+
+/**
+ * @brief StorageFileReader with a read-ahead buffer.
+ */
+class BufferedFileReader : public StorageFileReader {
+public:
+    /**
+     * @brief Reads a single line into the provided buffer.
+     *
+     * Reads characters until newline (`\n`) or the buffer is full; a longer line is
+     * returned in pieces. Carriage returns (`\r`) are stripped.
+     *
+     * @param outLine Buffer to store the line
+     * @param maxLen Size of the buffer
+     * @return true if a line was read, false on EOF or error
+     */
+    bool readLine(char* outLine, size_t maxLen) override;
+
+    /**
+     * @brief Reads up to @p len bytes, taking what is buffered first.
+     *
+     * Requests of a whole buffer or more go straight to the filesystem.
+     */
+    size_t readChunk(void* buffer, size_t len) override;
+
+    /**
+     * @brief Moves the read position. Seeking inside the buffered block does not touch the filesystem.
+     */
+    bool seek(size_t offset) override;
+
+    /// @copydoc StorageFileReader::tell
+    size_t tell() const override { return bufferStart + bufferPos; }
+
+protected:
+    /**
+     * @brief Read up to @p len bytes from the file's current position.
+     * @return Bytes read, 0 at EOF, negative on error
+     */
+    virtual int readRaw(void* dst, size_t len) = 0;
+
+    /**
+     * @brief Move the file's position to @p offset.
+     */
+    virtual bool seekRaw(size_t offset) = 0;
+
+    /**
+     * @brief Discard buffered data and restart at offset 0; call when (re)opening.
+     */
+    void resetBuffer();
+
+private:
+    /// Refill the buffer from the file; false at EOF or on error
+    bool fill();
+
+    uint8_t buffer[FILE_READER_BUFFER_SIZE];
+    size_t bufferStart = 0; ///< File offset of buffer[0]
+    size_t bufferLen = 0;   ///< Valid bytes in buffer
+    size_t bufferPos = 0;   ///< Next byte to return
+};
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "storage/StorageFileWriter.h"
+#include <string>
+
+class CachingStorageManager;
+
+/**
+ * @brief Writer that appends through a CachingStorageManager, so its writes are batched in RAM
+ */
+class CachingFileWriter : public StorageFileWriter {
+public:
+    CachingFileWriter(CachingStorageManager* owner, const std::string& path);
+
+    ~CachingFileWriter() override;
+
+    /**
+     * @brief Writes @p len bytes at the end of the file.
+     * @return false if the data could be neither cached nor written.
+     */
+    bool write(const void* data, size_t len) override;
+
+    /**
+     * @brief Stop writing. Cached data is written back with the rest of the cache.
+     */
+    bool close() override;
+
+private:
+    CachingStorageManager* owner = nullptr;
+    std::string path;
+};
@@ -0,0 +1,287 @@
+/**
+ * @file CachingStorageManager.h
+ * @author Ian Archbell
+ * @brief RAM read cache and write-back buffer in front of another StorageManager.
+ *
+ * Part of the PicoFramework application framework.
+ * Small files that are read often (static assets, settings documents) are kept in RAM after
+ * the first read, and bursts of writeFile()/appendToFile() (logs, model saves) are absorbed
+ * in RAM and written to the backing storage in one operation on flush(), every
+ * STORAGE_CACHE_FLUSH_INTERVAL_MS, or when the budget is needed for something else.
+ * AppContext wraps the framework storage in one when STORAGE_CACHE_BUDGET is non-zero.
+ *
+ * Data written under Policy::Cache is lost if power fails before it is written back;
+ * use Policy::WriteThrough for paths where that matters.
+ *
+ * @version 0.1
+ * @date 2025-04-22
+ * @license MIT License
+ * @copyright Copyright (c) 2025, Ian Archbell
+ */
+
+#pragma once
+
+#include "StorageManager.h"
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <FreeRTOS.h>
+#include <semphr.h>
+#include <task.h>
+#include "framework_config.h"
+
+/**
+ * @brief StorageManager decorator that caches whole files in RAM within a byte budget.
+ *
+ * Files up to STORAGE_CACHE_MAX_FILE_SIZE are cached on first read. Appends to a file that
+ * is not cached are held as a tail and appended to the backing file on write-back, so a log
+ * is never read back in. When the budget is full the least recently used entry is written
+ * back if needed and dropped. An entry whose write-back fails is skipped, and after
+ * STORAGE_CACHE_WRITE_BACK_RETRIES failures in a row its data is discarded with a log message.
+ * A write is only held if its directory exists on the backing storage, so the usual
+ * "no such directory" failure is reported to the caller rather than at write-back.
+ *
+ * Each path follows the policy of the longest prefix registered with setPolicy(), or the
+ * default policy. Directory operations, rename and listDirectory() write back the affected
+ * entries first, so the backing storage always sees a consistent tree.
+ */
+class CachingStorageManager : public StorageManager
+{
+public:
+    /// @brief How a path uses the cache
+    enum class Policy
+    {
+        Cache,        ///< Reads cached, writes held in RAM until written back
+        WriteThrough, ///< Reads cached, writes go to the backing storage at once
+        Bypass        ///< Not cached
+    };
+
+    /// @brief Cache counters, see stats()
+    struct Stats
+    {
+        uint32_t hits;       ///< Reads served from RAM
+        uint32_t misses;     ///< Reads that went to the backing storage
+        uint32_t writeBacks; ///< Writes issued to the backing storage on behalf of cached data
+        uint32_t evictions;  ///< Entries dropped to make room
+        uint32_t discarded;  ///< Entries dropped, data lost, after STORAGE_CACHE_WRITE_BACK_RETRIES failed write-backs
+        size_t used;         ///< Bytes of the budget in use
+        size_t dirty;        ///< Bytes not yet written back
+    };
+
+    /**
+     * @brief Wrap @p backing.
+     * @param backing Storage that holds the files. Must outlive this object.
+     * @param budget Maximum bytes of cached contents and path names.
+     */
+    CachingStorageManager(StorageManager *backing, size_t budget);
+
+    /**
+     * @brief Set the policy for @p prefix and everything below it.
+     *
+     * Cached entries under the prefix are written back and dropped first.
+     * @param prefix Directory or file path, e.g. "/www" or "/log/system.log".
+     * @param policy Policy to apply.
+     */
+    void setPolicy(const std::string &prefix, Policy policy);
+
+    /// @brief Policy for paths no setPolicy() prefix matches (Policy::Cache to start with)
+    void setDefaultPolicy(Policy policy);
+
+    /**
+     * @brief Write all pending data to the backing storage.
+     * @return false if any write-back failed; that data stays cached and is retried.
+     */
+    bool flush();
+
+    /// @brief Hit, miss and write-back counters and current usage
+    Stats stats();
+
+    /// @brief The storage being cached
+    StorageManager *backing() const { return backing_; }
+
+    /// @brief open a file for streaming read line access.
+    std::unique_ptr<StorageFileReader> openReader(const std::string& path) override;
+
+    /// @brief open a file for streaming writes through one handle.
+    std::unique_ptr<StorageFileWriter> openWriter(const std::string& path, bool append = false) override;
+
+    /// @brief Mount the backing storage.
+    bool mount() override;
+
+    /// @brief Write back everything, then unmount the backing storage.
+    bool unmount() override;
+
+    /// @brief Check if the backing storage is mounted.
+    bool isMounted() const override;
+
+    /**
+     * @brief Check if a file or directory exists.
+     * @param path Path to the file or directory.
+     * @return true if it exists, including files only written to the cache so far.
+     */
+    bool exists(const std::string &path) override;
+
+    /**
+     * @brief Remove a file or directory, discarding any of its data not yet written back.
+     * @param path Path to the file or directory.
+     * @return true if removed.
+     */
+    bool remove(const std::string &path) override;
+
+    /**
+     * @brief Rename a file or directory.
+     * @param from Source path.
+     * @param to Destination path.
+     * @return true if renamed.
+     */
+    bool rename(const std::string &from, const std::string &to) override;
+
+    /**
+     * @brief Read a file into a byte vector.
+     * @param path Path to the file.
+     * @param out Output vector with file contents.
+     * @return true if successful.
+     */
+    bool readFile(const std::string &path, std::vector<uint8_t> &out) override;
+
+    /**
+     * @brief Read part of a file into a string.
+     * @param path Path to the file.
+     * @param startPosition Start position in the file.
+     * @param length Length of data to read.
+     * @param buffer Output string to fill with data.
+     * @return true if successful.
+     */
+    bool readFileString(const std::string &path, uint32_t startPosition, uint32_t length, std::string &buffer) override;
+
+    /**
+     * @brief Write a byte vector to a file (overwrite).
+     * @param path Path to the file.
+     * @param data Data to write.
+     * @return true if successful (under Policy::Cache, if it is held for write-back).
+     */
+    bool writeFile(const std::string &path, const std::vector<uint8_t> &data) override;
+    bool writeFile(const std::string& path, const unsigned char* data, size_t size) override;
+
+    /**
+     * @brief Append data to a file, creating it if needed.
+     * @param path Path to the file.
+     * @param data Pointer to data.
+     * @param size Size of data in bytes.
+     * @return true if appended (under Policy::Cache, if it is held for write-back).
+     */
+    bool appendToFile(const std::string &path, const uint8_t *data, size_t size) override;
+
+    /**
+     * @brief Stream a file in chunks using a callback.
+     *
+     * A cached file is streamed from RAM without holding the cache lock.
+     * @param path Path to the file.
+     * @param chunkCallback Callback to receive chunks of up to HTTP_BUFFER_SIZE bytes.
+     * @return true if streamed successfully.
+     */
+    bool streamFile(const std::string &path, std::function<void(const uint8_t *, size_t)> chunkCallback) override;
+
+    /**
+     * @brief Get the size of a file, including data not yet written back.
+     * @param path Path to the file.
+     * @return Size in bytes.
+     */
+    size_t getFileSize(const std::string &path) override;
+
+    /**
+     * @brief List a directory after writing back the entries in it.
+     * @param path Path to directory.
+     * @param out Vector to receive the entries.
+     * @return true if listed successfully.
+     */
+    bool listDirectory(const std::string &path, std::vector<FileInfo> &out) override;
+
+    /// @brief Write back the entries in a directory, then enumerate it on the backing storage.
+    bool forEachDirectoryEntry(const std::string &path, uint32_t cursor, size_t limit,
+                               const std::function<bool(const FileInfo &)> &visitor,
+                               uint32_t *next = nullptr) override;
+
+    /// @brief Create a directory on the backing storage.
+    bool createDirectory(const std::string &path) override;
+
+    /// @brief Write back anything under the directory, then remove it.
+    bool removeDirectory(const std::string &path) override;
+
+    /// @brief Drop the cache and format the backing storage.
+    bool formatStorage() override;
+
+private:
+    using Data = std::shared_ptr<std::vector<uint8_t>>;
+
+    struct Entry
+    {
+        Data data;             ///< Whole file if complete, otherwise bytes to append to the backing file
+        bool complete = true;  ///< data is the whole file
+        bool rewrite = false;  ///< Write-back must replace the backing file rather than append
+        size_t clean = 0;      ///< Leading bytes of a complete file already in the backing file
+        uint32_t lastUse = 0;
+        uint8_t failures = 0;  ///< Write-backs failed in a row
+
+        bool dirty() const { return rewrite || clean < data->size(); }
+    };
+
+    using Entries = std::map<std::string, Entry>;
+
+    /// Canonical form of @p path: leading '/', no trailing '/'
+    static std::string normalize(const std::string &path);
+
+    /// Policy of the longest matching prefix
+    Policy policyFor(const std::string &path) const;
+
+    /// The cached whole file, loading it if it qualifies, or null. Called with lock_ held.
+    Entry *readable(const std::string &path);
+
+    /// Read a backing file into a clean entry if it fits. Called with lock_ held.
+    Entry *load(const std::string &path);
+
+    /// Append under Policy::Cache. Called with lock_ held.
+    bool appendCached(const std::string &path, const uint8_t *data, size_t size);
+
+    /// Write an entry's pending data to the backing storage. Called with lock_ held.
+    bool writeBack(const std::string &path, Entry &entry);
+
+    /// Write back and drop @p path and, if @p children, everything under it. Called with lock_ held.
+    bool settle(const std::string &path, bool children);
+
+    /// Write back, without dropping, everything under directory @p path. Called with lock_ held.
+    bool writeBackUnder(const std::string &path);
+
+    /// Drop an entry and release its budget. Called with lock_ held.
+    Entries::iterator drop(Entries::iterator it);
+
+    /// Drop an entry that has failed too often to write back, if it has. Called with lock_ held.
+    bool discardIfFailing(Entries::iterator &it);
+
+    /// True if the directory holding @p path exists on the backing storage. Called with lock_ held.
+    bool parentExists(const std::string &path);
+
+    /// Evict least recently used entries other than @p keep until @p bytes more fit. Called with lock_ held.
+    bool makeRoom(size_t bytes, const std::string &keep);
+
+    static void flushTask(void *param);
+
+    StorageManager *backing_;
+    Entries entries_;
+    std::vector<std::pair<std::string, Policy>> rules_;
+    Policy defaultPolicy_ = Policy::Cache;
+    size_t budget_;
+    size_t used_ = 0;
+    uint32_t clock_ = 0; ///< Use counter for LRU
+    Stats stats_ = {};
+
+    SemaphoreHandle_t lock_ = nullptr;
+    StaticSemaphore_t lockBuffer_;
+
+#if STORAGE_CACHE_FLUSH_INTERVAL_MS > 0
+    TaskHandle_t task_ = nullptr;
+    StaticTask_t taskBuffer_;
+    StackType_t taskStack_[STORAGE_CACHE_STACK_SIZE];
+#endif
+};
@@ -1,13 +1,13 @@
 #pragma once
 
-#include "storage/StorageFileReader.h"
+#include "storage/BufferedFileReader.h"
 #include <ff_stdio.h>
 #include <string>
 
 /**
- * @brief Buffered line reader for FatFs FILE* files
+ * @brief Buffered reader for FatFs FILE* files
  */
-class FatFsFileReader : public StorageFileReader {
+class FatFsFileReader : public BufferedFileReader {
 public:
     FatFsFileReader();
     ~FatFsFileReader() override;
@@ -20,19 +20,19 @@ public:
     bool open(const std::string& path);
 
     /**
-     * @brief Reads a single line into the provided buffer.
-     * Carriage returns are stripped. Stops at newline or buffer end.
-     * @param outLine Destination buffer
-     * @param maxLen Size of the buffer
-     * @return true if line read, false on EOF or error
+     * @brief Size of the open file in bytes (0 if not open).
      */
-    bool readLine(char* outLine, size_t maxLen) override;
+    size_t size() override;
 
     /**
      * @brief Closes the file
      */
     void close() override;
 
+protected:
+    int readRaw(void* dst, size_t len) override;
+    bool seekRaw(size_t offset) override;
+
 private:
     FF_FILE* file = nullptr;  // FatFs file handle
     bool isOpen = false;
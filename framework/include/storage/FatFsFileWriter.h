@@ -0,0 +1,47 @@
+#pragma once
+
+#include "storage/StorageFileWriter.h"
+#include <ff_stdio.h>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Writer that keeps a FatFs file open across writes
+ *
+ * Writes are collected into blocks of FATFS_IO_BUFFER_SIZE that end on a block boundary of
+ * the file, so each reaches the card as one multi-sector transfer of whole sectors rather
+ * than a read-modify-write of a partial sector per call.
+ */
+class FatFsFileWriter : public StorageFileWriter {
+public:
+    FatFsFileWriter();
+    ~FatFsFileWriter() override;
+
+    /**
+     * @brief Opens a file for writing, creating it if needed
+     * @param path Path to the file
+     * @param append true to append, false to truncate
+     * @return true if opened successfully
+     */
+    bool open(const std::string& path, bool append);
+
+    /**
+     * @brief Writes @p len bytes at the end of the file.
+     *
+     * Data may be held until a block is complete; it is written by close() at the latest.
+     */
+    bool write(const void* data, size_t len) override;
+
+    /**
+     * @brief Writes any held data and closes the file
+     */
+    bool close() override;
+
+private:
+    /// Write the held bytes to the file
+    bool flushBuffer();
+
+    FF_FILE* file = nullptr;  // FatFs file handle
+    std::vector<uint8_t> buffer; // Bytes waiting for the rest of their block
+    size_t position = 0;         // File offset of buffer[0]
+};
@@ -22,6 +22,9 @@
 #include "StorageManager.h"
 #include "FreeRTOS.h"
 #include "semphr.h"
+#include "task.h"
+#include "timers.h"
+#include <ff_stdio.h>
 
 /**
  * @class FatFsStorageManager
@@ -109,7 +112,9 @@ public:
      * @param path Path to the file.
      * @param chunkCallback Callback function to handle each chunk of data.
      * @return true if successful, false otherwise.
-     * @note The callback will be called multiple times with chunks of data from the file.
+     * @note The callback will be called multiple times with chunks of up to HTTP_BUFFER_SIZE bytes.
+     * The card is read in sector-aligned blocks of FATFS_IO_BUFFER_SIZE so each block is
+     * one multi-sector transfer.
      */
     bool streamFile(const std::string &path, std::function<void(const uint8_t *, size_t)> chunkCallback) override;
 
@@ -121,6 +126,18 @@ public:
      */
     bool listDirectory(const std::string &path, std::vector<FileInfo> &out) override;
 
+    /**
+     * @brief Visit directory entries as they are found, holding one entry at a time.
+     * @param path Path to the directory.
+     * @param offset Entries to skip first.
+     * @param limit Most entries to visit (0 = all).
+     * @param visitor Called per entry; return false to stop.
+     * @return true if the directory could be read.
+     */
+    bool forEachDirectoryEntry(const std::string &path, uint32_t cursor, size_t limit,
+                               const std::function<bool(const FileInfo &)> &visitor,
+                               uint32_t *next = nullptr) override;
+
     /**
      * @brief Create a directory at the specified path.
      * @param path Path to create the directory.
@@ -151,7 +168,11 @@ public:
      * @return true if successful, false otherwise.
      * @note If the file does not exist, it will be created.
      * If the file exists, data will be appended to the end.
-     * 
+     * The file is kept open for up to FATFS_APPEND_HOLD_MS so a run of appends (a log)
+     * does not reopen it each time. When the hold expires a timer wakes a small task that
+     * closes it, even if no further call is made; it is closed sooner by an append to another file, by any other
+     * operation on it, or by unmount(). Its directory entry, and so its size on the card,
+     * is updated when it is closed.
      */
     bool appendToFile(const std::string &path, const uint8_t *data, size_t size) override;
 
@@ -176,12 +197,39 @@ public:
      */
     std::unique_ptr<StorageFileReader> openReader(const std::string& path) override;
 
+    /**
+     * @brief open a file for streaming write access.
+     * @param path The file path
+     * @param append true to append, false to truncate
+     * @return A new writer object, or nullptr on failure
+     */
+    std::unique_ptr<StorageFileWriter> openWriter(const std::string& path, bool append = false) override;
+
 
 private:
     bool mounted = false;           ///< Indicates if the filesystem is currently mounted
     std::string mountPoint = "sd0"; ///< Default mount point
 
-    SemaphoreHandle_t mutex; ///< Optional lock for thread safety
+    SemaphoreHandle_t mutex; ///< Guards the held append handle
+
+    FF_FILE *appendFile = nullptr; ///< File appendToFile() keeps open for the next append
+    std::string appendPath;        ///< Resolved path of appendFile
+    TickType_t appendOpened = 0;   ///< When appendFile was opened
+
+    TimerHandle_t appendTimer = nullptr;   ///< Fires when the hold on appendFile expires
+    TaskHandle_t appendCloser = nullptr;   ///< Closes appendFile when the timer fires; created on first use
+
+    /// Timer callback: wake appendCloser (the timer task itself must not do SD I/O)
+    static void appendHoldExpired(TimerHandle_t timer);
+
+    /// Task that closes the held append handle once its hold has expired
+    static void appendCloserTask(void *param);
+
+    /// Close the held append handle if it is @p resolved or below it, committing its directory entry
+    void releaseAppendFile(const std::string &resolved);
+
+    /// Close the held append handle. Called with mutex held.
+    void closeAppendFile();
 
     std::string resolvePath(const std::string &path) const;
 
@@ -0,0 +1,123 @@
+/**
+ * @file FlashOpService.h
+ * @author Ian Archbell
+ * @brief Pinned task that performs flash program and erase operations for LittleFS.
+ *
+ * Part of the PicoFramework application framework.
+ * On multicore builds every flash_safe_execute() pauses the other core, so each call has a
+ * fixed handshake cost on top of the operation itself. LittleFS programs in PROG_SIZE pages;
+ * this service collects contiguous page programs in a RAM batch and writes them with one
+ * flash_safe_execute() when the batch is full, when a non-contiguous program or an erase
+ * arrives, or when LittleFS syncs. read() overlays the pending batch on the XIP copy under
+ * the same lock, so a client always sees its own writes, even if another client flushes the
+ * batch at the same time.
+ *
+ * The operations themselves run on a task pinned to FLASH_OP_CORE. Callers queue an
+ * operation and sleep on a task notification until it completes.
+ *
+ * @version 0.1
+ * @date 2025-04-22
+ * @license MIT License
+ * @copyright Copyright (c) 2025, Ian Archbell
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <FreeRTOS.h>
+#include <queue.h>
+#include <semphr.h>
+#include <task.h>
+#include "framework_config.h"
+
+/**
+ * @brief Queues flash operations to a task on one core, batching contiguous programs.
+ *
+ * Offsets are relative to the start of flash (not XIP_BASE). Program offsets and sizes must
+ * be multiples of FLASH_PAGE_SIZE and erase offsets and sizes multiples of FLASH_SECTOR_SIZE,
+ * as for flash_range_program() and flash_range_erase().
+ */
+class FlashOpService
+{
+public:
+    /**
+     * @brief Access the singleton instance, starting its task on first use.
+     */
+    static FlashOpService &instance();
+
+    /**
+     * @brief Program @p size bytes at @p offset.
+     *
+     * The data is copied into the pending batch and may not reach flash until a later
+     * flush(); a batch that can't take it is written first.
+     * @return 0 on success, -1 if a flash operation failed.
+     */
+    int program(uint32_t offset, const void *data, size_t size);
+
+    /**
+     * @brief Erase @p size bytes at @p offset, writing any pending batch first.
+     * @return 0 on success, -1 if a flash operation failed.
+     */
+    int erase(uint32_t offset, size_t size);
+
+    /**
+     * @brief Write the pending batch, if any, and wait for it.
+     * @return 0 on success, -1 if the program failed.
+     */
+    int flush();
+
+    /**
+     * @brief Read @p size bytes at @p offset: the flash contents through XIP, with any pending
+     *        (not yet programmed) bytes of the batch copied over them.
+     *
+     * Both steps happen under one lock hold, so a flush by another caller can't land between
+     * them and leave @p dst holding the erased bytes the batch was about to replace.
+     */
+    void read(uint32_t offset, void *dst, size_t size);
+
+private:
+    FlashOpService();
+    FlashOpService(const FlashOpService &) = delete;
+    FlashOpService &operator=(const FlashOpService &) = delete;
+
+    enum class OpType : uint8_t
+    {
+        Program,
+        Erase
+    };
+
+    /// One operation handed to the service task
+    struct Op
+    {
+        OpType type;
+        uint32_t offset;
+        const uint8_t *data;
+        size_t size;
+        TaskHandle_t waiter; ///< Notified on FLASH_OP_NOTIFY_INDEX when done
+        int *result;
+    };
+
+    /// Queue an operation and wait for it. Called with lock_ held.
+    int submit(OpType type, uint32_t offset, const uint8_t *data, size_t size);
+
+    /// Write the batch. Called with lock_ held.
+    int flushLocked();
+
+    static void serviceTask(void *param);
+
+    uint8_t batch_[FLASH_OP_BATCH_SIZE]; ///< Programs not yet written, contiguous from batchOffset_
+    uint32_t batchOffset_ = 0;
+    size_t batchLen_ = 0;
+
+    SemaphoreHandle_t lock_ = nullptr; ///< Guards the batch and orders callers
+    StaticSemaphore_t lockBuffer_;
+
+    QueueHandle_t ops_ = nullptr;
+    StaticQueue_t opsBuffer_;
+    uint8_t opsStorage_[FLASH_OP_QUEUE_LENGTH * sizeof(Op)];
+
+    TaskHandle_t task_ = nullptr;
+    StaticTask_t taskBuffer_;
+    StackType_t stack_[FLASH_OP_STACK_SIZE];
+};
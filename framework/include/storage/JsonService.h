@@ -17,16 +17,32 @@
 
 #include <string>
 #include <vector>
+#include <map>
 #include "StorageManager.h"
 #include "nlohmann/json.hpp"
+#include "json/JsonPool.h"
 
 /**
  * @class JsonService
  * @brief Manages loading and saving of a single JSON document using StorageManager.
+ *
+ * Documents can be stored as JSON text or in one of the binary encodings supported by
+ * nlohmann::json (CBOR, MessagePack). The format is chosen per file, either by extension
+ * (".cbor", ".msgpack") or by registering it with setFormat().
  */
 class JsonService
 {
 public:
+    /**
+     * @brief On-storage encoding of a JSON document.
+     */
+    enum class Format
+    {
+        Text,       ///< Plain JSON text (".json")
+        Cbor,       ///< RFC 8949 CBOR (".cbor")
+        MessagePack ///< MessagePack (".msgpack")
+    };
+
     /**
      * @brief Construct a new JsonService.
      * @param storage Pointer to a StorageManager for persistent access.
@@ -35,6 +51,10 @@ public:
 
     /**
      * @brief Load a JSON file from storage.
+     *
+     * If the file is registered with a binary format and only the original text file exists,
+     * the text file is parsed, rewritten in the binary format and then removed.
+     *
      * @param path File path to load from.
      * @return true if load was successful and JSON parsed correctly.
      */
@@ -47,41 +67,79 @@ public:
      */
     bool save(const std::string &path) const;
 
+    /**
+     * @brief Select the storage format used for a file.
+     *
+     * The path is the logical name used with load() and save(). For binary formats the
+     * file is stored alongside with its extension replaced, e.g. "/zones.json" is stored
+     * as "/zones.cbor".
+     *
+     * @param path Logical file path.
+     * @param format Format to use for this file.
+     */
+    void setFormat(const std::string &path, Format format);
+
+    /**
+     * @brief Get the storage format used for a file.
+     * @param path Logical file path.
+     * @return Registered format, or the format implied by the file extension.
+     */
+    Format getFormat(const std::string &path) const;
+
+    /**
+     * @brief Get the physical path a logical path is stored at for a given format.
+     * @param path Logical file path.
+     * @param format Storage format.
+     * @return Path with the extension matching the format.
+     */
+    static std::string storagePath(const std::string &path, Format format);
+
     /**
      * @brief Access the internal JSON object.
      */
-    nlohmann::json &data();
+    FrameworkJson &data();
 
     /**
      * @brief Const access to the internal JSON object.
      */
-    const nlohmann::json &data() const;
+    const FrameworkJson &data() const;
 
     /**
      * @brief Alias for data().
      */
-    nlohmann::json &root();
+    FrameworkJson &root();
 
     /**
      * @brief Const alias for data().
      */
-    const nlohmann::json &root() const;
+    const FrameworkJson &root() const;
 
     /**
      * @brief Operator alias for data().
      */
-    nlohmann::json &operator*();
+    FrameworkJson &operator*();
 
     /**
      * @brief Const operator alias for data().
      */
-    const nlohmann::json &operator*() const;
+    const FrameworkJson &operator*() const;
 
     bool hasValidData() const;
 
     private:
+        /**
+         * @brief Read and decode a single file into data_.
+         */
+        bool readDocument(const std::string &path, Format format);
+
+        /**
+         * @brief Move a text document to its binary storage path.
+         */
+        bool migrate(const std::string &textPath, Format format);
+
         StorageManager *storage;
-        nlohmann::json data_;
+        FrameworkJson data_;
+        std::map<std::string, Format> formats; ///< Per-file format overrides
     };
 
     /**
@@ -0,0 +1,46 @@
+/**
+ * @file KvFlash.h
+ * @author Ian Archbell
+ * @brief Raw flash range used by KvLog.
+ *
+ * Part of the PicoFramework application framework.
+ * KvLog only needs to read, program pages and erase sectors, so the flash is behind this
+ * small interface: PicoKvFlash on the device, a simulated part in the host benchmark.
+ *
+ * @version 0.1
+ * @date 2025-04-22
+ * @license MIT License
+ * @copyright Copyright (c) 2025, Ian Archbell
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief NOR flash range with page program and sector erase, addressed from 0.
+ *
+ * Programming can only clear bits, so a page may be programmed again with 0xFF in every
+ * byte that is not meant to change.
+ */
+class KvFlash
+{
+public:
+    static constexpr size_t PageSize = 256;    ///< Program granularity (FLASH_PAGE_SIZE)
+    static constexpr size_t SectorSize = 4096; ///< Erase granularity (FLASH_SECTOR_SIZE)
+
+    virtual ~KvFlash() = default;
+
+    /// @brief Size of the range in bytes, a multiple of SectorSize
+    virtual size_t size() const = 0;
+
+    /// @brief Copy @p len bytes at @p offset into @p dst
+    virtual bool read(uint32_t offset, void *dst, size_t len) = 0;
+
+    /// @brief Program whole pages; @p offset and @p len are multiples of PageSize
+    virtual bool program(uint32_t offset, const void *src, size_t len) = 0;
+
+    /// @brief Erase the sector starting at @p offset to 0xFF
+    virtual bool erase(uint32_t offset) = 0;
+};
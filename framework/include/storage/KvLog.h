@@ -0,0 +1,207 @@
+/**
+ * @file KvLog.h
+ * @author Ian Archbell
+ * @brief Log-structured key-value store on a raw flash range, used by KvStore.
+ *
+ * Part of the PicoFramework application framework.
+ * Every put or remove appends one record to the active sector, so a small change costs a
+ * single page program rather than a sector erase and rewrite. Records are located by an
+ * in-RAM index rebuilt by scanning the log at mount.
+ *
+ * Sectors are used in order of a sequence number stamped in their header when they are
+ * opened. Compaction always takes the oldest sector: live records are copied to the head of
+ * the log and the sector is erased, so tombstones can be dropped and every sector is
+ * rewritten in turn. New sectors are taken least-worn first, using the erase count kept in
+ * each sector header. One free sector is always held back so compaction can run.
+ *
+ * Each record carries a CRC; a torn record closes its sector and the records before it stay
+ * valid. An interrupted compaction leaves duplicates, and the newer copy wins on replay.
+ *
+ * KvLog is not thread-safe; KvStore serializes access with its mutex.
+ *
+ * @version 0.1
+ * @date 2025-04-22
+ * @license MIT License
+ * @copyright Copyright (c) 2025, Ian Archbell
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "framework_config.h"
+#include "storage/KvFlash.h"
+
+/**
+ * @brief Log-structured key-value store over a KvFlash range of at least three sectors.
+ *
+ * Keys are up to KV_STORE_MAX_KEY_LEN bytes, values up to KV_STORE_MAX_VALUE_LEN bytes of
+ * arbitrary binary data.
+ */
+class KvLog
+{
+public:
+    /// Space and wear figures, see stats()
+    struct Stats
+    {
+        size_t keys;
+        size_t sectors;
+        size_t freeSectors;
+        size_t liveBytes;     ///< Bytes of records the index points at
+        size_t deadBytes;     ///< Superseded records and tombstones in sectors not yet compacted
+        uint32_t minErases;
+        uint32_t maxErases;
+    };
+
+    explicit KvLog(KvFlash &flash);
+
+    /**
+     * @brief Scan the flash and rebuild the index. Unformatted sectors are erased.
+     * @return false if the range is too small or a flash operation failed.
+     */
+    bool mount();
+
+    /**
+     * @brief Erase every sector, discarding all keys but keeping the erase counts.
+     */
+    bool format();
+
+    /// @brief True once mount() or format() has succeeded
+    bool isMounted() const { return mounted; }
+
+    /**
+     * @brief Copy a value into @p dst.
+     * @param key Key to look up.
+     * @param dst Destination buffer, may be null to query the size.
+     * @param dstLen Size of @p dst; at most this many bytes are copied.
+     * @param valueLen Receives the full length of the value if not null.
+     * @return false if the key is not present or the read failed.
+     */
+    bool get(const std::string &key, void *dst, size_t dstLen, size_t *valueLen = nullptr);
+
+    /// @brief Read a whole value into @p out
+    bool get(const std::string &key, std::vector<uint8_t> &out);
+
+    /**
+     * @brief Store a value, replacing any existing one.
+     *
+     * Writing the value a key already has costs nothing.
+     * @return false if the key or value is too long, the store is full or the write failed.
+     */
+    bool put(const std::string &key, const void *data, size_t len);
+
+    /**
+     * @brief Remove a key by appending a tombstone.
+     * @return true if the key is gone (including if it was never there).
+     */
+    bool remove(const std::string &key);
+
+    /// @brief True if @p key has a value
+    bool contains(const std::string &key) const { return index.count(key) != 0; }
+
+    /// @brief All keys with values, in no particular order
+    std::vector<std::string> keys() const;
+
+    /**
+     * @brief True if compaction would restore the free sector target.
+     *
+     * Puts compact inline only when they run out of sectors; KvStore calls compactStep()
+     * from a background task while this is true.
+     */
+    bool needsCompaction() const;
+
+    /**
+     * @brief Compact the oldest sector.
+     * @return false if there was nothing to compact or a flash operation failed.
+     */
+    bool compactStep();
+
+    /// @brief Current space and wear figures
+    Stats stats() const;
+
+private:
+    enum class SectorState : uint8_t
+    {
+        Free,   ///< Erased with a header holding its erase count
+        Active, ///< The head of the log, taking appends
+        Used    ///< Full or closed, waiting for compaction
+    };
+
+    struct Sector
+    {
+        SectorState state;
+        uint32_t seq;        ///< Order the sector was opened in
+        uint32_t erases;
+        uint32_t writePos;   ///< Offset in the sector of the next record
+        uint32_t liveBytes;
+    };
+
+    /// Where the current value of a key is
+    struct Location
+    {
+        uint32_t offset;     ///< Record offset in the flash range
+        uint16_t valueLen;
+    };
+
+    struct SectorHeader
+    {
+        uint32_t magic;
+        uint32_t erases;
+        uint32_t seq;        ///< 0xFFFFFFFF while the sector is free
+        uint32_t seqCheck;   ///< ~seq, so a torn open is detected
+    };
+
+    struct RecordHeader
+    {
+        uint8_t keyLen;      ///< 0xFF marks the end of the sector's records
+        uint8_t type;
+        uint16_t valueLen;
+        uint32_t crc;        ///< CRC-32 of the header fields, key and value
+    };
+
+    static constexpr uint32_t Magic = 0x3153564B; ///< "KVS1"
+    static constexpr uint8_t TypePut = 0x01;
+    static constexpr uint8_t TypeDelete = 0x02;
+    static constexpr size_t FreeTarget = 2;       ///< Free sectors wanted: one for the next open, one for compaction
+
+    static size_t recordSize(size_t keyLen, size_t valueLen) { return (sizeof(RecordHeader) + keyLen + valueLen + 3) & ~size_t(3); }
+    static uint32_t crc32(uint32_t crc, const void *data, size_t len);
+    static uint32_t recordCrc(const RecordHeader &header, const void *key, const void *value);
+
+    /// Scan one in-use sector, replaying its records into the index
+    bool replay(size_t s);
+
+    /// Append a record to the active sector, opening a new one if it doesn't fit
+    bool append(uint8_t type, const std::string &key, const void *value, size_t len);
+
+    /// Append to the active sector, which must have room
+    bool writeRecord(uint8_t type, const std::string &key, const void *value, size_t len, uint32_t &offset);
+
+    /// Program @p len bytes at an arbitrary offset through page-sized, 0xFF-padded writes
+    bool programBytes(uint32_t offset, const void *data, size_t len);
+
+    /// Close the active sector and open the least-worn free one
+    bool openSector();
+
+    /// Erase a sector and write a free header with its incremented erase count
+    bool eraseSector(size_t s);
+
+    /// Index of the used sector with the lowest sequence number, or SIZE_MAX
+    size_t oldestUsed() const;
+
+    /// Point the index at a record, moving the live byte count from the old location
+    void setLocation(const std::string &key, uint32_t offset, uint16_t valueLen);
+    void dropLocation(const std::string &key);
+
+    size_t freeSectors() const;
+
+    KvFlash &flash;
+    std::vector<Sector> sectors;
+    std::unordered_map<std::string, Location> index;
+    size_t active = SIZE_MAX;
+    uint32_t nextSeq = 0;
+    bool mounted = false;
+};
@@ -0,0 +1,104 @@
+/**
+ * @file KvStore.h
+ * @author Ian Archbell
+ * @brief Key-value store for settings and small records on a raw flash partition.
+ *
+ * Part of the PicoFramework application framework.
+ * JsonService rewrites the whole document for every change. KvStore keeps each setting
+ * as its own record in a log (see KvLog), so changing one costs a single page program.
+ * It is registered in AppContext when the build reserves a KV partition
+ * (KV_PARTITION_SIZE in framework_application.cmake).
+ *
+ * Compaction normally runs in a low-priority background task, so puts don't pay for the
+ * sector erase.
+ *
+ * @version 0.1
+ * @date 2025-04-22
+ * @license MIT License
+ * @copyright Copyright (c) 2025, Ian Archbell
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <FreeRTOS.h>
+#include <semphr.h>
+#include <task.h>
+#include "framework_config.h"
+#include "storage/KvLog.h"
+#include "storage/PicoKvFlash.h"
+
+/**
+ * @brief Thread-safe key-value store over KV_STORE_FLASH_SIZE bytes at KV_STORE_FLASH_OFFSET.
+ *
+ * The partition is mounted on first use; an unformatted partition is formatted then.
+ * Values are binary; the std::string overloads are a convenience for text.
+ */
+class KvStore
+{
+public:
+    KvStore();
+
+    /**
+     * @brief Copy a value into @p dst.
+     * @param key Key to look up.
+     * @param dst Destination buffer, may be null to query the size.
+     * @param dstLen Size of @p dst; at most this many bytes are copied.
+     * @param valueLen Receives the full length of the value if not null.
+     * @return false if the key is not present.
+     */
+    bool get(const std::string &key, void *dst, size_t dstLen, size_t *valueLen = nullptr);
+
+    /// @brief Read a value as a string
+    bool get(const std::string &key, std::string &value);
+
+    /**
+     * @brief Store a value, replacing any existing one.
+     * @return false if the key or value is too long (KV_STORE_MAX_KEY_LEN, KV_STORE_MAX_VALUE_LEN),
+     *         the store is full or the write failed.
+     */
+    bool put(const std::string &key, const void *data, size_t len);
+
+    /// @brief Store a string value
+    bool put(const std::string &key, const std::string &value);
+
+    /**
+     * @brief Remove a key.
+     * @return true if the key is gone (including if it was never there).
+     */
+    bool remove(const std::string &key);
+
+    /// @brief True if @p key has a value
+    bool contains(const std::string &key);
+
+    /// @brief All keys with values
+    std::vector<std::string> keys();
+
+    /// @brief Erase the partition, discarding every key
+    bool format();
+
+    /// @brief Space and wear figures
+    KvLog::Stats stats();
+
+private:
+    /// Mount on first use. Called with lock_ held.
+    bool ready();
+
+    /// Wake the compaction task if the log is short of free sectors. Called with lock_ held.
+    void checkCompaction();
+
+    static void compactTask(void *param);
+
+    PicoKvFlash flash;
+    KvLog log;
+
+    SemaphoreHandle_t lock_ = nullptr;
+    StaticSemaphore_t lockBuffer_;
+
+    TaskHandle_t task_ = nullptr;
+    StaticTask_t taskBuffer_;
+    StackType_t taskStack_[KV_STORE_STACK_SIZE];
+};
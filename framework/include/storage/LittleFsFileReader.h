@@ -1,13 +1,14 @@
 #pragma once
 
 #include "lfs.h"
-#include "storage/StorageFileReader.h"
+#include "storage/BufferedFileReader.h"
 #include <memory>
+#include <string>
 
 /**
- * @brief Buffered line reader for LittleFS lfs_file_t files
+ * @brief Buffered reader for LittleFS lfs_file_t files
  */
-class LittleFsFileReader : public StorageFileReader{
+class LittleFsFileReader : public BufferedFileReader{
 public:
     explicit LittleFsFileReader(lfs_t* lfs);
 
@@ -21,22 +22,18 @@ public:
     bool open(const std::string& path);
 
     /**
-     * @brief Reads a single line into the provided buffer.
-     *
-     * Reads characters until newline (`\n`) or buffer is full.
-     * Carriage returns (`\r`) are stripped. Returns false on EOF or error.
-     *
-     * @param outLine Buffer to store the line
-     * @param maxLen Size of the buffer
-     * @return true if a line was read, false on EOF or error
+     * @brief Size of the open file in bytes (0 if not open).
      */
-    bool readLine(char* outLine, size_t maxLen);
+    size_t size() override;
 
     /**
      * @brief Close the file and release resources.
      */
     void close() override;
 
+protected:
+    int readRaw(void* dst, size_t len) override;
+    bool seekRaw(size_t offset) override;
 
 private:
     lfs_t* lfs = nullptr;
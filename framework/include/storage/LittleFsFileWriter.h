@@ -0,0 +1,42 @@
+#pragma once
+
+#include "lfs.h"
+#include "storage/StorageFileWriter.h"
+#include <string>
+
+class LittleFsStorageManager;
+
+/**
+ * @brief Writer that keeps a LittleFS lfs_file_t open across writes
+ */
+class LittleFsFileWriter : public StorageFileWriter {
+public:
+    LittleFsFileWriter(lfs_t* lfs, LittleFsStorageManager* owner);
+
+    ~LittleFsFileWriter() override;
+
+    /**
+     * @brief Opens a file for writing, creating it if needed
+     * @param path Path to the file
+     * @param append true to append, false to truncate
+     * @return true if opened successfully
+     */
+    bool open(const std::string& path, bool append);
+
+    /**
+     * @brief Writes @p len bytes at the end of the file.
+     */
+    bool write(const void* data, size_t len) override;
+
+    /**
+     * @brief Close the file and drop its cached stat entry.
+     */
+    bool close() override;
+
+private:
+    lfs_t* lfs = nullptr;
+    LittleFsStorageManager* owner = nullptr;
+    lfs_file_t file{};
+    std::string path;
+    bool isOpen = false;
+};
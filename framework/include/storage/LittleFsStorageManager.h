@@ -16,11 +16,17 @@
 #include <string>
 #include <FreeRTOS.h> // for FreeRTOS types and functions
 #include <semphr.h>   // for SemaphoreHandle_t, StaticSemaphore_t, xSemaphoreCreateMutexStatic, xSemaphoreTake, xSemaphoreGive
+#include "framework_config.h"
 
 /**
  * @brief A LittleFS-based implementation of StorageManager, storing files in flash memory.
  *
  * Automatically mounts on first access if not already mounted.
+ *
+ * exists() and getFileSize() are answered from a small cache of lfs_stat results so that
+ * repeated lookups of the same paths (static file serving) don't walk the metadata in
+ * flash each time. Writes and appends invalidate their path; remove, rename, directory
+ * changes, format and unmount invalidate the whole cache.
  */
 class LittleFsStorageManager : public StorageManager
 {
@@ -33,6 +39,9 @@ public:
     /// @brief open a file for streaming read line access.
     std::unique_ptr<StorageFileReader> openReader(const std::string& path) override;
 
+    /// @brief open a file for streaming writes through one handle.
+    std::unique_ptr<StorageFileWriter> openWriter(const std::string& path, bool append = false) override;
+
     /**
      * @brief Mount the LittleFS filesystem.
      * @return true if mounted successfully.
@@ -52,7 +61,7 @@ public:
     bool isMounted() const override;
 
     /**
-     * @brief Check if a file or directory exists.
+     * @brief Check if a file or directory exists (cached).
      * @param path Path to the file or directory.
      * @return true if it exists.
      */
@@ -118,7 +127,7 @@ public:
     bool streamFile(const std::string &path, std::function<void(const uint8_t *, size_t)> chunkCallback) override;
 
     /**
-     * @brief Get the size of a file.
+     * @brief Get the size of a file (cached).
      * @param path Path to the file.
      * @return Size in bytes, or 0 on error.
      */
@@ -132,6 +141,18 @@ public:
      */
     bool listDirectory(const std::string &path, std::vector<FileInfo> &out) override;
 
+    /**
+     * @brief Visit directory entries as they are read, holding one entry at a time.
+     * @param path Path to directory.
+     * @param offset Entries to skip first.
+     * @param limit Most entries to visit (0 = all).
+     * @param visitor Called per entry; return false to stop.
+     * @return true if the directory could be opened.
+     */
+    bool forEachDirectoryEntry(const std::string &path, uint32_t cursor, size_t limit,
+                               const std::function<bool(const FileInfo &)> &visitor,
+                               uint32_t *next = nullptr) override;
+
     /**
      * @brief Create a new directory.
      * @param path Path of directory.
@@ -164,6 +185,8 @@ public:
     void formatInner(bool *result);
 
 private:
+    friend class LittleFsFileWriter; // invalidates its path's stat entry on close
+
     uintptr_t flashBase = 0;
     size_t flashSize = 0;
 
@@ -195,9 +218,42 @@ private:
     static int lfs_erase_cb_singlecore(const struct lfs_config *c, lfs_block_t block);
     static int lfs_prog_cb_multicore(const struct lfs_config *c, lfs_block_t block, lfs_off_t off, const void *buffer, lfs_size_t size);
     static int lfs_erase_cb_multicore(const struct lfs_config *c, lfs_block_t block);
+    static int lfs_sync_cb(const struct lfs_config *c);
     static int lfs_lock(const struct lfs_config *c);
     static int lfs_unlock(const struct lfs_config *c);
 
+    // --- Stat cache ---
+
+    /// Cached lfs_stat result for one path
+    struct StatEntry
+    {
+        std::string path;
+        size_t size = 0;
+        uint8_t type = 0;     ///< LFS_TYPE_REG, LFS_TYPE_DIR, or 0 if the path does not exist
+        uint32_t version = 0; ///< statVersion when the entry was filled
+    };
+
+    StatEntry statCache[STORAGE_STAT_CACHE_ENTRIES];
+    size_t statNext = 0;        ///< Round-robin replacement index
+    uint32_t statVersion = 1;   ///< Bumped by every invalidation
+    uint32_t statClearedAt = 1; ///< Entries filled before this version are stale
+    StaticSemaphore_t statMutexBuf;
+    SemaphoreHandle_t statMutex = nullptr;
+
+    /**
+     * @brief Look up @p path in the stat cache, calling lfs_stat on a miss.
+     * @param path Path to the file or directory.
+     * @param out Receives the cached entry; type is 0 if the path does not exist.
+     * @return false if lfs_stat failed with an error other than "not found".
+     */
+    bool statCached(const std::string &path, StatEntry &out);
+
+    /// Drop the cached entry for @p path
+    void invalidateStat(const std::string &path);
+
+    /// Drop every cached entry
+    void invalidateAllStats();
+
     /**
      * @brief Mount automatically if not mounted yet.
      * @return true if mounted successfully or already mounted.
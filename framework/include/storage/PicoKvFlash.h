@@ -0,0 +1,38 @@
+/**
+ * @file PicoKvFlash.h
+ * @author Ian Archbell
+ * @brief KvFlash over a raw range of the Pico's program flash.
+ *
+ * Part of the PicoFramework application framework.
+ * Programs and erases go through FlashOpService on multicore builds, like LittleFS, and
+ * with interrupts disabled otherwise. Reads come straight from XIP.
+ *
+ * @version 0.1
+ * @date 2025-04-22
+ * @license MIT License
+ * @copyright Copyright (c) 2025, Ian Archbell
+ */
+
+#pragma once
+
+#include "storage/KvFlash.h"
+
+/**
+ * @brief Flash range [offset, offset + size) from the start of flash, sector aligned.
+ *
+ * The range must be reserved for the store; see KV_PARTITION_SIZE in framework_application.cmake.
+ */
+class PicoKvFlash : public KvFlash
+{
+public:
+    PicoKvFlash(uint32_t offset, size_t size);
+
+    size_t size() const override { return length; }
+    bool read(uint32_t offset, void *dst, size_t len) override;
+    bool program(uint32_t offset, const void *src, size_t len) override;
+    bool erase(uint32_t offset) override;
+
+private:
+    uint32_t base;
+    size_t length;
+};
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "storage/StorageFileReader.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Reader over a snapshot of a RamStorageManager file
+ *
+ * The data is already in RAM, so it is read in place rather than through a read-ahead buffer.
+ */
+class RamFileReader : public StorageFileReader {
+public:
+    explicit RamFileReader(std::shared_ptr<const std::vector<uint8_t>> data);
+
+    bool readLine(char* buffer, size_t maxLen) override;
+    size_t readChunk(void* buffer, size_t len) override;
+    bool seek(size_t offset) override;
+    size_t tell() const override { return pos; }
+    size_t size() override { return data ? data->size() : 0; }
+
+    /**
+     * @brief Release the snapshot.
+     */
+    void close() override;
+
+private:
+    std::shared_ptr<const std::vector<uint8_t>> data;
+    size_t pos = 0;
+};
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "storage/StorageFileWriter.h"
+#include <string>
+
+class RamStorageManager;
+
+/**
+ * @brief Writer that appends to a RamStorageManager file
+ */
+class RamFileWriter : public StorageFileWriter {
+public:
+    RamFileWriter(RamStorageManager* owner, const std::string& path);
+
+    ~RamFileWriter() override;
+
+    /**
+     * @brief Writes @p len bytes at the end of the file.
+     * @return false if the file was removed or the budget is exhausted.
+     */
+    bool write(const void* data, size_t len) override;
+
+    /**
+     * @brief Stop writing. The data is already in the file.
+     */
+    bool close() override;
+
+private:
+    RamStorageManager* owner = nullptr;
+    std::string path;
+};
@@ -0,0 +1,244 @@
+/**
+ * @file RamStorageManager.h
+ * @author Ian Archbell
+ * @brief Heap-backed implementation of the StorageManager interface.
+ *
+ * Part of the PicoFramework application framework.
+ * Keeps a directory tree in RAM within a fixed byte budget. Useful for scratch data that
+ * should not wear flash (upload staging, rendered caches) and for running storage users
+ * such as HttpFileserver, JsonService and Logger in host tests. Contents survive unmount
+ * but not a reset.
+ *
+ * @version 0.1
+ * @date 2025-04-22
+ * @license MIT License
+ * @copyright Copyright (c) 2025, Ian Archbell
+ */
+
+#pragma once
+
+#include "StorageManager.h"
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <FreeRTOS.h>
+#include <semphr.h>
+#include "framework_config.h"
+
+/**
+ * @brief StorageManager that keeps files in RAM.
+ *
+ * Paths are absolute, '/' separated; a missing leading '/' is added and a trailing one
+ * dropped. As with LittleFS, a file's parent directory must exist before the file is created.
+ *
+ * File contents are reference counted: readers get a snapshot, and a write to a file that
+ * a reader still holds copies it first, so readers never see a partial update and need no lock.
+ * The budget counts file contents and path names; snapshots held by open readers are not
+ * counted.
+ */
+class RamStorageManager : public StorageManager
+{
+public:
+    /**
+     * @brief Construct an empty, mounted store.
+     * @param budget Maximum bytes of file contents and names.
+     */
+    explicit RamStorageManager(size_t budget = RAM_STORAGE_BUDGET);
+
+    /// @brief open a file for streaming read line access.
+    std::unique_ptr<StorageFileReader> openReader(const std::string& path) override;
+
+    /// @brief open a file for streaming writes through one handle.
+    std::unique_ptr<StorageFileWriter> openWriter(const std::string& path, bool append = false) override;
+
+    /**
+     * @brief Make the store available again after unmount(). Contents are kept.
+     * @return Always true.
+     */
+    bool mount() override;
+
+    /**
+     * @brief Refuse further access until mount(). Contents are kept.
+     * @return Always true.
+     */
+    bool unmount() override;
+
+    /**
+     * @brief Check if the store is mounted.
+     * @return true if mounted.
+     */
+    bool isMounted() const override;
+
+    /**
+     * @brief Check if a file or directory exists.
+     * @param path Path to the file or directory.
+     * @return true if it exists.
+     */
+    bool exists(const std::string &path) override;
+
+    /**
+     * @brief Remove a file or an empty directory.
+     * @param path Path to the file or directory.
+     * @return true if removed.
+     */
+    bool remove(const std::string &path) override;
+
+    /**
+     * @brief Rename a file or directory, replacing a file or empty directory at @p to.
+     * @param from Source path.
+     * @param to Destination path.
+     * @return true if renamed.
+     */
+    bool rename(const std::string &from, const std::string &to) override;
+
+    /**
+     * @brief Read a file into a byte vector.
+     * @param path Path to the file.
+     * @param out Output vector with file contents.
+     * @return true if successful.
+     */
+    bool readFile(const std::string &path, std::vector<uint8_t> &out) override;
+
+    /**
+     * @brief Read part of a file into a string.
+     * @param path Path to the file.
+     * @param startPosition Start position in the file.
+     * @param length Length of data to read.
+     * @param buffer Output string to fill with data.
+     * @return true if successful.
+     */
+    bool readFileString(const std::string &path, uint32_t startPosition, uint32_t length, std::string &buffer) override;
+
+    /**
+     * @brief Write a byte vector to a file (overwrite).
+     * @param path Path to the file.
+     * @param data Data to write.
+     * @return true if successful.
+     */
+    bool writeFile(const std::string &path, const std::vector<uint8_t> &data) override;
+    bool writeFile(const std::string& path, const unsigned char* data, size_t size) override;
+
+    /**
+     * @brief Append data to a file, creating it if needed.
+     * @param path Path to the file.
+     * @param data Pointer to data.
+     * @param size Size of data in bytes.
+     * @return true if appended.
+     */
+    bool appendToFile(const std::string &path, const uint8_t *data, size_t size) override;
+
+    /**
+     * @brief Stream a file in chunks using a callback.
+     *
+     * Chunks point straight into a snapshot of the file, so nothing is copied.
+     * @param path Path to the file.
+     * @param chunkCallback Callback to receive chunks of up to HTTP_BUFFER_SIZE bytes.
+     * @return true if streamed successfully.
+     */
+    bool streamFile(const std::string &path, std::function<void(const uint8_t *, size_t)> chunkCallback) override;
+
+    /**
+     * @brief Get the size of a file.
+     * @param path Path to the file.
+     * @return Size in bytes, or 0 if it is not a file.
+     */
+    size_t getFileSize(const std::string &path) override;
+
+    /**
+     * @brief List the entries of a directory.
+     * @param path Path to directory.
+     * @param out Vector the entries are appended to.
+     * @return true if listed successfully.
+     */
+    bool listDirectory(const std::string &path, std::vector<FileInfo> &out) override;
+
+    /**
+     * @brief Visit a window of a directory's entries, in name order.
+     *
+     * The window is copied under the lock and visited after it is released.
+     * @param path Path to directory.
+     * @param offset Entries to skip first.
+     * @param limit Most entries to visit (0 = all).
+     * @param visitor Called per entry; return false to stop.
+     * @return true if @p path is a directory.
+     */
+    bool forEachDirectoryEntry(const std::string &path, uint32_t cursor, size_t limit,
+                               const std::function<bool(const FileInfo &)> &visitor,
+                               uint32_t *next = nullptr) override;
+
+    /**
+     * @brief Create a directory and any missing parents.
+     * @param path Path of directory.
+     * @return true if it exists as a directory afterwards.
+     */
+    bool createDirectory(const std::string &path) override;
+
+    /**
+     * @brief Remove an empty directory.
+     * @param path Path of directory.
+     * @return true if removed.
+     */
+    bool removeDirectory(const std::string &path) override;
+
+    /**
+     * @brief Remove everything.
+     * @return Always true.
+     */
+    bool formatStorage() override;
+
+    /// @brief Bytes of the budget in use
+    size_t bytesUsed() const { return used; }
+
+    /// @brief The budget given at construction
+    size_t budget() const { return limit; }
+
+private:
+    friend class RamFileWriter; // appends through appendData
+
+    using Data = std::shared_ptr<std::vector<uint8_t>>;
+
+    struct Node
+    {
+        bool isDirectory;
+        Data data; ///< File contents, null for a directory
+    };
+
+    /// Canonical form of @p path: leading '/', no trailing '/'
+    static std::string normalize(const std::string &path);
+
+    /// Directory part of a normalized path ("/" for top-level entries)
+    static std::string parentOf(const std::string &path);
+
+    /// True if @p path is a directory. Called with lock held.
+    bool isDirectoryLocked(const std::string &path) const;
+
+    /// True if a directory has no entries. Called with lock held.
+    bool isEmptyLocked(const std::string &path) const;
+
+    /// Charge @p add bytes against the budget after releasing @p release. Called with lock held.
+    bool charge(size_t release, size_t add);
+
+    /// Create or replace a file. Called with lock held.
+    bool putFile(const std::string &path, const uint8_t *data, size_t size);
+
+    /// Append to a file, optionally creating it. Called with lock held.
+    bool appendLocked(const std::string &path, const void *data, size_t size, bool create);
+
+    /// Append to a file that exists (used by RamFileWriter)
+    bool appendData(const std::string &path, const void *data, size_t size);
+
+    /// Append a window of a directory's entries to @p out, taking the lock
+    bool listLocked(const std::string &path, size_t offset, size_t limit, std::vector<FileInfo> &out);
+
+    /// The contents of a file, or null if there is no such file
+    std::shared_ptr<const std::vector<uint8_t>> snapshot(const std::string &path);
+
+    std::map<std::string, Node> nodes; ///< Every path except "/", sorted so a directory's entries are adjacent
+    size_t limit;
+    size_t used = 0;
+    bool mounted = true;
+
+    SemaphoreHandle_t lock = nullptr;
+    StaticSemaphore_t lockBuffer;
+};
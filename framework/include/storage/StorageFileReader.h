@@ -1,7 +1,7 @@
 #pragma once
 #include <cstddef>
 /**
- * @brief Abstract interface for reading a file line-by-line.
+ * @brief Abstract interface for reading a file line-by-line or in chunks.
  */
 class StorageFileReader {
 public:
@@ -16,6 +16,30 @@ public:
      */
     virtual bool readLine(char* buffer, size_t maxLen) = 0;
 
+    /**
+     * @brief Reads up to @p len bytes from the current position.
+     * @param buffer Destination buffer
+     * @param len Maximum number of bytes to read
+     * @return Number of bytes read; 0 on EOF or error
+     */
+    virtual size_t readChunk(void* buffer, size_t len) = 0;
+
+    /**
+     * @brief Moves the read position to @p offset bytes from the start of the file.
+     * @return true on success
+     */
+    virtual bool seek(size_t offset) = 0;
+
+    /**
+     * @brief Current read position in bytes from the start of the file.
+     */
+    virtual size_t tell() const = 0;
+
+    /**
+     * @brief Size of the file in bytes.
+     */
+    virtual size_t size() = 0;
+
     /**
      * @brief Close the file and release resources.
      */
@@ -0,0 +1,23 @@
+#pragma once
+#include <cstddef>
+/**
+ * @brief Abstract interface for writing a file through one open handle.
+ */
+class StorageFileWriter {
+public:
+    virtual ~StorageFileWriter() = default;
+
+    /**
+     * @brief Writes @p len bytes at the end of the file.
+     * @param data Source buffer
+     * @param len Number of bytes to write
+     * @return true if all bytes were written
+     */
+    virtual bool write(const void* data, size_t len) = 0;
+
+    /**
+     * @brief Close the file, committing what was written.
+     * @return true if the file was closed cleanly
+     */
+    virtual bool close() = 0;
+};
@@ -21,6 +21,7 @@
 #include <cstdint>
 #include <nlohmann/json.hpp>
 #include "storage/StorageFileReader.h"
+#include "storage/StorageFileWriter.h"
 
 /**
  * @brief Structure representing metadata for a file or directory.
@@ -85,6 +86,44 @@ public:
     /** @brief List all entries in the given directory. */
     virtual bool listDirectory(const std::string &path, std::vector<FileInfo> &out) = 0;
 
+    /**
+     * @brief Visit a window of a directory's entries one at a time, without building a list.
+     *
+     * Entries come in the backend's own order. The visitor is not called with storage locks
+     * held. The default implementation pages over listDirectory(); backends override it to read
+     * the directory incrementally, so memory use is bounded by one entry, not the directory.
+     *
+     * @p cursor is an opaque position: 0 for the start, otherwise a value returned in @p next.
+     * LittleFS uses its directory position, which it seeks to without reading the entries
+     * before it. Backends that can't seek use an entry count, which costs O(cursor) reads to
+     * reach. Either way a cursor is only meaningful for the directory it came from, and entries
+     * added or removed between calls can be skipped or repeated.
+     * @param path Directory path.
+     * @param cursor Where to start: 0, or a previous @p next.
+     * @param limit Most entries to visit (0 = all).
+     * @param visitor Called per entry; the FileInfo is only valid during the call. Return false
+     *                to stop (that entry is not consumed, so @p next still points at it).
+     * @param next If not null, receives the cursor for the first entry not consumed.
+     * @return false if the directory could not be read or the cursor is not valid for it.
+     */
+    virtual bool forEachDirectoryEntry(const std::string &path, uint32_t cursor, size_t limit,
+                                       const std::function<bool(const FileInfo &)> &visitor,
+                                       uint32_t *next = nullptr)
+    {
+        std::vector<FileInfo> entries;
+        if (!listDirectory(path, entries))
+            return false;
+        size_t i = cursor;
+        for (; i < entries.size() && (limit == 0 || i - cursor < limit); ++i)
+        {
+            if (!visitor(entries[i]))
+                break;
+        }
+        if (next)
+            *next = static_cast<uint32_t>(i < entries.size() ? i : entries.size());
+        return true;
+    }
+
     /** @brief Create a directory at the given path (recursive if needed). */
     virtual bool createDirectory(const std::string &path) = 0;
 
@@ -106,4 +145,12 @@ public:
      * @return A new reader object, or nullptr on failure
      */
     virtual std::unique_ptr<StorageFileReader> openReader(const std::string& path) = 0;
+
+    /**
+     * @brief Open a file for streaming write access, creating it if needed.
+     * @param path The file path
+     * @param append true to append to an existing file, false to truncate it
+     * @return A new writer object, or nullptr on failure
+     */
+    virtual std::unique_ptr<StorageFileWriter> openWriter(const std::string& path, bool append = false) = 0;
 };
\ No newline at end of file
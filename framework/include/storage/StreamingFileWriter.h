@@ -0,0 +1,115 @@
+/**
+ * @file StreamingFileWriter.h
+ * @author Ian Archbell
+ * @brief Double-buffered file writer that overlaps storage writes with network receive.
+ *
+ * Part of the PicoFramework application framework.
+ * The file stays open for the whole transfer (one StorageManager::openWriter() instead of
+ * an open/append/close per chunk). Data is collected in one of two STREAM_WRITER_BLOCK_SIZE
+ * buffers; when it is full it is handed to a shared writer task, which programs it while
+ * the caller keeps receiving into the other buffer. The caller only waits when it fills
+ * its second buffer before the first has been written.
+ *
+ * Used by MultipartParser for uploads and by HttpClient for toFile() downloads.
+ *
+ * @version 0.1
+ * @date 2025-04-22
+ * @license MIT License
+ * @copyright Copyright (c) 2025, Ian Archbell
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <FreeRTOS.h>
+#include <queue.h>
+#include <semphr.h>
+#include <task.h>
+#include "framework_config.h"
+#include "storage/StorageFileWriter.h"
+
+class StorageManager;
+
+/**
+ * @brief Streams data to one file through two block buffers and the writer task.
+ *
+ * Holds 2 x STREAM_WRITER_BLOCK_SIZE bytes, so allocate it on the heap rather than a task stack.
+ * Not thread safe: one task writes to a given instance.
+ */
+class StreamingFileWriter
+{
+public:
+    StreamingFileWriter();
+
+    /// Closes the file, waiting for any block still being written
+    ~StreamingFileWriter();
+
+    StreamingFileWriter(const StreamingFileWriter &) = delete;
+    StreamingFileWriter &operator=(const StreamingFileWriter &) = delete;
+
+    /**
+     * @brief Open @p path for writing and start the writer task if needed.
+     * @param storage Storage backend to write through.
+     * @param path    File path.
+     * @param append  true to append to an existing file, false to truncate it.
+     * @return false if the file could not be opened.
+     */
+    bool open(StorageManager *storage, const std::string &path, bool append = false);
+
+    /**
+     * @brief Queue data for writing. Blocks only while both buffers are full.
+     * @return false if the file is not open or an earlier block failed to write.
+     */
+    bool write(const void *data, size_t len);
+
+    /**
+     * @brief Write what is buffered, wait for it and close the file.
+     * @return false if any write or the close failed.
+     */
+    bool close();
+
+    /// @brief True while a file is open
+    bool isOpen() const { return file_ != nullptr; }
+
+    /// @brief Bytes committed to storage so far
+    size_t bytesWritten() const { return written_; }
+
+private:
+    /// One buffer handed to the writer task
+    struct Job
+    {
+        StreamingFileWriter *writer;
+        uint8_t index;
+        size_t len;
+    };
+
+    /// Hand the buffer being filled to the writer task and switch to the other one
+    bool submit();
+
+    /// Wait until the writer task has finished with the buffer in flight
+    bool waitIdle();
+
+    static void writerTask(void *param);
+    static void startWriter();
+
+    std::unique_ptr<StorageFileWriter> file_;
+    uint8_t buffers_[2][STREAM_WRITER_BLOCK_SIZE];
+    uint8_t fill_ = 0;      ///< Buffer being filled by write()
+    size_t fillLen_ = 0;    ///< Bytes in that buffer
+    bool inFlight_ = false; ///< The other buffer is with the writer task
+    std::atomic<bool> failed_{false};
+    size_t written_ = 0;
+    SemaphoreHandle_t done_ = nullptr; ///< Given by the writer task when a buffer is written
+    StaticSemaphore_t doneBuffer_;
+
+    static QueueHandle_t jobs_;
+    static StaticQueue_t jobsBuffer_;
+    static uint8_t jobsStorage_[STREAM_WRITER_QUEUE_LENGTH * sizeof(Job)];
+    static TaskHandle_t writer_;
+    static StaticTask_t writerBuffer_;
+    static StackType_t writerStack_[STREAM_WRITER_STACK_SIZE];
+};
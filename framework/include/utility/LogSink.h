@@ -0,0 +1,117 @@
+/**
+ * @file LogSink.h
+ * @author Ian Archbell
+ * @brief Buffered, asynchronous log file writer used by Logger and DebugTrace.
+ *
+ * Part of the PicoFramework application framework.
+ * Logging a line only copies it into the sink's RAM ring buffer. A low-priority writer
+ * task, shared by all sinks, appends the buffered lines to the file in blocks of up to
+ * LOG_SINK_FLUSH_BYTES once that many are waiting or LOG_SINK_FLUSH_INTERVAL_MS has passed,
+ * so the filesystem sees one append per block instead of one open/append/close per line
+ * and the logging task never waits on flash. When the buffer is full the line is dropped
+ * and counted rather than blocking the caller.
+ *
+ * Files can be size-capped: when the next block would take the file past its limit it is
+ * renamed to `<path>.1` (older copies shift up to `<path>.<maxFiles>`) and a new file started.
+ *
+ * Nothing is allocated until file output is used: a sink's buffer is taken from the heap by
+ * its first open(), and the writer task with its stack and staging block by the first open()
+ * of any sink. An application that never logs to a file pays only for the small objects.
+ *
+ * @version 0.1
+ * @date 2025-04-22
+ * @license MIT License
+ * @copyright Copyright (c) 2025, Ian Archbell
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <FreeRTOS.h>
+#include <semphr.h>
+#include <task.h>
+#include "framework_config.h"
+
+/**
+ * @brief One buffered log file.
+ *
+ * Instances must have static storage duration; open() registers the sink with the writer task.
+ */
+class LogSink
+{
+public:
+    /**
+     * @brief Start buffering lines for @p path and start the writer task if needed.
+     *
+     * Calling open() again on an open sink flushes it and switches to the new path.
+     *
+     * @param path        Log file path.
+     * @param maxFileSize Rotate once the file would exceed this many bytes (0 = never rotate).
+     * @param maxFiles    Rotated copies to keep (`<path>.1` is the newest); 0 truncates instead.
+     * @return false if LOG_SINK_MAX_SINKS sinks are already registered, or the buffer or
+     *         writer task could not be allocated.
+     */
+    bool open(const std::string &path, size_t maxFileSize = LOG_FILE_MAX_SIZE, uint8_t maxFiles = LOG_FILE_MAX_FILES);
+
+    /// @brief True once open() has succeeded
+    bool isOpen() const { return registered_ && !path_.empty(); }
+
+    /**
+     * @brief Buffer one line (or any text). Never blocks.
+     * @return false if the buffer could not hold all of it; nothing is written and the drop is counted.
+     *         Also false, without counting, before the sink has been opened.
+     */
+    bool write(const char *text, size_t len);
+
+    /**
+     * @brief Write everything buffered to the file now, in the calling task.
+     * @return false if an append failed (the data in that block is lost).
+     */
+    bool flush();
+
+    /// @brief Lines dropped because the buffer was full
+    uint32_t droppedLines() const { return dropped_.load(std::memory_order_relaxed); }
+
+    /// @brief Bytes waiting to be written
+    size_t buffered() const;
+
+    /// @brief File the sink writes to
+    const std::string &path() const { return path_; }
+
+private:
+    /// Copy up to @p max bytes out of the ring; caller holds flushLock_
+    size_t take(char *out, size_t max);
+
+    /// Append one block, rotating first if it would overflow the file; caller holds flushLock_
+    bool append(const char *data, size_t len);
+
+    /// Shift `<path>.N` files up by one and move the live file to `<path>.1`
+    void rotate();
+
+    static void writerTask(void *param);
+
+    /// Create the writer task and staging block on first use
+    static bool startWriter();
+
+    char *buffer_ = nullptr; ///< LOG_SINK_BUFFER_SIZE bytes, allocated by the first open()
+    size_t head_ = 0; ///< Total bytes written into the ring
+    size_t tail_ = 0; ///< Total bytes taken out of the ring
+    std::atomic<uint32_t> dropped_{0};
+
+    std::string path_;
+    size_t maxFileSize_ = 0;
+    uint8_t maxFiles_ = 0;
+    size_t fileSize_ = 0;     ///< Current file size, read from storage on the first flush
+    bool sizeKnown_ = false;
+    bool registered_ = false;
+
+    static LogSink *sinks_[LOG_SINK_MAX_SINKS];
+    static size_t sinkCount_;
+    static char *staging_;               ///< One block on its way to storage, allocated with the writer
+    static SemaphoreHandle_t flushLock_; ///< Serializes flushes (writer task and explicit flush()) and guards sinks_
+    static StaticSemaphore_t flushLockBuffer_;
+    static TaskHandle_t writer_;
+};
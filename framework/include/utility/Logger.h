@@ -5,7 +5,8 @@
  *
  * Part of the PicoFramework application framework.
  * Logs messages with timestamps and severity levels (INFO, WARN, ERROR).
- * Optionally supports logging to an SD card via FatFsStorageManager.
+ * Optionally supports logging to a file; lines are buffered and written in
+ * blocks by a background LogSink, with size-capped rotation.
  * 
  * Usage example:
  * @code
@@ -16,8 +17,8 @@
  * Logger::error("Critical error occurred.");
  * @endcode
  *
- * @version 0.2
- * @date 2025-03-31
+ * @version 0.3
+ * @date 2025-04-22
  * @license MIT License
  * @copyright Copyright (c) 2025, Ian Archbell
  */
@@ -28,8 +29,10 @@
  
  #include <cstdio>
  #include <ctime>
+ #include <functional>
  #include <string>
  #include "storage/StorageManager.h"
+ #include "utility/LogSink.h"
  
  /**
   * @brief Severity levels for logging.
@@ -74,10 +77,27 @@
      static void setMinLogLevel(LogLevel level);
  
      /**
-      * @brief Enable writing logs to SD card via a storage manager.
-      * @param path Path to the log file on SD card (e.g. "/log/system.log").
+      * @brief Enable writing logs to a file via the storage manager.
+      *
+      * Lines are buffered and appended in the background; the file is rotated to
+      * `<path>.1` .. `<path>.maxFiles` when it would exceed @p maxFileSize.
+      *
+      * @param path Path to the log file (e.g. "/log/system.log").
+      * @param maxFileSize Rotation threshold in bytes (0 = never rotate).
+      * @param maxFiles Rotated copies to keep.
       */
-     static void enableFileLogging(const std::string& path);
+     static void enableFileLogging(const std::string& path, size_t maxFileSize = LOG_FILE_MAX_SIZE,
+                                   uint8_t maxFiles = LOG_FILE_MAX_FILES);
+
+     /**
+      * @brief Write any buffered lines to the log file now.
+      */
+     static void flush();
+
+     /**
+      * @brief Lines not written to the log file because its buffer was full.
+      */
+     static uint32_t droppedLines() { return sink.droppedLines(); }
 
      /**
      * @brief Streams each line of the log file to the provided handler.
@@ -95,6 +115,7 @@
  
      static inline std::string logPath = "";
      static inline bool logToFile = false;
+     static inline LogSink sink;
  };
  
  #endif // LOGGER_H
@@ -51,107 +51,109 @@ EventManager::EventManager(size_t queueSize)
 {
     lock = xSemaphoreCreateMutexStatic(&lockBuffer_);
     configASSERT(lock);
+    dispatcher_ = xTaskCreateStatic(dispatcherTask, "EventDispatch", EVENT_DISPATCH_STACK_SIZE, this,
+                                    EVENT_DISPATCH_PRIORITY, dispatcherStack_, &dispatcherBuffer_);
+    configASSERT(dispatcher_);
 }
 
 /// @copydoc EventManager::subscribe
 void EventManager::subscribe(uint32_t mask, FrameworkController* target)
-{
-    withSubscribers([&](auto& subs) {
-        subs.push_back({mask, target});
-    });
-}
-
-void EventManager::withSubscribers(const std::function<void(std::vector<Subscriber>&)>& fn)
 {
     xSemaphoreTake(lock, portMAX_DELAY);
-    fn(subscribers_);
-    xSemaphoreGive(lock);
-}
-
-/// @copydoc EventManager::withSubscribersFromISR
-void EventManager::withSubscribersFromISR(const std::function<void(std::vector<Subscriber>&)>& fn)
-{
-    xSemaphoreTake(lock, portMAX_DELAY);
-    fn(subscribers_);
+    bool ok = dispatch_.add(mask, target);
     xSemaphoreGive(lock);
+    if (!ok) {
+        printf("[EventManager] Subscriber limit reached for one or more events, increase EVENT_MAX_SUBSCRIBERS_PER_CODE\n");
+    }
 }
 
 /// @copydoc EventManager::postNotification
 void EventManager::postNotification(const Notification& n, FrameworkTask* target)
 {
-    const uint8_t index = n.code();
-
+    Event e;
+    e.notification = n;
+    e.target = target;
     if (is_in_interrupt()) {
-        BaseType_t xHigherPriTaskWoken = pdFALSE;
-
-        withSubscribersFromISR([&](auto& subs) {
-            for (auto& sub : subs) {
-                if ((sub.eventMask & (1u << index)) &&
-                    (target == nullptr || sub.controller == target)) {
-                    sub.controller->notifyFromISR(index, 1, &xHigherPriTaskWoken);
-                }
-            }
-        });
-
-        portYIELD_FROM_ISR(xHigherPriTaskWoken);
+        postFromISR(e, Delivery::Notification);
     } else {
-        withSubscribers([&](auto& subs) {
-            for (auto& sub : subs) {
-                if ((sub.eventMask & (1u << index)) &&
-                    (target == nullptr || sub.controller == target)) {
-                    sub.controller->notify(index, 1);
-                }
-            }
-        });
+        deliver(e, Delivery::Notification);
     }
 }
 
-
 /// @copydoc EventManager::enqueue
 void EventManager::enqueue(const Event& event)
 {
-    const uint8_t code = event.notification.code();
+    if (is_in_interrupt()) {
+        postFromISR(event, Delivery::Queue);
+    } else {
+        deliver(event, Delivery::Queue);
+        event.release(); // the producer's reference
+    }
+}
 
+/// @copydoc EventManager::postEvent
+void EventManager::postEvent(const Event& e)
+{
     if (is_in_interrupt()) {
-        BaseType_t xHigherPriTaskWoken = pdFALSE;
+        postFromISR(e, Delivery::Both);
+    } else {
+        deliver(e, Delivery::Both);
+        e.release(); // the producer's reference
+    }
+}
 
-        withSubscribersFromISR([&](auto& subs) {
-            for (auto& sub : subs) {
-                if ((sub.eventMask & (1u << code)) &&
-                    (event.target == nullptr || sub.controller == event.target))
-                {
-                    QueueHandle_t q = sub.controller->getEventQueue();
-                    if (q) {
-                        BaseType_t result = xQueueSendToBackFromISR(q, &event, &xHigherPriTaskWoken);
-                        if (result != pdPASS) {
-                            debug_print("[EventManager] xQueueSendFromISR FAILED — queue full!\n");
-                        }
-                    }
-                }
-            }
-        });
+/// @copydoc EventManager::getIsrIngressStats
+EventManager::IsrIngressStats EventManager::getIsrIngressStats() const
+{
+    return {isrRing_.pushedCount(), isrRing_.droppedCount(), isrRing_.pending(), isrRing_.capacity()};
+}
 
-        portYIELD_FROM_ISR(xHigherPriTaskWoken);
-    } else {
-        withSubscribers([&](auto& subs) {
-            for (auto& sub : subs) {
-                if ((sub.eventMask & (1u << code)) &&
-                    (event.target == nullptr || sub.controller == event.target))
-                {
-                    QueueHandle_t q = sub.controller->getEventQueue();
-                    if (q) {
-                        if (xQueueSendToBack(q, &event, 0) != pdPASS) {
-                            debug_print("[EventManager] xQueueSend FAILED — queue full!\n");
-                        }
-                    }
+/// @copydoc EventManager::postFromISR
+void EventManager::postFromISR(const Event& event, Delivery delivery)
+{
+    if (!isrRing_.push({event, delivery})) {
+        event.release(); // dropped: counted by the ring, reported through getIsrIngressStats()
+        return;
+    }
+    BaseType_t xHigherPriTaskWoken = pdFALSE;
+    vTaskNotifyGiveFromISR(dispatcher_, &xHigherPriTaskWoken);
+    portYIELD_FROM_ISR(xHigherPriTaskWoken);
+}
+
+/// @copydoc EventManager::deliver
+void EventManager::deliver(const Event& event, Delivery delivery)
+{
+    // One pass over the code's subscribers covers both the queue and the notification
+    const uint8_t code = event.notification.code();
+    dispatch_.forEach(code, [&](FrameworkController* sub) {
+        if (event.target != nullptr && sub != event.target) {
+            return;
+        }
+        if (delivery != Delivery::Notification) {
+            if (sub->getEventQueue()) {
+                event.retain(); // before the send, so the consumer cannot release it first
+                if (!sub->queueEvent(event)) {
+                    event.release();
+                    debug_print("[EventManager] xQueueSend FAILED — queue full!\n");
                 }
             }
-        });
-    }
+        }
+        if (delivery != Delivery::Queue) {
+            sub->notify(code, 1);
+        }
+    });
 }
 
-void EventManager::postEvent(const Event& e)
+/// @copydoc EventManager::dispatcherTask
+void EventManager::dispatcherTask(void* param)
 {
-    enqueue(e);
-    postNotification(e.notification, e.target);
+    auto* self = static_cast<EventManager*>(param);
+    IsrEvent pending;
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        while (self->isrRing_.pop(pending)) {
+            self->deliver(pending.event, pending.delivery);
+            pending.event.release(); // the ISR producer's reference
+        }
+    }
 }
@@ -0,0 +1,86 @@
+/**
+ * @file EventPayloadPool.cpp
+ * @author Ian Archbell
+ * @brief Implementation of the reference-counted event payload pool.
+ *
+ * Part of the PicoFramework application framework.
+ * A block is free while its reference count is zero. acquire() claims a block with a
+ * compare-and-swap from 0 to 1, so producers in tasks and ISRs never contend on a lock.
+ *
+ * @version 0.1
+ * @date 2025-04-22
+ * @license MIT License
+ * @copyright Copyright (c) 2025, Ian Archbell
+ */
+
+#include "events/EventPayloadPool.h"
+#include <cstring>
+
+alignas(8) uint8_t EventPayloadPool::blocks[EVENT_PAYLOAD_BLOCKS][EVENT_PAYLOAD_BLOCK_SIZE];
+std::atomic<uint8_t> EventPayloadPool::refs[EVENT_PAYLOAD_BLOCKS] = {};
+std::atomic<uint32_t> EventPayloadPool::failures{0};
+
+/// @copydoc EventPayloadPool::acquire
+void *EventPayloadPool::acquire(const void *src, size_t size)
+{
+    if (size > EVENT_PAYLOAD_BLOCK_SIZE)
+    {
+        failures.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    for (size_t i = 0; i < EVENT_PAYLOAD_BLOCKS; ++i)
+    {
+        uint8_t expected = 0;
+        if (refs[i].compare_exchange_strong(expected, 1, std::memory_order_acquire))
+        {
+            memcpy(blocks[i], src, size);
+            return blocks[i];
+        }
+    }
+    failures.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+}
+
+/// @copydoc EventPayloadPool::retain
+void EventPayloadPool::retain(const void *data)
+{
+    int i = indexOf(data);
+    if (i >= 0)
+    {
+        refs[i].fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+/// @copydoc EventPayloadPool::release
+void EventPayloadPool::release(const void *data)
+{
+    int i = indexOf(data);
+    if (i >= 0)
+    {
+        refs[i].fetch_sub(1, std::memory_order_release);
+    }
+}
+
+/// @copydoc EventPayloadPool::getStats
+EventPayloadStats EventPayloadPool::getStats()
+{
+    EventPayloadStats stats = {0, EVENT_PAYLOAD_BLOCKS, EVENT_PAYLOAD_BLOCK_SIZE, failures.load(std::memory_order_relaxed)};
+    for (size_t i = 0; i < EVENT_PAYLOAD_BLOCKS; ++i)
+    {
+        if (refs[i].load(std::memory_order_relaxed) != 0)
+        {
+            ++stats.blocksInUse;
+        }
+    }
+    return stats;
+}
+
+int EventPayloadPool::indexOf(const void *data)
+{
+    auto p = static_cast<const uint8_t *>(data);
+    if (p < &blocks[0][0] || p >= &blocks[0][0] + sizeof(blocks))
+    {
+        return -1;
+    }
+    return static_cast<int>((p - &blocks[0][0]) / EVENT_PAYLOAD_BLOCK_SIZE);
+}
@@ -7,13 +7,23 @@
 #include "framework/AppContext.h"
 #include "framework_config.h"
 
+GpioEventManager::PinFilter GpioEventManager::filters[NUM_BANK0_GPIOS];
+
 GpioEventManager& GpioEventManager::getInstance() {
     static GpioEventManager instance;
     return instance;
 }
 
+void GpioEventManager::initFilterLock() {
+    if (!filterLock) {
+        filterLock = spin_lock_init(spin_lock_claim_unused(true));
+    }
+}
+
 void GpioEventManager::enableInterrupt(uint pin, uint32_t edgeMask) {
      if(!handler_set){
+        initFilterLock();
+        eventManager = AppContext::get<EventManager>();
         gpio_set_irq_callback(gpio_event_handler);
         handler_set = true;
     }
@@ -33,7 +43,88 @@ void GpioEventManager::unregisterAll(uint pin) {
     listeners.erase(pin);
 }
 
+void GpioEventManager::setDebounce(uint pin, uint32_t windowUs) {
+    if (pin >= NUM_BANK0_GPIOS) {
+        return;
+    }
+    initFilterLock();
+    uint32_t save = spin_lock_blocking(filterLock);
+    filters[pin].debounceUs = windowUs;
+    spin_unlock(filterLock, save);
+}
+
+void GpioEventManager::setPulseCounting(uint pin, uint32_t periodMs) {
+    if (pin >= NUM_BANK0_GPIOS) {
+        return;
+    }
+    initFilterLock();
+    uint32_t save = spin_lock_blocking(filterLock);
+    filters[pin].periodMs = periodMs; // a period already open is still flushed by its alarm
+    spin_unlock(filterLock, save);
+}
+
+uint32_t GpioEventManager::getSuppressedCount(uint pin) const {
+    return pin < NUM_BANK0_GPIOS ? filters[pin].suppressed : 0;
+}
+
+int64_t GpioEventManager::flushPulses(alarm_id_t, void *userData) {
+    uint pin = static_cast<uint>(reinterpret_cast<uintptr_t>(userData));
+
+    uint32_t save = spin_lock_blocking(filterLock);
+    GpioPulseEvent pulse = filters[pin].pulse;
+    filters[pin].pulse = {};
+    filters[pin].armed = false;
+    spin_unlock(filterLock, save);
+
+#if GPIO_EVENT_HANDLING & GPIO_EVENTS
+    if (pulse.count && eventManager) {
+        static_assert(sizeof(GpioPulseEvent) <= EVENT_INLINE_PAYLOAD_SIZE, "GpioPulseEvent must fit in the event's inline payload");
+        Event evt(SystemNotification::GpioPulse);
+        evt.setPayload(&pulse, sizeof(pulse));
+        eventManager->postEvent(evt); // runs in the alarm IRQ, so this goes through the ISR ring
+    }
+#endif
+    return 0; // one-shot: the next counted edge opens a new period
+}
+
 void GpioEventManager::gpio_event_handler(uint gpio, uint32_t events) {
+    if (gpio < NUM_BANK0_GPIOS && filterLock) {
+        uint32_t now = time_us_32();
+        uint32_t periodMs = 0;
+        bool arm = false;
+
+        uint32_t save = spin_lock_blocking(filterLock);
+        PinFilter &f = filters[gpio];
+        if (f.debounceUs && f.seenEdge && now - f.lastEdgeUs < f.debounceUs) {
+            f.suppressed++;
+            spin_unlock(filterLock, save);
+            return; // bounce
+        }
+        f.lastEdgeUs = now;
+        f.seenEdge = true;
+        periodMs = f.periodMs;
+        if (periodMs) {
+            if (f.pulse.count == 0) {
+                f.pulse.pin = static_cast<uint16_t>(gpio);
+                f.pulse.firstUs = now;
+            }
+            f.pulse.count++;
+            f.pulse.lastUs = now;
+            f.pulse.edges |= static_cast<uint16_t>(events);
+            arm = !f.armed;
+            f.armed = true;
+        }
+        spin_unlock(filterLock, save);
+
+        if (periodMs) {
+            // The alarm pool takes its own lock, so arm outside ours
+            if (arm && add_alarm_in_ms(periodMs, flushPulses, reinterpret_cast<void *>(static_cast<uintptr_t>(gpio)), true) < 0) {
+                flushPulses(0, reinterpret_cast<void *>(static_cast<uintptr_t>(gpio))); // no alarm slot: deliver what we have now
+            }
+            return;
+        }
+    }
+
     GpioEvent gpioEvent = {
         static_cast<uint16_t>(gpio),
         static_cast<uint16_t>(events)
@@ -53,6 +144,8 @@ void GpioEventManager::gpio_event_handler(uint gpio, uint32_t events) {
     // Also send an Event to EventManager if anyone wants to subscribe
 #if GPIO_EVENT_HANDLING & GPIO_EVENTS
     Event evt = Event(SystemNotification::GpioChange, gpioEvent, sizeof(GpioEvent)); // broadcast event to anyone subscribed as target isn't specified
-    AppContext::get<EventManager>()->postEvent(evt); // EventManager knows whther it's an ISR or not
+    if (eventManager) {
+        eventManager->postEvent(evt); // queued in the ISR ring and delivered by the dispatcher task
+    }
 #endif
 }
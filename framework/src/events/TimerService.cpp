@@ -10,32 +10,13 @@
  * start/stop event durations. Integrates with FreeRTOS timers and the
  * EventManager to deliver events in an event-driven, non-blocking manner.
  *
- * @version 0.1
- * @date 2025-03-31
+ * @version 0.2
+ * @date 2025-04-22
  *
  * @license MIT License
  * @copyright Copyright (c) 2025, Ian Archbell
  */
 
-/**
- * @note Memory & Timer Lifetime (v0.1):
- *
- * - One-shot timers (`scheduleAt`, `scheduleDailyAt`, `scheduleDuration`) dynamically allocate an `Event` using `new`
- *   and clean it up automatically after posting (inside the timer callback).
- *
- * - Repeating timers (`scheduleEvery`) also allocate an `Event`, which is reused on each invocation.
- *   It is not deleted automatically and is assumed to remain valid for the lifetime of the timer.
- *
- *  It is now possible to cancel scheduled jobs using a job ID which will delete the timer and free the associated event.
- *
- * @todo Planned for v0.2+:
- * - Persistent job tracking (scheduled jobs stored and reloaded)
- * - Named job handles for cancellation or status checks
- * - Automatic recovery of missed events after reboot
- */
-
-
-
 #include "events/TimerService.h"
 #include <cstdio>
 #include "time/PicoTime.h"
@@ -47,6 +28,10 @@ StaticSemaphore_t TimerService::lockBuffer_;
 TimerService::TimerService() {
     lock_ = xSemaphoreCreateMutexStatic(&lockBuffer_);
     configASSERT(lock_);
+    lastTick_ = xTaskGetTickCount();
+    task_ = xTaskCreateStatic(timerTask, "TimerService", TIMER_SERVICE_STACK_SIZE, this,
+                              TIMER_SERVICE_PRIORITY, taskStack_, &taskBuffer_);
+    configASSERT(task_);
 }
 
 void TimerService::withLock(const std::function<void()>& fn) {
@@ -91,187 +76,93 @@ TimerService &TimerService::instance()
     return inst;
 }
 
-/// @copydoc TimerService::scheduleAt
-void TimerService::scheduleAt(time_t unixTime, const Event &event)
-{
-    std::string defaultId = "at_" + std::to_string(unixTime);
-    scheduleAt(unixTime, event, defaultId);
-}
-
-void TimerService::scheduleAt(time_t unixTime, const Event &event, const std::string &jobId)
+/// @copydoc TimerService::schedule
+TimerJobId TimerService::schedule(uint32_t delayMs, uint32_t periodMs, TimerAction action)
 {
-    time_t now = PicoTime::now();
-    uint32_t delaySeconds = (unixTime > now) ? (unixTime - now) : 0;
-
-    TimerHandle_t handle = xTimerCreate("AtTimer", pdMS_TO_TICKS(delaySeconds * 1000), pdFALSE, new Event(event),
-                                        [](TimerHandle_t xTimer)
-                                        {
-                                            Event *evt = static_cast<Event *>(pvTimerGetTimerID(xTimer));
-                                            if (evt)
-                                            {
-                                                AppContext::get<EventManager>()->postEvent(*evt);
-                                                delete evt;
-                                            }
-                                            xTimerDelete(xTimer, 0);
-                                        });
+    TimerJobId id = 0;
+    Event event = action.event;
+    withLock([&]() {
+        // The wheel lags real time while the task sleeps, so file relative to the current tick
+        uint64_t now = wheel_.now() + static_cast<TickType_t>(xTaskGetTickCount() - lastTick_);
+        id = wheel_.schedule(now + pdMS_TO_TICKS(delayMs), pdMS_TO_TICKS(periodMs), std::move(action));
+    });
 
-    if (handle)
+    if (!id)
     {
-        withLock([&]() {
-            // Cancel and delete old timer if it exists
-            auto it = scheduledJobs.find(jobId);
-            if (it != scheduledJobs.end()) {
-                xTimerStop(it->second, 0);
-                xTimerDelete(it->second, 0);
-                scheduledJobs.erase(it);
-            }
-            scheduledJobs[jobId] = handle;
-        });
-        xTimerStart(handle, 0);
+        printf("[TimerService] ERROR: No free job slot (TIMER_SERVICE_MAX_JOBS = %d)\n", TIMER_SERVICE_MAX_JOBS);
+        event.release();
+        return 0;
     }
+    xTaskNotifyGive(task_);
+    return id;
 }
 
-/// @copydoc TimerService::scheduleEvery
-void TimerService::scheduleEvery(uint32_t intervalMs, const Event &event)
+/// @copydoc TimerService::scheduleAt
+TimerJobId TimerService::scheduleAt(time_t unixTime, const Event &event)
 {
-    std::string defaultId = "interval_" + std::to_string((uint32_t)event.notification.code());
-    scheduleEvery(intervalMs, event, defaultId);
+    time_t now = PicoTime::now();
+    uint32_t delaySeconds = (unixTime > now) ? (unixTime - now) : 0;
+    return schedule(delaySeconds * 1000, 0, {event, nullptr, false});
 }
 
-void TimerService::scheduleEvery(uint32_t intervalMs, const Event &event, const std::string &jobId)
+/// @copydoc TimerService::scheduleEvery
+TimerJobId TimerService::scheduleEvery(uint32_t intervalMs, const Event &event)
 {
-    TimerHandle_t handle = xTimerCreate("EveryTimer", pdMS_TO_TICKS(intervalMs), pdTRUE, new Event(event),
-                                        [](TimerHandle_t xTimer)
-                                        {
-                                            Event *evt = static_cast<Event *>(pvTimerGetTimerID(xTimer));
-                                            if (evt)
-                                            {
-                                                AppContext::get<EventManager>()->postEvent(*evt);
-                                            }
-                                        });
-
-    if (handle)
-    {
-        withLock([&]() {
-            scheduledJobs[jobId] = handle;
-        });        
-        xTimerStart(handle, 0);
-    }
+    return schedule(intervalMs, intervalMs, {event, nullptr, true});
 }
 
 /// @copydoc TimerService::scheduleDailyAt
-void TimerService::scheduleDailyAt(TimeOfDay time, DaysOfWeek days, const Event &event)
-{
-    std::string defaultId = "daily_" + std::to_string((uint32_t)event.notification.code()) + "_" + std::to_string(toSeconds(time));
-    scheduleDailyAt(time, days, event, defaultId);
-}
-
-void TimerService::scheduleDailyAt(TimeOfDay time, DaysOfWeek days, const Event &event, const std::string &jobId)
+TimerJobId TimerService::scheduleDailyAt(TimeOfDay time, DaysOfWeek days, const Event &event)
 {
     time_t now = PicoTime::now();
     uint32_t delaySeconds = secondsUntilNextMatch(time, days, now);
 
-    TimerHandle_t handle = xTimerCreate("DailyJob", pdMS_TO_TICKS(delaySeconds * 1000), pdFALSE, new Event(event),
-                                        [](TimerHandle_t xTimer)
-                                        {
-                                            Event *evt = static_cast<Event *>(pvTimerGetTimerID(xTimer));
-                                            if (evt)
-                                            {
-                                                AppContext::get<EventManager>()->postEvent(*evt);
-                                                delete evt;
-                                            }
-                                            xTimerDelete(xTimer, 0);
-                                        });
-
-    if (handle)
+    TimerJobId id = schedule(delaySeconds * 1000, 0, {event, nullptr, false});
+    if (id)
     {
-        withLock([&]() {
-            scheduledJobs[jobId] = handle;
-        });        
-        xTimerStart(handle, 0);
         TimerJob job{time, days, 0, event, {}, true};
         rescheduleDailyJob(job);
     }
+    return id;
 }
 
 /// @copydoc TimerService::scheduleDuration
-void TimerService::scheduleDuration(TimeOfDay start, DaysOfWeek days, uint32_t durationMs,
-                                    const Event &startEvent, const Event &stopEvent)
-{
-    std::string baseId = "duration_" + std::to_string((uint32_t)startEvent.notification.code());
-    scheduleDuration(start, days, durationMs, startEvent, stopEvent, baseId);
-}
-
-void TimerService::scheduleDuration(TimeOfDay start, DaysOfWeek days, uint32_t durationMs,
-                                    const Event &startEvent, const Event &stopEvent, const std::string &baseId)
+TimerService::DurationJobs TimerService::scheduleDuration(TimeOfDay start, DaysOfWeek days, uint32_t durationMs,
+                                                          const Event &startEvent, const Event &stopEvent)
 {
     time_t now = PicoTime::now();
     uint32_t startDelay = secondsUntilNextMatch(start, days, now);
-
-    std::string startId = baseId + "_start";
-    std::string stopId = baseId + "_stop";
-
-    TimerHandle_t startHandle = xTimerCreate("StartJob", pdMS_TO_TICKS(startDelay * 1000), pdFALSE, new Event(startEvent),
-                                             [](TimerHandle_t xTimer)
-                                             {
-                                                 Event *evt = static_cast<Event *>(pvTimerGetTimerID(xTimer));
-                                                 if (evt)
-                                                 {
-                                                     AppContext::get<EventManager>()->postEvent(*evt);
-                                                     delete evt;
-                                                 }
-                                                 xTimerDelete(xTimer, 0);
-                                             });
-
-    if (startHandle)
-    {
-        withLock([&]() {
-            scheduledJobs[startId] = startHandle;
-        });        
-        xTimerStart(startHandle, 0);
-    }
-
     uint32_t stopDelay = startDelay + durationMs / 1000;
 
-    TimerHandle_t stopHandle = xTimerCreate("StopJob", pdMS_TO_TICKS(stopDelay * 1000), pdFALSE, new Event(stopEvent),
-                                            [](TimerHandle_t xTimer)
-                                            {
-                                                Event *evt = static_cast<Event *>(pvTimerGetTimerID(xTimer));
-                                                if (evt)
-                                                {
-                                                    AppContext::get<EventManager>()->postEvent(*evt);
-                                                    delete evt;
-                                                }
-                                                xTimerDelete(xTimer, 0);
-                                            });
-
-    if (stopHandle)
-    {
-        withLock([&]() {
-            scheduledJobs[stopId] = stopHandle;
-        });   
-        xTimerStart(stopHandle, 0);
-    }
+    DurationJobs jobs;
+    jobs.start = schedule(startDelay * 1000, 0, {startEvent, nullptr, false});
+    jobs.stop = schedule(stopDelay * 1000, 0, {stopEvent, nullptr, false});
 
     TimerJob job{start, days, durationMs, startEvent, stopEvent, true};
     rescheduleDailyJob(job);
+    return jobs;
 }
 
 /// @copydoc TimerService::cancel
-bool TimerService::cancel(const std::string &jobId) {
+bool TimerService::cancel(TimerJobId jobId) {
+    TimerAction removed;
     bool success = false;
     withLock([&]() {
-        auto it = scheduledJobs.find(jobId);
-        if (it != scheduledJobs.end()) {
-            xTimerStop(it->second, 0);
-            xTimerDelete(it->second, 0);
-            scheduledJobs.erase(it);
-            success = true;
-        }
+        success = wheel_.cancel(jobId, &removed);
     });
+    if (success) {
+        removed.event.release(); // the reference the job was holding
+    }
     return success;
 }
 
+/// @copydoc TimerService::activeJobs
+size_t TimerService::activeJobs() {
+    size_t n = 0;
+    withLock([&]() { n = wheel_.size(); });
+    return n;
+}
+
 /// @copydoc TimerService::checkMissedEvents
 void TimerService::checkMissedEvents(time_t)
 {
@@ -284,32 +175,68 @@ void TimerService::rescheduleDailyJob(const TimerJob &)
     // Not implemented in v0.2
 }
 
-void TimerService::scheduleCallbackAt(time_t when, std::function<void()> callback) {
+/// @copydoc TimerService::scheduleCallbackAt
+TimerJobId TimerService::scheduleCallbackAt(time_t when, std::function<void()> callback) {
     time_t now = PicoTime::now();
     if (when <= now) {
         printf("[TimerService] WARNING: scheduled time is in the past (%lld <= %lld)\n", when, now);
-        return;
+        return 0;
     }
 
-    auto* cb = new std::function<void()>(std::move(callback));
     uint32_t delayMs = static_cast<uint32_t>((when - now) * 1000);
+    return schedule(delayMs, 0, {Event(), std::move(callback), false});
+}
 
-    TimerHandle_t handle = xTimerCreate("CbTimer", pdMS_TO_TICKS(delayMs), pdFALSE, cb,
-        [](TimerHandle_t xTimer) {
-            auto* fn = static_cast<std::function<void()>*>(pvTimerGetTimerID(xTimer));
-            if (fn) {
-                (*fn)();    // 🔥 fire the user callback
-                delete fn;  // ✅ clean up
-            }
-            xTimerDelete(xTimer, 0);
-        });
-
-    if (handle) {
-        xTimerStart(handle, 0);
-    } else {
-        printf("[TimerService] ERROR: Failed to create xTimer\n");
-        delete cb;
+/// @copydoc TimerService::fire
+void TimerService::fire(TimerAction &action)
+{
+    if (action.callback) {
+        action.callback();
+        return;
+    }
+    if (action.repeating) {
+        action.event.retain(); // the wheel keeps its reference for the next interval
     }
+    AppContext::get<EventManager>()->postEvent(action.event);
 }
 
+/// @copydoc TimerService::timerTask
+void TimerService::timerTask(void *param)
+{
+    TimerService *self = static_cast<TimerService *>(param);
+    for (;;)
+    {
+        xSemaphoreTake(self->lock_, portMAX_DELAY);
+        TickType_t tick = xTaskGetTickCount();
+        self->wheel_.advance(self->wheel_.now() + static_cast<TickType_t>(tick - self->lastTick_));
+        self->lastTick_ = tick;
+        xSemaphoreGive(self->lock_);
+
+        // Fire outside the lock so callbacks can schedule or cancel jobs
+        TimerAction action;
+        for (;;)
+        {
+            xSemaphoreTake(self->lock_, portMAX_DELAY);
+            bool due = self->wheel_.popDue(action);
+            xSemaphoreGive(self->lock_);
+            if (!due)
+            {
+                break;
+            }
+            self->fire(action);
+        }
+        action = TimerAction(); // drop any callback captures before sleeping
+
+        xSemaphoreTake(self->lock_, portMAX_DELAY);
+        uint64_t next = self->wheel_.ticksUntilNext();
+        TickType_t elapsed = xTaskGetTickCount() - self->lastTick_;
+        xSemaphoreGive(self->lock_);
 
+        TickType_t wait = portMAX_DELAY; // nothing scheduled: sleep until schedule() notifies
+        if (next)
+        {
+            wait = next > elapsed ? static_cast<TickType_t>(next - elapsed < portMAX_DELAY ? next - elapsed : portMAX_DELAY - 1) : 0;
+        }
+        ulTaskNotifyTake(pdTRUE, wait);
+    }
+}
@@ -14,6 +14,12 @@
     #include "storage/FatFsStorageManager.h"
 #endif
 #include "framework_config.h"
+#if KV_STORE_FLASH_SIZE > 0
+    #include "storage/KvStore.h"
+#endif
+#if STORAGE_CACHE_BUDGET > 0
+    #include "storage/CachingStorageManager.h"
+#endif
 #include "DebugTrace.h"
 TRACE_INIT(AppContext);
 
@@ -29,19 +35,21 @@ void AppContext::initFrameworkServices() {
     #if PICO_HTTP_ENABLE_LITTLEFS
         TRACE("[AppContext] Initializing LittleFS storage manager.\n");
         static LittleFsStorageManager littlefs;
-        registerService<StorageManager>(&littlefs);
-        TRACE("[AppContext] LittleFS storage manager registered.\n");
-        static JsonService jsonService(&littlefs);
-        registerService<JsonService>(&jsonService);
-        TRACE("[AppContext] Registered JsonService.\n");
-        
+        StorageManager *storage = &littlefs;
     #else
         static FatFsStorageManager fatfs;
-        registerService<StorageManager>(&fatfs);
-        static JsonService jsonService(&fatfs);
-        registerService<JsonService>(&jsonService);
-        TRACE("[AppContext] Registered FatFsStorageManager.\n");
+        StorageManager *storage = &fatfs;
     #endif
+    #if STORAGE_CACHE_BUDGET > 0
+        static CachingStorageManager storageCache(storage, STORAGE_CACHE_BUDGET);
+        storage = &storageCache;
+        TRACE("[AppContext] Caching storage in %u bytes of RAM.\n", static_cast<unsigned>(STORAGE_CACHE_BUDGET));
+    #endif
+        registerService<StorageManager>(storage);
+        TRACE("[AppContext] Registered StorageManager.\n");
+        static JsonService jsonService(storage);
+        registerService<JsonService>(&jsonService);
+        TRACE("[AppContext] Registered JsonService.\n");
         // Time manager (always present)
         static TimeManager timeMgr;
         registerService<TimeManager>(&timeMgr);
@@ -57,6 +65,11 @@ void AppContext::initFrameworkServices() {
         static Logger logger;
         registerService<Logger>(&logger);
         TRACE("[AppContext] Registered Logger.\n");
+    #if KV_STORE_FLASH_SIZE > 0
+        static KvStore kvStore;
+        registerService<KvStore>(&kvStore);
+        TRACE("[AppContext] Registered KvStore.\n");
+    #endif
     #if defined(ENABLE_GPIO_EVENTS)
         static GpioEventManager gpioEventManager = GpioEventManager::getInstance();
         AppContext::registerService<GpioEventManager>(&gpioEventManager);
@@ -23,7 +23,7 @@
  * Intended to be subclassed. You override `onStart()`, `onEvent()`, and `poll()`
  * to define your application's behavior.
  *
- * @version 0.1
+ * @version 0.2
  * @date 2025-03-31
  * @license MIT License
  * @copyright Copyright (c) 2025, Ian Archbell
@@ -35,6 +35,20 @@
 #include "events/EventManager.h"
 #include "events/Event.h"
 #include "http/Router.h"
+#include <cstdio>
+#include <cstring>
+
+/// True once @p now has reached @p deadline, allowing for tick count wrap
+static inline bool reached(TickType_t now, TickType_t deadline)
+{
+    return static_cast<TickType_t>(now - deadline) < (portMAX_DELAY >> 1);
+}
+
+/// Ticks from @p now until @p deadline, 0 if it has passed
+static inline TickType_t ticksUntil(TickType_t now, TickType_t deadline)
+{
+    return reached(now, deadline) ? 0 : static_cast<TickType_t>(deadline - now);
+}
 
 FrameworkController::FrameworkController(const char *name, Router &sharedRouter, uint16_t stackSize, UBaseType_t priority)
     : FrameworkTask(name, stackSize, priority),
@@ -46,11 +60,87 @@ void FrameworkController::run()
     enableEventQueue();  // MUST be here to initialize queue before use
     initRoutes();        // Call initRoutes() to set up routes
     onStart();           // Call onStart() to initialize controller state
+    nextPoll_ = xTaskGetTickCount(); // poll once to learn the interval and any runEvery() deadlines
     while (true)
     {
-        waitAndDispatch(getPollIntervalTicks()); // Wait for notifications or timeout
-        poll();               // Call user logic
+        TickType_t now = xTaskGetTickCount();
+        waitAndDispatch(ticksUntilNextDeadline(now)); // Sleep until an event or the next deadline
+
+        now = xTaskGetTickCount();
+        runDuePeriodicJobs(now);
+
+        if (pollScheduled_ && reached(now, nextPoll_))
+        {
+            runEveryDue_ = portMAX_DELAY;
+            poll();           // Call user logic
+            TickType_t interval = getPollIntervalTicks();
+            TickType_t next = runEveryDue_ < interval ? runEveryDue_ : interval;
+            pollScheduled_ = next != portMAX_DELAY; // nothing due and polling disabled: wake for events only
+            nextPoll_ = xTaskGetTickCount() + next;
+        }
+    }
+}
+
+/// @copydoc FrameworkController::ticksUntilNextDeadline
+TickType_t FrameworkController::ticksUntilNextDeadline(TickType_t now) const
+{
+    TickType_t wait = pollScheduled_ ? ticksUntil(now, nextPoll_) : portMAX_DELAY;
+    for (const auto &job : periodicJobs_)
+    {
+        if (job.fn)
+        {
+            TickType_t due = ticksUntil(now, job.next);
+            wait = due < wait ? due : wait;
+        }
+    }
+    return wait;
+}
+
+/// @copydoc FrameworkController::runDuePeriodicJobs
+void FrameworkController::runDuePeriodicJobs(TickType_t now)
+{
+    for (auto &job : periodicJobs_)
+    {
+        if (!job.fn || !reached(now, job.next))
+        {
+            continue;
+        }
+        job.next += job.interval;
+        if (reached(now, job.next))
+        {
+            job.next = now + job.interval; // overran by a whole interval: skip rather than burst
+        }
+        job.fn();
+    }
+}
+
+/// @copydoc FrameworkController::addPeriodicJob
+int FrameworkController::addPeriodicJob(uint32_t intervalMs, std::function<void()> fn)
+{
+    TickType_t interval = pdMS_TO_TICKS(intervalMs) ? pdMS_TO_TICKS(intervalMs) : 1;
+    for (int i = 0; i < CONTROLLER_MAX_PERIODIC_JOBS; ++i)
+    {
+        if (!periodicJobs_[i].fn)
+        {
+            periodicJobs_[i].fn = std::move(fn);
+            periodicJobs_[i].interval = interval;
+            periodicJobs_[i].next = xTaskGetTickCount() + interval;
+            return i;
+        }
+    }
+    printf("[%s] No free periodic job slot (CONTROLLER_MAX_PERIODIC_JOBS = %d)\n", getName(), CONTROLLER_MAX_PERIODIC_JOBS);
+    return -1;
+}
+
+/// @copydoc FrameworkController::removePeriodicJob
+bool FrameworkController::removePeriodicJob(int id)
+{
+    if (id < 0 || id >= CONTROLLER_MAX_PERIODIC_JOBS || !periodicJobs_[id].fn)
+    {
+        return false;
     }
+    periodicJobs_[id].fn = nullptr;
+    return true;
 }
 
 /// @copydoc FrameworkController::onStart
@@ -76,29 +166,107 @@ void FrameworkController::onEvent(const Event &event)
 /// @copydoc FrameworkController::poll
 void FrameworkController::poll()
 {
-    // Default no-op
+    // Default: do nothing
 }
 
 /// @copydoc FrameworkController::waitAndDispatch
-void FrameworkController::waitAndDispatch(uint32_t timeoutMs)
+void FrameworkController::waitAndDispatch(TickType_t timeoutTicks)
 {
     Event event;
-    if (getNextEvent(event, timeoutMs))
+    if (receiveEvent(event, timeoutTicks))
     {
         onEvent(event);
+        event.release(); // this queue's reference to an owned payload
+    }
+}
+
+/// @copydoc FrameworkController::enableEventQueue
+void FrameworkController::enableEventQueue(size_t depth)
+{
+    if (eventQueue_) {
+        return;
+    }
+    eventQueue_ = xQueueCreate(depth, sizeof(Event));
+    highQueue_ = xQueueCreate(EVENT_HIGH_QUEUE_LENGTH, sizeof(Event));
+    queueSet_ = xQueueCreateSet(depth + EVENT_HIGH_QUEUE_LENGTH);
+    configASSERT(eventQueue_ && highQueue_ && queueSet_);
+    // Both lanes are empty here, as xQueueAddToSet requires
+    xQueueAddToSet(highQueue_, queueSet_);
+    xQueueAddToSet(eventQueue_, queueSet_);
+}
+
+/// @copydoc FrameworkController::queueEvent
+bool FrameworkController::queueEvent(const Event &event)
+{
+    if (!eventQueue_) {
+        return false;
+    }
+    QueueHandle_t lane = event.priority == EventPriority::High ? highQueue_ : eventQueue_;
+    if (xQueueSendToBack(lane, &event, 0) != pdPASS) {
+        dropped_[static_cast<size_t>(event.priority)].fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+/// @copydoc FrameworkController::receiveEvent
+bool FrameworkController::receiveEvent(Event &event, TickType_t timeoutTicks)
+{
+    // The set holds one entry per queued event. Taking exactly one entry per event keeps it
+    // in step with the lanes even though we read High first rather than the lane it named.
+    if (!queueSet_ || xQueueSelectFromSet(queueSet_, timeoutTicks) == nullptr) {
+        return false;
     }
+    return xQueueReceive(highQueue_, &event, 0) == pdTRUE || xQueueReceive(eventQueue_, &event, 0) == pdTRUE;
 }
 
 /// @copydoc FrameworkController::runEvery
 void FrameworkController::runEvery(uint32_t intervalMs, const std::function<void()> &fn, const char *id)
 {
-    TickType_t now = xTaskGetTickCount();
-    TickType_t &last = _timers[std::string(id)];
+    // FNV-1a: the loop compares hashes, and the strings themselves only on a hash match
+    uint32_t hash = 2166136261u;
+    for (const char *p = id; *p; ++p)
+    {
+        hash = (hash ^ static_cast<uint8_t>(*p)) * 16777619u;
+    }
 
-    if ((now - last) >= pdMS_TO_TICKS(intervalMs))
+    RunEveryTimer *timer = nullptr;
+    for (size_t i = 0; i < runEveryCount_; ++i)
+    {
+        RunEveryTimer &t = runEveryTimers_[i];
+        if (t.idHash == hash && (t.id == id || strcmp(t.id, id) == 0))
+        {
+            timer = &t;
+            break;
+        }
+    }
+    if (!timer)
+    {
+        configASSERT(runEveryCount_ < CONTROLLER_MAX_RUN_EVERY); // raise CONTROLLER_MAX_RUN_EVERY
+        if (runEveryCount_ == CONTROLLER_MAX_RUN_EVERY)
+        {
+            if (!runEveryOverflowWarned_)
+            {
+                printf("[%s] runEvery(\"%s\"): more than CONTROLLER_MAX_RUN_EVERY IDs, running it on every poll\n", getName(), id);
+                runEveryOverflowWarned_ = true;
+            }
+            fn();
+            return;
+        }
+        timer = &runEveryTimers_[runEveryCount_++];
+        *timer = {id, hash, 0};
+    }
+
+    TickType_t now = xTaskGetTickCount();
+    TickType_t interval = pdMS_TO_TICKS(intervalMs);
+    if ((now - timer->last) >= interval)
     {
         fn();
-        last = now;
+        timer->last = now;
     }
+
+    TickType_t remaining = interval - (now - timer->last);
+    remaining = remaining ? remaining : 1;
+    runEveryDue_ = remaining < runEveryDue_ ? remaining : runEveryDue_;
 }
 
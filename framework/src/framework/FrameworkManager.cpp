@@ -165,8 +165,7 @@ void FrameworkManager::poll()
             {
                 networkFailures++;
 
-                Event event{SystemNotification::NetworkDown};
-                AppContext::get<EventManager>()->postEvent(event);
+                AppContext::get<EventManager>()->postEvent(Event(SystemNotification::NetworkDown).withPriority(EventPriority::High));
 
                 if (WIFI_REBOOT_ON_FAILURE && networkFailures >= 3)
                 {
@@ -43,7 +43,7 @@ bool FrameworkModel::load()
     TRACE("[FrameworkModel] Loading data from %s\n", storagePath.c_str());
     if (!jsonService->load(storagePath))
         return false;
-    collection = jsonService->data().value("items", nlohmann::json::array());
+    collection = jsonService->data().value("items", FrameworkJson::array());
     if (collection.empty())
     {
         TRACE("No items found in %s\n", storagePath.c_str());
@@ -102,7 +102,7 @@ bool FrameworkModel::create(const nlohmann::json &item)
     std::string id = item[idField];
     if (find(id))
         return false;
-    collection.push_back(item);
+    collection.push_back(FrameworkJson(item));
     return true;
 }
 
@@ -158,7 +158,7 @@ bool FrameworkModel::save(const std::string &id, const nlohmann::json &data)
     }
 
     // If not found, append
-    collection.push_back(data);
+    collection.push_back(FrameworkJson(data));
     return save();
 }
 
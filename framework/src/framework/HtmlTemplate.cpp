@@ -0,0 +1,218 @@
+/**
+ * @file HtmlTemplate.cpp
+ * @author Ian Archbell
+ * @brief Implementation of compiled {{key}} templates and the file template cache.
+ *
+ * Part of the PicoFramework application framework.
+ *
+ * @version 0.1
+ * @date 2025-04-30
+ * @license MIT License
+ * @copyright Copyright (c) 2025, Ian Archbell
+ */
+
+#include "framework_config.h" // Must be included before DebugTrace.h to ensure framework_config.h is processed first
+#include "DebugTrace.h"
+TRACE_INIT(HtmlTemplate)
+
+#include "framework/HtmlTemplate.h"
+#include "framework/AppContext.h"
+#include "storage/StorageManager.h"
+#include "http/HttpResponse.h"
+
+#include <cstring>
+#include <FreeRTOS.h>
+#include <semphr.h>
+
+namespace
+{
+    struct CacheEntry
+    {
+        std::shared_ptr<const HtmlTemplate> tpl;
+        size_t size;      ///< File size when compiled, used to detect changes
+        uint32_t lastUse; ///< useClock value when last loaded, for LRU eviction
+    };
+
+    std::map<std::string, CacheEntry> cache;
+    uint32_t useClock = 0;
+
+    StaticSemaphore_t cacheMutexBuffer;
+    SemaphoreHandle_t cacheMutex = xSemaphoreCreateMutexStatic(&cacheMutexBuffer);
+
+    struct CacheLock
+    {
+        CacheLock() { xSemaphoreTake(cacheMutex, portMAX_DELAY); }
+        ~CacheLock() { xSemaphoreGive(cacheMutex); }
+    };
+}
+
+// Scan the source once, splitting it into literal runs and {{key}} slots
+HtmlTemplate::HtmlTemplate(std::string text)
+    : source(std::move(text))
+{
+    size_t literalStart = 0;
+    size_t pos = 0;
+    while ((pos = source.find("{{", pos)) != std::string::npos)
+    {
+        size_t close = source.find("}}", pos + 2);
+        if (close == std::string::npos)
+        {
+            break;
+        }
+        if (close == pos + 2)
+        {
+            pos = close + 2; // "{{}}" is literal text
+            continue;
+        }
+        if (pos > literalStart)
+        {
+            segments.push_back({literalStart, pos - literalStart, {}});
+        }
+        segments.push_back({pos, close + 2 - pos, source.substr(pos + 2, close - pos - 2)});
+        pos = close + 2;
+        literalStart = pos;
+    }
+    if (literalStart < source.size())
+    {
+        segments.push_back({literalStart, source.size() - literalStart, {}});
+    }
+    segments.shrink_to_fit();
+}
+
+/// @copydoc HtmlTemplate::compile
+std::shared_ptr<const HtmlTemplate> HtmlTemplate::compile(std::string text)
+{
+    return std::shared_ptr<const HtmlTemplate>(new HtmlTemplate(std::move(text)));
+}
+
+/// @copydoc HtmlTemplate::load
+std::shared_ptr<const HtmlTemplate> HtmlTemplate::load(const std::string &path)
+{
+    auto *storage = AppContext::get<StorageManager>();
+    if (!storage || !storage->exists(path))
+    {
+        return nullptr;
+    }
+    size_t size = storage->getFileSize(path);
+
+    {
+        CacheLock lock;
+        auto it = cache.find(path);
+        // Size is all the StorageManager reports; a same-size edit needs invalidate()
+        if (it != cache.end() && it->second.size == size)
+        {
+            it->second.lastUse = ++useClock;
+            return it->second.tpl;
+        }
+    }
+
+    std::vector<uint8_t> buf;
+    if (!storage->readFile(path, buf))
+    {
+        return nullptr;
+    }
+    auto tpl = compile(std::string(buf.begin(), buf.end()));
+    TRACE("Compiled %s: %zu bytes\n", path.c_str(), buf.size());
+
+    CacheLock lock;
+    if (cache.size() >= HTML_TEMPLATE_CACHE_ENTRIES && cache.find(path) == cache.end())
+    {
+        auto victim = cache.begin();
+        for (auto it = cache.begin(); it != cache.end(); ++it)
+        {
+            if (it->second.lastUse < victim->second.lastUse)
+            {
+                victim = it;
+            }
+        }
+        cache.erase(victim); // least recently used
+    }
+    cache[path] = {tpl, size, ++useClock};
+    return tpl;
+}
+
+/// @copydoc HtmlTemplate::invalidate
+void HtmlTemplate::invalidate(const std::string &path)
+{
+    CacheLock lock;
+    cache.erase(path);
+}
+
+/// @copydoc HtmlTemplate::clearCache
+void HtmlTemplate::clearCache()
+{
+    CacheLock lock;
+    cache.clear();
+}
+
+const char *HtmlTemplate::resolve(const Segment &seg, const Context &context, size_t &length) const
+{
+    if (!seg.key.empty())
+    {
+        auto it = context.find(seg.key);
+        if (it != context.end())
+        {
+            length = it->second.size();
+            return it->second.data();
+        }
+    }
+    length = seg.length;
+    return source.data() + seg.offset;
+}
+
+/// @copydoc HtmlTemplate::renderedLength
+size_t HtmlTemplate::renderedLength(const Context &context) const
+{
+    size_t total = 0;
+    for (const auto &seg : segments)
+    {
+        size_t length;
+        resolve(seg, context, length);
+        total += length;
+    }
+    return total;
+}
+
+/// @copydoc HtmlTemplate::render
+std::string HtmlTemplate::render(const Context &context) const
+{
+    std::string out;
+    out.reserve(renderedLength(context));
+    for (const auto &seg : segments)
+    {
+        size_t length;
+        const char *text = resolve(seg, context, length);
+        out.append(text, length);
+    }
+    return out;
+}
+
+/// @copydoc HtmlTemplate::stream
+void HtmlTemplate::stream(HttpResponse &res, const Context &context, const std::string &contentType) const
+{
+    res.start(res.getStatusCode(), renderedLength(context), contentType);
+
+    char buffer[HTML_TEMPLATE_BUFFER_SIZE];
+    size_t used = 0;
+    for (const auto &seg : segments)
+    {
+        size_t length;
+        const char *text = resolve(seg, context, length);
+        if (used + length > sizeof(buffer))
+        {
+            res.writeChunk(buffer, used);
+            used = 0;
+        }
+        if (length > sizeof(buffer))
+        {
+            res.writeChunk(text, length); // large literal: send straight from the template
+            continue;
+        }
+        memcpy(buffer + used, text, length);
+        used += length;
+    }
+    if (used > 0)
+    {
+        res.writeChunk(buffer, used);
+    }
+}
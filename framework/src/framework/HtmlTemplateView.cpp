@@ -4,15 +4,13 @@
  */
 
 #include "framework/HtmlTemplateView.h"
-#include "framework/AppContext.h"
-#include "storage/StorageManager.h"
 
 HtmlTemplateView::HtmlTemplateView(const std::string &source, TemplateSource mode)
     : mode_(mode)
 {
     if (mode_ == TemplateSource::Inline)
     {
-        templateSource_ = source;
+        inline_ = HtmlTemplate::compile(source);
     }
     else
     {
@@ -20,42 +18,33 @@ HtmlTemplateView::HtmlTemplateView(const std::string &source, TemplateSource mod
     }
 }
 
-std::string HtmlTemplateView::render(const std::map<std::string, std::string> &context) const
+std::shared_ptr<const HtmlTemplate> HtmlTemplateView::getTemplate() const
 {
-    std::string tpl;
-
     if (mode_ == TemplateSource::Inline)
     {
-        tpl = templateSource_;
-    }
-    else
-    {
-        auto *storage = AppContext::get<StorageManager>();
-        std::vector<uint8_t> buf;
-        if (storage && storage->readFile(filePath_, buf))
-        {
-            tpl.assign(buf.begin(), buf.end());
-        }
-        else
-        {
-            tpl = "<h1>Template not found</h1>";
-        }
+        return inline_;
     }
 
-    for (const auto &[key, value] : context)
+    auto tpl = HtmlTemplate::load(filePath_);
+    if (!tpl)
     {
-        std::string placeholder = "{{" + key + "}}";
-        size_t pos = 0;
-        while ((pos = tpl.find(placeholder, pos)) != std::string::npos)
-        {
-            tpl.replace(pos, placeholder.length(), value);
-            pos += value.length();
-        }
+        static const auto notFound = HtmlTemplate::compile("<h1>Template not found</h1>");
+        return notFound;
     }
-
     return tpl;
 }
 
+std::string HtmlTemplateView::render(const std::map<std::string, std::string> &context) const
+{
+    return getTemplate()->render(context);
+}
+
+bool HtmlTemplateView::stream(HttpResponse &res, const std::map<std::string, std::string> &context) const
+{
+    getTemplate()->stream(res, context, getContentType());
+    return true;
+}
+
 std::string HtmlTemplateView::getContentType() const
 {
     return "text/html";
@@ -1,17 +1,94 @@
 #include "http/HttpClient.h"
+#include "http/HttpConnectionPool.h"
 #include "http/HttpRequest.h"
 #include "http/HttpResponse.h"
 #include "http/HttpParser.h"
 #include "http/ChunkedDecoder.h"
 #include "network/Tcp.h"
+#include "storage/StreamingFileWriter.h"
+#include "utility/utility.h"
 
 #include <sstream>
 #include <cstring>
+#include <cstdlib>
+#include <tuple>
 
 #include "framework_config.h"
 #include "DebugTrace.h"
 TRACE_INIT(HttpClient)
 
+/// Methods that may be sent again if a reused connection turns out to be dead (RFC 9110 section 9.2.2)
+static bool isIdempotent(const std::string &method)
+{
+    return method == "GET" || method == "HEAD" || method == "PUT" || method == "DELETE" || method == "OPTIONS";
+}
+
+std::unique_ptr<Tcp> HttpClient::connect(const HttpRequest &request, uint16_t port, bool useTls)
+{
+    const std::string &host = request.getHost();
+    const std::string &cert = request.getRootCACertificate();
+
+    auto socket = std::make_unique<Tcp>();
+    if (useTls)
+    {
+        if (!cert.empty())
+        {
+            socket->setRootCACertificate(cert);
+        }
+        socket->setHostname(host.c_str()); // required for SNI
+    }
+
+    if (!socket->connect(host.c_str(), port, useTls))
+    {
+        return nullptr;
+    }
+    return socket;
+}
+
+uint32_t HttpClient::keepAliveMs(const std::string &rawHeader, const std::map<std::string, std::string> &headers,
+                                 bool noBody, size_t leftover)
+{
+    // HTTP/1.0 servers close by default
+    if (rawHeader.compare(0, 9, "HTTP/1.1 ") != 0)
+    {
+        return 0;
+    }
+
+    auto connection = headers.find("connection");
+    if (connection != headers.end() && toLower(connection->second).find("close") != std::string::npos)
+    {
+        return 0;
+    }
+
+    // Only a body with a known end leaves the connection at the start of the next response
+    if (!noBody && !HttpParser::isChunkedEncoding(headers))
+    {
+        auto length = headers.find("content-length");
+        if (length == headers.end() || leftover > strtoul(length->second.c_str(), nullptr, 10))
+        {
+            return 0;
+        }
+    }
+
+    // Keep-Alive: timeout=N is when the server will close it; give it up a second sooner
+    uint32_t ms = HTTP_CLIENT_KEEPALIVE_MS;
+    auto keepAlive = headers.find("keep-alive");
+    if (keepAlive != headers.end())
+    {
+        size_t pos = toLower(keepAlive->second).find("timeout=");
+        if (pos != std::string::npos)
+        {
+            unsigned long seconds = strtoul(keepAlive->second.c_str() + pos + strlen("timeout="), nullptr, 10);
+            uint32_t serverMs = seconds > 1 ? (seconds - 1) * 1000 : 0;
+            if (serverMs < ms)
+            {
+                ms = serverMs;
+            }
+        }
+    }
+    return ms;
+}
+
 bool HttpClient::sendRequest(const HttpRequest &request, HttpResponse &response)
 {
 
@@ -28,8 +105,6 @@ bool HttpClient::sendRequest(const HttpRequest &request, HttpResponse &response)
     const bool useTls = (protocol == "https");
     const uint16_t port = useTls ? 443 : 80;
 
-    Tcp socket;
-
     TRACE("Connecting to %s:%d\n", host.c_str(), port);
     TRACE("Using TLS: %s\n", useTls ? "true" : "false");
     TRACE("Root CA: %s\n", cert.empty() ? "none" : "set");
@@ -42,18 +117,16 @@ bool HttpClient::sendRequest(const HttpRequest &request, HttpResponse &response)
         TRACE("  %s: %s\n", key.c_str(), value.c_str());
     }
 
-    if (useTls)
+    // A Connection header from the caller wins; otherwise ask for the connection to be kept
+    bool setsConnection = false;
+    bool callerCloses = false;
+    for (const auto &[key, value] : headers)
     {
-        if (!cert.empty())
+        if (toLower(key) == "connection")
         {
-            socket.setRootCACertificate(cert);
+            setsConnection = true;
+            callerCloses = toLower(value).find("close") != std::string::npos;
         }
-        socket.setHostname(host.c_str()); // required for SNI
-    }
-
-    if (!socket.connect(host.c_str(), port, useTls))
-    {
-        return false;
     }
 
     std::ostringstream req;
@@ -65,6 +138,11 @@ bool HttpClient::sendRequest(const HttpRequest &request, HttpResponse &response)
         req << key << ": " << value << "\r\n";
     }
 
+    if (!setsConnection && HTTP_CLIENT_POOL_SIZE > 0)
+    {
+        req << "Connection: keep-alive\r\n";
+    }
+
     if (!body.empty())
     {
         req << "Content-Length: " << body.length() << "\r\n";
@@ -77,21 +155,52 @@ bool HttpClient::sendRequest(const HttpRequest &request, HttpResponse &response)
     }
 
     const std::string requestStr = req.str();
-    if (!socket.send(requestStr.c_str(), requestStr.length()))
-    {
-        return false;
-    }
 
-    auto [rawHeader, leftover] = HttpParser::receiveHeaderAndLeftover(socket);
-    if (rawHeader.empty())
+    const HttpConnectionPool::Key endpoint{host, port, useTls, useTls ? cert : std::string()};
+    HttpConnectionPool &pool = HttpConnectionPool::instance();
+    std::unique_ptr<Tcp> socket = pool.acquire(endpoint);
+    bool reused = socket != nullptr;
+    TRACE("%s connection\n", reused ? "Reusing" : "Opening");
+
+    std::string rawHeader;
+    std::string leftover;
+    while (true)
     {
-        return false;
+        if (!socket)
+        {
+            socket = connect(request, port, useTls);
+            if (!socket)
+            {
+                return false;
+            }
+        }
+
+        bool sent = socket->send(requestStr.c_str(), requestStr.length()) >= 0;
+        if (sent)
+        {
+            std::tie(rawHeader, leftover) = HttpParser::receiveHeaderAndLeftover(*socket);
+        }
+        if (!rawHeader.empty())
+        {
+            break;
+        }
+
+        // The server may have closed a kept connection just as it was reused; if the request
+        // can't have taken effect, or is safe to repeat, send it once more on a new connection
+        if (!reused || (sent && !isIdempotent(method)))
+        {
+            return false;
+        }
+        TRACE("Reused connection failed, reconnecting\n");
+        socket.reset();
+        reused = false;
     }
 
     TRACE("Raw header: %s\n", rawHeader.c_str());
     TRACE("Leftover: %s\n", leftover.c_str());
 
-    response.setStatus(HttpParser::parseStatusCode(rawHeader));
+    const int status = HttpParser::parseStatusCode(rawHeader);
+    response.setStatus(status);
     const auto parsedHeaders = HttpParser::parseHeaders(rawHeader);
     for (const auto &[key, value] : parsedHeaders)
     {
@@ -100,26 +209,35 @@ bool HttpClient::sendRequest(const HttpRequest &request, HttpResponse &response)
 
     bool truncated = false;
 
-    if (request.wantsToFile()) {
+    // These end at the header; waiting for a body would stall until the receive timeout
+    const bool noBody = method == "HEAD" || status == 204 || status == 304;
+
+    if (noBody)
+    {
+        TRACE("No body expected for status %d\n", status);
+    }
+    else if (request.wantsToFile()) {
         StorageManager* storage = AppContext::get<StorageManager>();
         const std::string& path = request.getOutputFilePath();
-    
+
+        // Keep the file open and let the writer task program one block while the next is received
+        auto writer = std::make_unique<StreamingFileWriter>();
+        if (!writer->open(storage, path, true)) {
+            printf("[HttpClient] Cannot open output file: %s\n", path.c_str());
+            return false;
+        }
+        auto sink = [&](const char* data, size_t len) {
+            return writer->write(data, len);
+        };
+
         bool ok = false;
         if (HttpParser::isChunkedEncoding(parsedHeaders)) {
-            ok = HttpParser::receiveChunkedBodyToFile(socket, leftover,
-                [&](const char* data, size_t len) {
-                    return storage->appendToFile(path, reinterpret_cast<const uint8_t*>(data), len);
-                },
-                MAX_HTTP_BODY_LENGTH,
-                &truncated);
+            ok = HttpParser::receiveChunkedBodyToFile(*socket, leftover, sink, MAX_HTTP_BODY_LENGTH, &truncated);
         } else {
-            ok = HttpParser::receiveFixedLengthBodyToFile(socket, parsedHeaders, leftover,
-                [&](const char* data, size_t len) {
-                    return storage->appendToFile(path, reinterpret_cast<const uint8_t*>(data), len);
-                },
-                MAX_HTTP_BODY_LENGTH,
-                &truncated);
+            ok = HttpParser::receiveFixedLengthBodyToFile(*socket, parsedHeaders, leftover, sink,
+                                                          MAX_HTTP_BODY_LENGTH, &truncated);
         }
+        ok = writer->close() && ok;
     
         if (!ok)
             return false;
@@ -133,7 +251,7 @@ bool HttpClient::sendRequest(const HttpRequest &request, HttpResponse &response)
     else
     {
         std::string bodyData;
-        if (!HttpParser::receiveBody(socket, parsedHeaders, leftover, bodyData, MAX_HTTP_BODY_LENGTH, &truncated))
+        if (!HttpParser::receiveBody(*socket, parsedHeaders, leftover, bodyData, MAX_HTTP_BODY_LENGTH, &truncated))
         {
             return false;
         }
@@ -142,5 +260,9 @@ bool HttpClient::sendRequest(const HttpRequest &request, HttpResponse &response)
             response.markBodyTruncated();
     }
 
+    // Keep the connection only if the whole response has been read from it
+    uint32_t keepAlive = (callerCloses || truncated) ? 0 : keepAliveMs(rawHeader, parsedHeaders, noBody, leftover.size());
+    pool.release(endpoint, std::move(socket), keepAlive);
+
     return true;
 }
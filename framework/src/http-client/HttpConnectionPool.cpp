@@ -0,0 +1,152 @@
+/**
+ * @file HttpConnectionPool.cpp
+ * @author Ian Archbell
+ * @brief Implementation of the HttpClient keep-alive connection pool.
+ * @version 0.1
+ * @date 2025-04-22
+ * @license MIT License
+ * @copyright Copyright (c) 2025, Ian Archbell
+ */
+
+#include "http/HttpConnectionPool.h"
+
+#include "framework_config.h"
+#include "DebugTrace.h"
+TRACE_INIT(HttpClient)
+
+/// @copydoc HttpConnectionPool::instance
+HttpConnectionPool &HttpConnectionPool::instance()
+{
+    static HttpConnectionPool inst;
+    return inst;
+}
+
+/// @copydoc HttpConnectionPool::HttpConnectionPool
+HttpConnectionPool::HttpConnectionPool()
+{
+    lock_ = xSemaphoreCreateMutexStatic(&lockBuffer_);
+    configASSERT(lock_);
+    idle_.reserve(HTTP_CLIENT_POOL_SIZE);
+}
+
+/// @copydoc HttpConnectionPool::takeExpired
+void HttpConnectionPool::takeExpired(TickType_t now, std::vector<std::unique_ptr<Tcp>> &closing)
+{
+    for (auto it = idle_.begin(); it != idle_.end();)
+    {
+        if (now - it->since >= it->keepAlive)
+        {
+            TRACE("Closing idle connection to %s:%u\n", it->key.host.c_str(), it->key.port);
+            closing.push_back(std::move(it->socket));
+            it = idle_.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+/// @copydoc HttpConnectionPool::acquire
+std::unique_ptr<Tcp> HttpConnectionPool::acquire(const Key &key)
+{
+    std::vector<std::unique_ptr<Tcp>> closing; // closed after the lock is released
+    std::unique_ptr<Tcp> socket;
+
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    takeExpired(xTaskGetTickCount(), closing);
+    for (size_t i = idle_.size(); i-- > 0;)
+    {
+        if (!(idle_[i].key == key))
+        {
+            continue;
+        }
+        std::unique_ptr<Tcp> candidate = std::move(idle_[i].socket);
+        idle_.erase(idle_.begin() + i);
+        if (candidate->isIdle())
+        {
+            socket = std::move(candidate);
+            break;
+        }
+        TRACE("Idle connection to %s:%u was closed by the server\n", key.host.c_str(), key.port);
+        closing.push_back(std::move(candidate));
+    }
+    xSemaphoreGive(lock_);
+
+    return socket;
+}
+
+/// @copydoc HttpConnectionPool::release
+void HttpConnectionPool::release(const Key &key, std::unique_ptr<Tcp> socket, uint32_t keepAliveMs)
+{
+    if (!socket || keepAliveMs == 0 || HTTP_CLIENT_POOL_SIZE == 0 || HTTP_CLIENT_POOL_PER_HOST == 0)
+    {
+        return; // closed as it goes out of scope
+    }
+
+    std::vector<std::unique_ptr<Tcp>> closing;
+
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    TickType_t now = xTaskGetTickCount();
+    takeExpired(now, closing);
+
+    // Make room, closing the connection idle longest for this host, or failing that, any host
+    size_t forHost = 0;
+    for (const auto &idle : idle_)
+    {
+        forHost += idle.key == key ? 1 : 0;
+    }
+    while (forHost >= HTTP_CLIENT_POOL_PER_HOST || idle_.size() >= HTTP_CLIENT_POOL_SIZE)
+    {
+        auto victim = idle_.begin();
+        if (forHost >= HTTP_CLIENT_POOL_PER_HOST)
+        {
+            while (!(victim->key == key))
+            {
+                ++victim;
+            }
+            forHost--;
+        }
+        else if (victim->key == key)
+        {
+            forHost--;
+        }
+        closing.push_back(std::move(victim->socket));
+        idle_.erase(victim);
+    }
+
+    idle_.push_back({key, std::move(socket), now, pdMS_TO_TICKS(keepAliveMs)});
+    TRACE("Holding connection to %s:%u (%u idle)\n", key.host.c_str(), key.port, (unsigned)idle_.size());
+    xSemaphoreGive(lock_);
+}
+
+/// @copydoc HttpConnectionPool::evictIdle
+void HttpConnectionPool::evictIdle()
+{
+    std::vector<std::unique_ptr<Tcp>> closing;
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    takeExpired(xTaskGetTickCount(), closing);
+    xSemaphoreGive(lock_);
+}
+
+/// @copydoc HttpConnectionPool::clear
+void HttpConnectionPool::clear()
+{
+    std::vector<std::unique_ptr<Tcp>> closing;
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    for (auto &idle : idle_)
+    {
+        closing.push_back(std::move(idle.socket));
+    }
+    idle_.clear();
+    xSemaphoreGive(lock_);
+}
+
+/// @copydoc HttpConnectionPool::size
+size_t HttpConnectionPool::size()
+{
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    size_t n = idle_.size();
+    xSemaphoreGive(lock_);
+    return n;
+}
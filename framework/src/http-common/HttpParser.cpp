@@ -122,6 +122,14 @@ std::pair<std::string, std::string> HttpParser::receiveHeaderAndLeftover(Tcp &so
         }
 
         buffer.append(temp, n);
+
+        // On a reused connection the last CRLF of the previous chunked body can arrive late;
+        // empty lines before the status line are ignored (RFC 9112 section 2.2)
+        while (buffer.compare(0, 2, "\r\n") == 0)
+        {
+            buffer.erase(0, 2);
+        }
+
         std::size_t headerEnd = buffer.find("\r\n\r\n");
 
         if (headerEnd != std::string::npos)
@@ -140,6 +140,7 @@ HttpRequest::HttpRequest(const char *rawHeaders, const std::string &reqMethod, c
 HttpRequest& HttpRequest::setBody(const std::string &b)
 {
     body = b;
+    bodyParsed = false;
     return *this;
 }
 
@@ -147,6 +148,7 @@ HttpRequest& HttpRequest::setJson(const std::string &json)
 {
     setHeader("Content-Type", "application/json");
     body = json;
+    bodyParsed = false;
     return *this;
 }
 
@@ -154,9 +156,21 @@ HttpRequest& HttpRequest::setJson(const nlohmann::json &json)
 {
     setHeader("Content-Type", "application/json");
     body = json.dump();
+    parsedBody = json;
+    bodyParsed = true;
     return *this;
 }
 
+const nlohmann::json &HttpRequest::json() const
+{
+    if (!bodyParsed)
+    {
+        parsedBody = nlohmann::json::parse(body, nullptr, false);
+        bodyParsed = true;
+    }
+    return parsedBody;
+}
+
 void HttpRequest::parseHeaders(const char *raw)
 {
     headers = HttpParser::parseHeaders(raw);
@@ -222,6 +236,7 @@ std::optional<std::pair<std::string, std::string>> HttpRequest::receiveUntilHead
 }
 
 bool HttpRequest::appendRemainingBody(int expectedLength) {
+    bodyParsed = false;
     size_t remaining = expectedLength - body.size();
     char buffer[HTTP_BUFFER_SIZE];
 
@@ -342,8 +357,9 @@ HttpRequest HttpRequest::receive(Tcp *tcp)
  */
 int HttpRequest::handle_multipart(HttpResponse &res)
 {
-    MultipartParser parser;
-    return parser.handleMultipart(*this, res) ? 0 : -1;
+    // Heap allocated: the parser's receive window is too big for the HTTP task stack
+    auto parser = std::make_unique<MultipartParser>();
+    return parser->handleMultipart(*this, res) ? 0 : -1;
 }
 
 /**
@@ -495,23 +511,29 @@ HttpRequest &HttpRequest::setRootCACertificate(const std::string &certData)
 
 #if defined(PICO_HTTP_ENABLE_STORAGE)
 #include <fstream>
+#include "framework/AppContext.h"
+#include "storage/StorageManager.h"
 HttpRequest &HttpRequest::setBodyFromFile(const std::string &path)
 {
     std::ifstream file(path, std::ios::in | std::ios::binary);
     if (file)
     {
         body.assign((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        bodyParsed = false;
     }
     return *this;
 }
 
 bool HttpRequest::setRootCACertificateFromFile(const char *path)
 {
-    std::string contents;
-    if (!StorageManager::instance().readFileToString(path, contents))
+    auto *storage = AppContext::get<StorageManager>();
+    auto file = storage ? storage->openReader(path) : nullptr;
+    if (!file)
     {
         return false;
     }
+    std::string contents(file->size(), '\0');
+    contents.resize(file->readChunk(contents.data(), contents.size()));
     setRootCACertificate(contents);
     return true;
 }
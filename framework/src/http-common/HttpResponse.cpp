@@ -17,6 +17,7 @@
 
 #include "http/HttpResponse.h"
 #include "http/JsonResponse.h"
+#include "http/JsonStreamWriter.h"
 #include "framework_config.h" 
 #include "DebugTrace.h"
 TRACE_INIT(HttpResponse)
@@ -26,6 +27,7 @@ TRACE_INIT(HttpResponse)
 #include <lwip/sockets.h>
 #include "utility/utility.h"
 #include "framework/FrameworkView.h"
+#include "framework/HtmlTemplate.h"
 #include "http/HttpFileserver.h"
 
 // ------------------------------------------------------------------------
@@ -304,12 +306,60 @@ void HttpResponse::writeChunk(const char *data, size_t length)
     }
 }
 
+/**
+ * @copydoc HttpResponse::startChunked()
+ */
+void HttpResponse::startChunked(int code, const std::string &contentType)
+{
+    status_code = code;
+    headers.erase("Content-Length");
+    headers["Content-Type"] = contentType;
+    headers["Transfer-Encoding"] = "chunked";
+    chunked = true;
+    sendHeaders();
+}
+
+/**
+ * @copydoc HttpResponse::sendChunk()
+ */
+void HttpResponse::sendChunk(const char *data, size_t length)
+{
+    if (!headerSent || !chunked)
+    {
+        printf("Error: sendChunk called before startChunked()\n");
+        return;
+    }
+    if (length == 0)
+    {
+        return; // a zero-length chunk would terminate the body
+    }
+
+    char sizeLine[12];
+    int n = snprintf(sizeLine, sizeof(sizeLine), "%zx\r\n", length);
+    tcp->send(sizeLine, n);
+    tcp->send(data, length);
+    tcp->send("\r\n", 2);
+}
+
 /**
  * @copydoc HttpResponse::finish()
  */
 void HttpResponse::finish()
 {
-    // Placeholder for future expansion (e.g., chunked transfer end).
+    if (chunked && headerSent)
+    {
+        tcp->send("0\r\n\r\n", 5);
+        chunked = false;
+    }
+}
+
+/**
+ * @copydoc HttpResponse::abort()
+ */
+void HttpResponse::abort()
+{
+    chunked = false;
+    tcp->close();
 }
 
 // ------------------------------------------------------------------------
@@ -355,10 +405,39 @@ HttpResponse &HttpResponse::json(const std::string &body)
         .send(body);
     return *this;
 }
-// send a json object
+// True if @p j nests containers more than @p limit deep; stops looking once it knows
+static bool nestedDeeperThan(const nlohmann::json &j, size_t limit)
+{
+    if (!j.is_structured())
+    {
+        return false;
+    }
+    if (limit == 0)
+    {
+        return true;
+    }
+    for (const auto &el : j)
+    {
+        if (nestedDeeperThan(el, limit - 1))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @copydoc HttpResponse::json(const nlohmann::json &)
+ */
 HttpResponse &HttpResponse::json(const nlohmann::json &jsonObj)
 {
-    return json(jsonObj.dump()); // dump() creates a compact string
+    if (nestedDeeperThan(jsonObj, JSON_STREAM_MAX_DEPTH))
+    {
+        return json(jsonObj.dump()); // too deep for the stream writer
+    }
+    JsonStreamWriter writer(*this, status_code);
+    writer.value(jsonObj).end();
+    return *this;
 }
 
 HttpResponse &HttpResponse::jsonFormatted(const nlohmann::json &jsonObj)
@@ -389,18 +468,7 @@ HttpResponse &HttpResponse::redirect(const std::string &url, int code)
  */
 std::string HttpResponse::renderTemplate(const std::string &tpl, const std::map<std::string, std::string> &context)
 {
-    std::string result = tpl;
-    for (const auto &[key, value] : context)
-    {
-        std::string placeholder = "{{" + key + "}}";
-        size_t pos = 0;
-        while ((pos = result.find(placeholder, pos)) != std::string::npos)
-        {
-            result.replace(pos, placeholder.length(), value);
-            pos += value.length();
-        }
-    }
-    return result;
+    return HtmlTemplate::compile(tpl)->render(context);
 }
 
 
@@ -420,6 +488,10 @@ void HttpResponse::send(const FrameworkView& view,
                         const std::map<std::string, std::string>& context) {
     view.applyHeaders(*this);
     setContentType(view.getContentType());
+    if (view.stream(*this, context))
+    {
+        return;
+    }
     std::string body = view.render(context);
     send(body);
 }
@@ -21,82 +21,192 @@
 
  #include "http/JsonRequestHelper.h"
  #include "http/HttpRequest.h"
+ #include <cstdlib>
+ #include <type_traits>
  
  using json = nlohmann::json;
  
- /// @copydoc JsonRequestHelper::getFullJson
- json JsonRequestHelper::getFullJson(const HttpRequest& req)
+ /// @copydoc JsonRequestHelper::document
+ const json *JsonRequestHelper::document(const HttpRequest& req)
  {
-     if (!req.isJson()) return json::object();
-     return json::parse(req.getBody(), nullptr, false);
+     if (!req.isJson()) return nullptr;
+     const json &doc = req.json();
+     return doc.is_discarded() ? nullptr : &doc;
  }
- 
- /// @copydoc JsonRequestHelper::getJsonValue
- json JsonRequestHelper::getJsonValue(const HttpRequest& req, const std::string& path)
+
+ /**
+  * @brief Step into a child of the current value, by key or array index.
+  */
+ static const json *child(const json *current, const std::string &part, bool allowIndex)
  {
-     json current = getFullJson(req);
-     if (!current.is_object()) return nullptr;
- 
+     if (current->is_object())
+     {
+         auto it = current->find(part);
+         return it != current->end() ? &*it : nullptr;
+     }
+     if (allowIndex && current->is_array() && !part.empty() &&
+         part.find_first_not_of("0123456789") == std::string::npos)
+     {
+         size_t index = std::strtoul(part.c_str(), nullptr, 10);
+         return index < current->size() ? &(*current)[index] : nullptr;
+     }
+     return nullptr;
+ }
+
+ /// @copydoc JsonRequestHelper::find
+ const json *JsonRequestHelper::find(const HttpRequest& req, const std::string& path)
+ {
+     const json *current = document(req);
+     if (!current || !current->is_object()) return nullptr;
+
+     std::string part; // reused for each path segment
+     if (!path.empty() && path[0] == '/')
+     {
+         // JSON pointer (RFC 6901): "/a/b/0", with ~1 for '/' and ~0 for '~'
+         size_t pos = 1;
+         while (current)
+         {
+             size_t next = path.find('/', pos);
+             part.clear();
+             for (size_t i = pos; i < (next == std::string::npos ? path.size() : next); ++i)
+             {
+                 if (path[i] == '~' && i + 1 < path.size() && (path[i + 1] == '0' || path[i + 1] == '1'))
+                 {
+                     part += (path[i + 1] == '1') ? '/' : '~';
+                     ++i;
+                 }
+                 else
+                 {
+                     part += path[i];
+                 }
+             }
+             current = child(current, part, true);
+             if (next == std::string::npos) break;
+             pos = next + 1;
+         }
+         return current;
+     }
+
+     // Dot-separated path: intermediate segments must be objects
      size_t pos = 0, next;
      while ((next = path.find('.', pos)) != std::string::npos)
      {
-         std::string part = path.substr(pos, next - pos);
-         if (!current.contains(part) || !current[part].is_object()) return nullptr;
-         current = current[part];
+         part.assign(path, pos, next - pos);
+         current = child(current, part, false);
+         if (!current || !current->is_object()) return nullptr;
          pos = next + 1;
      }
+     part.assign(path, pos, std::string::npos);
+     return child(current, part, false);
+ }
+
+ /// @copydoc JsonRequestHelper::extract
+ size_t JsonRequestHelper::extract(const HttpRequest& req, std::initializer_list<JsonField> fields)
+ {
+     size_t found = 0;
+     for (const auto &field : fields)
+     {
+         const json *val = find(req, field.path);
+         if (!val || val->is_null()) continue;
+
+         bool assigned = std::visit([val](auto *target) -> bool {
+             using T = std::remove_pointer_t<decltype(target)>;
+             if constexpr (std::is_same_v<T, std::string>)
+             {
+                 *target = val->is_string() ? val->get<std::string>() : val->dump();
+                 return true;
+             }
+             else if constexpr (std::is_same_v<T, int>)
+             {
+                 if (!val->is_number_integer()) return false;
+                 *target = val->get<int>();
+                 return true;
+             }
+             else if constexpr (std::is_same_v<T, double>)
+             {
+                 if (!val->is_number()) return false;
+                 *target = val->get<double>();
+                 return true;
+             }
+             else if constexpr (std::is_same_v<T, bool>)
+             {
+                 if (!val->is_boolean()) return false;
+                 *target = val->get<bool>();
+                 return true;
+             }
+             else
+             {
+                 *target = *val;
+                 return true;
+             }
+         }, field.target);
+
+         if (assigned) ++found;
+     }
+     return found;
+ }
+
+ /// @copydoc JsonRequestHelper::getFullJson
+ json JsonRequestHelper::getFullJson(const HttpRequest& req)
+ {
+     if (!req.isJson()) return json::object();
+     return req.json();
+ }
  
-     std::string last = path.substr(pos);
-     return current.contains(last) ? current[last] : nullptr;
+ /// @copydoc JsonRequestHelper::getJsonValue
+ json JsonRequestHelper::getJsonValue(const HttpRequest& req, const std::string& path)
+ {
+     const json *val = find(req, path);
+     return val ? *val : json(nullptr);
  }
  
  /// @copydoc JsonRequestHelper::hasField
  bool JsonRequestHelper::hasField(const HttpRequest& req, const std::string& key)
  {
-     return !getJsonValue(req, key).is_null();
+     const json *val = find(req, key);
+     return val && !val->is_null();
  }
  
  /// @copydoc JsonRequestHelper::getString
  std::string JsonRequestHelper::getString(const HttpRequest& req, const std::string& key)
  {
-     auto val = getJsonValue(req, key);
-     if (val.is_string()) return val.get<std::string>();
-     if (!val.is_null()) return val.dump();
-     return "";
+     const json *val = find(req, key);
+     if (!val || val->is_null()) return "";
+     if (val->is_string()) return val->get<std::string>();
+     return val->dump();
  }
  
  /// @copydoc JsonRequestHelper::getInt
  int JsonRequestHelper::getInt(const HttpRequest& req, const std::string& key, int def)
  {
-     auto val = getJsonValue(req, key);
-     return val.is_number_integer() ? val.get<int>() : def;
+     const json *val = find(req, key);
+     return (val && val->is_number_integer()) ? val->get<int>() : def;
  }
  
  /// @copydoc JsonRequestHelper::getDouble
  double JsonRequestHelper::getDouble(const HttpRequest& req, const std::string& key, double def)
  {
-     auto val = getJsonValue(req, key);
-     return val.is_number() ? val.get<double>() : def;
+     const json *val = find(req, key);
+     return (val && val->is_number()) ? val->get<double>() : def;
  }
  
  /// @copydoc JsonRequestHelper::getBool
  bool JsonRequestHelper::getBool(const HttpRequest& req, const std::string& key, bool def)
  {
-     auto val = getJsonValue(req, key);
-     return val.is_boolean() ? val.get<bool>() : def;
+     const json *val = find(req, key);
+     return (val && val->is_boolean()) ? val->get<bool>() : def;
  }
  
  /// @copydoc JsonRequestHelper::getArray
  json JsonRequestHelper::getArray(const HttpRequest& req, const std::string& key)
  {
-     auto val = getJsonValue(req, key);
-     return val.is_array() ? val : json::array();
+     const json *val = find(req, key);
+     return (val && val->is_array()) ? *val : json::array();
  }
  
  /// @copydoc JsonRequestHelper::getObject
  json JsonRequestHelper::getObject(const HttpRequest& req, const std::string& key)
  {
-     auto val = getJsonValue(req, key);
-     return val.is_object() ? val : json::object();
+     const json *val = find(req, key);
+     return (val && val->is_object()) ? *val : json::object();
  }
- 
\ No newline at end of file
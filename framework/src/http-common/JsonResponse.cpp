@@ -17,28 +17,33 @@
 
 #include "http/JsonResponse.h"
 #include "http/HttpResponse.h"
+#include "http/JsonStreamWriter.h"
 
 namespace JsonResponse {
 
+/**
+ * @brief Stream a {"success": true, "data": ..., "message": ...} envelope.
+ *
+ * The data is written in place rather than copied into a wrapper object first.
+ */
+static void sendEnvelope(HttpResponse& res, int statusCode, const nlohmann::json& data, const std::string& message) {
+    JsonStreamWriter w(res, statusCode);
+    w.beginObject().key("success").value(true);
+    if (!data.is_null() && !data.empty()) w.key("data").value(data);
+    if (!message.empty()) w.key("message").value(message);
+    w.endObject().end();
+}
+
 void sendSuccess(HttpResponse& res, const nlohmann::json& data, const std::string& message) {
-    nlohmann::json j = { {"success", true} };
-    if (!data.is_null() && !data.empty()) j["data"] = data;
-    if (!message.empty()) j["message"] = message;
-    res.status(200).json(j);
+    sendEnvelope(res, 200, data, message);
 }
 
 void sendCreated(HttpResponse& res, const nlohmann::json& data, const std::string& message) {
-    nlohmann::json j = { {"success", true} };
-    if (!data.is_null() && !data.empty()) j["data"] = data;
-    if (!message.empty()) j["message"] = message;
-    res.status(201).json(j);
+    sendEnvelope(res, 201, data, message);
 }
 
 void sendMessage(HttpResponse& res, const std::string& message) {
-    res.status(200).json({
-        {"success", true},
-        {"message", message}
-    });
+    sendEnvelope(res, 200, nullptr, message);
 }
 
 void sendNoContent(HttpResponse& res) {
@@ -50,13 +55,10 @@ void sendJson(HttpResponse& res, const nlohmann::json& raw, int statusCode) {
 }
 
 void sendError(HttpResponse& res, int statusCode, const std::string& code, const std::string& message) {
-    res.status(statusCode).json({
-        {"success", false},
-        {"error", {
-            {"code", code},
-            {"message", message}
-        }}
-    });
+    JsonStreamWriter w(res, statusCode);
+    w.beginObject().key("success").value(false);
+    w.key("error").beginObject().key("code").value(code).key("message").value(message).endObject();
+    w.endObject().end();
 }
 
 } // namespace JsonResponse
@@ -0,0 +1,410 @@
+/**
+ * @file JsonStreamWriter.cpp
+ * @author Ian Archbell
+ * @brief Implementation of the streaming JSON response writer.
+ *
+ * Part of the PicoFramework HTTP server.
+ * Output is staged in a fixed buffer. The first time the buffer fills the response
+ * headers are sent with chunked transfer encoding and each full buffer becomes one chunk.
+ * Small documents never leave the buffer and are sent with a Content-Length header.
+ *
+ * @version 0.1
+ * @date 2025-04-04
+ * @license MIT License
+ * @copyright Copyright (c) 2025, Ian Archbell
+ */
+
+#include "framework_config.h" // Must be included before DebugTrace.h to ensure framework_config.h is processed first
+#include "DebugTrace.h"
+TRACE_INIT(JsonStreamWriter)
+
+#include "http/JsonStreamWriter.h"
+#include "http/HttpResponse.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+/// @copydoc JsonStreamWriter::JsonStreamWriter
+JsonStreamWriter::JsonStreamWriter(HttpResponse &res, int statusCode)
+    : res(res), statusCode(statusCode)
+{
+}
+
+/// @copydoc JsonStreamWriter::~JsonStreamWriter
+JsonStreamWriter::~JsonStreamWriter()
+{
+    if (!ended)
+    {
+        end();
+    }
+}
+
+// ------------------------------------------------------------------------
+// Structure
+// ------------------------------------------------------------------------
+
+/// @copydoc JsonStreamWriter::beginObject
+JsonStreamWriter &JsonStreamWriter::beginObject()
+{
+    open('{');
+    return *this;
+}
+
+/// @copydoc JsonStreamWriter::endObject
+JsonStreamWriter &JsonStreamWriter::endObject()
+{
+    close('}');
+    return *this;
+}
+
+/// @copydoc JsonStreamWriter::beginArray
+JsonStreamWriter &JsonStreamWriter::beginArray()
+{
+    open('[');
+    return *this;
+}
+
+/// @copydoc JsonStreamWriter::endArray
+JsonStreamWriter &JsonStreamWriter::endArray()
+{
+    close(']');
+    return *this;
+}
+
+/// @copydoc JsonStreamWriter::key
+JsonStreamWriter &JsonStreamWriter::key(const char *name)
+{
+    if (depth == 0 || afterKey)
+    {
+        failed = true;
+        return *this;
+    }
+    beginValue();
+    writeString(name, strlen(name));
+    put(':');
+    afterKey = true;
+    return *this;
+}
+
+// ------------------------------------------------------------------------
+// Values
+// ------------------------------------------------------------------------
+
+/// @copydoc JsonStreamWriter::value(const char *)
+JsonStreamWriter &JsonStreamWriter::value(const char *str)
+{
+    if (!str)
+    {
+        return value(nullptr);
+    }
+    beginValue();
+    writeString(str, strlen(str));
+    return *this;
+}
+
+/// @copydoc JsonStreamWriter::value(const std::string &)
+JsonStreamWriter &JsonStreamWriter::value(const std::string &str)
+{
+    beginValue();
+    writeString(str.data(), str.size());
+    return *this;
+}
+
+/// @copydoc JsonStreamWriter::value(bool)
+JsonStreamWriter &JsonStreamWriter::value(bool b)
+{
+    beginValue();
+    if (b)
+        write("true", 4);
+    else
+        write("false", 5);
+    return *this;
+}
+
+JsonStreamWriter &JsonStreamWriter::signedValue(long long v)
+{
+    char num[24];
+    int n = snprintf(num, sizeof(num), "%lld", v);
+    beginValue();
+    write(num, n);
+    return *this;
+}
+
+JsonStreamWriter &JsonStreamWriter::unsignedValue(unsigned long long v)
+{
+    char num[24];
+    int n = snprintf(num, sizeof(num), "%llu", v);
+    beginValue();
+    write(num, n);
+    return *this;
+}
+
+/// @copydoc JsonStreamWriter::value(double)
+JsonStreamWriter &JsonStreamWriter::value(double d)
+{
+    if (!std::isfinite(d))
+    {
+        return value(nullptr); // same as nlohmann::json::dump()
+    }
+
+    // Prefer the short form when it round-trips, as dump() does
+    char num[32];
+    int n = snprintf(num, sizeof(num), "%.15g", d);
+    if (strtod(num, nullptr) != d)
+    {
+        n = snprintf(num, sizeof(num), "%.17g", d);
+    }
+    beginValue();
+    write(num, n);
+    return *this;
+}
+
+/// @copydoc JsonStreamWriter::value(std::nullptr_t)
+JsonStreamWriter &JsonStreamWriter::value(std::nullptr_t)
+{
+    beginValue();
+    write("null", 4);
+    return *this;
+}
+
+template <typename BasicJson>
+JsonStreamWriter &JsonStreamWriter::jsonValue(const BasicJson &j)
+{
+    switch (j.type())
+    {
+    case nlohmann::detail::value_t::object:
+        beginObject();
+        for (auto it = j.begin(); it != j.end(); ++it)
+        {
+            key(it.key());
+            value(it.value());
+        }
+        endObject();
+        break;
+    case nlohmann::detail::value_t::array:
+        beginArray();
+        for (const auto &el : j)
+        {
+            value(el);
+        }
+        endArray();
+        break;
+    case nlohmann::detail::value_t::string:
+        value(j.template get_ref<const std::string &>());
+        break;
+    case nlohmann::detail::value_t::boolean:
+        value(j.template get<bool>());
+        break;
+    case nlohmann::detail::value_t::number_integer:
+        signedValue(j.template get<int64_t>());
+        break;
+    case nlohmann::detail::value_t::number_unsigned:
+        unsignedValue(j.template get<uint64_t>());
+        break;
+    case nlohmann::detail::value_t::number_float:
+        value(j.template get<double>());
+        break;
+    default:
+        value(nullptr); // null, discarded and binary values
+        break;
+    }
+    return *this;
+}
+
+/// @copydoc JsonStreamWriter::value(const nlohmann::json &)
+JsonStreamWriter &JsonStreamWriter::value(const nlohmann::json &j)
+{
+    return jsonValue(j);
+}
+
+// Allocator-aware document types streamed through the header template
+template JsonStreamWriter &JsonStreamWriter::jsonValue<PooledJson>(const PooledJson &);
+template JsonStreamWriter &JsonStreamWriter::jsonValue<ScratchJson>(const ScratchJson &);
+
+/// @copydoc JsonStreamWriter::rawValue
+JsonStreamWriter &JsonStreamWriter::rawValue(const char *json, size_t length)
+{
+    beginValue();
+    write(json, length);
+    return *this;
+}
+
+// ------------------------------------------------------------------------
+// Completion
+// ------------------------------------------------------------------------
+
+/// @copydoc JsonStreamWriter::end
+void JsonStreamWriter::end()
+{
+    if (ended)
+    {
+        return;
+    }
+    ended = true;
+
+    if (failed)
+    {
+        // The body is missing whatever came after the failure, so it must not look complete
+        printf("[JsonStreamWriter] JSON too deeply nested or malformed, response abandoned\n");
+        if (!started)
+        {
+            used = 0;
+            res.sendError(500, "JSON_ERROR", "Response could not be serialized");
+        }
+        else
+        {
+            res.abort(); // no terminating chunk, so the client sees a truncated body
+        }
+        return;
+    }
+
+    if (depth != 0)
+    {
+        TRACE_WARN("JSON stream ended with %u open containers\n", depth);
+    }
+
+    if (!started)
+    {
+        // Whole document fits in the buffer: send it as a regular response
+        res.status(statusCode)
+            .set("Content-Type", "application/json")
+            .set("Content-Length", std::to_string(used));
+        res.sendHeaders();
+        res.writeChunk(buffer, used);
+        used = 0;
+        return;
+    }
+
+    flush();
+    res.finish();
+    TRACE("Streamed %zu bytes of JSON\n", total);
+}
+
+// ------------------------------------------------------------------------
+// Internal helpers
+// ------------------------------------------------------------------------
+
+void JsonStreamWriter::beginValue()
+{
+    if (afterKey)
+    {
+        afterKey = false;
+        return;
+    }
+    if (depth > 0 && needComma[depth])
+    {
+        put(',');
+    }
+    needComma[depth] = true;
+}
+
+void JsonStreamWriter::open(char c)
+{
+    if (depth >= JSON_STREAM_MAX_DEPTH)
+    {
+        failed = true;
+        return;
+    }
+    beginValue();
+    put(c);
+    ++depth;
+    needComma[depth] = false;
+}
+
+void JsonStreamWriter::close(char c)
+{
+    if (depth == 0 || afterKey)
+    {
+        failed = true;
+        return;
+    }
+    put(c);
+    --depth;
+}
+
+void JsonStreamWriter::write(const char *data, size_t length)
+{
+    if (failed || ended)
+    {
+        return;
+    }
+    total += length;
+    while (length > 0)
+    {
+        size_t space = sizeof(buffer) - used;
+        size_t n = length < space ? length : space;
+        memcpy(buffer + used, data, n);
+        used += n;
+        data += n;
+        length -= n;
+        if (used == sizeof(buffer))
+        {
+            flush();
+        }
+    }
+}
+
+void JsonStreamWriter::put(char c)
+{
+    write(&c, 1);
+}
+
+void JsonStreamWriter::writeString(const char *str, size_t length)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    put('"');
+    size_t runStart = 0;
+    for (size_t i = 0; i < length; ++i)
+    {
+        unsigned char c = static_cast<unsigned char>(str[i]);
+        if (c >= 0x20 && c != '"' && c != '\\')
+        {
+            continue; // copied as part of the current run
+        }
+
+        write(str + runStart, i - runStart);
+        runStart = i + 1;
+
+        char esc[6] = {'\\', 0, 0, 0, 0, 0};
+        size_t escLen = 2;
+        switch (c)
+        {
+        case '"': esc[1] = '"'; break;
+        case '\\': esc[1] = '\\'; break;
+        case '\b': esc[1] = 'b'; break;
+        case '\f': esc[1] = 'f'; break;
+        case '\n': esc[1] = 'n'; break;
+        case '\r': esc[1] = 'r'; break;
+        case '\t': esc[1] = 't'; break;
+        default:
+            esc[1] = 'u';
+            esc[2] = '0';
+            esc[3] = '0';
+            esc[4] = hex[c >> 4];
+            esc[5] = hex[c & 0x0F];
+            escLen = 6;
+            break;
+        }
+        write(esc, escLen);
+    }
+    write(str + runStart, length - runStart);
+    put('"');
+}
+
+void JsonStreamWriter::flush()
+{
+    if (used == 0)
+    {
+        return;
+    }
+    if (!started)
+    {
+        res.startChunked(statusCode, "application/json");
+        started = true;
+    }
+    res.sendChunk(buffer, used);
+    used = 0;
+}
@@ -26,6 +26,8 @@ TRACE_INIT(HttpFileserver)
 #include <cstring>
 #include <lwip/sockets.h>
 #include <unordered_map>
+#include <optional>
+#include <cstdlib>
 
 #include <FreeRTOS.h>
 #include <task.h>
@@ -37,6 +39,7 @@ TRACE_INIT(HttpFileserver)
 #include "framework/AppContext.h"
 #include "framework_config.h"
 #include "http/JsonResponse.h"
+#include "http/JsonStreamWriter.h"
 
 #define TRACE_ON
 
@@ -72,6 +75,15 @@ bool FileHandler::listDirectory(const std::string &path, std::vector<FileInfo> &
     return storage->listDirectory(path, out);
 }
 
+/// @copydoc FileHandler::forEachDirectoryEntry
+bool FileHandler::forEachDirectoryEntry(const std::string &path, uint32_t cursor, size_t limit,
+                                        const std::function<bool(const FileInfo &)> &visitor,
+                                        uint32_t *next)
+{
+    auto *storage = AppContext::get<StorageManager>();
+    return storage->forEachDirectoryEntry(path, cursor, limit, visitor, next);
+}
+
 /// @copydoc FileHandler::serveFile
 bool FileHandler::serveFile(HttpResponse &res, const char *uri)
 {
@@ -85,7 +97,9 @@ bool FileHandler::serveFile(HttpResponse &res, const char *uri)
         return false;
     }
 
-    if (!storageManager->exists(path))
+    // One open serves the existence check, size, gzip sniff and body
+    auto file = storageManager->openReader(path);
+    if (!file)
     {
         if (!storageManager->isMounted())
         {
@@ -101,7 +115,7 @@ bool FileHandler::serveFile(HttpResponse &res, const char *uri)
         }
     }
 
-    size_t fileSize = storageManager->getFileSize(path);
+    size_t fileSize = file->size();
     if (fileSize == 0)
     {
         JsonResponse::sendError(res, 500, "FILESIZE_ERROR", "Error getting file size for: " + std::string(uri));
@@ -115,15 +129,10 @@ bool FileHandler::serveFile(HttpResponse &res, const char *uri)
     {
         // Gzip magic number: 0x1F 0x8B (in little-endian)
         const uint8_t gzip_magic_number[] = {0x1F, 0x8B};
-        std::string magic_number;
-        if (storageManager->readFileString(path, 0, 2, magic_number))
+        uint8_t magic_number[2];
+        if (file->readChunk(magic_number, sizeof(magic_number)) == sizeof(magic_number))
         {
-            TRACE("Read magic number in hex: ");
-            for (size_t i = 0; i < magic_number.size(); ++i)
-            {
-                TRACE("%02X ", static_cast<unsigned char>(magic_number[i]));
-            }
-            TRACE("\n");
+            TRACE("Read magic number in hex: %02X %02X\n", magic_number[0], magic_number[1]);
             if (magic_number[0] == gzip_magic_number[0] && magic_number[1] == gzip_magic_number[1]) // GZIP magic number
             {
                 TRACE("File is already gzipped: %s\n", path.c_str());
@@ -131,14 +140,19 @@ bool FileHandler::serveFile(HttpResponse &res, const char *uri)
                 res.set("Content-Encoding", "gzip");
             }
         }
+        file->seek(0); // still inside the read-ahead buffer
     }
 
     res.start(200, fileSize, mimeType.c_str());
 
-    storageManager->streamFile(path, [&](const uint8_t *data, size_t len)
-                               {
-        res.writeChunk(reinterpret_cast<const char*>(data), len);
-        vTaskDelay(pdMS_TO_TICKS(STREAM_SEND_DELAY_MS)); }); // allow tcpip thread to get in
+    char buffer[HTTP_BUFFER_SIZE];
+    size_t n;
+    while ((n = file->readChunk(buffer, sizeof(buffer))) > 0)
+    {
+        res.writeChunk(buffer, n);
+        vTaskDelay(pdMS_TO_TICKS(STREAM_SEND_DELAY_MS)); // allow tcpip thread to get in
+    }
+    file->close();
 
     res.finish();
     return true;
@@ -169,26 +183,82 @@ void HttpFileserver::handle_list_directory(HttpRequest &req, HttpResponse &res,
         directory_path = "/"; // Default to root directory if no path is specified
     }
 
-    std::vector<FileInfo> entries;
-    if (!fileHandler.listDirectory(directory_path, entries))
+    // ?limit=N&cursor=C pages through the directory; the cursor is an opaque storage position
+    size_t limit = LIST_DIRECTORY_PAGE_SIZE;
+    uint32_t cursor = 0;
+    for (const auto &param : req.getQueryParams())
     {
-        res.sendError(404, "not_found", "Directory not found or inaccessible");
-        return;
+        char *end = nullptr;
+        unsigned long n = strtoul(param.second.c_str(), &end, 10);
+        if (param.second.empty() || *end != '\0')
+        {
+            continue; // ignore anything that isn't a plain number
+        }
+        if (param.first == "limit" && n > 0)
+        {
+            limit = n < LIST_DIRECTORY_MAX_PAGE_SIZE ? n : LIST_DIRECTORY_MAX_PAGE_SIZE;
+        }
+        else if (param.first == "cursor")
+        {
+            cursor = static_cast<uint32_t>(n);
+        }
     }
 
-    nlohmann::json fileArray = nlohmann::json::array();
-    for (const auto &entry : entries)
+    // Entries are written as they are read, so memory use doesn't depend on the directory
+    // size. The writer is only created once there is an entry or a clean end, so a directory
+    // that can't be opened (or a stale cursor) still gets a 404.
+    std::optional<JsonStreamWriter> w;
+    auto begin = [&]()
     {
-        fileArray.push_back({{"name", entry.name},
-                             {"size", entry.size},
-                             {"type", entry.isDirectory ? "directory" : "file"}});
-    }
-
-    nlohmann::json result = {
-        {"path", directory_path},
-        {"files", fileArray}};
+        w.emplace(res);
+        w->beginObject().key("success").value(true);
+        w->key("data").beginObject().key("path").value(directory_path).key("files").beginArray();
+    };
+
+    // One entry past the page tells whether there is a next page
+    size_t count = 0;
+    bool more = false;
+    uint32_t next = 0;
+    bool ok = fileHandler.forEachDirectoryEntry(directory_path, cursor, limit + 1, [&](const FileInfo &entry)
+    {
+        if (count == limit)
+        {
+            more = true;
+            return false;
+        }
+        if (!w)
+        {
+            begin();
+        }
+        w->beginObject()
+            .key("name").value(entry.name)
+            .key("size").value(static_cast<unsigned long>(entry.size))
+            .key("type").value(entry.isDirectory ? "directory" : "file")
+            .endObject();
+        count++;
+        return true;
+    }, &next);
 
-    res.sendSuccess(result, "Directory listed successfully.");
+    if (!w)
+    {
+        if (!ok)
+        {
+            res.sendError(404, "not_found", "Directory not found or inaccessible");
+            return;
+        }
+        begin();
+    }
+    w->endArray().key("nextCursor");
+    if (more)
+    {
+        w->value(std::to_string(next));
+    }
+    else
+    {
+        w->value(nullptr);
+    }
+    w->endObject().key("message").value("Directory listed successfully.");
+    w->endObject().end();
 }
 
 // Helper function to check if a string ends with a given suffix
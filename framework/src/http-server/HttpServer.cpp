@@ -248,7 +248,6 @@ void HttpServer::handleClient(Tcp* conn)
     int64_t lastActivity = start;
     const int64_t idleTimeoutMs = HTTP_IDLE_TIMEOUT; //  idle timeout - kill connection if no data received
 
-
     HttpRequest req = HttpRequest::receive(conn);
     if (req.getMethod().empty())
     {
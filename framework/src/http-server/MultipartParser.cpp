@@ -5,19 +5,20 @@
  *
  * Part of the PicoFramework HTTP server.
  * This module processes multipart/form-data uploads, detects boundaries,
- * parses headers, extracts filenames, and writes file data to storage.
+ * parses headers, writes file parts to storage and collects form fields.
  * It also handles sending appropriate HTTP responses based on the success
  * or failure of the upload process.
  *
  * Extracts the boundary from the Content-Type header
- * Manages multipart state using a basic state machine (SEARCHING_FOR_BOUNDARY, FOUND_BOUNDARY, etc.)
- * Used a streaming recv() loop
- * Bufferes data and handles chunk boundaries
- * Writes file data incrementally (appends to file to cope with large file sizes)
+ * Manages multipart state using a small state machine (Preamble, AfterDelimiter, Headers, Body)
+ * Receives from the socket straight into a fixed window buffer
+ * Searches for the "\r\n--boundary" delimiter with Boyer-Moore-Horspool, remembering how far
+ * it has searched, so a delimiter split across reads is found without rescanning or copying
+ * Writes file data through a StreamingFileWriter, so flash programming overlaps receiving
  * Rejects uploads with duplicate filenames
- * Only supports one file per request (for simplicity)
+ * Supports any number of files and form fields per request
  *
- * @version 0.1
+ * @version 0.2
  * @date 2025-03-26
  *
  * @license MIT License
@@ -30,242 +31,410 @@ TRACE_INIT(MultipartParser)
 
 #include "http/MultipartParser.h"
 #include <lwip/sockets.h>
-#include <iostream>
+#include <cstdint>
 #include <cstring>
+#include <strings.h>
 #include <sstream>
-#include <fstream>
 #include <algorithm>
-#include <cctype>
-//#include <filesystem>
 #include <FreeRTOS.h>
 #include <task.h>
 
 #include "framework/AppContext.h"
 #include "storage/StorageManager.h"
 
-State MultipartParser::currentState = SEARCHING_FOR_BOUNDARY; // Initialize state
-
 /// @copydoc MultipartParser::MultipartParser
 MultipartParser::MultipartParser()
-
 {
-
 }
 
+/// @copydoc MultipartParser::setBoundaryFromContentType
 void MultipartParser::setBoundaryFromContentType(const std::string& contentType){
     size_t boundaryPos = contentType.find("boundary=");
     if (boundaryPos != std::string::npos) {
         boundary = contentType.substr(boundaryPos + 9); // 9 is the length of "boundary="
-        // Remove any leading/trailing whitespace
-        boundary.erase(0, boundary.find_first_not_of(" \t\r\n"));
-        boundary.erase(boundary.find_last_not_of(" \t\r\n") + 1);
+        boundary = boundary.substr(0, boundary.find(';'));
+        // Remove any leading/trailing whitespace and quotes
+        boundary.erase(0, boundary.find_first_not_of(" \t\r\n\""));
+        boundary.erase(boundary.find_last_not_of(" \t\r\n\"") + 1);
         TRACE("Boundary set to: '%s'\n", boundary.c_str());
     } else {
         boundary.clear();
         TRACE("No boundary found in Content-Type header\n");
     }
+
+    if (boundary.size() > MaxBoundary) {
+        TRACE("Boundary longer than %zu characters rejected\n", MaxBoundary);
+        boundary.clear();
+    }
+    if (boundary.empty()) {
+        delimiter.clear();
+        return;
+    }
+
+    // The delimiter includes the CRLF that ends the previous part's content
+    delimiter = "\r\n--" + boundary;
+    const size_t m = delimiter.size();
+    memset(skip, static_cast<int>(m), sizeof(skip));
+    for (size_t i = 0; i + 1 < m; ++i) {
+        skip[static_cast<uint8_t>(delimiter[i])] = static_cast<uint8_t>(m - 1 - i);
+    }
 }
 
+/// @copydoc MultipartParser::handleMultipart
 bool MultipartParser::handleMultipart(HttpRequest& req, HttpResponse& res)
 {
     tcp = req.getTcp();  // extract here — don't store in ctor
 
-    std::string contentType = req.getHeader("Content-Type");
-    setBoundaryFromContentType(contentType);
-
-    if (boundary.empty()) {
+    if (!begin(req.getHeader("Content-Type"))) {
         res.status(400).send("Missing boundary");
         return false;
     }
 
-    char buf[1460];
-    int len;
-
-    currentState = SEARCHING_FOR_BOUNDARY;
-
     // Handle any body data included with the initial request
+    bool ok = true;
     const std::string &initialBody = req.getBody();
     if (!initialBody.empty())
     {
-        std::string chunk = initialBody;
-        if (!handleChunk(chunk))
-        {
-            TRACE("Error handling chunk\n");
-            return false;
-        }
+        ok = feed(initialBody.data(), initialBody.size());
     }
 
-    // Stream remaining data from socket
-    while ((len = tcp->recv(buf, sizeof(buf) - 1, HTTP_RECEIVE_TIMEOUT)) > 0)
+    // Stream remaining data from socket straight into the window
+    while (ok && state != State::Complete)
     {
-        buf[len] = '\0';
-        std::string chunk(buf, len);
+        if (WindowSize - end < HTTP_BUFFER_SIZE)
+            compact();
 
-        if (!handleChunk(chunk))
-        {
-            sendHttpResponse(400, "Upload incomplete or failed");
-            TRACE("Error handling chunk\n");
-            return false;
-        }
-
-        if (currentState == COMPLETE)
+        int len = tcp->recv(reinterpret_cast<char *>(window + end), WindowSize - end, HTTP_RECEIVE_TIMEOUT);
+        if (len <= 0)
             break;
+        end += len;
+        ok = process();
+    }
 
-        vTaskDelay(pdMS_TO_TICKS(10)); // yield to allow other tasks to run
+    if (state != State::Complete)
+    {
+        discardFile();
+        TRACE("Multipart upload incomplete or failed\n");
+        if (!responseSent)
+            sendHttpResponse(400, "Upload incomplete or failed");
+        return false;
     }
 
-    if (currentState != COMPLETE)
+    if (files.empty())
     {
-        sendHttpResponse(400, "Upload incomplete or failed");
+        sendHttpResponse(400, "Invalid upload: no filename or filename exists already");
         return false;
     }
 
     // Only send 200 when we're truly done
-    TRACE("Multipart: Successfully received file '%s'\n", filename.c_str());
-    std::string filenameOnly = filename.substr(filename.find_last_of('/') + 1);
+    TRACE("Multipart: Successfully received %zu file(s), %zu field(s)\n", files.size(), fields.size());
+    std::string filenameOnly = files.front().substr(files.front().find_last_of('/') + 1);
     sendHttpResponse(200, filenameOnly);
     return true;
 }
 
-/// @copydoc MultipartParser::handleChunk
-bool MultipartParser::handleChunk(std::string &chunkData)
+/// @copydoc MultipartParser::begin
+bool MultipartParser::begin(const std::string& contentType)
 {
-    TRACE("Handling chunk, size: %zu bytes\n", chunkData.size());
-    const std::string boundaryPrefix = "--" + boundary;
-    const std::string finalBoundary = boundaryPrefix + "--";
+    setBoundaryFromContentType(contentType);
+    if (boundary.empty())
+        return false;
+
+    // Seed the window with a CRLF so the first delimiter matches like the others
+    window[0] = '\r';
+    window[1] = '\n';
+    start = 0;
+    end = 2;
+    scanFrom = 0;
+    state = State::Preamble;
+    return true;
+}
 
-    while (!chunkData.empty() && currentState != COMPLETE)
+/// @copydoc MultipartParser::feed
+bool MultipartParser::feed(const char* data, size_t len)
+{
+    while (len > 0 && state != State::Complete)
     {
-        switch (currentState)
+        if (end == WindowSize)
+            compact();
+
+        size_t n = std::min(len, WindowSize - end);
+        if (n == 0)
+            return false;
+        memcpy(window + end, data, n);
+        end += n;
+        data += n;
+        len -= n;
+
+        if (!process())
+            return false;
+    }
+    return true;
+}
+
+/// @copydoc MultipartParser::compact
+void MultipartParser::compact()
+{
+    if (start == 0)
+        return;
+    memmove(window, window + start, end - start);
+    end -= start;
+    scanFrom = scanFrom > start ? scanFrom - start : 0;
+    start = 0;
+}
+
+/// @copydoc MultipartParser::findDelimiter
+size_t MultipartParser::findDelimiter()
+{
+    const size_t m = delimiter.size();
+    const uint8_t* pattern = reinterpret_cast<const uint8_t*>(delimiter.data());
+    size_t i = std::max(scanFrom, start);
+
+    while (i + m <= end)
+    {
+        uint8_t last = window[i + m - 1];
+        if (last == pattern[m - 1] && memcmp(window + i, pattern, m - 1) == 0)
+            return i;
+        i += skip[last];
+    }
+    scanFrom = i; // no match can start before here
+    return SIZE_MAX;
+}
+
+/// @copydoc MultipartParser::process
+bool MultipartParser::process()
+{
+    for (;;)
+    {
+        switch (state)
         {
-        case SEARCHING_FOR_BOUNDARY:
+        case State::Preamble:
+        case State::Body:
         {
-            size_t boundaryPos = chunkData.find(boundaryPrefix);
-            if (boundaryPos != std::string::npos)
+            size_t hit = findDelimiter();
+            if (hit != SIZE_MAX)
             {
-                size_t skip = boundaryPos + boundaryPrefix.length();
-                if (chunkData.substr(skip, 2) == "\r\n")
-                    skip += 2;
-                chunkData = chunkData.substr(skip);
-                currentState = FOUND_BOUNDARY;
-                TRACE("Found initial boundary, buffer size now: %zu bytes\n", chunkData.size());
+                if (state == State::Body && partData(window + start, hit - start, true) == SIZE_MAX)
+                    return false;
+                start = hit + delimiter.size();
+                scanFrom = start;
+                state = State::AfterDelimiter;
                 continue;
             }
-            return true; // Wait for more data
+
+            // Bytes before scanFrom are content; the rest may be the start of a split delimiter
+            if (state == State::Preamble)
+            {
+                start = scanFrom;
+                return true;
+            }
+            size_t used = partData(window + start, scanFrom - start, false);
+            if (used == SIZE_MAX)
+                return false;
+            start += used;
+            return true;
         }
 
-        case FOUND_BOUNDARY:
+        case State::AfterDelimiter:
         {
-            size_t headersEnd = chunkData.find("\r\n\r\n");
-            if (headersEnd == std::string::npos)
+            // Skip transport padding
+            while (start < end && (window[start] == ' ' || window[start] == '\t'))
+                start++;
+            if (end - start < 2)
                 return true; // wait for more data
 
-            std::string headers = chunkData.substr(0, headersEnd);
-            std::istringstream stream(headers);
-            std::string line;
-            bool gotFilename = false;
+            if (window[start] == '-' && window[start + 1] == '-')
+            {
+                TRACE("Final boundary reached — exiting multipart parser\n");
+                state = State::Complete;
+                continue;
+            }
+            if (window[start] == '\r' && window[start + 1] == '\n')
+            {
+                // Leave the CRLF in place: a part with no headers is just "\r\n\r\n"
+                state = State::Headers;
+                continue;
+            }
+            sendHttpResponse(400, "Malformed multipart body");
+            state = State::Failed;
+            return false;
+        }
 
-            while (std::getline(stream, line))
+        case State::Headers:
+        {
+            static const char blankLine[] = "\r\n\r\n";
+            const uint8_t* first = window + start;
+            const uint8_t* last = window + end;
+            const uint8_t* pos = std::search(first, last, blankLine, blankLine + 4);
+            if (pos == last)
             {
-                line.erase(std::remove(line.begin(), line.end(), '\r'), line.end());
-                if (line.find("Content-Disposition:") != std::string::npos)
+                if (start == 0 && end == WindowSize)
                 {
-                    gotFilename = extractFilename(line);
-                    if (gotFilename)
-                    {
-                        TRACE("Filename extracted: %s\n", filename.c_str());
-                    }
+                    sendHttpResponse(400, "Part headers too large");
+                    state = State::Failed;
+                    return false;
                 }
+                return true; // wait for more data
             }
 
-            if (!gotFilename)
+            std::string headers;
+            if (pos > first + 2)
+                headers.assign(reinterpret_cast<const char*>(first + 2), pos - (first + 2));
+            start = (pos - window) + 4;
+            scanFrom = start;
+
+            if (!beginPart(headers))
             {
-                sendHttpResponse(400, "Invalid upload: no filename or filename exists already");
-                currentState = COMPLETE;
+                state = State::Failed;
                 return false;
             }
-
-            chunkData = chunkData.substr(headersEnd + 4); // skip headers
-            currentState = FOUND_DATA_START;
+            state = State::Body;
             continue;
         }
 
-        case FOUND_DATA_START:
-        {
-            size_t finalPos = chunkData.find(finalBoundary);
-            size_t nextBoundaryPos = chunkData.find(boundaryPrefix);
+        case State::Complete:
+            start = end; // ignore the epilogue
+            return true;
 
-            size_t boundaryPos = std::string::npos;
-            bool isFinal = false;
+        default:
+            return false;
+        }
+    }
+}
 
-            if (finalPos != std::string::npos &&
-                (nextBoundaryPos == std::string::npos || finalPos < nextBoundaryPos))
-            {
-                boundaryPos = finalPos;
-                isFinal = true;
-            }
-            else if (nextBoundaryPos != std::string::npos)
-            {
-                boundaryPos = nextBoundaryPos;
-            }
+/// @copydoc MultipartParser::beginPart
+bool MultipartParser::beginPart(const std::string& headers)
+{
+    std::string name;
+    std::string file;
+    bool hasFilename = false;
 
-            if (boundaryPos == std::string::npos)
-            {
-                // No boundary, stream all data
-                if (processFileData(chunkData))
-                {
-                    chunkData.clear();
-                    return true;
-                }
-                return false; // Error processing data;
-            }
+    size_t pos = 0;
+    while (pos < headers.size())
+    {
+        size_t eol = headers.find("\r\n", pos);
+        if (eol == std::string::npos)
+            eol = headers.size();
+        std::string line = headers.substr(pos, eol - pos);
+        pos = eol + 2;
 
-            // Process data up to boundary
-            size_t dataEnd = boundaryPos;
-            if (dataEnd >= 2 && chunkData.substr(dataEnd - 2, 2) == "\r\n")
-                dataEnd -= 2;
+        if (strncasecmp(line.c_str(), "Content-Disposition:", 20) == 0)
+        {
+            headerParam(line, "name", name);
+            hasFilename = headerParam(line, "filename", file);
+        }
+    }
 
-            std::string fileData = chunkData.substr(0, dataEnd);
-            processFileData(fileData);
+    if (hasFilename && !file.empty())
+        return beginFile(file);
 
-            // Advance past boundary
-            size_t skip = boundaryPos + boundaryPrefix.length();
-            isFinal = (chunkData.substr(skip, 2) == "--");
-            if (isFinal)
-                skip += 2;
+    // No file chosen for a file input is sent as filename="" with no content; treat it as a field
+    if (name.empty())
+    {
+        sendHttpResponse(400, "Invalid upload: part has no name");
+        return false;
+    }
+    fieldName = name;
+    fields[fieldName].clear();
+    TRACE("Form field: %s\n", fieldName.c_str());
+    return true;
+}
 
-            if (chunkData.substr(skip, 2) == "\r\n")
-                skip += 2;
+/// @copydoc MultipartParser::partData
+size_t MultipartParser::partData(const uint8_t* data, size_t len, bool last)
+{
+    if (filename.empty())
+    {
+        std::string &value = fields[fieldName];
+        size_t room = MULTIPART_MAX_FIELD_SIZE > value.size() ? MULTIPART_MAX_FIELD_SIZE - value.size() : 0;
+        value.append(reinterpret_cast<const char*>(data), std::min(len, room));
+        return len;
+    }
 
-            chunkData = chunkData.substr(skip);
+    if (len && !processFileData(data, len))
+        return SIZE_MAX;
 
-            TRACE("Final boundary reached — exiting multipart parser\n");
-            currentState = COMPLETE; 
-            break;
+    if (last)
+    {
+        if (!writer.close())
+        {
+            TRACE("Failed to finish file during multipart upload\n");
+            sendHttpResponse(500, "Failed to write file data");
+            discardFile();
+            return SIZE_MAX;
+        }
+        TRACE("Multipart: received file '%s', %zu bytes\n", filename.c_str(), writer.bytesWritten());
+        files.push_back(filename);
+        filename.clear();
+    }
+    return len;
+}
 
-            TRACE("Final boundary reached — exiting multipart parser\n");
-            break;
+/// @copydoc MultipartParser::headerParam
+bool MultipartParser::headerParam(const std::string& header, const char* key, std::string& value)
+{
+    const size_t n = header.size();
+    size_t pos = header.find(';');
+    while (pos != std::string::npos && pos < n)
+    {
+        ++pos;
+        while (pos < n && (header[pos] == ' ' || header[pos] == '\t'))
+            ++pos;
+
+        size_t eq = pos;
+        while (eq < n && header[eq] != '=' && header[eq] != ';')
+            ++eq;
+        size_t keyEnd = eq;
+        while (keyEnd > pos && (header[keyEnd - 1] == ' ' || header[keyEnd - 1] == '\t'))
+            --keyEnd;
+        bool match = keyEnd - pos == strlen(key) && strncasecmp(header.c_str() + pos, key, keyEnd - pos) == 0;
+
+        size_t next;
+        std::string v;
+        if (eq < n && header[eq] == '=')
+        {
+            size_t vs = eq + 1;
+            if (vs < n && header[vs] == '"')
+            {
+                // Quoted values may contain ';'
+                size_t close = header.find('"', vs + 1);
+                if (close == std::string::npos)
+                    close = n;
+                v = header.substr(vs + 1, close - vs - 1);
+                next = header.find(';', close);
+            }
+            else
+            {
+                next = header.find(';', vs);
+                v = header.substr(vs, (next == std::string::npos ? n : next) - vs);
+            }
+        }
+        else
+        {
+            next = eq < n ? eq : std::string::npos;
         }
 
-        default:
-            return false;
+        if (match)
+        {
+            value = v;
+            return true;
         }
+        pos = next;
     }
-
-    return true;
+    return false;
 }
 
-/// @copydoc MultipartParser::extractFilename
-bool MultipartParser::extractFilename(const std::string &contentDisposition)
+/// @copydoc MultipartParser::beginFile
+bool MultipartParser::beginFile(const std::string& name)
 {
-    std::size_t start = contentDisposition.find("filename=\"");
-    if (start == std::string::npos)
+    // Never let the client choose a directory
+    std::string baseName = name.substr(name.find_last_of("/\\") + 1);
+    if (baseName.empty() || baseName == "." || baseName == "..")
+    {
+        sendHttpResponse(400, "Invalid upload: no filename or filename exists already");
         return false;
+    }
 
-    start += 10;
-    std::size_t end = contentDisposition.find("\"", start);
-    if (end == std::string::npos)
-        return false;
     // Ensure upload directory exists
     auto storage = AppContext::get<StorageManager>();
     if(!storage) {
@@ -274,7 +443,7 @@ bool MultipartParser::extractFilename(const std::string &contentDisposition)
         return false;
     }
     storage->mount(); // ensure mounted
-    std::string uploads(MULTIPART_UPLOAD_PATH); 
+    std::string uploads(MULTIPART_UPLOAD_PATH);
     TRACE("Checking if upload directory exists: %s\n", uploads.c_str());
     if (!storage->exists(uploads)) {
         TRACE("Upload directory does not exist, creating: %s\n", uploads.c_str());
@@ -284,23 +453,34 @@ bool MultipartParser::extractFilename(const std::string &contentDisposition)
             return false;
         }
     }
-    filename = std::string(MULTIPART_UPLOAD_PATH) + "/" + contentDisposition.substr(start, end - start);
-    TRACE("checking if filename: %s exists\n", filename.c_str());
-    if (file_exists(filename))
+
+    std::string path = uploads + "/" + baseName;
+    TRACE("checking if filename: %s exists\n", path.c_str());
+    if (storage->exists(path) || std::find(files.begin(), files.end(), path) != files.end())
     {
-        printf("[MultipartParser] File already exists: %s\n", filename.c_str());
+        printf("[MultipartParser] File already exists: %s\n", path.c_str());
+        sendHttpResponse(400, "Invalid upload: no filename or filename exists already");
         return false;
     }
+
+    if (!writer.open(storage, path))
+    {
+        printf("[MultipartParser] Cannot create file: %s\n", path.c_str());
+        sendHttpResponse(500, "Failed to write file data");
+        return false;
+    }
+    filename = path;
+    TRACE("Filename extracted: %s\n", filename.c_str());
     return true;
 }
 
 /// @copydoc MultipartParser::processFileData
-bool MultipartParser::processFileData(const std::string &fileData)
+bool MultipartParser::processFileData(const uint8_t* data, size_t size)
 {
-    TRACE("Processing file data, size: %zu bytes\n", fileData.size());
-    auto *storage = AppContext::get<StorageManager>();
-    if (!storage->appendToFile(filename, (uint8_t *)fileData.c_str(), fileData.size()))
+    TRACE("Processing file data, size: %zu bytes\n", size);
+    if (!writer.write(data, size))
     {
+        auto *storage = AppContext::get<StorageManager>();
         if (!storage->isMounted())
         {
             TRACE("SD card not mounted — cannot handle multipart upload\n");
@@ -316,35 +496,27 @@ bool MultipartParser::processFileData(const std::string &fileData)
     return true;
 }
 
-/// @copydoc MultipartParser::file_exists
-int MultipartParser::file_exists(const std::string& filename)
+/// @copydoc MultipartParser::discardFile
+void MultipartParser::discardFile()
 {
-    StorageManager *storage = AppContext::get<StorageManager>();
-    TRACE("[MultipartParser] Checking if file exists: %s\n", filename.c_str());
-    return storage->exists(filename);
-}
-
-/// @copydoc MultipartParser::findDataStart
-int MultipartParser::findDataStart(std::string &currentData)
-{
-    std::size_t pos = currentData.find("\r\n\r\n");
-    return (pos != std::string::npos) ? static_cast<int>(pos + 4) : -1;
-}
-
-/// @copydoc MultipartParser::handleFinalBoundary
-bool MultipartParser::handleFinalBoundary(std::string &fileData)
-{
-    std::size_t finalBoundaryPos = fileData.find(boundary + "--");
-    if (finalBoundaryPos != std::string::npos)
+    if (filename.empty())
+        return;
+    writer.close();
+    auto *storage = AppContext::get<StorageManager>();
+    if (storage)
     {
-        fileData = fileData.substr(0, finalBoundaryPos);
-        return true;
+        TRACE("Removing partial upload: %s\n", filename.c_str());
+        storage->remove(filename);
     }
-    return false;
+    filename.clear();
 }
 
 /// @copydoc MultipartParser::sendHttpResponse
 void MultipartParser::sendHttpResponse(int statusCode, const std::string &messageOrFilename) {
+    if (!tcp) {
+        return; // fed directly, the caller sees the failure from feed()
+    }
+
     std::ostringstream oss;
     std::string body;
 
@@ -363,10 +535,11 @@ void MultipartParser::sendHttpResponse(int statusCode, const std::string &messag
         << body;
 
     std::string response = oss.str();
-    if (!tcp || !tcp->isConnected()) {
+    if (!tcp->isConnected()) {
         panic("Attempted to send on invalid socket");
     }
 
     tcp->send(response.c_str(), response.length());
+    responseSent = true;
     vTaskDelay(pdMS_TO_TICKS(50));
 }
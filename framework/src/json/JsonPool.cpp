@@ -0,0 +1,364 @@
+/**
+ * @file JsonPool.cpp
+ * @author Ian Archbell
+ * @brief Implementation of the JSON size-class pool and scratch arenas.
+ *
+ * Part of the PicoFramework application framework.
+ * Each size class keeps an intrusive free list. Empty lists are refilled by carving a
+ * new slab obtained from the FreeRTOS heap; slabs are kept for reuse, so steady-state
+ * JSON churn never reaches the general heap. Under UNIT_TEST the heap calls map to
+ * malloc/free so the pool can be exercised by host benchmarks.
+ *
+ * @version 0.1
+ * @date 2025-04-04
+ * @license MIT License
+ * @copyright Copyright (c) 2025, Ian Archbell
+ */
+
+#include "json/JsonPool.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifndef UNIT_TEST
+#include "FreeRTOS.h"
+#include "task.h"
+#define POOL_HEAP_ALLOC(size) pvPortMalloc(size)
+#define POOL_HEAP_FREE(ptr) vPortFree(ptr)
+#define POOL_LOCK() taskENTER_CRITICAL()
+#define POOL_UNLOCK() taskEXIT_CRITICAL()
+#define POOL_ASSERT(x) configASSERT(x)
+#else
+#include <cassert>
+#define POOL_HEAP_ALLOC(size) malloc(size)
+#define POOL_HEAP_FREE(ptr) free(ptr)
+#define POOL_LOCK()
+#define POOL_UNLOCK()
+#define POOL_ASSERT(x) assert(x)
+#endif
+
+// The heap is never called with the pool lock held: heap_4 suspends the scheduler, which is
+// not allowed inside a critical section on SMP builds.
+
+namespace
+{
+    constexpr size_t classSizes[JsonPoolStats::NumClasses] = {16, 32, 64, 128, 256};
+
+    struct FreeBlock
+    {
+        FreeBlock *next;
+    };
+
+    struct SizeClass
+    {
+        FreeBlock *freeList = nullptr;
+        size_t inUse = 0;
+        size_t free = 0;
+    };
+
+    SizeClass classes[JsonPoolStats::NumClasses];
+    size_t slabCount = 0;
+    size_t largeCount = 0;
+    size_t largeBytes = 0;
+    size_t scratchFallbacks = 0;
+    JsonScratch *liveArenas = nullptr; ///< Every constructed JsonScratch, for JsonScratch::release()
+
+    /// Map a request size to its class index, or -1 if it is too large for the pool
+    inline int classIndex(size_t size)
+    {
+        for (size_t i = 0; i < JsonPoolStats::NumClasses; ++i)
+        {
+            if (size <= classSizes[i])
+                return static_cast<int>(i);
+        }
+        return -1;
+    }
+
+    /// Carve a slab into blocks of one class. Called with the pool lock held.
+    void carve(size_t index, uint8_t *slab)
+    {
+        static_assert(JSON_POOL_SLAB_SIZE >= 256, "JSON_POOL_SLAB_SIZE must hold at least one block of every class");
+
+        size_t blockSize = classSizes[index];
+        size_t count = JSON_POOL_SLAB_SIZE / blockSize;
+        SizeClass &sc = classes[index];
+        for (size_t i = 0; i < count; ++i)
+        {
+            auto *block = reinterpret_cast<FreeBlock *>(slab + i * blockSize);
+            block->next = sc.freeList;
+            sc.freeList = block;
+        }
+        sc.free += count;
+        ++slabCount;
+    }
+}
+
+// ------------------------------------------------------------------------
+// JsonPool
+// ------------------------------------------------------------------------
+
+void *JsonPool::allocate(size_t size)
+{
+    int index = classIndex(size);
+    if (index < 0)
+    {
+        void *p = POOL_HEAP_ALLOC(size);
+        if (p)
+        {
+            POOL_LOCK();
+            ++largeCount;
+            largeBytes += size;
+            POOL_UNLOCK();
+        }
+        return p;
+    }
+
+    SizeClass &sc = classes[index];
+    while (true)
+    {
+        POOL_LOCK();
+        FreeBlock *block = sc.freeList;
+        if (block)
+        {
+            sc.freeList = block->next;
+            --sc.free;
+            ++sc.inUse;
+        }
+        POOL_UNLOCK();
+        if (block)
+            return block;
+
+        // Refill with the lock released; another task may refill the class meanwhile
+        uint8_t *slab = static_cast<uint8_t *>(POOL_HEAP_ALLOC(JSON_POOL_SLAB_SIZE));
+        if (!slab)
+            return nullptr;
+
+        POOL_LOCK();
+        bool needed = !sc.freeList;
+        if (needed)
+            carve(static_cast<size_t>(index), slab);
+        POOL_UNLOCK();
+        if (!needed)
+            POOL_HEAP_FREE(slab);
+    }
+}
+
+void JsonPool::deallocate(void *ptr, size_t size)
+{
+    if (!ptr)
+        return;
+
+    int index = classIndex(size);
+    if (index < 0)
+    {
+        POOL_LOCK();
+        --largeCount;
+        largeBytes -= size;
+        POOL_UNLOCK();
+        POOL_HEAP_FREE(ptr);
+        return;
+    }
+
+    POOL_LOCK();
+    SizeClass &sc = classes[index];
+    auto *block = static_cast<FreeBlock *>(ptr);
+    block->next = sc.freeList;
+    sc.freeList = block;
+    ++sc.free;
+    --sc.inUse;
+    POOL_UNLOCK();
+}
+
+void JsonPool::getStats(JsonPoolStats &out)
+{
+    memset(&out, 0, sizeof(out));
+
+    POOL_LOCK();
+    for (size_t i = 0; i < JsonPoolStats::NumClasses; ++i)
+    {
+        out.classSize[i] = classSizes[i];
+        out.blocksInUse[i] = classes[i].inUse;
+        out.blocksFree[i] = classes[i].free;
+    }
+    out.slabs = slabCount;
+    out.slabBytes = slabCount * JSON_POOL_SLAB_SIZE;
+    out.largeAllocs = largeCount;
+    out.largeBytes = largeBytes;
+    out.scratchFallbacks = scratchFallbacks;
+    POOL_UNLOCK();
+
+#ifndef UNIT_TEST
+    HeapStats_t heap;
+    vPortGetHeapStats(&heap);
+    out.heapFree = heap.xAvailableHeapSpaceInBytes;
+    out.heapLargestFreeBlock = heap.xSizeOfLargestFreeBlockInBytes;
+    out.heapFreeBlocks = heap.xNumberOfFreeBlocks;
+    if (out.heapFree > 0)
+    {
+        out.heapFragmentationPct = static_cast<uint8_t>(100 - (out.heapLargestFreeBlock * 100) / out.heapFree);
+    }
+#endif
+}
+
+void JsonPool::printStats()
+{
+    JsonPoolStats stats;
+    getStats(stats);
+
+    printf("[JsonPool] slabs: %zu (%zu bytes), large: %zu (%zu bytes), scratch overflow: %zu\n",
+           stats.slabs, stats.slabBytes, stats.largeAllocs, stats.largeBytes, stats.scratchFallbacks);
+    for (size_t i = 0; i < JsonPoolStats::NumClasses; ++i)
+    {
+        printf("[JsonPool]   %4zu B: %5zu in use, %5zu free\n",
+               stats.classSize[i], stats.blocksInUse[i], stats.blocksFree[i]);
+    }
+#ifndef UNIT_TEST
+    printf("[JsonPool] heap free: %zu, largest block: %zu, free blocks: %zu, fragmentation: %u%%\n",
+           stats.heapFree, stats.heapLargestFreeBlock, stats.heapFreeBlocks, stats.heapFragmentationPct);
+#endif
+}
+
+void JsonPool::outOfMemory(size_t size)
+{
+    printf("ERROR: JSON allocation failed for size %zu!\n", size);
+    printStats();
+#ifndef UNIT_TEST
+    while (1)
+        ; // Trap like the global operator new
+#else
+    abort();
+#endif
+}
+
+// ------------------------------------------------------------------------
+// JsonScratch
+// ------------------------------------------------------------------------
+
+JsonScratch::JsonScratch(size_t capacity)
+    : buffer(static_cast<uint8_t *>(POOL_HEAP_ALLOC(capacity))),
+      capacity(buffer ? capacity : 0)
+{
+    if (!buffer)
+    {
+        printf("[JsonPool] No heap for a %zu byte scratch arena, using the pool\n", capacity);
+    }
+
+    POOL_LOCK();
+    nextLive = liveArenas;
+    liveArenas = this;
+    POOL_UNLOCK();
+}
+
+JsonScratch::~JsonScratch()
+{
+    if (current() == this)
+    {
+        setCurrent(nullptr);
+    }
+
+    POOL_LOCK();
+    JsonScratch **link = &liveArenas;
+    while (*link != this)
+    {
+        link = &(*link)->nextLive;
+    }
+    *link = nextLive;
+    POOL_UNLOCK();
+
+    POOL_HEAP_FREE(buffer);
+}
+
+void *JsonScratch::allocate(size_t size)
+{
+    size_t aligned = (size + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+    if (capacity - used < aligned)
+    {
+        POOL_LOCK();
+        ++scratchFallbacks;
+        POOL_UNLOCK();
+        return JsonPool::allocate(size);
+    }
+    void *p = buffer + used;
+    used += aligned;
+    if (used > peak)
+    {
+        peak = used;
+    }
+    return p;
+}
+
+void JsonScratch::deallocate(void *ptr, size_t size)
+{
+    if (!owns(ptr))
+    {
+        JsonPool::deallocate(ptr, size);
+    }
+}
+
+void JsonScratch::release(void *ptr, size_t size)
+{
+    JsonScratch *owner = nullptr;
+    POOL_LOCK();
+    for (JsonScratch *arena = liveArenas; arena; arena = arena->nextLive)
+    {
+        if (arena->owns(ptr))
+        {
+            owner = arena;
+            break;
+        }
+    }
+    POOL_UNLOCK();
+
+    if (!owner)
+    {
+        JsonPool::deallocate(ptr, size);
+        return;
+    }
+
+    // Arena blocks go back on reset(). One freed while another arena is current belongs to
+    // a ScratchJson that outlived, or was moved out of, the scope it was built in.
+    POOL_ASSERT(owner == current());
+}
+
+#ifndef UNIT_TEST
+JsonScratch *JsonScratch::current()
+{
+    if (xTaskGetSchedulerState() != taskSCHEDULER_RUNNING)
+        return nullptr;
+    return static_cast<JsonScratch *>(pvTaskGetThreadLocalStoragePointer(nullptr, JSON_SCRATCH_TLS_INDEX));
+}
+
+void JsonScratch::setCurrent(JsonScratch *scratch)
+{
+    vTaskSetThreadLocalStoragePointer(nullptr, JSON_SCRATCH_TLS_INDEX, scratch);
+}
+#else
+static thread_local JsonScratch *currentScratch = nullptr;
+
+JsonScratch *JsonScratch::current()
+{
+    return currentScratch;
+}
+
+void JsonScratch::setCurrent(JsonScratch *scratch)
+{
+    currentScratch = scratch;
+}
+#endif
+
+// ------------------------------------------------------------------------
+// JsonScratchScope
+// ------------------------------------------------------------------------
+
+JsonScratchScope::JsonScratchScope(JsonScratch &scratch)
+    : scratch(scratch), previous(JsonScratch::current())
+{
+    JsonScratch::setCurrent(&scratch);
+}
+
+JsonScratchScope::~JsonScratchScope()
+{
+    scratch.reset();
+    JsonScratch::setCurrent(previous);
+}
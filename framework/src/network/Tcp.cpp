@@ -62,6 +62,7 @@ Tcp &Tcp::operator=(Tcp &&other) noexcept
         server_tls_config = other.server_tls_config;
     #endif
         connected = other.connected;
+        peer_closed = other.peer_closed;
         use_tls = other.use_tls;
         recv_buffer = other.recv_buffer;
 
@@ -198,12 +199,18 @@ void Tcp::onError(void *arg, err_t err)
     printf("[Tcp] altcp error: %d\n", err);
 
     self->connectResult = err;
+    self->peer_closed = true;
 
     // Notify the waiting task (e.g. to break ulTaskNotifyTakeIndexed)
     if (self->connectingTask)
     {
         xTaskNotifyGiveIndexed(self->connectingTask, NotifyConnect);
     }
+    if (self->waiting_task)
+    {
+        xTaskNotifyGiveIndexed(self->waiting_task, NotifyRecv);
+        self->waiting_task = nullptr;
+    }
 
     self->tls_pcb = nullptr;
 }
@@ -363,6 +370,14 @@ err_t Tcp::tlsRecvCallback(void *arg, struct altcp_pcb *conn, struct pbuf *p, er
             self->recv_buffer = nullptr;
         }
         self->recv_offset = 0;
+        self->peer_closed = true;
+
+        // Wake a reader rather than leave it waiting out its timeout
+        if (self->waiting_task)
+        {
+            xTaskNotifyGiveIndexed(self->waiting_task, NotifyRecv);
+            self->waiting_task = nullptr;
+        }
         return ERR_OK;
     }
 
@@ -409,6 +424,9 @@ int Tcp::recv(char *buffer, size_t size, uint32_t timeout_ms)
     // If no data available yet, block and wait for notify
     if (!recv_buffer)
     {
+        if (peer_closed)
+            return 0;
+
         waiting_task = xTaskGetCurrentTaskHandle();
         BaseType_t result = ulTaskNotifyTakeIndexed(NotifyRecv, pdTRUE, pdMS_TO_TICKS(timeout_ms));
         if (result == 0 || !recv_buffer)
@@ -465,9 +483,34 @@ int Tcp::close()
     }
 
     connected = false;
+    peer_closed = false;
     return result;
 }
 
+bool Tcp::isIdle()
+{
+    if (!connected || peer_closed)
+    {
+        return false;
+    }
+#if PICO_TCP_ENABLE_TLS
+    if (use_tls)
+    {
+        // The recv callback records both unread data and a close from the server
+        return tls_pcb != nullptr && recv_buffer == nullptr;
+    }
+#endif
+    if (sockfd < 0)
+    {
+        return false;
+    }
+
+    // Nothing to read and not at EOF: the peer is still there and has said nothing
+    char probe;
+    int n = lwip_recv(sockfd, &probe, 1, MSG_PEEK | MSG_DONTWAIT);
+    return n < 0 && (errno == EWOULDBLOCK || errno == EAGAIN);
+}
+
 err_t Tcp::acceptCallback(void *arg, struct altcp_pcb *new_conn, err_t err)
 {
     auto *self = static_cast<Tcp *>(arg);
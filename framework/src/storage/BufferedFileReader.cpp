@@ -0,0 +1,149 @@
+/**
+ * @file BufferedFileReader.cpp
+ * @author Ian Archbell
+ * @brief Implementation of the read-ahead buffer for file readers.
+ *
+ * Part of the PicoFramework application framework.
+ * The underlying file position is always bufferStart + bufferLen; the reader's logical
+ * position is bufferStart + bufferPos.
+ *
+ * @version 0.1
+ * @date 2025-04-22
+ * @license MIT License
+ * @copyright Copyright (c) 2025, Ian Archbell
+ */
+
+#include "storage/BufferedFileReader.h"
+#include <cstring>
+
+/// @copydoc BufferedFileReader::readLine
+bool BufferedFileReader::readLine(char* outLine, size_t maxLen)
+{
+    if (maxLen < 2)
+        return false;
+
+    size_t count = 0;
+    bool eof = false;
+
+    while (count < maxLen - 1)
+    {
+        if (bufferPos == bufferLen && !fill())
+        {
+            eof = true;
+            break;
+        }
+
+        const uint8_t* start = buffer + bufferPos;
+        size_t available = bufferLen - bufferPos;
+        const uint8_t* newline = static_cast<const uint8_t*>(memchr(start, '\n', available));
+        size_t span = newline ? static_cast<size_t>(newline - start) : available;
+        size_t room = maxLen - 1 - count;
+        size_t take = span < room ? span : room;
+
+        memcpy(outLine + count, start, take);
+        bufferPos += take;
+
+        // Strip carriage returns; they don't count against the buffer size
+        if (memchr(outLine + count, '\r', take))
+        {
+            size_t kept = count;
+            for (size_t i = count; i < count + take; ++i)
+            {
+                if (outLine[i] != '\r')
+                    outLine[kept++] = outLine[i];
+            }
+            count = kept;
+        }
+        else
+        {
+            count += take;
+        }
+
+        if (newline && take == span)
+        {
+            bufferPos++; // consume the newline
+            outLine[count] = '\0';
+            return true;
+        }
+    }
+
+    // A line that exactly filled outLine still owns its newline, even across a block boundary
+    if (!eof && (bufferPos < bufferLen || fill()) && buffer[bufferPos] == '\n')
+        bufferPos++;
+
+    if (count == 0 && eof)
+        return false;
+
+    outLine[count] = '\0';
+    return true;
+}
+
+/// @copydoc BufferedFileReader::readChunk
+size_t BufferedFileReader::readChunk(void* dst, size_t len)
+{
+    uint8_t* out = static_cast<uint8_t*>(dst);
+    size_t total = 0;
+
+    while (total < len)
+    {
+        if (bufferPos < bufferLen)
+        {
+            size_t n = bufferLen - bufferPos;
+            if (n > len - total)
+                n = len - total;
+            memcpy(out + total, buffer + bufferPos, n);
+            bufferPos += n;
+            total += n;
+            continue;
+        }
+
+        if (len - total >= sizeof(buffer))
+        {
+            // Large reads bypass the buffer instead of copying through it
+            int n = readRaw(out + total, len - total);
+            if (n <= 0)
+                break;
+            bufferStart += bufferLen + n;
+            bufferLen = bufferPos = 0;
+            total += n;
+        }
+        else if (!fill())
+        {
+            break;
+        }
+    }
+    return total;
+}
+
+/// @copydoc BufferedFileReader::seek
+bool BufferedFileReader::seek(size_t offset)
+{
+    if (offset >= bufferStart && offset <= bufferStart + bufferLen)
+    {
+        bufferPos = offset - bufferStart;
+        return true;
+    }
+    if (!seekRaw(offset))
+        return false;
+    bufferStart = offset;
+    bufferLen = bufferPos = 0;
+    return true;
+}
+
+/// @copydoc BufferedFileReader::resetBuffer
+void BufferedFileReader::resetBuffer()
+{
+    bufferStart = bufferLen = bufferPos = 0;
+}
+
+/// @copydoc BufferedFileReader::fill
+bool BufferedFileReader::fill()
+{
+    bufferStart += bufferLen;
+    bufferLen = bufferPos = 0;
+    int n = readRaw(buffer, sizeof(buffer));
+    if (n <= 0)
+        return false;
+    bufferLen = static_cast<size_t>(n);
+    return true;
+}
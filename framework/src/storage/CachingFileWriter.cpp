@@ -0,0 +1,23 @@
+#include "storage/CachingFileWriter.h"
+#include "storage/CachingStorageManager.h"
+
+CachingFileWriter::CachingFileWriter(CachingStorageManager *owner, const std::string &path)
+    : owner(owner), path(path) {}
+
+CachingFileWriter::~CachingFileWriter()
+{
+    close();
+}
+
+bool CachingFileWriter::write(const void *data, size_t len)
+{
+    if (!owner)
+        return false;
+    return len == 0 || owner->appendToFile(path, static_cast<const uint8_t *>(data), len);
+}
+
+bool CachingFileWriter::close()
+{
+    owner = nullptr;
+    return true;
+}
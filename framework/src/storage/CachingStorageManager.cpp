@@ -0,0 +1,729 @@
+/**
+ * @file CachingStorageManager.cpp
+ * @author Ian Archbell
+ * @brief Implementation of the RAM cache and write-back layer over a StorageManager.
+ * @version 0.1
+ * @date 2025-04-22
+ * @license MIT License
+ * @copyright Copyright (c) 2025, Ian Archbell
+ */
+
+#include "storage/CachingStorageManager.h"
+#include "storage/CachingFileWriter.h"
+#include "storage/RamFileReader.h"
+#include <algorithm>
+#include <cstdio>
+
+/// @copydoc CachingStorageManager::CachingStorageManager
+CachingStorageManager::CachingStorageManager(StorageManager *backing, size_t budget)
+    : backing_(backing), budget_(budget)
+{
+    lock_ = xSemaphoreCreateMutexStatic(&lockBuffer_);
+    configASSERT(lock_);
+#if STORAGE_CACHE_FLUSH_INTERVAL_MS > 0
+    task_ = xTaskCreateStatic(flushTask, "CacheFlush", STORAGE_CACHE_STACK_SIZE, this,
+                              STORAGE_CACHE_PRIORITY, taskStack_, &taskBuffer_);
+    configASSERT(task_);
+#endif
+}
+
+/// @copydoc CachingStorageManager::normalize
+std::string CachingStorageManager::normalize(const std::string &path)
+{
+    std::string out = (path.empty() || path[0] != '/') ? "/" + path : path;
+    while (out.size() > 1 && out.back() == '/')
+    {
+        out.pop_back();
+    }
+    return out;
+}
+
+/// @copydoc CachingStorageManager::setPolicy
+void CachingStorageManager::setPolicy(const std::string &prefix, Policy policy)
+{
+    std::string p = normalize(prefix);
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    settle(p, true);
+    bool found = false;
+    for (auto &rule : rules_)
+    {
+        if (rule.first == p)
+        {
+            rule.second = policy;
+            found = true;
+        }
+    }
+    if (!found)
+    {
+        rules_.emplace_back(p, policy);
+    }
+    xSemaphoreGive(lock_);
+}
+
+/// @copydoc CachingStorageManager::setDefaultPolicy
+void CachingStorageManager::setDefaultPolicy(Policy policy)
+{
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    defaultPolicy_ = policy;
+    xSemaphoreGive(lock_);
+}
+
+/// @copydoc CachingStorageManager::policyFor
+CachingStorageManager::Policy CachingStorageManager::policyFor(const std::string &path) const
+{
+    Policy policy = defaultPolicy_;
+    size_t longest = 0;
+    for (const auto &rule : rules_)
+    {
+        const std::string &prefix = rule.first;
+        bool matches = prefix == "/" ||
+                       (path.compare(0, prefix.size(), prefix) == 0 &&
+                        (path.size() == prefix.size() || path[prefix.size()] == '/'));
+        if (matches && prefix.size() >= longest)
+        {
+            policy = rule.second;
+            longest = prefix.size();
+        }
+    }
+    return policy;
+}
+
+/// @copydoc CachingStorageManager::flush
+bool CachingStorageManager::flush()
+{
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    bool ok = true;
+    for (auto it = entries_.begin(); it != entries_.end();)
+    {
+        if (writeBack(it->first, it->second))
+        {
+            ++it;
+            continue;
+        }
+        ok = false;
+        if (!discardIfFailing(it))
+        {
+            ++it;
+        }
+    }
+    xSemaphoreGive(lock_);
+    return ok;
+}
+
+/// @copydoc CachingStorageManager::stats
+CachingStorageManager::Stats CachingStorageManager::stats()
+{
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    Stats st = stats_;
+    st.used = used_;
+    st.dirty = 0;
+    for (const auto &entry : entries_)
+    {
+        const Entry &e = entry.second;
+        st.dirty += e.rewrite ? e.data->size() : e.data->size() - e.clean;
+    }
+    xSemaphoreGive(lock_);
+    return st;
+}
+
+/// @copydoc CachingStorageManager::writeBack
+bool CachingStorageManager::writeBack(const std::string &path, Entry &entry)
+{
+    if (!entry.dirty())
+    {
+        return true;
+    }
+
+    const std::vector<uint8_t> &data = *entry.data;
+    bool ok;
+    if (entry.rewrite)
+    {
+        ok = backing_->writeFile(path, data.data(), data.size());
+    }
+    else
+    {
+        ok = backing_->appendToFile(path, data.data() + entry.clean, data.size() - entry.clean);
+    }
+    if (!ok)
+    {
+        entry.failures++;
+        printf("[StorageCache] Write-back of '%s' failed (%u)\n", path.c_str(), entry.failures);
+        return false;
+    }
+
+    stats_.writeBacks++;
+    entry.failures = 0;
+    entry.rewrite = false;
+    if (entry.complete)
+    {
+        entry.clean = data.size();
+    }
+    else
+    {
+        // A tail has nothing left to hold once it is in the file
+        used_ -= data.size();
+        entry.data = std::make_shared<std::vector<uint8_t>>();
+    }
+    return true;
+}
+
+/// @copydoc CachingStorageManager::drop
+CachingStorageManager::Entries::iterator CachingStorageManager::drop(Entries::iterator it)
+{
+    used_ -= it->first.size() + it->second.data->size();
+    return entries_.erase(it);
+}
+
+/// @copydoc CachingStorageManager::discardIfFailing
+bool CachingStorageManager::discardIfFailing(Entries::iterator &it)
+{
+    if (it->second.failures < STORAGE_CACHE_WRITE_BACK_RETRIES)
+    {
+        return false;
+    }
+    const Entry &entry = it->second;
+    printf("[StorageCache] Giving up on '%s' after %u failed write-backs, %zu bytes lost\n",
+           it->first.c_str(), entry.failures, entry.rewrite ? entry.data->size() : entry.data->size() - entry.clean);
+    stats_.discarded++;
+    it = drop(it);
+    return true;
+}
+
+/// @copydoc CachingStorageManager::parentExists
+bool CachingStorageManager::parentExists(const std::string &path)
+{
+    size_t slash = path.rfind('/');
+    return slash == 0 || backing_->exists(path.substr(0, slash));
+}
+
+/// @copydoc CachingStorageManager::settle
+bool CachingStorageManager::settle(const std::string &path, bool children)
+{
+    bool ok = true;
+    for (auto it = entries_.lower_bound(path);
+         it != entries_.end() && it->first.compare(0, path.size(), path) == 0;)
+    {
+        bool match = it->first.size() == path.size() ||
+                     (children && (path == "/" || it->first[path.size()] == '/'));
+        if (!match)
+        {
+            ++it;
+        }
+        else if (writeBack(it->first, it->second))
+        {
+            it = drop(it);
+        }
+        else
+        {
+            ok = false;
+            ++it;
+        }
+    }
+    return ok;
+}
+
+/// @copydoc CachingStorageManager::writeBackUnder
+bool CachingStorageManager::writeBackUnder(const std::string &path)
+{
+    std::string prefix = path == "/" ? "/" : path + "/";
+    bool ok = true;
+    for (auto it = entries_.lower_bound(prefix);
+         it != entries_.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it)
+    {
+        ok = writeBack(it->first, it->second) && ok;
+    }
+    return ok;
+}
+
+/// @copydoc CachingStorageManager::makeRoom
+bool CachingStorageManager::makeRoom(size_t bytes, const std::string &keep)
+{
+    if (bytes > budget_)
+    {
+        return false;
+    }
+    if (used_ + bytes <= budget_)
+    {
+        return true;
+    }
+
+    // Least recently used first; one that can't be written back is passed over, not waited on
+    std::vector<Entries::iterator> victims;
+    victims.reserve(entries_.size());
+    for (auto it = entries_.begin(); it != entries_.end(); ++it)
+    {
+        if (it->first != keep)
+        {
+            victims.push_back(it);
+        }
+    }
+    std::sort(victims.begin(), victims.end(), [](Entries::iterator a, Entries::iterator b)
+              { return a->second.lastUse < b->second.lastUse; });
+
+    for (auto victim : victims)
+    {
+        if (used_ + bytes <= budget_)
+        {
+            break;
+        }
+        if (writeBack(victim->first, victim->second))
+        {
+            drop(victim);
+            stats_.evictions++;
+        }
+        else
+        {
+            discardIfFailing(victim);
+        }
+    }
+    return used_ + bytes <= budget_;
+}
+
+/// @copydoc CachingStorageManager::load
+CachingStorageManager::Entry *CachingStorageManager::load(const std::string &path)
+{
+    size_t size = backing_->getFileSize(path);
+    if (size == 0 || size > STORAGE_CACHE_MAX_FILE_SIZE || !makeRoom(path.size() + size, path))
+    {
+        return nullptr;
+    }
+
+    auto data = std::make_shared<std::vector<uint8_t>>();
+    if (!backing_->readFile(path, *data) || path.size() + data->size() > budget_ - used_)
+    {
+        return nullptr; // gone, or grew since the size was taken
+    }
+
+    Entry &entry = entries_[path];
+    entry.data = std::move(data);
+    entry.clean = entry.data->size();
+    entry.lastUse = ++clock_;
+    used_ += path.size() + entry.data->size();
+    return &entry;
+}
+
+/// @copydoc CachingStorageManager::readable
+CachingStorageManager::Entry *CachingStorageManager::readable(const std::string &path)
+{
+    if (policyFor(path) == Policy::Bypass)
+    {
+        settle(path, false);
+        return nullptr;
+    }
+
+    auto it = entries_.find(path);
+    if (it != entries_.end() && it->second.complete)
+    {
+        stats_.hits++;
+        it->second.lastUse = ++clock_;
+        return &it->second;
+    }
+    stats_.misses++;
+    if (it != entries_.end() && !settle(path, false))
+    {
+        return nullptr; // the tail could not be written, so the file can't be read whole
+    }
+    return load(path);
+}
+
+/// @copydoc CachingStorageManager::appendCached
+bool CachingStorageManager::appendCached(const std::string &path, const uint8_t *data, size_t size)
+{
+    auto it = entries_.find(path);
+    if (it == entries_.end())
+    {
+        // Only the appended bytes are held; the file itself is never read in
+        if (!parentExists(path))
+        {
+            printf("[StorageCache] appendToFile: no directory for '%s'\n", path.c_str());
+            return false;
+        }
+        if (!makeRoom(path.size(), path))
+        {
+            return backing_->appendToFile(path, data, size);
+        }
+        it = entries_.emplace(path, Entry{std::make_shared<std::vector<uint8_t>>(), false}).first;
+        used_ += path.size();
+    }
+
+    Entry &entry = it->second;
+    entry.lastUse = ++clock_;
+    if (entry.data->size() + size > STORAGE_CACHE_MAX_FILE_SIZE)
+    {
+        // Too big to keep whole: write out what is held and keep collecting a fresh tail
+        if (!writeBack(path, entry))
+        {
+            return false;
+        }
+        used_ -= entry.data->size();
+        entry.data = std::make_shared<std::vector<uint8_t>>();
+        entry.complete = false;
+        entry.clean = 0;
+    }
+
+    if (size > STORAGE_CACHE_MAX_FILE_SIZE || !makeRoom(size, path))
+    {
+        // Keep the order of the bytes: what is held goes first, then this goes straight through
+        return settle(path, false) && backing_->appendToFile(path, data, size);
+    }
+    if (entry.data.use_count() > 1)
+    {
+        entry.data = std::make_shared<std::vector<uint8_t>>(*entry.data); // a reader holds the old one
+    }
+    entry.data->insert(entry.data->end(), data, data + size);
+    used_ += size;
+    return true;
+}
+
+/// @copydoc CachingStorageManager::mount
+bool CachingStorageManager::mount()
+{
+    return backing_->mount();
+}
+
+/// @copydoc CachingStorageManager::unmount
+bool CachingStorageManager::unmount()
+{
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    bool ok = settle("/", true);
+    xSemaphoreGive(lock_);
+    return backing_->unmount() && ok;
+}
+
+/// @copydoc CachingStorageManager::isMounted
+bool CachingStorageManager::isMounted() const
+{
+    return backing_->isMounted();
+}
+
+/// @copydoc CachingStorageManager::exists
+bool CachingStorageManager::exists(const std::string &path)
+{
+    std::string p = normalize(path);
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    bool found = entries_.count(p) != 0 || backing_->exists(p);
+    xSemaphoreGive(lock_);
+    return found;
+}
+
+/// @copydoc CachingStorageManager::remove
+bool CachingStorageManager::remove(const std::string &path)
+{
+    std::string p = normalize(path);
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    // Children first, so a directory holding unwritten files is not removed as empty
+    writeBackUnder(p);
+    bool cached = false;
+    auto it = entries_.find(p);
+    if (it != entries_.end())
+    {
+        drop(it);
+        cached = true;
+    }
+    bool ok = backing_->remove(p) || (cached && !backing_->exists(p));
+    xSemaphoreGive(lock_);
+    return ok;
+}
+
+/// @copydoc CachingStorageManager::rename
+bool CachingStorageManager::rename(const std::string &from, const std::string &to)
+{
+    std::string src = normalize(from);
+    std::string dst = normalize(to);
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    bool ok = settle(src, true) && settle(dst, true) && backing_->rename(src, dst);
+    xSemaphoreGive(lock_);
+    return ok;
+}
+
+/// @copydoc CachingStorageManager::readFile
+bool CachingStorageManager::readFile(const std::string &path, std::vector<uint8_t> &out)
+{
+    std::string p = normalize(path);
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    bool ok;
+    if (Entry *entry = readable(p))
+    {
+        out.assign(entry->data->begin(), entry->data->end());
+        ok = true;
+    }
+    else
+    {
+        ok = backing_->readFile(p, out);
+    }
+    xSemaphoreGive(lock_);
+    return ok;
+}
+
+/// @copydoc CachingStorageManager::readFileString
+bool CachingStorageManager::readFileString(const std::string &path, uint32_t startPosition, uint32_t length, std::string &buffer)
+{
+    std::string p = normalize(path);
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    bool ok;
+    if (Entry *entry = readable(p))
+    {
+        const std::vector<uint8_t> &data = *entry->data;
+        ok = startPosition < data.size();
+        if (ok)
+        {
+            if (startPosition + length > data.size())
+            {
+                length = data.size() - startPosition;
+            }
+            buffer.assign(reinterpret_cast<const char *>(data.data()) + startPosition, length);
+        }
+    }
+    else
+    {
+        ok = backing_->readFileString(p, startPosition, length, buffer);
+    }
+    xSemaphoreGive(lock_);
+    return ok;
+}
+
+/// @copydoc CachingStorageManager::writeFile
+bool CachingStorageManager::writeFile(const std::string &path, const std::vector<uint8_t> &data)
+{
+    return writeFile(path, data.data(), data.size());
+}
+
+/// @copydoc CachingStorageManager::writeFile
+bool CachingStorageManager::writeFile(const std::string &path, const unsigned char *data, size_t size)
+{
+    std::string p = normalize(path);
+    xSemaphoreTake(lock_, portMAX_DELAY);
+
+    // Whatever is cached is about to be replaced
+    auto it = entries_.find(p);
+    bool known = it != entries_.end();
+    if (known)
+    {
+        drop(it);
+    }
+
+    Policy policy = policyFor(p);
+    if (policy == Policy::Cache && !known && !parentExists(p))
+    {
+        // Held data would only fail at write-back, after the caller was told it was saved
+        printf("[StorageCache] writeFile: no directory for '%s'\n", p.c_str());
+        xSemaphoreGive(lock_);
+        return false;
+    }
+
+    bool fits = policy != Policy::Bypass && size <= STORAGE_CACHE_MAX_FILE_SIZE &&
+                makeRoom(p.size() + size, p);
+    bool ok = true;
+    if (policy != Policy::Cache || !fits)
+    {
+        ok = backing_->writeFile(p, data, size);
+    }
+    if (ok && fits)
+    {
+        Entry &entry = entries_[p];
+        entry.data = std::make_shared<std::vector<uint8_t>>(data, data + size);
+        entry.rewrite = policy == Policy::Cache;
+        entry.clean = entry.rewrite ? 0 : size;
+        entry.lastUse = ++clock_;
+        used_ += p.size() + size;
+    }
+
+    xSemaphoreGive(lock_);
+    return ok;
+}
+
+/// @copydoc CachingStorageManager::appendToFile
+bool CachingStorageManager::appendToFile(const std::string &path, const uint8_t *data, size_t size)
+{
+    std::string p = normalize(path);
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    bool ok;
+    Policy policy = policyFor(p);
+    if (policy == Policy::Cache)
+    {
+        ok = appendCached(p, data, size);
+    }
+    else
+    {
+        auto it = entries_.find(p);
+        bool whole = policy == Policy::WriteThrough && it != entries_.end() && it->second.complete;
+        if (!whole)
+        {
+            settle(p, false);
+        }
+        ok = backing_->appendToFile(p, data, size);
+        if (whole)
+        {
+            // Keep the cached copy in step, or drop it if it no longer fits
+            Entry &entry = it->second;
+            if (ok && entry.data->size() + size <= STORAGE_CACHE_MAX_FILE_SIZE && makeRoom(size, p))
+            {
+                if (entry.data.use_count() > 1)
+                {
+                    entry.data = std::make_shared<std::vector<uint8_t>>(*entry.data);
+                }
+                entry.data->insert(entry.data->end(), data, data + size);
+                entry.clean = entry.data->size();
+                used_ += size;
+            }
+            else
+            {
+                settle(p, false);
+            }
+        }
+    }
+    xSemaphoreGive(lock_);
+    return ok;
+}
+
+/// @copydoc CachingStorageManager::streamFile
+bool CachingStorageManager::streamFile(const std::string &path, std::function<void(const uint8_t *, size_t)> chunkCallback)
+{
+    std::string p = normalize(path);
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    Entry *entry = readable(p);
+    std::shared_ptr<const std::vector<uint8_t>> data = entry ? entry->data : nullptr;
+    xSemaphoreGive(lock_);
+
+    // The callback usually sends over TCP, so other tasks must not wait on it for the lock
+    if (!data)
+    {
+        return backing_->streamFile(p, chunkCallback);
+    }
+    for (size_t pos = 0; pos < data->size(); pos += HTTP_BUFFER_SIZE)
+    {
+        size_t n = data->size() - pos < HTTP_BUFFER_SIZE ? data->size() - pos : HTTP_BUFFER_SIZE;
+        chunkCallback(data->data() + pos, n);
+    }
+    return true;
+}
+
+/// @copydoc CachingStorageManager::getFileSize
+size_t CachingStorageManager::getFileSize(const std::string &path)
+{
+    std::string p = normalize(path);
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    size_t size;
+    auto it = entries_.find(p);
+    if (it != entries_.end() && it->second.complete)
+    {
+        size = it->second.data->size();
+    }
+    else
+    {
+        size = backing_->getFileSize(p) + (it != entries_.end() ? it->second.data->size() : 0);
+    }
+    xSemaphoreGive(lock_);
+    return size;
+}
+
+/// @copydoc CachingStorageManager::listDirectory
+bool CachingStorageManager::listDirectory(const std::string &path, std::vector<FileInfo> &out)
+{
+    std::string p = normalize(path);
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    writeBackUnder(p);
+    bool ok = backing_->listDirectory(p, out);
+    xSemaphoreGive(lock_);
+    return ok;
+}
+
+/// @copydoc CachingStorageManager::forEachDirectoryEntry
+bool CachingStorageManager::forEachDirectoryEntry(const std::string &path, uint32_t cursor, size_t limit,
+                                                  const std::function<bool(const FileInfo &)> &visitor,
+                                                  uint32_t *next)
+{
+    std::string p = normalize(path);
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    writeBackUnder(p);
+    xSemaphoreGive(lock_);
+    return backing_->forEachDirectoryEntry(p, cursor, limit, visitor, next);
+}
+
+/// @copydoc CachingStorageManager::createDirectory
+bool CachingStorageManager::createDirectory(const std::string &path)
+{
+    return backing_->createDirectory(normalize(path));
+}
+
+/// @copydoc CachingStorageManager::removeDirectory
+bool CachingStorageManager::removeDirectory(const std::string &path)
+{
+    std::string p = normalize(path);
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    bool ok = settle(p, true) && backing_->removeDirectory(p);
+    xSemaphoreGive(lock_);
+    return ok;
+}
+
+/// @copydoc CachingStorageManager::formatStorage
+bool CachingStorageManager::formatStorage()
+{
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    entries_.clear();
+    used_ = 0;
+    bool ok = backing_->formatStorage();
+    xSemaphoreGive(lock_);
+    return ok;
+}
+
+/// @copydoc CachingStorageManager::openReader
+std::unique_ptr<StorageFileReader> CachingStorageManager::openReader(const std::string &path)
+{
+    std::string p = normalize(path);
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    Entry *entry = readable(p);
+    std::shared_ptr<const std::vector<uint8_t>> data = entry ? entry->data : nullptr;
+    xSemaphoreGive(lock_);
+
+    if (!data)
+    {
+        return backing_->openReader(p);
+    }
+    return std::make_unique<RamFileReader>(std::move(data));
+}
+
+/// @copydoc CachingStorageManager::openWriter
+std::unique_ptr<StorageFileWriter> CachingStorageManager::openWriter(const std::string &path, bool append)
+{
+    std::string p = normalize(path);
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    bool cached = policyFor(p) == Policy::Cache;
+    bool parent = true;
+    if (!cached)
+    {
+        settle(p, false); // the backing writer would leave a cached copy stale
+    }
+    else
+    {
+        parent = entries_.count(p) != 0 || parentExists(p);
+    }
+    xSemaphoreGive(lock_);
+
+    if (!cached)
+    {
+        return backing_->openWriter(p, append);
+    }
+    if (!parent)
+    {
+        printf("[StorageCache] openWriter: no directory for '%s'\n", p.c_str());
+        return nullptr;
+    }
+    if (!append && !writeFile(p, nullptr, 0))
+    {
+        printf("[StorageCache] openWriter: open failed for '%s'\n", p.c_str());
+        return nullptr;
+    }
+    return std::make_unique<CachingFileWriter>(this, p);
+}
+
+/// @copydoc CachingStorageManager::flushTask
+void CachingStorageManager::flushTask(void *param)
+{
+    CachingStorageManager *self = static_cast<CachingStorageManager *>(param);
+    for (;;)
+    {
+        vTaskDelay(pdMS_TO_TICKS(STORAGE_CACHE_FLUSH_INTERVAL_MS));
+        self->flush();
+    }
+}
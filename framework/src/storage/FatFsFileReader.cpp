@@ -9,6 +9,8 @@ FatFsFileReader::~FatFsFileReader() {
 }
 
 bool FatFsFileReader::open(const std::string& path) {
+    close();
+    resetBuffer();
     file = ff_fopen(path.c_str(), "r");
     isOpen = (file != nullptr);
     return isOpen;
@@ -24,26 +26,19 @@ void FatFsFileReader::close() {
 }
 
 
-bool FatFsFileReader::readLine(char* outLine, size_t maxLen) {
-    if (!isOpen || !file || maxLen == 0) return false;
-
-
-    size_t count = 0;
-    int ch;
-
-    while (count < maxLen - 1) {
-        ch = ff_fgetc(file);
-        if (ch == EOF) break;
-        if (ch == '\n') break;
-        if (ch != '\r') {
-            outLine[count++] = static_cast<char>(ch);
-        }
-    }
+int FatFsFileReader::readRaw(void* dst, size_t len) {
+    if (!isOpen || !file) return -1;
+    return static_cast<int>(ff_fread(dst, 1, len, file));
+}
 
-    if (count == 0 && ch == EOF) return false;
 
-    outLine[count] = '\0';
-    return true;
+bool FatFsFileReader::seekRaw(size_t offset) {
+    if (!isOpen || !file) return false;
+    return ff_fseek(file, static_cast<long>(offset), SEEK_SET) == 0;
 }
 
 
+size_t FatFsFileReader::size() {
+    if (!isOpen || !file) return 0;
+    return ff_filelength(file);
+}
@@ -0,0 +1,63 @@
+#include "storage/FatFsFileWriter.h"
+#include "framework_config.h"
+#include <algorithm>
+#include <ff_stdio.h>
+
+FatFsFileWriter::FatFsFileWriter() = default;
+
+FatFsFileWriter::~FatFsFileWriter() {
+    close();
+}
+
+bool FatFsFileWriter::open(const std::string& path, bool append) {
+    close();
+    file = ff_fopen(path.c_str(), append ? "a" : "w");
+    position = file ? ff_filelength(file) : 0;
+    buffer.clear();
+    buffer.reserve(FATFS_IO_BUFFER_SIZE);
+    return file != nullptr;
+}
+
+
+bool FatFsFileWriter::write(const void* data, size_t len) {
+    if (!file) return false;
+    const uint8_t* src = static_cast<const uint8_t*>(data);
+    while (len > 0) {
+        // Bytes from the end of the buffer to the next block boundary of the file
+        size_t limit = FATFS_IO_BUFFER_SIZE - position % FATFS_IO_BUFFER_SIZE;
+        if (buffer.empty() && len >= limit) {
+            // Whole blocks go straight from the caller's data
+            size_t n = limit + (len - limit) / FATFS_IO_BUFFER_SIZE * FATFS_IO_BUFFER_SIZE;
+            if (ff_fwrite(src, 1, n, file) != n) return false;
+            position += n;
+            src += n;
+            len -= n;
+            continue;
+        }
+        size_t n = std::min(len, limit - buffer.size());
+        buffer.insert(buffer.end(), src, src + n);
+        src += n;
+        len -= n;
+        if (buffer.size() == limit && !flushBuffer()) return false;
+    }
+    return true;
+}
+
+
+bool FatFsFileWriter::flushBuffer() {
+    if (buffer.empty()) return true;
+    size_t n = ff_fwrite(buffer.data(), 1, buffer.size(), file);
+    bool ok = n == buffer.size();
+    position += buffer.size();
+    buffer.clear();
+    return ok;
+}
+
+
+bool FatFsFileWriter::close() {
+    if (!file) return true;
+    bool ok = flushBuffer();
+    ok = ff_fclose(file) == 0 && ok;
+    file = nullptr;
+    return ok;
+}
@@ -21,10 +21,43 @@ TRACE_INIT(FatFsStorageManager)
 #include "storage/FatFsStorageManager.h"
 #include "storage/FatFsFileReader.h"
 #include <ff_utils.h>
+#include "task.h"
 #include <ff_stdio.h>
 
 /// @copydoc FatFsStorageManager::FatFsStorageManager()
-FatFsStorageManager::FatFsStorageManager() {}
+FatFsStorageManager::FatFsStorageManager()
+{
+    mutex = xSemaphoreCreateMutex();
+    if (FATFS_APPEND_HOLD_MS > 0)
+    {
+        appendTimer = xTimerCreate("fatfsAppend", pdMS_TO_TICKS(FATFS_APPEND_HOLD_MS), pdFALSE,
+                                   this, appendHoldExpired);
+    }
+}
+
+/// @copydoc FatFsStorageManager::appendHoldExpired
+void FatFsStorageManager::appendHoldExpired(TimerHandle_t timer)
+{
+    auto *self = static_cast<FatFsStorageManager *>(pvTimerGetTimerID(timer));
+    xTaskNotifyGive(self->appendCloser);
+}
+
+/// @copydoc FatFsStorageManager::appendCloserTask
+void FatFsStorageManager::appendCloserTask(void *param)
+{
+    auto *self = static_cast<FatFsStorageManager *>(param);
+    for (;;)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        xSemaphoreTake(self->mutex, portMAX_DELAY);
+        // The file may have been closed, or closed and reopened, since the timer fired
+        if (self->appendFile && xTaskGetTickCount() - self->appendOpened >= pdMS_TO_TICKS(FATFS_APPEND_HOLD_MS))
+        {
+            self->closeAppendFile();
+        }
+        xSemaphoreGive(self->mutex);
+    }
+}
 
 /// @copydoc FatFsStorageManager::mount()
 bool FatFsStorageManager::mount()
@@ -56,6 +89,7 @@ bool FatFsStorageManager::mount()
 /// @copydoc FatFsStorageManager::unmount()
 bool FatFsStorageManager::unmount()
 {
+    releaseAppendFile("/");
     ::unmount(mountPoint.c_str());
     mounted = false;
     return true;
@@ -71,6 +105,7 @@ bool FatFsStorageManager::exists(const std::string &path)
         return false;
     }
     TRACE("[FatFs] Checking if exists: %s\n", resolvePath(path).c_str());
+    releaseAppendFile(resolvePath(path));
     FF_Stat_t xStat;
 
     // Use ff_stat to check if the file or directory exists
@@ -87,6 +122,18 @@ bool FatFsStorageManager::exists(const std::string &path)
 
 /// @copydoc FatFsStorageManager::listDirectory()
 bool FatFsStorageManager::listDirectory(const std::string &path, std::vector<FileInfo> &out)
+{
+    return forEachDirectoryEntry(path, 0, 0, [&out](const FileInfo &entry)
+    {
+        out.push_back(entry);
+        return true;
+    });
+}
+
+/// @copydoc FatFsStorageManager::forEachDirectoryEntry()
+bool FatFsStorageManager::forEachDirectoryEntry(const std::string &path, uint32_t cursor, size_t limit,
+                                                const std::function<bool(const FileInfo &)> &visitor,
+                                                uint32_t *next)
 {
     if (!ensureMounted()) {
         TRACE("SD card not mounted — cannot list directory: %s\n", path.c_str());
@@ -95,6 +142,7 @@ bool FatFsStorageManager::listDirectory(const std::string &path, std::vector<Fil
     TRACE("[FatFs] Listing directory: %s\n", path.c_str());
     FF_FindData_t xFindStruct{};
     std::string searchPath = resolvePath(path.empty() ? "/" : path);
+    releaseAppendFile(searchPath); // so sizes are current
     TRACE("[FatFs] Search path: %s\n", searchPath.c_str());
     int result = ff_findfirst(searchPath.c_str(), &xFindStruct);
 
@@ -103,17 +151,26 @@ bool FatFsStorageManager::listDirectory(const std::string &path, std::vector<Fil
         return false;
     }
 
+    // ff_findnext() can't seek, so the cursor is an entry count
+    FileInfo info;
+    size_t index = 0;
+    size_t visited = 0;
     do {
-        if (xFindStruct.pcFileName && strlen(xFindStruct.pcFileName) > 0) {
-            FileInfo info;
+        if (xFindStruct.pcFileName && strlen(xFindStruct.pcFileName) > 0 && index++ >= cursor) {
             info.name = xFindStruct.pcFileName;
             info.isDirectory = xFindStruct.ucAttributes & FF_FAT_ATTR_DIR;
             info.isReadOnly = xFindStruct.ucAttributes & FF_FAT_ATTR_READONLY;
             info.size = static_cast<size_t>(xFindStruct.ulFileSize);
-            out.push_back(info);
+            visited++;
+            if (!visitor(info)) {
+                index--; // not consumed
+                break;
+            }
         }
-    } while (ff_findnext(&xFindStruct) == FF_ERR_NONE);
+    } while ((limit == 0 || visited < limit) && ff_findnext(&xFindStruct) == FF_ERR_NONE);
 
+    if (next)
+        *next = static_cast<uint32_t>(index > cursor ? index : cursor);
     return true;
 }
 
@@ -135,6 +192,7 @@ bool FatFsStorageManager::removeDirectory(const std::string &path)
         TRACE("SD card not mounted — cannot remove directory: %s\n", path.c_str());
         return false;
     }
+    releaseAppendFile(resolvePath(path));
     return ff_rmdir(resolvePath(path).c_str()) == FF_ERR_NONE;
 }   
 
@@ -146,6 +204,7 @@ bool FatFsStorageManager::readFile(const std::string &path, std::vector<uint8_t>
         TRACE("SD card not mounted — cannot read file: %s\n", path.c_str());
         return false;
     }
+    releaseAppendFile(resolvePath(path));
     FF_FILE *file = ff_fopen(resolvePath(path).c_str(), "r");
     if (!file)
         return false;
@@ -174,13 +233,7 @@ bool FatFsStorageManager::writeFile(const std::string &path, const std::vector<u
         TRACE("SD card not mounted — cannot write to file: %s\n", path.c_str());
         return false;
     }
-    FF_FILE *file = ff_fopen(resolvePath(path).c_str(), "w");
-    if (!file)
-        return false;
-
-    ff_fwrite(data.data(), 1, data.size(), file);
-    ff_fclose(file);
-    return true;
+    return writeFile(path, data.data(), data.size());
 }
 
 bool FatFsStorageManager::writeFile(const std::string& path, const unsigned char* data, size_t size)
@@ -191,10 +244,13 @@ bool FatFsStorageManager::writeFile(const std::string& path, const unsigned char
         return false;
     }
 
+    releaseAppendFile(resolvePath(path));
     FF_FILE* file = ff_fopen(resolvePath(path).c_str(), "w");
     if (!file)
         return false;
 
+    // One write for the whole size: FreeRTOS+FAT extends the cluster chain once for all of it
+    // and moves the whole clusters as multi-sector transfers
     size_t written = ff_fwrite(data, 1, size, file);
     ff_fclose(file);
 
@@ -209,6 +265,7 @@ bool FatFsStorageManager::remove(const std::string &path)
         TRACE("SD card not mounted — cannot remove file: %s\n", path.c_str());
         return false;
     }
+    releaseAppendFile(resolvePath(path));
     return ff_remove(resolvePath(path).c_str()) == FF_ERR_NONE;
 }
 
@@ -220,6 +277,8 @@ bool FatFsStorageManager::rename(const std::string &from, const std::string &to)
         TRACE("SD card not mounted — cannot rename file %s to file: %s\n", from.c_str(), to.c_str());
         return false;
     }
+    releaseAppendFile(resolvePath(from));
+    releaseAppendFile(resolvePath(to));
     return ff_rename(resolvePath(from).c_str(), resolvePath(to).c_str(), false) == 0;
 }
 
@@ -231,15 +290,23 @@ bool FatFsStorageManager::streamFile(const std::string &path, std::function<void
         TRACE("SD card not mounted — cannot stream file: %s\n", path.c_str());
         return false;
     }
-    FF_FILE *file = ff_fopen(resolvePath(path).c_str(), "r");
+    std::string resolved = resolvePath(path);
+    releaseAppendFile(resolved);
+    FF_FILE *file = ff_fopen(resolved.c_str(), "r");
     if (!file)
         return false;
 
-    uint8_t buffer[HTTP_BUFFER_SIZE];
+    // Reading whole sector-aligned blocks lets FreeRTOS+FAT read clusters straight into the
+    // buffer as multi-sector transfers; HTTP_BUFFER_SIZE reads straddle sectors and go one
+    // sector at a time through its cache
+    std::vector<uint8_t> buffer(FATFS_IO_BUFFER_SIZE);
     size_t bytes;
-    while ((bytes = ff_fread(buffer, 1, sizeof(buffer), file)) > 0)
+    while ((bytes = ff_fread(buffer.data(), 1, buffer.size(), file)) > 0)
     {
-        chunkCallback(buffer, bytes);
+        for (size_t pos = 0; pos < bytes; pos += HTTP_BUFFER_SIZE)
+        {
+            chunkCallback(buffer.data() + pos, std::min<size_t>(HTTP_BUFFER_SIZE, bytes - pos));
+        }
     }
 
     ff_fclose(file);
@@ -254,6 +321,7 @@ size_t FatFsStorageManager::getFileSize(const std::string &path)
         TRACE("SD card not mounted — cannot get file size: %s\n", path.c_str());
         return false;
     }
+    releaseAppendFile(resolvePath(path));
     FF_FILE *file = ff_fopen(resolvePath(path).c_str(), "r");
     if (!file)
         return 0;
@@ -273,13 +341,70 @@ bool FatFsStorageManager::appendToFile(const std::string &path, const uint8_t *d
         TRACE("SD card not mounted — cannot append to file: %s\n", path.c_str());
         return false;
     }
-    FF_FILE *file = ff_fopen(resolvePath(path).c_str(), "a");
-    if (!file)
-        return false;
+    std::string resolved = resolvePath(path);
+    xSemaphoreTake(mutex, portMAX_DELAY);
 
-    size_t written = ff_fwrite(data, 1, size, file);
-    ff_fclose(file);
-    return written == size;
+    TickType_t now = xTaskGetTickCount();
+    if (appendFile && (appendPath != resolved || now - appendOpened >= pdMS_TO_TICKS(FATFS_APPEND_HOLD_MS)))
+    {
+        closeAppendFile(); // another file, or held long enough: commit the directory entry
+    }
+    if (!appendFile && appendTimer && !appendCloser &&
+        xTaskCreate(appendCloserTask, "FatFsAppend", FATFS_APPEND_CLOSER_STACK_SIZE, this,
+                    FATFS_APPEND_CLOSER_PRIORITY, &appendCloser) != pdPASS)
+    {
+        appendCloser = nullptr; // nothing to close the file later, so don't hold it
+    }
+    if (!appendFile)
+    {
+        appendFile = ff_fopen(resolved.c_str(), "a");
+        appendPath = resolved;
+        appendOpened = now;
+        if (appendFile && appendCloser)
+        {
+            xTimerChangePeriod(appendTimer, pdMS_TO_TICKS(FATFS_APPEND_HOLD_MS), 0); // also starts it
+        }
+    }
+
+    bool ok = false;
+    if (appendFile)
+    {
+        ok = ff_fwrite(data, 1, size, appendFile) == size;
+        if (!ok || !appendCloser)
+        {
+            closeAppendFile();
+        }
+    }
+    xSemaphoreGive(mutex);
+    return ok;
+}
+
+/// @copydoc FatFsStorageManager::releaseAppendFile
+void FatFsStorageManager::releaseAppendFile(const std::string &resolved)
+{
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    // FreeRTOS+FAT refuses to open a file that is open for writing
+    if (appendFile && appendPath.compare(0, resolved.size(), resolved) == 0 &&
+        (appendPath.size() == resolved.size() || resolved.back() == '/' || appendPath[resolved.size()] == '/'))
+    {
+        closeAppendFile();
+    }
+    xSemaphoreGive(mutex);
+}
+
+/// @copydoc FatFsStorageManager::closeAppendFile
+void FatFsStorageManager::closeAppendFile()
+{
+    if (appendFile)
+    {
+        ff_fclose(appendFile);
+        appendFile = nullptr;
+    }
+    appendPath.clear();
+    if (appendTimer && xTimerIsTimerActive(appendTimer))
+    {
+        xTimerStop(appendTimer, 0);
+    }
 }
 
 /// @brief Helper function to normalize full path based on mountPoint and relative path
@@ -354,6 +479,7 @@ bool FatFsStorageManager::formatStorage()
         return false;
     }
 
+    releaseAppendFile("/");
     if (!format(mountPoint.c_str())) {
         printf("[FatFs] Format failed for device: %s\n", mountPoint.c_str());
         return false;
@@ -376,6 +502,7 @@ bool FatFsStorageManager::readFileString(const std::string &path, uint32_t start
         return false;
     }
 
+    releaseAppendFile(resolvePath(path));
     FF_FILE *file = ff_fopen(resolvePath(path).c_str(), "r");
     if (!file)
     {
@@ -414,9 +541,20 @@ bool FatFsStorageManager::readFileString(const std::string &path, uint32_t start
 std::unique_ptr<StorageFileReader> FatFsStorageManager::openReader(const std::string& path) {
     if (!ensureMounted()) return nullptr;
 
+    releaseAppendFile(resolvePath(path));
     auto reader = std::make_unique<FatFsFileReader>();
     if (!reader->open(resolvePath(path))) return nullptr;
     return reader;
 }
 
+#include "storage/FatFsFileWriter.h"
+
+std::unique_ptr<StorageFileWriter> FatFsStorageManager::openWriter(const std::string& path, bool append) {
+    if (!ensureMounted()) return nullptr;
+
+    releaseAppendFile(resolvePath(path));
+    auto writer = std::make_unique<FatFsFileWriter>();
+    if (!writer->open(resolvePath(path), append)) return nullptr;
+    return writer;
+}
 
@@ -0,0 +1,188 @@
+/**
+ * @file FlashOpService.cpp
+ * @author Ian Archbell
+ * @brief Implementation of the pinned flash operation service.
+ *
+ * Part of the PicoFramework application framework.
+ * lock_ is held from the moment an operation is queued until its notification arrives, so
+ * the service task owns batch_ while it programs it and there is never more than one
+ * operation in flight.
+ *
+ * @version 0.1
+ * @date 2025-04-22
+ * @license MIT License
+ * @copyright Copyright (c) 2025, Ian Archbell
+ */
+
+#include "storage/FlashOpService.h"
+#include <cstdio>
+#include <cstring>
+#include <hardware/flash.h> // for flash_range_program, flash_range_erase
+#include <pico/flash.h>     // for flash_safe_execute
+#include <hardware/regs/addressmap.h> // for XIP_BASE
+
+namespace
+{
+    struct FlashParams
+    {
+        uint32_t offset;
+        const uint8_t *data;
+        size_t size;
+    };
+
+    // Run from RAM while XIP is unavailable
+    void __not_in_flash_func(programCallback)(void *p)
+    {
+        auto *params = static_cast<FlashParams *>(p);
+        flash_range_program(params->offset, params->data, params->size);
+    }
+
+    void __not_in_flash_func(eraseCallback)(void *p)
+    {
+        auto *params = static_cast<FlashParams *>(p);
+        flash_range_erase(params->offset, params->size);
+    }
+}
+
+/// @copydoc FlashOpService::instance
+FlashOpService &FlashOpService::instance()
+{
+    static FlashOpService inst;
+    return inst;
+}
+
+/// @copydoc FlashOpService::FlashOpService
+FlashOpService::FlashOpService()
+{
+    lock_ = xSemaphoreCreateMutexStatic(&lockBuffer_);
+    ops_ = xQueueCreateStatic(FLASH_OP_QUEUE_LENGTH, sizeof(Op), opsStorage_, &opsBuffer_);
+#if (configUSE_CORE_AFFINITY == 1) && (configNUMBER_OF_CORES > 1)
+    task_ = xTaskCreateStaticAffinitySet(serviceTask, "FlashOp", FLASH_OP_STACK_SIZE, this,
+                                         FLASH_OP_PRIORITY, stack_, &taskBuffer_, (1 << FLASH_OP_CORE));
+#else
+    task_ = xTaskCreateStatic(serviceTask, "FlashOp", FLASH_OP_STACK_SIZE, this,
+                              FLASH_OP_PRIORITY, stack_, &taskBuffer_);
+#endif
+    configASSERT(task_);
+}
+
+/// @copydoc FlashOpService::program
+int FlashOpService::program(uint32_t offset, const void *data, size_t size)
+{
+    xSemaphoreTake(lock_, portMAX_DELAY);
+
+    int result = 0;
+    if (batchLen_ > 0 && (offset != batchOffset_ + batchLen_ || batchLen_ + size > sizeof(batch_)))
+    {
+        result = flushLocked();
+    }
+
+    if (result == 0)
+    {
+        if (size > sizeof(batch_))
+        {
+            // Too big to stage; LittleFS's buffer stays valid until we return
+            result = submit(OpType::Program, offset, static_cast<const uint8_t *>(data), size);
+        }
+        else
+        {
+            if (batchLen_ == 0)
+            {
+                batchOffset_ = offset;
+            }
+            memcpy(batch_ + batchLen_, data, size);
+            batchLen_ += size;
+            if (batchLen_ == sizeof(batch_))
+            {
+                result = flushLocked();
+            }
+        }
+    }
+
+    xSemaphoreGive(lock_);
+    return result;
+}
+
+/// @copydoc FlashOpService::erase
+int FlashOpService::erase(uint32_t offset, size_t size)
+{
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    int result = flushLocked();
+    if (result == 0)
+    {
+        result = submit(OpType::Erase, offset, nullptr, size);
+    }
+    xSemaphoreGive(lock_);
+    return result;
+}
+
+/// @copydoc FlashOpService::flush
+int FlashOpService::flush()
+{
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    int result = flushLocked();
+    xSemaphoreGive(lock_);
+    return result;
+}
+
+/// @copydoc FlashOpService::read
+void FlashOpService::read(uint32_t offset, void *dst, size_t size)
+{
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    memcpy(dst, reinterpret_cast<const void *>(XIP_BASE + offset), size);
+    uint32_t from = offset > batchOffset_ ? offset : batchOffset_;
+    uint32_t to = offset + size < batchOffset_ + batchLen_ ? offset + size : batchOffset_ + batchLen_;
+    if (batchLen_ > 0 && from < to)
+    {
+        memcpy(static_cast<uint8_t *>(dst) + (from - offset), batch_ + (from - batchOffset_), to - from);
+    }
+    xSemaphoreGive(lock_);
+}
+
+/// @copydoc FlashOpService::flushLocked
+int FlashOpService::flushLocked()
+{
+    if (batchLen_ == 0)
+    {
+        return 0;
+    }
+    int result = submit(OpType::Program, batchOffset_, batch_, batchLen_);
+    batchLen_ = 0;
+    return result;
+}
+
+/// @copydoc FlashOpService::submit
+int FlashOpService::submit(OpType type, uint32_t offset, const uint8_t *data, size_t size)
+{
+    int result = -1;
+    Op op{type, offset, data, size, xTaskGetCurrentTaskHandle(), &result};
+    xQueueSend(ops_, &op, portMAX_DELAY);
+    ulTaskNotifyTakeIndexed(FLASH_OP_NOTIFY_INDEX, pdTRUE, portMAX_DELAY);
+    return result;
+}
+
+/// @copydoc FlashOpService::serviceTask
+void FlashOpService::serviceTask(void *param)
+{
+    auto *self = static_cast<FlashOpService *>(param);
+    Op op;
+    for (;;)
+    {
+        if (xQueueReceive(self->ops_, &op, portMAX_DELAY) != pdTRUE)
+        {
+            continue;
+        }
+
+        FlashParams params{op.offset, op.data, op.size};
+        int rc = flash_safe_execute(op.type == OpType::Program ? programCallback : eraseCallback,
+                                    &params, FLASH_OP_TIMEOUT_MS);
+        if (rc != PICO_OK)
+        {
+            printf("[FlashOpService] %s of %zu bytes at 0x%08lx failed (%d)\n",
+                   op.type == OpType::Program ? "Program" : "Erase", op.size,
+                   static_cast<unsigned long>(op.offset), rc);
+        }
+        *op.result = (rc == PICO_OK) ? 0 : -1;
+        xTaskNotifyGiveIndexed(op.waiter, FLASH_OP_NOTIFY_INDEX);
+    }
+}
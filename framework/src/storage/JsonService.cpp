@@ -20,8 +20,15 @@ TRACE_INIT(JsonService)
 #include "storage/JsonService.h"
 #include <cstdio>
 #include <cstdint>
+#include <cstring>
 #include <vector>
 
+static bool endsWith(const std::string &str, const char *suffix)
+{
+    size_t len = strlen(suffix);
+    return str.size() >= len && str.compare(str.size() - len, len, suffix) == 0;
+}
+
 /// @copydoc mergeDefaults
 nlohmann::json mergeDefaults(const nlohmann::json &target, const nlohmann::json &defaults)
 {
@@ -48,39 +55,124 @@ nlohmann::json mergeDefaults(const nlohmann::json &target, const nlohmann::json
 JsonService::JsonService(StorageManager *storage)
     : storage(storage) {}
 
-/// @copydoc JsonService::load
-bool JsonService::load(const std::string &path)
+/// @copydoc JsonService::setFormat
+void JsonService::setFormat(const std::string &path, Format format)
 {
-    std::vector<uint8_t> buffer;
-    if (!storage)
-    return false;
+    formats[path] = format;
+}
 
-    if(!storage->isMounted())
+/// @copydoc JsonService::getFormat
+JsonService::Format JsonService::getFormat(const std::string &path) const
+{
+    auto it = formats.find(path);
+    if (it != formats.end())
+        return it->second;
+
+    if (endsWith(path, ".cbor"))
+        return Format::Cbor;
+    if (endsWith(path, ".msgpack"))
+        return Format::MessagePack;
+    return Format::Text;
+}
+
+/// @copydoc JsonService::storagePath
+std::string JsonService::storagePath(const std::string &path, Format format)
+{
+    const char *ext = ".json";
+    switch (format)
     {
-       storage->mount();
+    case Format::Cbor:
+        ext = ".cbor";
+        break;
+    case Format::MessagePack:
+        ext = ".msgpack";
+        break;
+    default:
+        break;
     }
-    
+
+    if (endsWith(path, ext))
+        return path;
+
+    size_t slash = path.find_last_of('/');
+    size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+        return path + ext;
+    return path.substr(0, dot) + ext;
+}
+
+/// @copydoc JsonService::readDocument
+bool JsonService::readDocument(const std::string &path, Format format)
+{
+    std::vector<uint8_t> buffer;
     if (!storage->readFile(path, buffer))
     {
         TRACE("Failed to read JSON file: %s\n", path.c_str());
         return false;
     }
-
-    std::string str(buffer.begin(), buffer.end());
-    TRACE("Loaded JSON file from %s: %zu bytes\n", path.c_str(), str.size());
-    TRACE("Content: %s\n", str.c_str());
+    TRACE("Loaded JSON file from %s: %zu bytes\n", path.c_str(), buffer.size());
 
     // Treat empty file as valid empty object
-    if (str.empty())
+    if (buffer.empty())
     {
-        data_ = nlohmann::json::object();
+        data_ = FrameworkJson::object();
         return true;
     }
 
-    data_ = nlohmann::json::parse(str, nullptr, false); // No exceptions
+    // All parsers run without exceptions and return a discarded value on error
+    switch (format)
+    {
+    case Format::Cbor:
+        data_ = FrameworkJson::from_cbor(buffer, true, false);
+        break;
+    case Format::MessagePack:
+        data_ = FrameworkJson::from_msgpack(buffer, true, false);
+        break;
+    default:
+        data_ = FrameworkJson::parse(buffer.begin(), buffer.end(), nullptr, false);
+        break;
+    }
     return !data_.is_discarded();
 }
 
+/// @copydoc JsonService::migrate
+bool JsonService::migrate(const std::string &textPath, Format format)
+{
+    if (!readDocument(textPath, Format::Text))
+        return false;
+
+    TRACE("Migrating %s to %s\n", textPath.c_str(), storagePath(textPath, format).c_str());
+    if (!save(textPath))
+        return false;
+
+    // Only drop the original once the binary copy is safely written
+    storage->remove(textPath);
+    return true;
+}
+
+/// @copydoc JsonService::load
+bool JsonService::load(const std::string &path)
+{
+    if (!storage)
+    return false;
+
+    if(!storage->isMounted())
+    {
+       storage->mount();
+    }
+
+    Format format = getFormat(path);
+    std::string target = storagePath(path, format);
+
+    if (format != Format::Text && target != path &&
+        !storage->exists(target) && storage->exists(path))
+    {
+        return migrate(path, format);
+    }
+
+    return readDocument(target, format);
+}
+
 /// @copydoc JsonService::save
 bool JsonService::save(const std::string &path) const
 {
@@ -90,48 +182,65 @@ bool JsonService::save(const std::string &path) const
     {
         storage->mount();
     }
-    std::string content = data_.dump(2); // Pretty print
-    std::vector<uint8_t> buffer(content.begin(), content.end());
+
+    Format format = getFormat(path);
+    std::string target = storagePath(path, format);
+
+    std::vector<uint8_t> buffer;
+    switch (format)
+    {
+    case Format::Cbor:
+        buffer = FrameworkJson::to_cbor(data_);
+        break;
+    case Format::MessagePack:
+        buffer = FrameworkJson::to_msgpack(data_);
+        break;
+    default:
+    {
+        std::string content = data_.dump(JSON_SERVICE_INDENT);
+        buffer.assign(content.begin(), content.end());
+        break;
+    }
+    }
     TRACE("Buffer size: %zu bytes\n", buffer.size());
-    TRACE("Buffer content: %s\n", content.c_str());
 
-    bool ok = storage->writeFile(path, buffer);
-    TRACE("Saved JSON file to %s: %s\n", path.c_str(), ok ? "ok" : "failed");
+    bool ok = storage->writeFile(target, buffer);
+    TRACE("Saved JSON file to %s: %s\n", target.c_str(), ok ? "ok" : "failed");
     return ok;
 }
 
 /// @copydoc JsonService::data
-nlohmann::json &JsonService::data()
+FrameworkJson &JsonService::data()
 {
     return data_;
 }
 
 /// @copydoc JsonService::data const
-const nlohmann::json &JsonService::data() const
+const FrameworkJson &JsonService::data() const
 {
     return data_;
 }
 
 /// @copydoc JsonService::root
-nlohmann::json &JsonService::root()
+FrameworkJson &JsonService::root()
 {
     return data_;
 }
 
 /// @copydoc JsonService::root const
-const nlohmann::json &JsonService::root() const
+const FrameworkJson &JsonService::root() const
 {
     return data_;
 }
 
 /// @copydoc JsonService::operator*
-nlohmann::json &JsonService::operator*()
+FrameworkJson &JsonService::operator*()
 {
     return data_;
 }
 
 /// @copydoc JsonService::operator* const
-const nlohmann::json &JsonService::operator*() const
+const FrameworkJson &JsonService::operator*() const
 {
     return data_;
 }
@@ -0,0 +1,681 @@
+/**
+ * @file KvLog.cpp
+ * @author Ian Archbell
+ * @brief Implementation of the log-structured key-value store.
+ *
+ * Part of the PicoFramework application framework.
+ * Records are 4-byte aligned and never cross a sector. They are programmed through a
+ * one-page staging buffer, so a record that fits in the current page costs one program.
+ *
+ * @version 0.1
+ * @date 2025-04-22
+ * @license MIT License
+ * @copyright Copyright (c) 2025, Ian Archbell
+ */
+
+#include "storage/KvLog.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+    constexpr size_t ChunkSize = 64; ///< Stack buffer for reading values back
+
+    /// Collects sequential bytes into 0xFF-padded pages and programs each page once
+    class PageWriter
+    {
+    public:
+        PageWriter(KvFlash &flash, uint32_t offset) : flash(flash), pos(offset)
+        {
+            page = offset & ~uint32_t(KvFlash::PageSize - 1);
+            memset(buf, 0xFF, sizeof(buf));
+        }
+
+        bool append(const void *data, size_t len)
+        {
+            const uint8_t *src = static_cast<const uint8_t *>(data);
+            while (len > 0)
+            {
+                size_t at = pos - page;
+                size_t n = KvFlash::PageSize - at;
+                n = n < len ? n : len;
+                memcpy(buf + at, src, n);
+                pos += n;
+                src += n;
+                len -= n;
+                if (pos - page == KvFlash::PageSize && !flush())
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool finish()
+        {
+            return pos == page || flush();
+        }
+
+    private:
+        bool flush()
+        {
+            bool ok = flash.program(page, buf, sizeof(buf));
+            page += KvFlash::PageSize;
+            memset(buf, 0xFF, sizeof(buf));
+            return ok;
+        }
+
+        KvFlash &flash;
+        uint32_t page;
+        uint32_t pos;
+        uint8_t buf[KvFlash::PageSize];
+    };
+
+    bool allErased(const void *data, size_t len)
+    {
+        const uint8_t *p = static_cast<const uint8_t *>(data);
+        for (size_t i = 0; i < len; ++i)
+        {
+            if (p[i] != 0xFF)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+/// @copydoc KvLog::KvLog
+KvLog::KvLog(KvFlash &flash) : flash(flash)
+{
+}
+
+/// @copydoc KvLog::mount
+bool KvLog::mount()
+{
+    size_t count = flash.size() / KvFlash::SectorSize;
+    if (count < 3)
+    {
+        printf("[KvLog] Flash range of %zu bytes is too small (3 sectors minimum)\n", flash.size());
+        return false;
+    }
+
+    sectors.assign(count, Sector{SectorState::Free, 0xFFFFFFFF, 0, sizeof(SectorHeader), 0});
+    index.clear();
+    active = SIZE_MAX;
+    nextSeq = 0;
+    mounted = false;
+
+    std::vector<size_t> inUse;
+    std::vector<size_t> unformatted;
+    for (size_t s = 0; s < count; ++s)
+    {
+        SectorHeader h;
+        if (!flash.read(s * KvFlash::SectorSize, &h, sizeof(h)))
+        {
+            return false;
+        }
+        if (h.magic != Magic)
+        {
+            unformatted.push_back(s);
+        }
+        else if (h.seq == 0xFFFFFFFF && h.seqCheck == 0xFFFFFFFF)
+        {
+            sectors[s].erases = h.erases;
+        }
+        else if (h.seqCheck == ~h.seq)
+        {
+            sectors[s] = Sector{SectorState::Used, h.seq, h.erases, sizeof(SectorHeader), 0};
+            inUse.push_back(s);
+            nextSeq = h.seq + 1 > nextSeq ? h.seq + 1 : nextSeq;
+        }
+        else
+        {
+            // Opening was interrupted before any record was written
+            sectors[s].erases = h.erases;
+            unformatted.push_back(s);
+        }
+    }
+
+    // Replay oldest first so newer records win
+    std::sort(inUse.begin(), inUse.end(), [this](size_t a, size_t b) { return sectors[a].seq < sectors[b].seq; });
+    for (size_t s : inUse)
+    {
+        if (!replay(s))
+        {
+            return false;
+        }
+    }
+    if (!inUse.empty() && sectors[inUse.back()].writePos < KvFlash::SectorSize)
+    {
+        active = inUse.back();
+        sectors[active].state = SectorState::Active;
+    }
+
+    for (size_t s : unformatted)
+    {
+        uint8_t chunk[ChunkSize];
+        bool erased = true;
+        for (uint32_t off = 0; erased && off < KvFlash::SectorSize; off += sizeof(chunk))
+        {
+            if (!flash.read(s * KvFlash::SectorSize + off, chunk, sizeof(chunk)))
+            {
+                return false;
+            }
+            erased = allErased(chunk, sizeof(chunk));
+        }
+
+        if (erased)
+        {
+            // Blank flash only needs its header
+            SectorHeader h{Magic, 0, 0xFFFFFFFF, 0xFFFFFFFF};
+            PageWriter pw(flash, s * KvFlash::SectorSize);
+            if (!pw.append(&h, sizeof(h)) || !pw.finish())
+            {
+                return false;
+            }
+        }
+        else if (!eraseSector(s))
+        {
+            return false;
+        }
+    }
+
+    if (active == SIZE_MAX && !openSector())
+    {
+        return false;
+    }
+    mounted = true;
+    return true;
+}
+
+/// @copydoc KvLog::format
+bool KvLog::format()
+{
+    if (!mounted && !mount())
+    {
+        // Unreadable headers: start the erase counts again
+        sectors.assign(flash.size() / KvFlash::SectorSize, Sector{SectorState::Free, 0xFFFFFFFF, 0, sizeof(SectorHeader), 0});
+        if (sectors.size() < 3)
+        {
+            return false;
+        }
+    }
+
+    mounted = false;
+    index.clear();
+    active = SIZE_MAX;
+    nextSeq = 0;
+    for (size_t s = 0; s < sectors.size(); ++s)
+    {
+        if (!eraseSector(s))
+        {
+            return false;
+        }
+    }
+    if (!openSector())
+    {
+        return false;
+    }
+    mounted = true;
+    return true;
+}
+
+/// @copydoc KvLog::get
+bool KvLog::get(const std::string &key, void *dst, size_t dstLen, size_t *valueLen)
+{
+    auto it = index.find(key);
+    if (it == index.end())
+    {
+        return false;
+    }
+    if (valueLen)
+    {
+        *valueLen = it->second.valueLen;
+    }
+    size_t n = dstLen < it->second.valueLen ? dstLen : it->second.valueLen;
+    return !dst || n == 0 || flash.read(it->second.offset + sizeof(RecordHeader) + key.size(), dst, n);
+}
+
+/// @copydoc KvLog::get
+bool KvLog::get(const std::string &key, std::vector<uint8_t> &out)
+{
+    size_t len = 0;
+    if (!get(key, nullptr, 0, &len))
+    {
+        return false;
+    }
+    out.resize(len);
+    return get(key, out.data(), len);
+}
+
+/// @copydoc KvLog::put
+bool KvLog::put(const std::string &key, const void *data, size_t len)
+{
+    if (!mounted || key.empty() || key.size() > KV_STORE_MAX_KEY_LEN || len > KV_STORE_MAX_VALUE_LEN)
+    {
+        return false;
+    }
+
+    auto it = index.find(key);
+    if (it != index.end() && it->second.valueLen == len)
+    {
+        // Settings are often saved unchanged; don't spend a program on them
+        uint32_t at = it->second.offset + sizeof(RecordHeader) + key.size();
+        const uint8_t *src = static_cast<const uint8_t *>(data);
+        uint8_t chunk[ChunkSize];
+        size_t same = 0;
+        while (same < len)
+        {
+            size_t n = len - same < sizeof(chunk) ? len - same : sizeof(chunk);
+            if (!flash.read(at + same, chunk, n) || memcmp(chunk, src + same, n) != 0)
+            {
+                break;
+            }
+            same += n;
+        }
+        if (same == len)
+        {
+            return true;
+        }
+    }
+
+    return append(TypePut, key, data, len);
+}
+
+/// @copydoc KvLog::remove
+bool KvLog::remove(const std::string &key)
+{
+    if (!mounted)
+    {
+        return false;
+    }
+    if (index.find(key) == index.end())
+    {
+        return true;
+    }
+    return append(TypeDelete, key, nullptr, 0);
+}
+
+/// @copydoc KvLog::keys
+std::vector<std::string> KvLog::keys() const
+{
+    std::vector<std::string> result;
+    result.reserve(index.size());
+    for (const auto &entry : index)
+    {
+        result.push_back(entry.first);
+    }
+    return result;
+}
+
+/// @copydoc KvLog::needsCompaction
+bool KvLog::needsCompaction() const
+{
+    if (!mounted || freeSectors() >= FreeTarget || freeSectors() == 0)
+    {
+        return false;
+    }
+    for (const auto &sector : sectors)
+    {
+        if (sector.state == SectorState::Used && sector.writePos - sizeof(SectorHeader) > sector.liveBytes)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/// @copydoc KvLog::compactStep
+bool KvLog::compactStep()
+{
+    size_t victim = oldestUsed();
+    if (victim == SIZE_MAX || freeSectors() == 0)
+    {
+        return false;
+    }
+
+    uint32_t base = victim * KvFlash::SectorSize;
+    uint32_t pos = sizeof(SectorHeader);
+    while (pos + sizeof(RecordHeader) <= sectors[victim].writePos)
+    {
+        RecordHeader h;
+        char key[KV_STORE_MAX_KEY_LEN];
+        if (!flash.read(base + pos, &h, sizeof(h)))
+        {
+            return false;
+        }
+        if (h.keyLen == 0 || h.keyLen > KV_STORE_MAX_KEY_LEN)
+        {
+            break; // End of records, or where replay found a torn one
+        }
+        size_t size = recordSize(h.keyLen, h.valueLen);
+        if (!flash.read(base + pos + sizeof(h), key, h.keyLen))
+        {
+            return false;
+        }
+
+        // Tombstones go: nothing older than this sector is left for them to hide
+        std::string name(key, h.keyLen);
+        auto it = index.find(name);
+        if (h.type == TypePut && it != index.end() && it->second.offset == base + pos)
+        {
+            if (sectors[active].writePos + size > KvFlash::SectorSize && !openSector())
+            {
+                return false;
+            }
+
+            // Records don't depend on where they are, so copy the bytes as they stand
+            uint32_t to = active * KvFlash::SectorSize + sectors[active].writePos;
+            PageWriter pw(flash, to);
+            uint8_t chunk[ChunkSize];
+            for (size_t done = 0; done < size;)
+            {
+                size_t n = size - done < sizeof(chunk) ? size - done : sizeof(chunk);
+                if (!flash.read(base + pos + done, chunk, n) || !pw.append(chunk, n))
+                {
+                    return false;
+                }
+                done += n;
+            }
+            if (!pw.finish())
+            {
+                return false;
+            }
+            sectors[active].writePos += size;
+            setLocation(name, to, h.valueLen);
+        }
+        pos += size;
+    }
+
+    return eraseSector(victim);
+}
+
+/// @copydoc KvLog::stats
+KvLog::Stats KvLog::stats() const
+{
+    Stats st{index.size(), sectors.size(), 0, 0, 0, UINT32_MAX, 0};
+    for (const auto &sector : sectors)
+    {
+        if (sector.state == SectorState::Free)
+        {
+            st.freeSectors++;
+        }
+        else
+        {
+            st.liveBytes += sector.liveBytes;
+            st.deadBytes += sector.writePos - sizeof(SectorHeader) - sector.liveBytes;
+        }
+        st.minErases = sector.erases < st.minErases ? sector.erases : st.minErases;
+        st.maxErases = sector.erases > st.maxErases ? sector.erases : st.maxErases;
+    }
+    if (sectors.empty())
+    {
+        st.minErases = 0;
+    }
+    return st;
+}
+
+/// @copydoc KvLog::crc32
+uint32_t KvLog::crc32(uint32_t crc, const void *data, size_t len)
+{
+    const uint8_t *p = static_cast<const uint8_t *>(data);
+    crc = ~crc;
+    while (len--)
+    {
+        crc ^= *p++;
+        for (int i = 0; i < 8; ++i)
+        {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+/// @copydoc KvLog::recordCrc
+uint32_t KvLog::recordCrc(const RecordHeader &header, const void *key, const void *value)
+{
+    uint32_t crc = crc32(0, &header, offsetof(RecordHeader, crc));
+    crc = crc32(crc, key, header.keyLen);
+    return crc32(crc, value, header.valueLen);
+}
+
+/// @copydoc KvLog::replay
+bool KvLog::replay(size_t s)
+{
+    uint32_t base = s * KvFlash::SectorSize;
+    uint32_t pos = sizeof(SectorHeader);
+    Sector &sector = sectors[s];
+
+    while (pos + sizeof(RecordHeader) <= KvFlash::SectorSize)
+    {
+        RecordHeader h;
+        if (!flash.read(base + pos, &h, sizeof(h)))
+        {
+            return false;
+        }
+        if (allErased(&h, sizeof(h)))
+        {
+            sector.writePos = pos;
+            return true;
+        }
+
+        size_t size = recordSize(h.keyLen, h.valueLen);
+        if (h.keyLen == 0 || h.keyLen > KV_STORE_MAX_KEY_LEN || h.valueLen > KV_STORE_MAX_VALUE_LEN ||
+            (h.type != TypePut && h.type != TypeDelete) || pos + size > KvFlash::SectorSize)
+        {
+            break;
+        }
+
+        char key[KV_STORE_MAX_KEY_LEN];
+        if (!flash.read(base + pos + sizeof(h), key, h.keyLen))
+        {
+            return false;
+        }
+        uint32_t crc = crc32(crc32(0, &h, offsetof(RecordHeader, crc)), key, h.keyLen);
+        uint8_t chunk[ChunkSize];
+        uint32_t at = base + pos + sizeof(h) + h.keyLen;
+        for (size_t done = 0; done < h.valueLen;)
+        {
+            size_t n = h.valueLen - done < sizeof(chunk) ? h.valueLen - done : sizeof(chunk);
+            if (!flash.read(at + done, chunk, n))
+            {
+                return false;
+            }
+            crc = crc32(crc, chunk, n);
+            done += n;
+        }
+        if (crc != h.crc)
+        {
+            break;
+        }
+
+        std::string name(key, h.keyLen);
+        if (h.type == TypePut)
+        {
+            setLocation(name, base + pos, h.valueLen);
+        }
+        else
+        {
+            dropLocation(name);
+        }
+        pos += size;
+    }
+
+    // Full, or a torn record: nothing more is appended here
+    if (pos + sizeof(RecordHeader) <= KvFlash::SectorSize)
+    {
+        printf("[KvLog] Invalid record at 0x%08lx, closing sector\n", static_cast<unsigned long>(base + pos));
+    }
+    sector.writePos = KvFlash::SectorSize;
+    return true;
+}
+
+/// @copydoc KvLog::append
+bool KvLog::append(uint8_t type, const std::string &key, const void *value, size_t len)
+{
+    size_t size = recordSize(key.size(), len);
+    if (size > KvFlash::SectorSize - sizeof(SectorHeader))
+    {
+        return false;
+    }
+
+    if (sectors[active].writePos + size > KvFlash::SectorSize)
+    {
+        // Normally the background compaction has kept the free target; catch up if not
+        for (size_t i = 0; i < sectors.size() && freeSectors() < FreeTarget; ++i)
+        {
+            if (!compactStep())
+            {
+                break;
+            }
+        }
+        if (sectors[active].writePos + size > KvFlash::SectorSize)
+        {
+            if (freeSectors() < FreeTarget)
+            {
+                printf("[KvLog] Store full, can't write \"%s\"\n", key.c_str());
+                return false;
+            }
+            if (!openSector())
+            {
+                return false;
+            }
+        }
+    }
+
+    uint32_t offset = 0;
+    if (!writeRecord(type, key, value, len, offset))
+    {
+        return false;
+    }
+    if (type == TypePut)
+    {
+        setLocation(key, offset, static_cast<uint16_t>(len));
+    }
+    else
+    {
+        dropLocation(key);
+    }
+    return true;
+}
+
+/// @copydoc KvLog::writeRecord
+bool KvLog::writeRecord(uint8_t type, const std::string &key, const void *value, size_t len, uint32_t &offset)
+{
+    RecordHeader h{static_cast<uint8_t>(key.size()), type, static_cast<uint16_t>(len), 0};
+    h.crc = recordCrc(h, key.data(), value);
+
+    offset = active * KvFlash::SectorSize + sectors[active].writePos;
+    PageWriter pw(flash, offset);
+    bool ok = pw.append(&h, sizeof(h)) && pw.append(key.data(), key.size()) && pw.append(value, len) && pw.finish();
+
+    // Even a failed program may have used the space
+    sectors[active].writePos += recordSize(key.size(), len);
+    return ok;
+}
+
+/// @copydoc KvLog::openSector
+bool KvLog::openSector()
+{
+    size_t best = SIZE_MAX;
+    for (size_t s = 0; s < sectors.size(); ++s)
+    {
+        if (sectors[s].state == SectorState::Free && (best == SIZE_MAX || sectors[s].erases < sectors[best].erases))
+        {
+            best = s;
+        }
+    }
+    if (best == SIZE_MAX)
+    {
+        return false;
+    }
+
+    uint32_t seq[2] = {nextSeq, ~nextSeq};
+    PageWriter pw(flash, best * KvFlash::SectorSize + offsetof(SectorHeader, seq));
+    if (!pw.append(seq, sizeof(seq)) || !pw.finish())
+    {
+        return false;
+    }
+
+    if (active != SIZE_MAX)
+    {
+        sectors[active].state = SectorState::Used;
+    }
+    sectors[best].state = SectorState::Active;
+    sectors[best].seq = nextSeq++;
+    sectors[best].writePos = sizeof(SectorHeader);
+    sectors[best].liveBytes = 0;
+    active = best;
+    return true;
+}
+
+/// @copydoc KvLog::eraseSector
+bool KvLog::eraseSector(size_t s)
+{
+    uint32_t base = s * KvFlash::SectorSize;
+    if (!flash.erase(base))
+    {
+        return false;
+    }
+    uint32_t erases = sectors[s].erases + 1;
+    sectors[s] = Sector{SectorState::Free, 0xFFFFFFFF, erases, sizeof(SectorHeader), 0};
+
+    SectorHeader h{Magic, erases, 0xFFFFFFFF, 0xFFFFFFFF};
+    PageWriter pw(flash, base);
+    return pw.append(&h, sizeof(h)) && pw.finish();
+}
+
+/// @copydoc KvLog::oldestUsed
+size_t KvLog::oldestUsed() const
+{
+    size_t oldest = SIZE_MAX;
+    for (size_t s = 0; s < sectors.size(); ++s)
+    {
+        if (sectors[s].state == SectorState::Used && (oldest == SIZE_MAX || sectors[s].seq < sectors[oldest].seq))
+        {
+            oldest = s;
+        }
+    }
+    return oldest;
+}
+
+/// @copydoc KvLog::setLocation
+void KvLog::setLocation(const std::string &key, uint32_t offset, uint16_t valueLen)
+{
+    size_t size = recordSize(key.size(), valueLen);
+    auto it = index.find(key);
+    if (it != index.end())
+    {
+        sectors[it->second.offset / KvFlash::SectorSize].liveBytes -= recordSize(key.size(), it->second.valueLen);
+        it->second = Location{offset, valueLen};
+    }
+    else
+    {
+        index.emplace(key, Location{offset, valueLen});
+    }
+    sectors[offset / KvFlash::SectorSize].liveBytes += size;
+}
+
+/// @copydoc KvLog::dropLocation
+void KvLog::dropLocation(const std::string &key)
+{
+    auto it = index.find(key);
+    if (it != index.end())
+    {
+        sectors[it->second.offset / KvFlash::SectorSize].liveBytes -= recordSize(key.size(), it->second.valueLen);
+        index.erase(it);
+    }
+}
+
+/// @copydoc KvLog::freeSectors
+size_t KvLog::freeSectors() const
+{
+    size_t count = 0;
+    for (const auto &sector : sectors)
+    {
+        count += sector.state == SectorState::Free;
+    }
+    return count;
+}
@@ -0,0 +1,164 @@
+/**
+ * @file KvStore.cpp
+ * @author Ian Archbell
+ * @brief Implementation of the flash key-value store service.
+ * @version 0.1
+ * @date 2025-04-22
+ * @license MIT License
+ * @copyright Copyright (c) 2025, Ian Archbell
+ */
+
+#include "storage/KvStore.h"
+#include <cstdio>
+
+#include "DebugTrace.h"
+TRACE_INIT(KvStore)
+
+/// @copydoc KvStore::KvStore
+KvStore::KvStore() : flash(KV_STORE_FLASH_OFFSET, KV_STORE_FLASH_SIZE), log(flash)
+{
+    lock_ = xSemaphoreCreateMutexStatic(&lockBuffer_);
+    configASSERT(lock_);
+    task_ = xTaskCreateStatic(compactTask, "KvCompact", KV_STORE_STACK_SIZE, this,
+                              KV_STORE_PRIORITY, taskStack_, &taskBuffer_);
+    configASSERT(task_);
+}
+
+/// @copydoc KvStore::get
+bool KvStore::get(const std::string &key, void *dst, size_t dstLen, size_t *valueLen)
+{
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    bool ok = ready() && log.get(key, dst, dstLen, valueLen);
+    xSemaphoreGive(lock_);
+    return ok;
+}
+
+/// @copydoc KvStore::get
+bool KvStore::get(const std::string &key, std::string &value)
+{
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    size_t len = 0;
+    bool ok = ready() && log.get(key, nullptr, 0, &len);
+    if (ok)
+    {
+        value.resize(len);
+        ok = log.get(key, &value[0], len);
+    }
+    xSemaphoreGive(lock_);
+    return ok;
+}
+
+/// @copydoc KvStore::put
+bool KvStore::put(const std::string &key, const void *data, size_t len)
+{
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    bool ok = ready() && log.put(key, data, len);
+    checkCompaction();
+    xSemaphoreGive(lock_);
+    return ok;
+}
+
+/// @copydoc KvStore::put
+bool KvStore::put(const std::string &key, const std::string &value)
+{
+    return put(key, value.data(), value.size());
+}
+
+/// @copydoc KvStore::remove
+bool KvStore::remove(const std::string &key)
+{
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    bool ok = ready() && log.remove(key);
+    checkCompaction();
+    xSemaphoreGive(lock_);
+    return ok;
+}
+
+/// @copydoc KvStore::contains
+bool KvStore::contains(const std::string &key)
+{
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    bool ok = ready() && log.contains(key);
+    xSemaphoreGive(lock_);
+    return ok;
+}
+
+/// @copydoc KvStore::keys
+std::vector<std::string> KvStore::keys()
+{
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    std::vector<std::string> result;
+    if (ready())
+    {
+        result = log.keys();
+    }
+    xSemaphoreGive(lock_);
+    return result;
+}
+
+/// @copydoc KvStore::format
+bool KvStore::format()
+{
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    bool ok = log.format();
+    xSemaphoreGive(lock_);
+    return ok;
+}
+
+/// @copydoc KvStore::stats
+KvLog::Stats KvStore::stats()
+{
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    ready();
+    KvLog::Stats st = log.stats();
+    xSemaphoreGive(lock_);
+    return st;
+}
+
+/// @copydoc KvStore::ready
+bool KvStore::ready()
+{
+    if (log.isMounted())
+    {
+        return true;
+    }
+    if (log.mount())
+    {
+        TRACE("[KvStore] Mounted %u bytes at flash offset 0x%08x\n",
+              static_cast<unsigned>(flash.size()), static_cast<unsigned>(KV_STORE_FLASH_OFFSET));
+        return true;
+    }
+    printf("[KvStore] Mount failed, formatting\n");
+    return log.format();
+}
+
+/// @copydoc KvStore::checkCompaction
+void KvStore::checkCompaction()
+{
+    if (log.needsCompaction())
+    {
+        xTaskNotifyGive(task_);
+    }
+}
+
+/// @copydoc KvStore::compactTask
+void KvStore::compactTask(void *param)
+{
+    KvStore *self = static_cast<KvStore *>(param);
+    for (;;)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        // One sector per lock hold so puts can get in between erases
+        for (size_t i = 0; i < self->flash.size() / KvFlash::SectorSize; ++i)
+        {
+            xSemaphoreTake(self->lock_, portMAX_DELAY);
+            bool more = self->log.needsCompaction() && self->log.compactStep();
+            xSemaphoreGive(self->lock_);
+            if (!more)
+            {
+                break;
+            }
+        }
+    }
+}
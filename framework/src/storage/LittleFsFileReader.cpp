@@ -8,11 +8,9 @@ bool LittleFsFileReader::open(const std::string &path)
 {
     if (!lfs)
         return false;
+    close();
+    resetBuffer();
     isOpen = (lfs_file_open(lfs, &file, path.c_str(), LFS_O_RDONLY) == 0);
-    if (!isOpen)
-    {
-        return false;
-    }
     return isOpen;
 }
 
@@ -21,35 +19,26 @@ LittleFsFileReader::~LittleFsFileReader()
     close();
 }
 
-bool LittleFsFileReader::readLine(char *outLine, size_t maxLen)
+int LittleFsFileReader::readRaw(void *dst, size_t len)
 {
-    if (!isOpen || maxLen == 0)
-
-        return false;
-
-    size_t count = 0;
-    uint8_t ch;
-    int result;
-
-    while (count < maxLen - 1)
-    {
-        result = lfs_file_read(lfs, &file, &ch, 1);
-
-        if (result <= 0)
-            break;
-        if (ch == '\n')
-            break;
-        if (ch != '\r')
-        {
-            outLine[count++] = static_cast<char>(ch);
-        }
-    }
+    if (!isOpen)
+        return -1;
+    return lfs_file_read(lfs, &file, dst, len);
+}
 
-    if (count == 0 && result <= 0)
+bool LittleFsFileReader::seekRaw(size_t offset)
+{
+    if (!isOpen)
         return false;
+    return lfs_file_seek(lfs, &file, static_cast<lfs_soff_t>(offset), LFS_SEEK_SET) >= 0;
+}
 
-    outLine[count] = '\0';
-    return true;
+size_t LittleFsFileReader::size()
+{
+    if (!isOpen)
+        return 0;
+    lfs_soff_t size = lfs_file_size(lfs, &file);
+    return size < 0 ? 0 : static_cast<size_t>(size);
 }
 
 void LittleFsFileReader::close()
@@ -0,0 +1,40 @@
+#include "storage/LittleFsFileWriter.h"
+#include "storage/LittleFsStorageManager.h"
+
+LittleFsFileWriter::LittleFsFileWriter(lfs_t *lfs, LittleFsStorageManager *owner)
+    : lfs(lfs), owner(owner) {}
+
+LittleFsFileWriter::~LittleFsFileWriter()
+{
+    close();
+}
+
+bool LittleFsFileWriter::open(const std::string &path, bool append)
+{
+    if (!lfs)
+        return false;
+    close();
+    int flags = LFS_O_WRONLY | LFS_O_CREAT | (append ? LFS_O_APPEND : LFS_O_TRUNC);
+    isOpen = (lfs_file_open(lfs, &file, path.c_str(), flags) == 0);
+    if (isOpen)
+        this->path = path;
+    return isOpen;
+}
+
+bool LittleFsFileWriter::write(const void *data, size_t len)
+{
+    if (!isOpen)
+        return false;
+    return lfs_file_write(lfs, &file, data, len) == static_cast<lfs_ssize_t>(len);
+}
+
+bool LittleFsFileWriter::close()
+{
+    if (!isOpen)
+        return true;
+    bool ok = lfs_file_close(lfs, &file) == 0;
+    isOpen = false;
+    if (owner)
+        owner->invalidateStat(path);
+    return ok;
+}
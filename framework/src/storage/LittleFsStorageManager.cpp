@@ -1,14 +1,14 @@
 #include "storage/LittleFsStorageManager.h"
 #include "storage/LittleFsFileReader.h"
+#include "storage/LittleFsFileWriter.h"
+#include "storage/FlashOpService.h"
 #include <hardware/flash.h>           // for flash_range_program, flash_range_erase
 #include <hardware/sync.h>            // for save_and_disable_interrupts, restore_interrupts
-#include <pico/multicore.h>           // for multicore_lockout_start_blocking / end_blocking
 #include <hardware/regs/addressmap.h> // for XIP_BASE if not already defined
 #include <cstring>
 #include <iostream>
 #include <FreeRTOS.h> // for FreeRTOS types and functions
 #include <semphr.h>   // for SemaphoreHandle_t, StaticSemaphore_t, xSemaphoreCreateMutexStatic, xSemaphoreTake, xSemaphoreGive
-#include <pico/flash.h> // for flash_safe_execute
 #include "utility/utility.h"    // for runtimeStats
 #include "framework_config.h"
 #include "DebugTrace.h"
@@ -26,6 +26,7 @@ SemaphoreHandle_t LittleFsStorageManager::lfs_mutex = xSemaphoreCreateMutexStati
 
 LittleFsStorageManager::LittleFsStorageManager()
 {
+    statMutex = xSemaphoreCreateMutexStatic(&statMutexBuf);
     configure();
 }
 
@@ -43,7 +44,11 @@ int LittleFsStorageManager::lfs_read_cb(const struct lfs_config *c, lfs_block_t
 {
     auto *self = static_cast<LittleFsStorageManager *>(c->context);
     uintptr_t addr = self->flashBase + block * c->block_size + off;
+#if (configNUM_CORES > 1)
+    FlashOpService::instance().read(addr - XIP_BASE, buffer, size); // includes programs still in the batch
+#else
     std::memcpy(buffer, reinterpret_cast<const void *>(addr), size);
+#endif
     return 0;
 }
 
@@ -70,41 +75,12 @@ int LittleFsStorageManager::lfs_prog_cb_singlecore(const struct lfs_config *c, l
     return 0;
 }
 
-struct FlashProgParams
-{
-    uint32_t addr;
-    const uint8_t *data;
-    size_t size;
-};
-
-static void __not_in_flash_func(flash_prog_callback)(void *p)
-{
-    auto *params = static_cast<FlashProgParams *>(p);
-    flash_range_program(params->addr, params->data, params->size);
-}
-
-static int __not_in_flash_func(lfs_prog_multicore)(const struct lfs_config *c,
-                                                   lfs_block_t block,
-                                                   lfs_off_t off,
-                                                   const void *buffer,
-                                                   lfs_size_t size)
-{
-    auto *self = static_cast<LittleFsStorageManager *>(c->context);
-    uintptr_t addr = self->getFlashBase() + block * c->block_size + off;
-
-    FlashProgParams params = {
-        .addr = addr - XIP_BASE,
-        .data = static_cast<const uint8_t *>(buffer),
-        .size = size};
-    int result = flash_safe_execute(flash_prog_callback, &params, 1000);
-    return (result == PICO_OK) ? 0 : -1;
-}
-
+// Programs are batched by the flash task; the data is copied before this returns
 int LittleFsStorageManager::lfs_prog_cb_multicore(const struct lfs_config *c, lfs_block_t block, lfs_off_t off, const void *buffer, lfs_size_t size)
 {
     auto *self = static_cast<LittleFsStorageManager *>(c->context);
     uintptr_t addr = self->flashBase + block * c->block_size + off;
-    return lfs_prog_multicore(c, block, off, buffer, size);
+    return FlashOpService::instance().program(addr - XIP_BASE, buffer, size);
 }
 
 int LittleFsStorageManager::lfs_erase_cb(const struct lfs_config *c, lfs_block_t block)
@@ -126,38 +102,22 @@ int LittleFsStorageManager::lfs_erase_cb_singlecore(const struct lfs_config *c,
     return 0;
 }
 
-struct FlashEraseParams
-{
-    uint32_t addr;
-    size_t size;
-};
-
-// RAM function that does the actual erase
-static void __not_in_flash_func(flash_erase_callback)(void *p)
-{
-    auto *params = static_cast<FlashEraseParams *>(p);
-    flash_range_erase(params->addr, params->size);
-}
-
-static int lfs_erase_cb_flashsafe(const struct lfs_config *c, lfs_block_t block)
+// Public erase callback that gets registered in config.erase
+int LittleFsStorageManager::lfs_erase_cb_multicore(const struct lfs_config *c, lfs_block_t block)
 {
     auto *self = static_cast<LittleFsStorageManager *>(c->context);
-    uintptr_t addr = self->getFlashBase() + block * c->block_size;
-
-    FlashEraseParams eraseParams = {
-        .addr = addr - XIP_BASE,
-        .size = c->block_size};
-    int result = flash_safe_execute(flash_erase_callback, &eraseParams, 1000);
-    return (result == PICO_OK) ? 0 : -1;
+    uintptr_t addr = self->flashBase + block * c->block_size;
+    return FlashOpService::instance().erase(addr - XIP_BASE, c->block_size);
 }
 
-// Public erase callback that gets registered in config.erase
-int LittleFsStorageManager::lfs_erase_cb_multicore(const struct lfs_config *c, lfs_block_t block)
+// LittleFS syncs at each commit point, so batched programs must be in flash before it returns
+int LittleFsStorageManager::lfs_sync_cb(const struct lfs_config *c)
 {
-    auto *self = static_cast<LittleFsStorageManager *>(c->context);
-    uintptr_t addr = static_cast<LittleFsStorageManager *>(c->context)->flashBase + block * c->block_size;
-    int err = lfs_erase_cb_flashsafe(c, block);
-    return err;
+#if (configNUM_CORES > 1)
+    return FlashOpService::instance().flush();
+#else
+    return 0;
+#endif
 }
 
 extern "C"
@@ -177,8 +137,7 @@ void LittleFsStorageManager::configure()
     config.read = lfs_read_cb;
     config.prog = lfs_prog_cb;
     config.erase = lfs_erase_cb;
-    config.sync = [](const struct lfs_config *) -> int
-    { return 0; };
+    config.sync = lfs_sync_cb;
 
     config.read_size = 256;
     config.prog_size = 256;
@@ -219,8 +178,12 @@ bool LittleFsStorageManager::unmount()
     if (mounted)
     {
         lfs_unmount(&lfs);
+#if (configNUM_CORES > 1)
+        FlashOpService::instance().flush(); // programs from files that were never synced
+#endif
         mounted = false;
     }
+    invalidateAllStats();
     return true;
 }
 
@@ -229,21 +192,80 @@ bool LittleFsStorageManager::isMounted() const
     return mounted;
 }
 
-bool LittleFsStorageManager::exists(const std::string &path)
+bool LittleFsStorageManager::statCached(const std::string &path, StatEntry &out)
 {
+    xSemaphoreTake(statMutex, portMAX_DELAY);
+    for (const auto &entry : statCache)
+    {
+        if (entry.version >= statClearedAt && entry.path == path)
+        {
+            out = entry;
+            xSemaphoreGive(statMutex);
+            return true;
+        }
+    }
+    uint32_t version = statVersion;
+    xSemaphoreGive(statMutex);
+
     struct lfs_info info;
     int err = lfs_stat(&lfs, path.c_str(), &info);
-    return (err == 0);
+    if (err < 0 && err != LFS_ERR_NOENT)
+        return false;
+
+    out.path = path;
+    out.size = err == 0 ? info.size : 0;
+    out.type = err == 0 ? info.type : 0;
+    out.version = version;
+
+    // Only cache the result if nothing was written while lfs_stat ran
+    xSemaphoreTake(statMutex, portMAX_DELAY);
+    if (version == statVersion)
+    {
+        statCache[statNext] = out;
+        statNext = (statNext + 1) % STORAGE_STAT_CACHE_ENTRIES;
+    }
+    xSemaphoreGive(statMutex);
+    return true;
+}
+
+void LittleFsStorageManager::invalidateStat(const std::string &path)
+{
+    xSemaphoreTake(statMutex, portMAX_DELAY);
+    statVersion++;
+    for (auto &entry : statCache)
+    {
+        if (entry.path == path)
+            entry.version = 0;
+    }
+    xSemaphoreGive(statMutex);
+}
+
+void LittleFsStorageManager::invalidateAllStats()
+{
+    xSemaphoreTake(statMutex, portMAX_DELAY);
+    statClearedAt = ++statVersion;
+    xSemaphoreGive(statMutex);
+}
+
+bool LittleFsStorageManager::exists(const std::string &path)
+{
+    StatEntry entry;
+    return statCached(path, entry) && entry.type != 0;
 }
 
 bool LittleFsStorageManager::remove(const std::string &path)
 {
-    return lfs_remove(&lfs, path.c_str()) == 0;
+    bool ok = lfs_remove(&lfs, path.c_str()) == 0;
+    // A removed directory takes its children with it, so drop everything
+    invalidateAllStats();
+    return ok;
 }
 
 bool LittleFsStorageManager::rename(const std::string &from, const std::string &to)
 {
-    return lfs_rename(&lfs, from.c_str(), to.c_str()) == 0;
+    bool ok = lfs_rename(&lfs, from.c_str(), to.c_str()) == 0;
+    invalidateAllStats();
+    return ok;
 }
 
 bool LittleFsStorageManager::readFile(const std::string &path, std::vector<uint8_t> &out)
@@ -294,6 +316,7 @@ bool LittleFsStorageManager::writeFile(const std::string &path, const std::vecto
         return false;
     int written = lfs_file_write(&lfs, &file, data.data(), data.size());
     int closed = lfs_file_close(&lfs, &file);
+    invalidateStat(path);
     return (written == static_cast<int>(data.size())) && (closed == 0);
 }
 
@@ -308,6 +331,7 @@ bool LittleFsStorageManager::writeFile(const std::string& path, const unsigned c
 
     int written = lfs_file_write(&lfs, &file, data, size);
     lfs_file_close(&lfs, &file);
+    invalidateStat(path);
 
     return (written == static_cast<int>(size));
 }
@@ -326,9 +350,11 @@ bool LittleFsStorageManager::appendToFile(const std::string &path, const uint8_t
     {
         printf("[LittleFS] appendToFile: write failed for '%s'\n", path.c_str());
         lfs_file_close(&lfs, &file);
+        invalidateStat(path);
         return false;
     }
     lfs_file_close(&lfs, &file);
+    invalidateStat(path);
     return written == (int)size;
 }
 
@@ -359,18 +385,28 @@ bool LittleFsStorageManager::streamFile(const std::string &path, std::function<v
 
 size_t LittleFsStorageManager::getFileSize(const std::string &path)
 {
-    lfs_file_t file;
-    if (lfs_file_open(&lfs, &file, path.c_str(), LFS_O_RDONLY) < 0)
+    StatEntry entry;
+    if (!statCached(path, entry) || entry.type != LFS_TYPE_REG)
     {
-        printf("[LittleFS] getFileSize: open failed for '%s'\n", path.c_str());
+        printf("[LittleFS] getFileSize: no such file '%s'\n", path.c_str());
         return 0;
     }
-    lfs_soff_t size = lfs_file_size(&lfs, &file);
-    lfs_file_close(&lfs, &file);
-    return size < 0 ? 0 : size;
+    return entry.size;
 }
 
 bool LittleFsStorageManager::listDirectory(const std::string &path, std::vector<FileInfo> &out)
+{
+    return forEachDirectoryEntry(path, 0, 0, [&out](const FileInfo &entry)
+    {
+        out.push_back(entry);
+        return true;
+    });
+}
+
+/// @copydoc LittleFsStorageManager::forEachDirectoryEntry
+bool LittleFsStorageManager::forEachDirectoryEntry(const std::string &path, uint32_t cursor, size_t limit,
+                                                   const std::function<bool(const FileInfo &)> &visitor,
+                                                   uint32_t *next)
 {
     if(!mounted)
     {
@@ -382,18 +418,37 @@ bool LittleFsStorageManager::listDirectory(const std::string &path, std::vector<
     if (lfs_dir_open(&lfs, &dir, path.c_str()) < 0)
         return false;  
 
-    while (lfs_dir_read(&lfs, &dir, &info) > 0)
+    // The cursor is the lfs directory position: seeking to it skips whole metadata blocks
+    // rather than reading each entry before it
+    if (cursor > 0 && lfs_dir_seek(&lfs, &dir, cursor) < 0)
+    {
+        lfs_dir_close(&lfs, &dir);
+        return false;
+    }
+
+    // lfs calls take the lock themselves, so the visitor runs unlocked
+    FileInfo entry;
+    entry.isReadOnly = false;  // LittleFS doesn't expose this, so hardcoded
+    size_t visited = 0;
+    lfs_soff_t pos = lfs_dir_tell(&lfs, &dir);
+    while ((limit == 0 || visited < limit) && lfs_dir_read(&lfs, &dir, &info) > 0)
     {
         if (strcmp(info.name, ".") == 0 || strcmp(info.name, "..") == 0)
+        {
+            pos = lfs_dir_tell(&lfs, &dir);
             continue;
+        }
 
-        FileInfo entry;
-        entry.name = info.name;
+        entry.name = info.name; // reuses the string's capacity
         entry.size = info.size;
         entry.isDirectory = (info.type == LFS_TYPE_DIR);
-        entry.isReadOnly = false;  // LittleFS doesn't expose this, so hardcoded
-        out.push_back(entry);
+        visited++;
+        if (!visitor(entry))
+            break; // not consumed: pos still points at it
+        pos = lfs_dir_tell(&lfs, &dir);
     }
+    if (next)
+        *next = pos > 0 ? static_cast<uint32_t>(pos) : 0;
 
     lfs_dir_close(&lfs, &dir);
     return true;
@@ -403,7 +458,9 @@ bool LittleFsStorageManager::listDirectory(const std::string &path, std::vector<
 bool LittleFsStorageManager::createDirectory(const std::string &path)
 {
     TRACE("[LittleFS] Creating directory '%s'\n", path.c_str());
-    if (lfs_mkdir(&lfs, path.c_str()) < 0)
+    int err = lfs_mkdir(&lfs, path.c_str());
+    invalidateStat(path);
+    if (err < 0)
     {
         printf("[LittleFS] Failed to create directory '%s'\n", path.c_str());
         return false;
@@ -414,7 +471,9 @@ bool LittleFsStorageManager::createDirectory(const std::string &path)
 
 bool LittleFsStorageManager::removeDirectory(const std::string &path)
 {
-    return lfs_remove(&lfs, path.c_str()) == 0;
+    bool ok = lfs_remove(&lfs, path.c_str()) == 0;
+    invalidateAllStats();
+    return ok;
 }
 
 bool LittleFsStorageManager::formatStorage()
@@ -432,6 +491,7 @@ bool LittleFsStorageManager::formatStorage()
         unmount();
     }
     int err = lfs_format(&lfs, &config);
+    invalidateAllStats();
     result = (err == 0);
 
     if (result)
@@ -455,3 +515,14 @@ std::unique_ptr<StorageFileReader> LittleFsStorageManager::openReader(const std:
     if (!reader->open(path)) return nullptr;
     return reader;
 }
+
+std::unique_ptr<StorageFileWriter> LittleFsStorageManager::openWriter(const std::string& path, bool append) {
+    if (!mount()) return nullptr;
+    auto writer = std::make_unique<LittleFsFileWriter>(&lfs, this);
+    if (!writer->open(path, append)) {
+        printf("[LittleFS] openWriter: open failed for '%s'\n", path.c_str());
+        return nullptr;
+    }
+    invalidateStat(path); // opening creates or truncates the file
+    return writer;
+}
@@ -0,0 +1,74 @@
+/**
+ * @file PicoKvFlash.cpp
+ * @author Ian Archbell
+ * @brief Implementation of the raw flash range used by KvStore.
+ * @version 0.1
+ * @date 2025-04-22
+ * @license MIT License
+ * @copyright Copyright (c) 2025, Ian Archbell
+ */
+
+#include "storage/PicoKvFlash.h"
+#include <cstring>
+#include <FreeRTOS.h>
+#include <hardware/flash.h>           // for flash_range_program, flash_range_erase
+#include <hardware/sync.h>            // for save_and_disable_interrupts, restore_interrupts
+#include <hardware/regs/addressmap.h> // for XIP_BASE
+#include "storage/FlashOpService.h"
+
+/// @copydoc PicoKvFlash::PicoKvFlash
+PicoKvFlash::PicoKvFlash(uint32_t offset, size_t size) : base(offset), length(size & ~(SectorSize - 1))
+{
+}
+
+/// @copydoc PicoKvFlash::read
+bool PicoKvFlash::read(uint32_t offset, void *dst, size_t len)
+{
+    if (offset + len > length)
+    {
+        return false;
+    }
+#if (configNUM_CORES > 1)
+    // Through the service lock, so the read is ordered with programs queued by other clients
+    FlashOpService::instance().read(base + offset, dst, len);
+#else
+    std::memcpy(dst, reinterpret_cast<const void *>(XIP_BASE + base + offset), len);
+#endif
+    return true;
+}
+
+/// @copydoc PicoKvFlash::program
+bool PicoKvFlash::program(uint32_t offset, const void *src, size_t len)
+{
+    if (offset + len > length)
+    {
+        return false;
+    }
+#if (configNUM_CORES > 1)
+    // Flush straight away: reads of this range come from XIP, not the batch
+    FlashOpService &service = FlashOpService::instance();
+    return service.program(base + offset, src, len) == 0 && service.flush() == 0;
+#else
+    uint32_t ints = save_and_disable_interrupts();
+    flash_range_program(base + offset, static_cast<const uint8_t *>(src), len);
+    restore_interrupts(ints);
+    return true;
+#endif
+}
+
+/// @copydoc PicoKvFlash::erase
+bool PicoKvFlash::erase(uint32_t offset)
+{
+    if (offset + SectorSize > length)
+    {
+        return false;
+    }
+#if (configNUM_CORES > 1)
+    return FlashOpService::instance().erase(base + offset, SectorSize) == 0;
+#else
+    uint32_t ints = save_and_disable_interrupts();
+    flash_range_erase(base + offset, SectorSize);
+    restore_interrupts(ints);
+    return true;
+#endif
+}
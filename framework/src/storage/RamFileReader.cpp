@@ -0,0 +1,59 @@
+#include "storage/RamFileReader.h"
+#include <cstring>
+
+RamFileReader::RamFileReader(std::shared_ptr<const std::vector<uint8_t>> data)
+    : data(std::move(data)) {}
+
+bool RamFileReader::readLine(char* buffer, size_t maxLen)
+{
+    if (!data || maxLen < 2 || pos >= data->size())
+        return false;
+
+    const uint8_t* start = data->data() + pos;
+    size_t available = data->size() - pos;
+    const uint8_t* newline = static_cast<const uint8_t*>(memchr(start, '\n', available));
+    size_t span = newline ? static_cast<size_t>(newline - start) : available;
+
+    // Carriage returns are stripped and don't count against maxLen
+    size_t count = 0;
+    size_t i = 0;
+    for (; i < span && count < maxLen - 1; ++i)
+    {
+        if (start[i] != '\r')
+            buffer[count++] = static_cast<char>(start[i]);
+    }
+    pos += i;
+
+    // A line that exactly filled the buffer still owns its newline
+    if (pos < data->size() && (*data)[pos] == '\n')
+        pos++;
+
+    buffer[count] = '\0';
+    return true;
+}
+
+size_t RamFileReader::readChunk(void* buffer, size_t len)
+{
+    if (!data || pos >= data->size())
+        return 0;
+    size_t n = data->size() - pos;
+    if (n > len)
+        n = len;
+    memcpy(buffer, data->data() + pos, n);
+    pos += n;
+    return n;
+}
+
+bool RamFileReader::seek(size_t offset)
+{
+    if (!data || offset > data->size())
+        return false;
+    pos = offset;
+    return true;
+}
+
+void RamFileReader::close()
+{
+    data.reset();
+    pos = 0;
+}
@@ -0,0 +1,23 @@
+#include "storage/RamFileWriter.h"
+#include "storage/RamStorageManager.h"
+
+RamFileWriter::RamFileWriter(RamStorageManager *owner, const std::string &path)
+    : owner(owner), path(path) {}
+
+RamFileWriter::~RamFileWriter()
+{
+    close();
+}
+
+bool RamFileWriter::write(const void *data, size_t len)
+{
+    if (!owner)
+        return false;
+    return len == 0 || owner->appendData(path, data, len);
+}
+
+bool RamFileWriter::close()
+{
+    owner = nullptr;
+    return true;
+}
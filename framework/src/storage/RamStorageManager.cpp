@@ -0,0 +1,397 @@
+/**
+ * @file RamStorageManager.cpp
+ * @author Ian Archbell
+ * @brief Implementation of the RAM-backed StorageManager.
+ * @version 0.1
+ * @date 2025-04-22
+ * @license MIT License
+ * @copyright Copyright (c) 2025, Ian Archbell
+ */
+
+#include "storage/RamStorageManager.h"
+#include "storage/RamFileReader.h"
+#include "storage/RamFileWriter.h"
+#include <cstdio>
+#include <cstring>
+
+RamStorageManager::RamStorageManager(size_t budget) : limit(budget)
+{
+    lock = xSemaphoreCreateMutexStatic(&lockBuffer);
+}
+
+std::string RamStorageManager::normalize(const std::string &path)
+{
+    std::string out = (path.empty() || path[0] != '/') ? "/" + path : path;
+    while (out.size() > 1 && out.back() == '/')
+        out.pop_back();
+    return out;
+}
+
+std::string RamStorageManager::parentOf(const std::string &path)
+{
+    size_t slash = path.rfind('/');
+    return (slash == 0 || slash == std::string::npos) ? "/" : path.substr(0, slash);
+}
+
+bool RamStorageManager::isDirectoryLocked(const std::string &path) const
+{
+    if (path == "/")
+        return true;
+    auto it = nodes.find(path);
+    return it != nodes.end() && it->second.isDirectory;
+}
+
+bool RamStorageManager::isEmptyLocked(const std::string &path) const
+{
+    std::string prefix = path == "/" ? "/" : path + "/";
+    auto it = nodes.lower_bound(prefix);
+    return it == nodes.end() || it->first.compare(0, prefix.size(), prefix) != 0;
+}
+
+bool RamStorageManager::charge(size_t release, size_t add)
+{
+    if (used - release + add > limit)
+    {
+        printf("[RamStorage] Budget of %zu bytes exceeded (%zu in use)\n", limit, used);
+        return false;
+    }
+    used = used - release + add;
+    return true;
+}
+
+bool RamStorageManager::mount()
+{
+    mounted = true;
+    return true;
+}
+
+bool RamStorageManager::unmount()
+{
+    mounted = false;
+    return true;
+}
+
+bool RamStorageManager::isMounted() const
+{
+    return mounted;
+}
+
+bool RamStorageManager::exists(const std::string &path)
+{
+    std::string p = normalize(path);
+    xSemaphoreTake(lock, portMAX_DELAY);
+    bool found = mounted && (p == "/" || nodes.count(p) != 0);
+    xSemaphoreGive(lock);
+    return found;
+}
+
+bool RamStorageManager::remove(const std::string &path)
+{
+    std::string p = normalize(path);
+    xSemaphoreTake(lock, portMAX_DELAY);
+    auto it = nodes.find(p);
+    bool ok = mounted && it != nodes.end() && (!it->second.isDirectory || isEmptyLocked(p));
+    if (ok)
+    {
+        used -= p.size() + (it->second.data ? it->second.data->size() : 0);
+        nodes.erase(it);
+    }
+    xSemaphoreGive(lock);
+    return ok;
+}
+
+bool RamStorageManager::rename(const std::string &from, const std::string &to)
+{
+    std::string src = normalize(from);
+    std::string dst = normalize(to);
+    xSemaphoreTake(lock, portMAX_DELAY);
+
+    auto it = nodes.find(src);
+    bool ok = mounted && it != nodes.end() && isDirectoryLocked(parentOf(dst)) &&
+              dst.compare(0, src.size() + 1, src + "/") != 0; // not into itself
+    if (ok && src != dst)
+    {
+        auto existing = nodes.find(dst);
+        if (existing != nodes.end())
+        {
+            // Like LittleFS: a file replaces a file, a directory an empty directory
+            ok = existing->second.isDirectory == it->second.isDirectory &&
+                 (!existing->second.isDirectory || isEmptyLocked(dst));
+            if (ok)
+            {
+                used -= dst.size() + (existing->second.data ? existing->second.data->size() : 0);
+                nodes.erase(existing);
+            }
+        }
+
+        // Move the entry and, for a directory, everything under it. Siblings such as
+        // "/a.txt" sort between "/a" and "/a/x", so the children are found from src + "/"
+        std::string prefix = src + "/";
+        std::vector<std::pair<std::string, Node>> moved;
+        if (ok)
+        {
+            moved.emplace_back(dst, std::move(it->second));
+            nodes.erase(it);
+        }
+        for (auto child = nodes.lower_bound(prefix); ok && child != nodes.end();)
+        {
+            if (child->first.compare(0, prefix.size(), prefix) != 0)
+                break;
+            moved.emplace_back(dst + child->first.substr(src.size()), std::move(child->second));
+            child = nodes.erase(child);
+        }
+        for (auto &entry : moved)
+        {
+            used = used + dst.size() - src.size();
+            nodes.emplace(std::move(entry.first), std::move(entry.second));
+        }
+    }
+
+    xSemaphoreGive(lock);
+    return ok;
+}
+
+bool RamStorageManager::readFile(const std::string &path, std::vector<uint8_t> &out)
+{
+    auto data = snapshot(path);
+    if (!data)
+        return false;
+    out.assign(data->begin(), data->end());
+    return true;
+}
+
+bool RamStorageManager::readFileString(const std::string &path, uint32_t startPosition, uint32_t length, std::string &buffer)
+{
+    auto data = snapshot(path);
+    if (!data || startPosition >= data->size())
+        return false;
+    if (startPosition + length > data->size())
+        length = data->size() - startPosition;
+    buffer.assign(reinterpret_cast<const char *>(data->data()) + startPosition, length);
+    return true;
+}
+
+bool RamStorageManager::writeFile(const std::string &path, const std::vector<uint8_t> &data)
+{
+    return writeFile(path, data.data(), data.size());
+}
+
+bool RamStorageManager::writeFile(const std::string &path, const unsigned char *data, size_t size)
+{
+    std::string p = normalize(path);
+    xSemaphoreTake(lock, portMAX_DELAY);
+    bool ok = mounted && putFile(p, data, size);
+    xSemaphoreGive(lock);
+    return ok;
+}
+
+bool RamStorageManager::putFile(const std::string &path, const uint8_t *data, size_t size)
+{
+    auto it = nodes.find(path);
+    if (it != nodes.end() && it->second.isDirectory)
+        return false;
+    if (it == nodes.end() && !isDirectoryLocked(parentOf(path)))
+        return false;
+
+    size_t release = it != nodes.end() ? path.size() + it->second.data->size() : 0;
+    if (!charge(release, path.size() + size))
+        return false;
+
+    // A new vector, so open readers keep the old contents
+    nodes[path] = Node{false, std::make_shared<std::vector<uint8_t>>(data, data + size)};
+    return true;
+}
+
+bool RamStorageManager::appendToFile(const std::string &path, const uint8_t *data, size_t size)
+{
+    std::string p = normalize(path);
+    xSemaphoreTake(lock, portMAX_DELAY);
+    bool ok = mounted && appendLocked(p, data, size, true);
+    xSemaphoreGive(lock);
+    return ok;
+}
+
+bool RamStorageManager::appendData(const std::string &path, const void *data, size_t size)
+{
+    xSemaphoreTake(lock, portMAX_DELAY);
+    bool ok = mounted && appendLocked(path, data, size, false);
+    xSemaphoreGive(lock);
+    return ok;
+}
+
+bool RamStorageManager::appendLocked(const std::string &path, const void *data, size_t size, bool create)
+{
+    auto it = nodes.find(path);
+    if (it == nodes.end())
+        return create && putFile(path, static_cast<const uint8_t *>(data), size);
+    if (it->second.isDirectory || !charge(0, size))
+        return false;
+
+    Data &contents = it->second.data;
+    if (contents.use_count() > 1)
+        contents = std::make_shared<std::vector<uint8_t>>(*contents); // a reader holds the old one
+    const uint8_t *src = static_cast<const uint8_t *>(data);
+    contents->insert(contents->end(), src, src + size);
+    return true;
+}
+
+std::shared_ptr<const std::vector<uint8_t>> RamStorageManager::snapshot(const std::string &path)
+{
+    std::string p = normalize(path);
+    xSemaphoreTake(lock, portMAX_DELAY);
+    std::shared_ptr<const std::vector<uint8_t>> data;
+    auto it = nodes.find(p);
+    if (mounted && it != nodes.end() && !it->second.isDirectory)
+        data = it->second.data;
+    xSemaphoreGive(lock);
+    return data;
+}
+
+bool RamStorageManager::streamFile(const std::string &path, std::function<void(const uint8_t *, size_t)> chunkCallback)
+{
+    auto data = snapshot(path);
+    if (!data)
+        return false;
+    for (size_t pos = 0; pos < data->size(); pos += HTTP_BUFFER_SIZE)
+    {
+        size_t n = data->size() - pos < HTTP_BUFFER_SIZE ? data->size() - pos : HTTP_BUFFER_SIZE;
+        chunkCallback(data->data() + pos, n);
+    }
+    return true;
+}
+
+size_t RamStorageManager::getFileSize(const std::string &path)
+{
+    auto data = snapshot(path);
+    return data ? data->size() : 0;
+}
+
+bool RamStorageManager::listDirectory(const std::string &path, std::vector<FileInfo> &out)
+{
+    return listLocked(path, 0, 0, out);
+}
+
+bool RamStorageManager::forEachDirectoryEntry(const std::string &path, uint32_t cursor, size_t limit,
+                                              const std::function<bool(const FileInfo &)> &visitor,
+                                              uint32_t *next)
+{
+    // The cursor is an entry count: a RAM directory is cheap to skip through
+    std::vector<FileInfo> window;
+    if (!listLocked(path, cursor, limit, window))
+        return false;
+    size_t consumed = 0;
+    for (const auto &entry : window)
+    {
+        if (!visitor(entry))
+            break;
+        consumed++;
+    }
+    if (next)
+        *next = static_cast<uint32_t>(cursor + consumed);
+    return true;
+}
+
+bool RamStorageManager::listLocked(const std::string &path, size_t offset, size_t limit, std::vector<FileInfo> &out)
+{
+    std::string p = normalize(path);
+    xSemaphoreTake(lock, portMAX_DELAY);
+    bool ok = mounted && isDirectoryLocked(p);
+    if (ok)
+    {
+        std::string prefix = p == "/" ? "/" : p + "/";
+        size_t index = 0;
+        for (auto it = nodes.lower_bound(prefix); it != nodes.end() && (limit == 0 || index < offset + limit); ++it)
+        {
+            if (it->first.compare(0, prefix.size(), prefix) != 0)
+                break;
+            if (it->first.find('/', prefix.size()) != std::string::npos)
+                continue; // deeper down
+            if (index++ < offset)
+                continue;
+            FileInfo entry;
+            entry.name = it->first.substr(prefix.size());
+            entry.isDirectory = it->second.isDirectory;
+            entry.isReadOnly = false;
+            entry.size = it->second.data ? it->second.data->size() : 0;
+            out.push_back(entry);
+        }
+    }
+    xSemaphoreGive(lock);
+    return ok;
+}
+
+bool RamStorageManager::createDirectory(const std::string &path)
+{
+    std::string p = normalize(path);
+    xSemaphoreTake(lock, portMAX_DELAY);
+    bool ok = mounted;
+
+    // Create each missing level from the top down
+    for (size_t slash = 1; ok && p != "/" && slash != std::string::npos;)
+    {
+        slash = p.find('/', slash + 1);
+        std::string level = p.substr(0, slash);
+        auto it = nodes.find(level);
+        if (it != nodes.end())
+            ok = it->second.isDirectory;
+        else if ((ok = charge(0, level.size())))
+            nodes.emplace(level, Node{true, nullptr});
+    }
+
+    xSemaphoreGive(lock);
+    if (!ok)
+        printf("[RamStorage] Failed to create directory '%s'\n", p.c_str());
+    return ok;
+}
+
+bool RamStorageManager::removeDirectory(const std::string &path)
+{
+    std::string p = normalize(path);
+    xSemaphoreTake(lock, portMAX_DELAY);
+    auto it = nodes.find(p);
+    bool ok = mounted && it != nodes.end() && it->second.isDirectory && isEmptyLocked(p);
+    if (ok)
+    {
+        used -= p.size();
+        nodes.erase(it);
+    }
+    xSemaphoreGive(lock);
+    return ok;
+}
+
+bool RamStorageManager::formatStorage()
+{
+    xSemaphoreTake(lock, portMAX_DELAY);
+    nodes.clear();
+    used = 0;
+    xSemaphoreGive(lock);
+    return true;
+}
+
+std::unique_ptr<StorageFileReader> RamStorageManager::openReader(const std::string &path)
+{
+    auto data = snapshot(path);
+    if (!data)
+        return nullptr;
+    return std::make_unique<RamFileReader>(std::move(data));
+}
+
+std::unique_ptr<StorageFileWriter> RamStorageManager::openWriter(const std::string &path, bool append)
+{
+    std::string p = normalize(path);
+    xSemaphoreTake(lock, portMAX_DELAY);
+    bool ok = mounted;
+    if (ok)
+    {
+        auto it = nodes.find(p);
+        bool keep = append && it != nodes.end() && !it->second.isDirectory;
+        ok = keep || putFile(p, nullptr, 0);
+    }
+    xSemaphoreGive(lock);
+    if (!ok)
+    {
+        printf("[RamStorage] openWriter: open failed for '%s'\n", p.c_str());
+        return nullptr;
+    }
+    return std::make_unique<RamFileWriter>(this, p);
+}
@@ -0,0 +1,176 @@
+/**
+ * @file StreamingFileWriter.cpp
+ * @author Ian Archbell
+ * @brief Implementation of the double-buffered file writer.
+ *
+ * Part of the PicoFramework application framework.
+ * Each writer has at most one buffer with the writer task at a time, so the job queue
+ * only needs one slot per concurrent transfer. The done_ semaphore both signals that the
+ * buffer is free again and orders the writer task's updates before the caller reads them.
+ *
+ * @version 0.1
+ * @date 2025-04-22
+ * @license MIT License
+ * @copyright Copyright (c) 2025, Ian Archbell
+ */
+
+#include "storage/StreamingFileWriter.h"
+#include <cstdio>
+#include <cstring>
+#include "storage/StorageManager.h"
+
+QueueHandle_t StreamingFileWriter::jobs_ = nullptr;
+StaticQueue_t StreamingFileWriter::jobsBuffer_;
+uint8_t StreamingFileWriter::jobsStorage_[STREAM_WRITER_QUEUE_LENGTH * sizeof(Job)];
+TaskHandle_t StreamingFileWriter::writer_ = nullptr;
+StaticTask_t StreamingFileWriter::writerBuffer_;
+StackType_t StreamingFileWriter::writerStack_[STREAM_WRITER_STACK_SIZE];
+
+/// @copydoc StreamingFileWriter::StreamingFileWriter
+StreamingFileWriter::StreamingFileWriter()
+{
+    done_ = xSemaphoreCreateBinaryStatic(&doneBuffer_);
+}
+
+/// @copydoc StreamingFileWriter::~StreamingFileWriter
+StreamingFileWriter::~StreamingFileWriter()
+{
+    close();
+}
+
+/// @copydoc StreamingFileWriter::open
+bool StreamingFileWriter::open(StorageManager *storage, const std::string &path, bool append)
+{
+    if (file_)
+    {
+        close();
+    }
+    if (!storage)
+    {
+        return false;
+    }
+
+    startWriter();
+    file_ = storage->openWriter(path, append);
+    fill_ = 0;
+    fillLen_ = 0;
+    written_ = 0;
+    failed_ = false;
+    return file_ != nullptr;
+}
+
+/// @copydoc StreamingFileWriter::write
+bool StreamingFileWriter::write(const void *data, size_t len)
+{
+    if (!file_ || failed_)
+    {
+        return false;
+    }
+
+    const uint8_t *src = static_cast<const uint8_t *>(data);
+    while (len > 0)
+    {
+        size_t n = STREAM_WRITER_BLOCK_SIZE - fillLen_;
+        n = n < len ? n : len;
+        memcpy(buffers_[fill_] + fillLen_, src, n);
+        fillLen_ += n;
+        src += n;
+        len -= n;
+
+        if (fillLen_ == STREAM_WRITER_BLOCK_SIZE && !submit())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// @copydoc StreamingFileWriter::close
+bool StreamingFileWriter::close()
+{
+    if (!file_)
+    {
+        return true;
+    }
+
+    bool ok = true;
+    if (fillLen_ > 0 && !failed_)
+    {
+        ok = submit();
+    }
+    ok = waitIdle() && ok;
+    ok = file_->close() && ok;
+    file_.reset();
+    return ok;
+}
+
+/// @copydoc StreamingFileWriter::submit
+bool StreamingFileWriter::submit()
+{
+    // The other buffer must be back before this one can go
+    if (!waitIdle())
+    {
+        return false;
+    }
+
+    Job job{this, fill_, fillLen_};
+    inFlight_ = true;
+    xQueueSend(jobs_, &job, portMAX_DELAY);
+    fill_ ^= 1;
+    fillLen_ = 0;
+    return true;
+}
+
+/// @copydoc StreamingFileWriter::waitIdle
+bool StreamingFileWriter::waitIdle()
+{
+    if (inFlight_)
+    {
+        xSemaphoreTake(done_, portMAX_DELAY);
+        inFlight_ = false;
+    }
+    return !failed_;
+}
+
+/// @copydoc StreamingFileWriter::startWriter
+void StreamingFileWriter::startWriter()
+{
+    taskENTER_CRITICAL();
+    bool first = jobs_ == nullptr;
+    if (first)
+    {
+        jobs_ = xQueueCreateStatic(STREAM_WRITER_QUEUE_LENGTH, sizeof(Job), jobsStorage_, &jobsBuffer_);
+    }
+    taskEXIT_CRITICAL();
+
+    if (first)
+    {
+        writer_ = xTaskCreateStatic(writerTask, "FileWriter", STREAM_WRITER_STACK_SIZE, nullptr,
+                                    STREAM_WRITER_PRIORITY, writerStack_, &writerBuffer_);
+        configASSERT(writer_);
+    }
+}
+
+/// @copydoc StreamingFileWriter::writerTask
+void StreamingFileWriter::writerTask(void *)
+{
+    Job job;
+    for (;;)
+    {
+        if (xQueueReceive(jobs_, &job, portMAX_DELAY) != pdTRUE)
+        {
+            continue;
+        }
+        StreamingFileWriter *w = job.writer;
+        if (w->file_->write(w->buffers_[job.index], job.len))
+        {
+            w->written_ += job.len;
+        }
+        else
+        {
+            printf("[StreamingFileWriter] Write of %zu bytes failed\n", job.len);
+            w->failed_ = true;
+        }
+        xSemaphoreGive(w->done_);
+    }
+}
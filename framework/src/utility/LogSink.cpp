@@ -0,0 +1,253 @@
+/**
+ * @file LogSink.cpp
+ * @author Ian Archbell
+ * @brief Implementation of the buffered log file writer.
+ *
+ * Part of the PicoFramework application framework.
+ * The ring indices only ever grow; the difference between them is the number of bytes
+ * buffered. write() runs in a short critical section so it can be called from any task
+ * without blocking; all storage access happens under flushLock_.
+ *
+ * @version 0.1
+ * @date 2025-04-22
+ * @license MIT License
+ * @copyright Copyright (c) 2025, Ian Archbell
+ */
+
+#include "utility/LogSink.h"
+#include <cstdio>
+#include <cstring>
+#include "framework/AppContext.h"
+#include "storage/StorageManager.h"
+
+LogSink *LogSink::sinks_[LOG_SINK_MAX_SINKS] = {};
+size_t LogSink::sinkCount_ = 0;
+char *LogSink::staging_ = nullptr;
+SemaphoreHandle_t LogSink::flushLock_ = nullptr;
+StaticSemaphore_t LogSink::flushLockBuffer_;
+TaskHandle_t LogSink::writer_ = nullptr;
+
+/// @copydoc LogSink::open
+bool LogSink::open(const std::string &path, size_t maxFileSize, uint8_t maxFiles)
+{
+    if (!startWriter())
+    {
+        printf("[LogSink] Cannot open '%s': no memory for the writer task\n", path.c_str());
+        return false;
+    }
+    if (registered_)
+    {
+        flush();
+    }
+
+    xSemaphoreTake(flushLock_, portMAX_DELAY);
+    bool ok = true;
+    if (!registered_)
+    {
+        if (sinkCount_ == LOG_SINK_MAX_SINKS)
+        {
+            printf("[LogSink] Cannot open '%s': LOG_SINK_MAX_SINKS sinks already open\n", path.c_str());
+            ok = false;
+        }
+        else if (!buffer_ && !(buffer_ = static_cast<char *>(pvPortMalloc(LOG_SINK_BUFFER_SIZE))))
+        {
+            printf("[LogSink] Cannot open '%s': no memory for a %u byte buffer\n", path.c_str(), (unsigned)LOG_SINK_BUFFER_SIZE);
+            ok = false;
+        }
+        else
+        {
+            sinks_[sinkCount_++] = this;
+            registered_ = true;
+        }
+    }
+    if (ok)
+    {
+        path_ = path;
+        maxFileSize_ = maxFileSize;
+        maxFiles_ = maxFiles;
+        sizeKnown_ = false;
+    }
+    xSemaphoreGive(flushLock_);
+    return ok;
+}
+
+/// @copydoc LogSink::write
+bool LogSink::write(const char *text, size_t len)
+{
+    bool stored = false;
+    bool wake = false;
+
+    if (!buffer_)
+    {
+        return false; // not opened yet
+    }
+
+    taskENTER_CRITICAL();
+    if (len <= LOG_SINK_BUFFER_SIZE - (head_ - tail_))
+    {
+        size_t start = head_ % LOG_SINK_BUFFER_SIZE;
+        size_t first = len < LOG_SINK_BUFFER_SIZE - start ? len : LOG_SINK_BUFFER_SIZE - start;
+        memcpy(buffer_ + start, text, first);
+        memcpy(buffer_, text + first, len - first);
+        head_ += len;
+        stored = true;
+        wake = head_ - tail_ >= LOG_SINK_FLUSH_BYTES;
+    }
+    taskEXIT_CRITICAL();
+
+    if (!stored)
+    {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+    else if (wake && writer_)
+    {
+        xTaskNotifyGive(writer_);
+    }
+    return stored;
+}
+
+/// @copydoc LogSink::buffered
+size_t LogSink::buffered() const
+{
+    taskENTER_CRITICAL();
+    size_t n = head_ - tail_;
+    taskEXIT_CRITICAL();
+    return n;
+}
+
+/// @copydoc LogSink::flush
+bool LogSink::flush()
+{
+    if (!flushLock_ || path_.empty())
+    {
+        return false;
+    }
+    bool ok = true;
+    xSemaphoreTake(flushLock_, portMAX_DELAY);
+    size_t n;
+    while ((n = take(staging_, LOG_SINK_FLUSH_BYTES)) > 0)
+    {
+        ok = append(staging_, n) && ok;
+    }
+    xSemaphoreGive(flushLock_);
+    return ok;
+}
+
+/// @copydoc LogSink::take
+size_t LogSink::take(char *out, size_t max)
+{
+    taskENTER_CRITICAL();
+    size_t n = head_ - tail_;
+    n = n < max ? n : max;
+    size_t start = tail_ % LOG_SINK_BUFFER_SIZE;
+    size_t first = n < LOG_SINK_BUFFER_SIZE - start ? n : LOG_SINK_BUFFER_SIZE - start;
+    memcpy(out, buffer_ + start, first);
+    memcpy(out + first, buffer_, n - first);
+    tail_ += n;
+    taskEXIT_CRITICAL();
+    return n;
+}
+
+/// @copydoc LogSink::append
+bool LogSink::append(const char *data, size_t len)
+{
+    auto *storage = AppContext::get<StorageManager>();
+    if (!storage)
+    {
+        return false;
+    }
+
+    if (!sizeKnown_)
+    {
+        fileSize_ = storage->exists(path_) ? storage->getFileSize(path_) : 0;
+        sizeKnown_ = true;
+    }
+    if (maxFileSize_ && fileSize_ > 0 && fileSize_ + len > maxFileSize_)
+    {
+        rotate();
+        fileSize_ = 0;
+    }
+
+    if (!storage->appendToFile(path_, reinterpret_cast<const uint8_t *>(data), len))
+    {
+        return false;
+    }
+    fileSize_ += len;
+    return true;
+}
+
+/// @copydoc LogSink::rotate
+void LogSink::rotate()
+{
+    auto *storage = AppContext::get<StorageManager>();
+    if (maxFiles_ == 0)
+    {
+        storage->remove(path_);
+        return;
+    }
+
+    std::string oldest = path_ + "." + std::to_string(maxFiles_);
+    if (storage->exists(oldest))
+    {
+        storage->remove(oldest);
+    }
+    for (int i = maxFiles_ - 1; i >= 1; --i)
+    {
+        std::string from = path_ + "." + std::to_string(i);
+        if (storage->exists(from))
+        {
+            storage->rename(from, path_ + "." + std::to_string(i + 1));
+        }
+    }
+    storage->rename(path_, path_ + ".1");
+}
+
+/// @copydoc LogSink::startWriter
+bool LogSink::startWriter()
+{
+    taskENTER_CRITICAL();
+    if (flushLock_ == nullptr)
+    {
+        flushLock_ = xSemaphoreCreateMutexStatic(&flushLockBuffer_);
+    }
+    taskEXIT_CRITICAL();
+
+    xSemaphoreTake(flushLock_, portMAX_DELAY);
+    if (!staging_)
+    {
+        staging_ = static_cast<char *>(pvPortMalloc(LOG_SINK_FLUSH_BYTES));
+    }
+    if (staging_ && !writer_ &&
+        xTaskCreate(writerTask, "LogWriter", LOG_WRITER_STACK_SIZE, nullptr, LOG_WRITER_PRIORITY, &writer_) != pdPASS)
+    {
+        writer_ = nullptr;
+    }
+    bool ok = writer_ != nullptr;
+    xSemaphoreGive(flushLock_);
+    return ok;
+}
+
+/// @copydoc LogSink::writerTask
+void LogSink::writerTask(void *)
+{
+    LogSink *sinks[LOG_SINK_MAX_SINKS];
+    for (;;)
+    {
+        // Woken early when a sink has a block's worth buffered, otherwise flush on the interval
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(LOG_SINK_FLUSH_INTERVAL_MS));
+
+        // Sinks are only ever added, so a snapshot taken under the lock stays valid
+        xSemaphoreTake(flushLock_, portMAX_DELAY);
+        size_t count = sinkCount_;
+        memcpy(sinks, sinks_, count * sizeof(sinks[0]));
+        xSemaphoreGive(flushLock_);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (sinks[i]->buffered())
+            {
+                sinks[i]->flush();
+            }
+        }
+    }
+}
@@ -4,10 +4,10 @@
  * @brief Implementation of Logger for structured logging to stdout and optionally SD.
  *
  * Supports logging with timestamps and severity levels (INFO, WARN, ERROR),
- * and can write logs to an SD card file via FatFsStorageManager.
+ * and can write logs to a file through a buffered LogSink.
  *
- * @version 0.2
- * @date 2025-03-31
+ * @version 0.3
+ * @date 2025-04-22
  * @license MIT License
  * @copyright Copyright (c) 2025, Ian Archbell
  */
@@ -44,10 +44,18 @@ void Logger::setMinLogLevel(LogLevel level)
 }
 
 /// @copydoc Logger::enableFileLogging
-void Logger::enableFileLogging(const std::string &path)
+void Logger::enableFileLogging(const std::string &path, size_t maxFileSize, uint8_t maxFiles)
 {
     logPath = path;
-    logToFile = !logPath.empty();
+    logToFile = !logPath.empty() && sink.open(logPath, maxFileSize, maxFiles);
+}
+
+/// @copydoc Logger::flush
+void Logger::flush()
+{
+    if (logToFile) {
+        sink.flush();
+    }
 }
 
 /// @copydoc Logger::log
@@ -63,16 +71,14 @@ void Logger::log(LogLevel level, const char *msg)
     // Output to stdout
     printf("[%s] [%s] %s\n", timeBuf, levelStr, msg);
 
-    // Optionally append to log file
+    // Optionally buffer for the log file; the LogSink writer task appends it
     if (logToFile) {
-        auto* storage = AppContext::get<StorageManager>();
-        if (storage) {
-            char fullMsg[256];
-            snprintf(fullMsg, sizeof(fullMsg), "[%s] [%s] %s\n", timeBuf, levelStr, msg);
-            storage->appendToFile(logPath, reinterpret_cast<const uint8_t*>(fullMsg), strlen(fullMsg));
+        char fullMsg[256];
+        int n = snprintf(fullMsg, sizeof(fullMsg), "[%s] [%s] %s\n", timeBuf, levelStr, msg);
+        if (n > 0) {
+            sink.write(fullMsg, n < (int)sizeof(fullMsg) ? n : sizeof(fullMsg) - 1);
         }
     }
-    
 }
 
 /// @copydoc Logger::getTimeString
@@ -101,6 +107,7 @@ const char *Logger::levelToString(LogLevel level)
 
 bool Logger::forEachLine(const std::function<void(const char* line)>& handler) {
     if (logPath.empty()) return false;
+    flush(); // include lines still in the buffer
 
     auto* storage = AppContext::get<StorageManager>();
     auto reader = storage->openReader(logPath);
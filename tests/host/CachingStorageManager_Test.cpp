@@ -0,0 +1,128 @@
+#include "CppUTest/TestHarness.h"
+
+#include "mocks/mem_redefines.h"  // Must follow TestHarness.h so its new macro doesn't break std headers
+
+#include "storage/CachingStorageManager.h"
+#include "storage/RamStorageManager.h"
+#include <string>
+#include <vector>
+
+TEST_GROUP(CachingStorageManager)
+{
+    RamStorageManager *flash = nullptr;
+    CachingStorageManager *cache = nullptr;
+
+    void setup() {
+        flash = new RamStorageManager(64 * 1024);
+        cache = new CachingStorageManager(flash, 2048);
+    }
+    void teardown() {
+        delete cache;
+        delete flash;
+    }
+
+    static std::string read(StorageManager *storage, const std::string &path) {
+        std::vector<uint8_t> data;
+        if (!storage->readFile(path, data))
+            return "<missing>";
+        return std::string(data.begin(), data.end());
+    }
+
+    static bool append(StorageManager *storage, const std::string &path, const std::string &text) {
+        return storage->appendToFile(path, reinterpret_cast<const uint8_t *>(text.data()), text.size());
+    }
+};
+
+TEST(CachingStorageManager, AppendsAreHeldUntilFlush)
+{
+    CHECK_TRUE(append(flash, "/log.txt", "old\n"));
+    for (int i = 0; i < 10; ++i)
+        CHECK_TRUE(append(cache, "/log.txt", "line\n"));
+
+    STRCMP_EQUAL("old\n", read(flash, "/log.txt").c_str());
+    UNSIGNED_LONGS_EQUAL(54, cache->getFileSize("/log.txt"));
+
+    CHECK_TRUE(cache->flush());
+    UNSIGNED_LONGS_EQUAL(54, flash->getFileSize("/log.txt"));
+    UNSIGNED_LONGS_EQUAL(1, cache->stats().writeBacks);
+    UNSIGNED_LONGS_EQUAL(0, cache->stats().dirty);
+}
+
+TEST(CachingStorageManager, ReadsAreServedFromRam)
+{
+    CHECK_TRUE(append(flash, "/index.html", "<html></html>"));
+    STRCMP_EQUAL("<html></html>", read(cache, "/index.html").c_str());
+    STRCMP_EQUAL("<html></html>", read(cache, "/index.html").c_str());
+
+    CachingStorageManager::Stats st = cache->stats();
+    UNSIGNED_LONGS_EQUAL(1, st.misses);
+    UNSIGNED_LONGS_EQUAL(1, st.hits);
+}
+
+TEST(CachingStorageManager, WriteThroughAndBypass)
+{
+    CHECK_TRUE(flash->createDirectory("/cfg"));
+    CHECK_TRUE(flash->createDirectory("/upload"));
+    cache->setPolicy("/cfg", CachingStorageManager::Policy::WriteThrough);
+    cache->setPolicy("/upload", CachingStorageManager::Policy::Bypass);
+
+    std::vector<uint8_t> doc = {'{', '}'};
+    CHECK_TRUE(cache->writeFile("/cfg/app.json", doc));
+    STRCMP_EQUAL("{}", read(flash, "/cfg/app.json").c_str());
+
+    CHECK_TRUE(append(cache, "/upload/a.bin", "xyz"));
+    STRCMP_EQUAL("xyz", read(flash, "/upload/a.bin").c_str());
+    UNSIGNED_LONGS_EQUAL(0, cache->stats().dirty);
+}
+
+TEST(CachingStorageManager, EvictionWritesBackDirtyData)
+{
+    std::string block(900, 'a');
+    CHECK_TRUE(cache->writeFile("/a", reinterpret_cast<const unsigned char *>(block.data()), block.size()));
+    CHECK_TRUE(cache->writeFile("/b", reinterpret_cast<const unsigned char *>(block.data()), block.size()));
+    CHECK_FALSE(flash->exists("/a"));
+
+    // A third file does not fit in 2048 bytes, so the oldest goes to the backing storage
+    CHECK_TRUE(cache->writeFile("/c", reinterpret_cast<const unsigned char *>(block.data()), block.size()));
+    CHECK_TRUE(flash->exists("/a"));
+    UNSIGNED_LONGS_EQUAL(1, cache->stats().evictions);
+    STRCMP_EQUAL(block.c_str(), read(cache, "/a").c_str());
+}
+
+TEST(CachingStorageManager, RenameAndListSeeCachedFiles)
+{
+    CHECK_TRUE(flash->createDirectory("/d"));
+    CHECK_TRUE(append(cache, "/d/x.txt", "x"));
+
+    std::vector<FileInfo> entries;
+    CHECK_TRUE(cache->listDirectory("/d", entries));
+    UNSIGNED_LONGS_EQUAL(1, entries.size());
+
+    CHECK_TRUE(cache->rename("/d/x.txt", "/d/y.txt"));
+    STRCMP_EQUAL("x", read(flash, "/d/y.txt").c_str());
+    CHECK_FALSE(cache->exists("/d/x.txt"));
+}
+
+TEST(CachingStorageManager, WritesThatCanNeverLandAreRefusedOrDiscarded)
+{
+    std::string block(900, 'a');
+    const auto *bytes = reinterpret_cast<const unsigned char *>(block.data());
+    CHECK_FALSE(cache->writeFile("/nodir/cfg.json", bytes, 10));
+    CHECK_FALSE(append(cache, "/nodir/log.txt", "x"));
+
+    CHECK_TRUE(flash->createDirectory("/d"));
+    CHECK_TRUE(cache->writeFile("/d/a", bytes, block.size()));
+    CHECK_TRUE(flash->removeDirectory("/d")); // behind the cache's back
+
+    // Eviction passes over the stuck entry instead of giving up
+    CHECK_TRUE(cache->writeFile("/b", bytes, block.size()));
+    CHECK_TRUE(cache->writeFile("/c", bytes, block.size()));
+    CHECK_TRUE(flash->exists("/b"));
+    UNSIGNED_LONGS_EQUAL(1, cache->stats().evictions);
+
+    for (int i = 0; i < STORAGE_CACHE_WRITE_BACK_RETRIES; ++i)
+        cache->flush();
+    UNSIGNED_LONGS_EQUAL(1, cache->stats().discarded);
+    CHECK_TRUE(cache->flush());
+    UNSIGNED_LONGS_EQUAL(0, cache->stats().dirty);
+}
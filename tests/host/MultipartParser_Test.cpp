@@ -0,0 +1,276 @@
+#include "CppUTest/TestHarness.h"
+
+#include "mocks/mem_redefines.h"  // Must follow TestHarness.h so its new macro doesn't break std headers
+
+#include "http/MultipartParser.h"
+#include "framework/AppContext.h"
+#include "storage/RamStorageManager.h"
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#define BOUNDARY "----PicoBoundary7MA4YWxk"
+
+// Create the AppContext entry before any test runs, so CppUTest doesn't count it as a leak
+static const bool storageRegistered = (AppContext::getInstance().registerService<StorageManager>(nullptr), true);
+
+TEST_GROUP(MultipartParser)
+{
+    RamStorageManager *storage = nullptr;
+    MultipartParser *parser = nullptr;
+
+    void setup() {
+        reset();
+    }
+    void teardown() {
+        delete parser;
+        delete storage;
+        AppContext::getInstance().registerService<StorageManager>(nullptr);
+    }
+
+    /// Fresh storage and parser, so the same body can be uploaded again
+    void reset() {
+        delete parser;
+        delete storage;
+        storage = new RamStorageManager(64 * 1024);
+        AppContext::getInstance().registerService<StorageManager>(storage);
+        parser = new MultipartParser();
+        CHECK_TRUE(parser->begin("multipart/form-data; boundary=" BOUNDARY));
+    }
+
+    /// Feed the body @p piece bytes at a time, as if each were one read from the socket
+    bool feed(const std::string &body, size_t piece) {
+        for (size_t i = 0; i < body.size(); i += piece)
+            if (!parser->feed(body.data() + i, std::min(piece, body.size() - i)))
+                return false;
+        return true;
+    }
+
+    std::string read(const std::string &path) {
+        std::vector<uint8_t> data;
+        if (!storage->readFile(path, data))
+            return "<missing>";
+        return std::string(data.begin(), data.end());
+    }
+
+    static std::string filePart(const std::string &filename, const std::string &content) {
+        return "--" BOUNDARY "\r\n"
+               "Content-Disposition: form-data; name=\"file\"; filename=\"" + filename + "\"\r\n"
+               "Content-Type: application/octet-stream\r\n"
+               "\r\n" + content + "\r\n";
+    }
+
+    static std::string fieldPart(const std::string &name, const std::string &value) {
+        return "--" BOUNDARY "\r\n"
+               "Content-Disposition: form-data; name=\"" + name + "\"\r\n"
+               "\r\n" + value + "\r\n";
+    }
+
+    static std::string closing() {
+        return "--" BOUNDARY "--\r\n";
+    }
+
+    /// Content full of near misses: CRLFs, dashes and growing prefixes of the delimiter
+    static std::string awkwardContent(size_t size) {
+        const std::string delimiter = "\r\n--" BOUNDARY;
+        std::string s;
+        for (size_t n = 1; s.size() < size; n = n % (delimiter.size() - 1) + 1)
+            s += delimiter.substr(0, n) + "x" + std::to_string(s.size()) + "-\r";
+        s.resize(size);
+        return s;
+    }
+};
+
+TEST(MultipartParser, ReadsFileFedInSmallPieces)
+{
+    const std::string content = awkwardContent(500);
+    const std::string body = "preamble\r\n" + filePart("a.bin", content) + closing() + "epilogue";
+
+    for (size_t piece : {1, 2, 3, 7, 64, 1000})
+    {
+        reset();
+        CHECK_TRUE(feed(body, piece));
+        CHECK_TRUE(parser->isComplete());
+        UNSIGNED_LONGS_EQUAL(1, parser->getFiles().size());
+        STRCMP_EQUAL("/uploads/a.bin", parser->getFiles()[0].c_str());
+        CHECK_TRUE(read("/uploads/a.bin") == content);
+    }
+}
+
+TEST(MultipartParser, FindsDelimiterSplitAcrossReads)
+{
+    const std::string content = "hello world";
+    const std::string body = filePart("a.txt", content) + closing();
+
+    // Split at every offset from inside the content to past the closing delimiter
+    const size_t from = body.find(content);
+    for (size_t split = from; split <= body.size(); ++split)
+    {
+        reset();
+        CHECK_TRUE(parser->feed(body.data(), split));
+        CHECK_TRUE(parser->feed(body.data() + split, body.size() - split));
+        CHECK_TRUE(parser->isComplete());
+        STRCMP_EQUAL("hello world", read("/uploads/a.txt").c_str());
+    }
+}
+
+TEST(MultipartParser, CompactKeepsScanPosition)
+{
+    // Several windows' worth of content, so compact() runs with partial delimiters pending
+    const std::string content = awkwardContent(4 * HTTP_BUFFER_SIZE + 123);
+    const std::string body = filePart("big.bin", content) + fieldPart("after", "tail") + closing();
+
+    const size_t pieces[] = {1, 5, 97, 999, HTTP_BUFFER_SIZE, HTTP_BUFFER_SIZE + 1};
+    for (size_t piece : pieces)
+    {
+        reset();
+        CHECK_TRUE(feed(body, piece));
+        CHECK_TRUE(parser->isComplete());
+        UNSIGNED_LONGS_EQUAL(content.size(), storage->getFileSize("/uploads/big.bin"));
+        CHECK_TRUE(read("/uploads/big.bin") == content);
+        STRCMP_EQUAL("tail", parser->getFields().at("after").c_str());
+    }
+}
+
+TEST(MultipartParser, SkipsTransportPaddingAfterDelimiter)
+{
+    const std::string body = "--" BOUNDARY " \t \r\n"
+                             "Content-Disposition: form-data; name=\"a\"\r\n"
+                             "\r\n"
+                             "one\r\n"
+                             "--" BOUNDARY "\t\r\n"
+                             "Content-Disposition: form-data; name=\"b\"\r\n"
+                             "\r\n"
+                             "two\r\n"
+                             "--" BOUNDARY "--\r\n";
+
+    for (size_t piece : {1, 2, 1000})
+    {
+        reset();
+        CHECK_TRUE(feed(body, piece));
+        CHECK_TRUE(parser->isComplete());
+        STRCMP_EQUAL("one", parser->getFields().at("a").c_str());
+        STRCMP_EQUAL("two", parser->getFields().at("b").c_str());
+    }
+}
+
+TEST(MultipartParser, RejectsMalformedDelimiterLine)
+{
+    const std::string body = "--" BOUNDARY "x\r\n"
+                             "Content-Disposition: form-data; name=\"a\"\r\n"
+                             "\r\n"
+                             "one\r\n" +
+                             closing();
+
+    CHECK_FALSE(feed(body, 3));
+    CHECK_FALSE(parser->isComplete());
+}
+
+TEST(MultipartParser, PartWithNoHeadersIsRejectedNotMisread)
+{
+    // The blank line ending the (empty) header block directly follows the delimiter line
+    const std::string body = fieldPart("first", "1") +
+                             "--" BOUNDARY "\r\n"
+                             "\r\n"
+                             "no headers\r\n" +
+                             closing();
+
+    for (size_t piece : {1, 4, 1000})
+    {
+        reset();
+        CHECK_FALSE(feed(body, piece));
+        CHECK_FALSE(parser->isComplete());
+        STRCMP_EQUAL("1", parser->getFields().at("first").c_str());
+        UNSIGNED_LONGS_EQUAL(0, parser->getFiles().size());
+    }
+}
+
+TEST(MultipartParser, ReadsSeveralFilesAndFields)
+{
+    const std::string first = awkwardContent(3000);
+    const std::string second = "second file";
+    const std::string longValue(MULTIPART_MAX_FIELD_SIZE + 50, 'v');
+    const std::string body = fieldPart("title", "Holiday") +
+                             filePart("one.bin", first) +
+                             fieldPart("empty", "") +
+                             filePart("dir/two.txt", second) +
+                             fieldPart("long", longValue) +
+                             "--" BOUNDARY "\r\n"
+                             "Content-Disposition: form-data; name=\"none\"; filename=\"\"\r\n"
+                             "\r\n"
+                             "\r\n" +
+                             closing();
+
+    for (size_t piece : {1, 13, 512, 100000})
+    {
+        reset();
+        CHECK_TRUE(feed(body, piece));
+        CHECK_TRUE(parser->isComplete());
+
+        const std::vector<std::string> &files = parser->getFiles();
+        UNSIGNED_LONGS_EQUAL(2, files.size());
+        STRCMP_EQUAL("/uploads/one.bin", files[0].c_str());
+        STRCMP_EQUAL("/uploads/two.txt", files[1].c_str());
+        CHECK_TRUE(read("/uploads/one.bin") == first);
+        STRCMP_EQUAL("second file", read("/uploads/two.txt").c_str());
+
+        const auto &fields = parser->getFields();
+        UNSIGNED_LONGS_EQUAL(4, fields.size());
+        STRCMP_EQUAL("Holiday", fields.at("title").c_str());
+        STRCMP_EQUAL("", fields.at("empty").c_str());
+        STRCMP_EQUAL("", fields.at("none").c_str());
+        UNSIGNED_LONGS_EQUAL(MULTIPART_MAX_FIELD_SIZE, fields.at("long").size());
+    }
+}
+
+TEST(MultipartParser, RejectsDuplicateFilename)
+{
+    const std::string body = filePart("same.txt", "a") + filePart("same.txt", "b") + closing();
+
+    CHECK_FALSE(feed(body, 5));
+    CHECK_FALSE(parser->isComplete());
+    UNSIGNED_LONGS_EQUAL(1, parser->getFiles().size());
+    STRCMP_EQUAL("a", read("/uploads/same.txt").c_str());
+}
+
+TEST(MultipartParser, LongHeadersAreCompactedIntoWindow)
+{
+    // The first part leaves the headers starting late in the window, so they only fit once it is compacted
+    const std::string first = awkwardContent(900);
+    const std::string padding(HTTP_BUFFER_SIZE - 200, 'p');
+    const std::string body = filePart("first.bin", first) +
+                             "--" BOUNDARY "\r\n"
+                             "Content-Disposition: form-data; name=\"file\"; filename=\"h.txt\"\r\n"
+                             "X-Padding: " + padding + "\r\n"
+                             "\r\n"
+                             "data\r\n" +
+                             closing();
+
+    for (size_t piece : {1, 7, 600, 100000})
+    {
+        reset();
+        CHECK_TRUE(feed(body, piece));
+        CHECK_TRUE(parser->isComplete());
+        CHECK_TRUE(read("/uploads/first.bin") == first);
+        STRCMP_EQUAL("data", read("/uploads/h.txt").c_str());
+    }
+}
+
+TEST(MultipartParser, RejectsHeadersLargerThanWindow)
+{
+    const std::string padding(HTTP_BUFFER_SIZE + 200, 'p');
+    const std::string body = "--" BOUNDARY "\r\n"
+                             "Content-Disposition: form-data; name=\"file\"; filename=\"h.txt\"\r\n"
+                             "X-Padding: " + padding + "\r\n"
+                             "\r\n"
+                             "data\r\n" +
+                             closing();
+
+    for (size_t piece : {1, 64, 100000})
+    {
+        reset();
+        CHECK_FALSE(feed(body, piece));
+        CHECK_FALSE(parser->isComplete());
+        CHECK_FALSE(storage->exists("/uploads/h.txt"));
+    }
+}
@@ -0,0 +1,176 @@
+#include "CppUTest/TestHarness.h"
+
+#include "mocks/mem_redefines.h"  // Must follow TestHarness.h so its new macro doesn't break std headers
+
+#include "storage/RamStorageManager.h"
+#include <string>
+#include <vector>
+
+TEST_GROUP(RamStorageManager)
+{
+    RamStorageManager *storage = nullptr;
+
+    void setup() {
+        storage = new RamStorageManager(4096);
+    }
+    void teardown() {
+        delete storage;
+    }
+
+    std::string read(const std::string &path) {
+        std::vector<uint8_t> data;
+        if (!storage->readFile(path, data))
+            return "<missing>";
+        return std::string(data.begin(), data.end());
+    }
+
+    bool write(const std::string &path, const std::string &text) {
+        return storage->writeFile(path, reinterpret_cast<const unsigned char *>(text.data()), text.size());
+    }
+};
+
+TEST(RamStorageManager, WriteReadAndAppend)
+{
+    CHECK_TRUE(write("/a.txt", "hello"));
+    CHECK_TRUE(storage->appendToFile("/a.txt", reinterpret_cast<const uint8_t *>(" world"), 6));
+    STRCMP_EQUAL("hello world", read("a.txt").c_str());
+    UNSIGNED_LONGS_EQUAL(11, storage->getFileSize("/a.txt"));
+
+    std::string part;
+    CHECK_TRUE(storage->readFileString("/a.txt", 6, 100, part));
+    STRCMP_EQUAL("world", part.c_str());
+}
+
+TEST(RamStorageManager, ParentDirectoryMustExist)
+{
+    CHECK_FALSE(write("/logs/today.log", "x"));
+    CHECK_TRUE(storage->createDirectory("/logs/old"));
+    CHECK_TRUE(write("/logs/today.log", "x"));
+
+    std::vector<FileInfo> entries;
+    CHECK_TRUE(storage->listDirectory("/logs", entries));
+    UNSIGNED_LONGS_EQUAL(2, entries.size());
+    STRCMP_EQUAL("old", entries[0].name.c_str());
+    CHECK_TRUE(entries[0].isDirectory);
+    STRCMP_EQUAL("today.log", entries[1].name.c_str());
+
+    CHECK_FALSE(storage->removeDirectory("/logs"));
+    CHECK_TRUE(storage->remove("/logs/today.log"));
+    CHECK_TRUE(storage->removeDirectory("/logs/old"));
+    CHECK_TRUE(storage->removeDirectory("/logs"));
+    CHECK_FALSE(storage->exists("/logs"));
+}
+
+TEST(RamStorageManager, RenameMovesDirectoryContents)
+{
+    CHECK_TRUE(storage->createDirectory("/tmp"));
+    CHECK_TRUE(write("/tmp/upload.bin", "data"));
+    CHECK_TRUE(write("/tmp2", "file in the way"));
+
+    CHECK_FALSE(storage->rename("/tmp", "/tmp2")); // directory over a file
+    CHECK_TRUE(storage->rename("/tmp", "/www"));
+    STRCMP_EQUAL("data", read("/www/upload.bin").c_str());
+    CHECK_FALSE(storage->exists("/tmp/upload.bin"));
+
+    // Siblings that sort between "/a" and "/a/x" must not cut the move short
+    CHECK_TRUE(storage->createDirectory("/a"));
+    CHECK_TRUE(write("/a/x", "child"));
+    CHECK_TRUE(write("/a.txt", "sibling"));
+    CHECK_TRUE(write("/a-b", "sibling"));
+    CHECK_TRUE(storage->rename("/a", "/b"));
+    STRCMP_EQUAL("child", read("/b/x").c_str());
+    CHECK_FALSE(storage->exists("/a/x"));
+    CHECK_FALSE(storage->exists("/a"));
+    STRCMP_EQUAL("sibling", read("/a.txt").c_str());
+    STRCMP_EQUAL("sibling", read("/a-b").c_str());
+}
+
+TEST(RamStorageManager, BudgetIsEnforced)
+{
+    std::string big(4000, 'x');
+    CHECK_TRUE(write("/big", big));
+    size_t used = storage->bytesUsed();
+    CHECK_FALSE(write("/more", std::string(200, 'y')));
+    UNSIGNED_LONGS_EQUAL(used, storage->bytesUsed());
+
+    CHECK_TRUE(storage->remove("/big"));
+    UNSIGNED_LONGS_EQUAL(0, storage->bytesUsed());
+    CHECK_TRUE(write("/more", std::string(200, 'y')));
+}
+
+TEST(RamStorageManager, ReaderKeepsSnapshot)
+{
+    CHECK_TRUE(write("/log.txt", "line one\nline two\n"));
+    auto reader = storage->openReader("/log.txt");
+    CHECK_TRUE(reader != nullptr);
+
+    CHECK_TRUE(write("/log.txt", "replaced"));
+
+    char line[32];
+    CHECK_TRUE(reader->readLine(line, sizeof(line)));
+    STRCMP_EQUAL("line one", line);
+    CHECK_TRUE(reader->readLine(line, sizeof(line)));
+    STRCMP_EQUAL("line two", line);
+    CHECK_FALSE(reader->readLine(line, sizeof(line)));
+    STRCMP_EQUAL("replaced", read("/log.txt").c_str());
+}
+
+TEST(RamStorageManager, WriterAndStream)
+{
+    auto writer = storage->openWriter("/out.bin");
+    CHECK_TRUE(writer != nullptr);
+    std::string chunk(1000, 'z');
+    for (int i = 0; i < 3; ++i)
+        CHECK_TRUE(writer->write(reinterpret_cast<const uint8_t *>(chunk.data()), chunk.size()));
+    writer->close();
+
+    size_t streamed = 0;
+    CHECK_TRUE(storage->streamFile("/out.bin", [&](const uint8_t *, size_t n) { streamed += n; }));
+    UNSIGNED_LONGS_EQUAL(3000, streamed);
+}
+
+TEST(RamStorageManager, DirectoryEntriesArePaged)
+{
+    CHECK_TRUE(storage->createDirectory("/d"));
+    for (char c = 'a'; c <= 'e'; ++c)
+        CHECK_TRUE(write(std::string("/d/") + c, "x"));
+    CHECK_TRUE(storage->createDirectory("/d/f"));
+    CHECK_TRUE(write("/d/f/nested", "x"));
+
+    std::string names;
+    CHECK_TRUE(storage->forEachDirectoryEntry("/d", 2, 3, [&](const FileInfo &entry) {
+        names += entry.name;
+        return true;
+    }));
+    STRCMP_EQUAL("cde", names.c_str());
+
+    names.clear();
+    CHECK_TRUE(storage->forEachDirectoryEntry("/d", 4, 0, [&](const FileInfo &entry) {
+        names += entry.name;
+        return true;
+    }));
+    STRCMP_EQUAL("ef", names.c_str());
+
+    // Follow the returned cursor page by page
+    names.clear();
+    uint32_t cursor = 0;
+    int pages = 0;
+    do
+    {
+        uint32_t next = 0;
+        CHECK_TRUE(storage->forEachDirectoryEntry("/d", cursor, 4, [&](const FileInfo &entry) {
+            names += entry.name;
+            return true;
+        }, &next));
+        cursor = next;
+    } while (++pages < 2);
+    STRCMP_EQUAL("abcdef", names.c_str());
+
+    // An entry the visitor refuses is not consumed
+    uint32_t next = 0;
+    CHECK_TRUE(storage->forEachDirectoryEntry("/d", 1, 0, [&](const FileInfo &entry) {
+        return entry.name != "c";
+    }, &next));
+    LONGS_EQUAL(2, next);
+    CHECK_FALSE(storage->forEachDirectoryEntry("/missing", 0, 0, [](const FileInfo &) { return true; }));
+}
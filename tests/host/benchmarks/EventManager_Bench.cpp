@@ -0,0 +1,130 @@
+/**
+ * @file EventManager_Bench.cpp
+ * @brief Host benchmark of event dispatch cost versus subscriber count.
+ *
+ * Compares the previous EventManager dispatch (lock + scan of every subscriber's mask,
+ * done once for the queue and again for the notification) with the per-code
+ * EventDispatchTable now used by EventManager. Each subscriber listens to four of the
+ * 32 codes, so most subscribers are not interested in any given post.
+ */
+
+#include "events/EventDispatchTable.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+/// Stand-in for a FrameworkController: counts deliveries
+struct Controller
+{
+    uint32_t queued = 0;
+    uint32_t notified = 0;
+};
+
+/// Previous scheme: one vector of (mask, controller), scanned under a lock per delivery kind
+struct LinearDispatch
+{
+    struct Subscriber
+    {
+        uint32_t eventMask;
+        Controller *controller;
+    };
+    std::vector<Subscriber> subscribers;
+    std::mutex lock;
+
+    void subscribe(uint32_t mask, Controller *c) { subscribers.push_back({mask, c}); }
+
+    void post(uint8_t code)
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            for (auto &sub : subscribers)
+            {
+                if (sub.eventMask & (1u << code))
+                    sub.controller->queued++;
+            }
+        }
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            for (auto &sub : subscribers)
+            {
+                if (sub.eventMask & (1u << code))
+                    sub.controller->notified++;
+            }
+        }
+    }
+};
+
+/// New scheme: a single pass over the code's row, no lock on the post path
+struct TableDispatch
+{
+    EventDispatchTable<Controller, 64> table;
+
+    void subscribe(uint32_t mask, Controller *c) { table.add(mask, c); }
+
+    void post(uint8_t code)
+    {
+        table.forEach(code, [](Controller *c) {
+            c->queued++;
+            c->notified++;
+        });
+    }
+};
+
+static uint32_t maskFor(size_t i)
+{
+    // Four codes per subscriber, spread across the 32 codes
+    return (1u << (i % 32)) | (1u << ((i * 7 + 3) % 32)) | (1u << ((i * 13 + 5) % 32)) | (1u << ((i * 5 + 11) % 32));
+}
+
+template <typename Dispatch>
+static double postsPerSecond(size_t subscriberCount, uint64_t &deliveries)
+{
+    Dispatch dispatch;
+    std::vector<Controller> controllers(subscriberCount);
+    for (size_t i = 0; i < subscriberCount; ++i)
+    {
+        dispatch.subscribe(maskFor(i), &controllers[i]);
+    }
+
+    const int posts = 2000000;
+    auto start = Clock::now();
+    for (int i = 0; i < posts; ++i)
+    {
+        dispatch.post(static_cast<uint8_t>(i & 31));
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    deliveries = 0;
+    for (auto &c : controllers)
+    {
+        deliveries += c.queued + c.notified;
+    }
+    return posts / seconds;
+}
+
+int main()
+{
+    const size_t counts[] = {1, 4, 8, 16, 32, 64};
+
+    printf("%12s %18s %18s %8s\n", "subscribers", "linear posts/s", "table posts/s", "speedup");
+    for (size_t n : counts)
+    {
+        uint64_t linearDeliveries = 0;
+        uint64_t tableDeliveries = 0;
+        double linear = postsPerSecond<LinearDispatch>(n, linearDeliveries);
+        double table = postsPerSecond<TableDispatch>(n, tableDeliveries);
+        printf("%12zu %18.0f %18.0f %7.1fx\n", n, linear, table, table / linear);
+
+        if (linearDeliveries != tableDeliveries)
+        {
+            printf("Delivery mismatch: linear %llu, table %llu\n",
+                   static_cast<unsigned long long>(linearDeliveries), static_cast<unsigned long long>(tableDeliveries));
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,344 @@
+/**
+ * @file FatFsStream_Bench.cpp
+ * @brief Host model of SD card transactions for FatFs streaming, bulk writes and appends.
+ *
+ * FreeRTOS+FAT moves whole sectors of a read or write straight between the caller's buffer
+ * and the card in one multi-block command, but a partial sector at either end goes through
+ * its sector cache one sector at a time, and a partial sector written to the cache is read
+ * first. SimFat below follows those rules on a contiguous file over a file-backed block
+ * device, so the transfer patterns of FatFsStorageManager can be compared:
+ *
+ *  - streamFile: HTTP_BUFFER_SIZE (1460) reads vs FATFS_IO_BUFFER_SIZE (4096) aligned reads
+ *  - writer:     1460-byte ff_fwrite calls vs FatFsFileWriter's block coalescing
+ *  - appends:    open/append/close per call vs a held handle closed every FATFS_APPEND_HOLD_MS
+ *
+ * Card time is charged for a class 10 card on a 25 MHz SPI bus: 164 us per sector on the
+ * wire, 250 us command and access latency per read command, 800 us busy after a single-block
+ * write and 1000 us per multi-block write plus 30 us per block. The host MB/s is the real
+ * throughput of the backing file and is only a sanity check.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+static constexpr size_t SectorSize = 512;
+static constexpr double SectorUs = 164;
+static constexpr double ReadCmdUs = 250;
+static constexpr double WriteSingleUs = 800;
+static constexpr double WriteMultiUs = 1000;
+static constexpr double WriteBlockUs = 30;
+
+static constexpr size_t HttpBufferSize = 1460;
+static constexpr size_t IoBufferSize = 4096;
+
+class FileBlockDevice
+{
+public:
+    struct Counters
+    {
+        uint64_t reads = 0;
+        uint64_t writes = 0;
+        uint64_t sectorsRead = 0;
+        uint64_t sectorsWritten = 0;
+        double cardUs = 0;
+        double hostSeconds = 0;
+    };
+
+    FileBlockDevice() : file(tmpfile()) {}
+    ~FileBlockDevice() { fclose(file); }
+
+    void read(uint64_t sector, size_t count, uint8_t *dst)
+    {
+        auto t0 = std::chrono::steady_clock::now();
+        fseek(file, static_cast<long>(sector * SectorSize), SEEK_SET);
+        size_t got = fread(dst, 1, count * SectorSize, file);
+        memset(dst + got, 0, count * SectorSize - got);
+        counters.hostSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        counters.reads++;
+        counters.sectorsRead += count;
+        counters.cardUs += ReadCmdUs + count * SectorUs;
+    }
+
+    void write(uint64_t sector, size_t count, const uint8_t *src)
+    {
+        auto t0 = std::chrono::steady_clock::now();
+        fseek(file, static_cast<long>(sector * SectorSize), SEEK_SET);
+        fwrite(src, 1, count * SectorSize, file);
+        fflush(file);
+        counters.hostSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        counters.writes++;
+        counters.sectorsWritten += count;
+        counters.cardUs += (count == 1 ? WriteSingleUs : WriteMultiUs + count * WriteBlockUs) + count * SectorUs;
+    }
+
+    /// Directory entry update on close (kept apart from the file's sectors)
+    void writeMetadata()
+    {
+        counters.writes++;
+        counters.sectorsWritten++;
+        counters.cardUs += WriteSingleUs + SectorUs;
+    }
+
+    void reset() { counters = Counters(); }
+
+    FILE *file;
+    Counters counters;
+};
+
+/// One contiguous file with FreeRTOS+FAT's whole-sector fast path and a one-sector cache
+class SimFat
+{
+public:
+    explicit SimFat(FileBlockDevice &dev) : dev(dev) {}
+
+    size_t size() const { return fileSize; }
+
+    size_t read(size_t pos, uint8_t *dst, size_t len)
+    {
+        len = std::min(len, fileSize - std::min(pos, fileSize));
+        size_t done = 0;
+        while (done < len)
+        {
+            size_t offset = (pos + done) % SectorSize;
+            uint64_t sector = (pos + done) / SectorSize;
+            size_t whole = offset == 0 ? (len - done) / SectorSize : 0;
+            if (whole > 0)
+            {
+                flushIfCachedIn(sector, whole);
+                dev.read(sector, whole, dst + done);
+                done += whole * SectorSize;
+                continue;
+            }
+            size_t n = std::min(len - done, SectorSize - offset);
+            load(sector);
+            memcpy(dst + done, cache + offset, n);
+            done += n;
+        }
+        return len;
+    }
+
+    size_t write(size_t pos, const uint8_t *src, size_t len)
+    {
+        size_t done = 0;
+        while (done < len)
+        {
+            size_t offset = (pos + done) % SectorSize;
+            uint64_t sector = (pos + done) / SectorSize;
+            size_t whole = offset == 0 ? (len - done) / SectorSize : 0;
+            if (whole > 0)
+            {
+                if (cached >= 0 && static_cast<uint64_t>(cached) >= sector && static_cast<uint64_t>(cached) < sector + whole)
+                {
+                    cached = -1; // overwritten in full
+                    dirty = false;
+                }
+                dev.write(sector, whole, src + done);
+                done += whole * SectorSize;
+                continue;
+            }
+            size_t n = std::min(len - done, SectorSize - offset);
+            load(sector);
+            memcpy(cache + offset, src + done, n);
+            dirty = true;
+            done += n;
+        }
+        fileSize = std::max(fileSize, pos + len);
+        return len;
+    }
+
+    void close()
+    {
+        flush();
+        dev.writeMetadata();
+    }
+
+private:
+    void load(uint64_t sector)
+    {
+        if (cached == static_cast<int64_t>(sector))
+            return;
+        flush();
+        if (sector * SectorSize < fileSize)
+            dev.read(sector, 1, cache);
+        else
+            memset(cache, 0, sizeof(cache));
+        cached = static_cast<int64_t>(sector);
+    }
+
+    void flush()
+    {
+        if (dirty)
+            dev.write(static_cast<uint64_t>(cached), 1, cache);
+        dirty = false;
+    }
+
+    void flushIfCachedIn(uint64_t sector, size_t count)
+    {
+        if (cached >= 0 && static_cast<uint64_t>(cached) >= sector && static_cast<uint64_t>(cached) < sector + count)
+            flush();
+    }
+
+    FileBlockDevice &dev;
+    uint8_t cache[SectorSize];
+    int64_t cached = -1;
+    bool dirty = false;
+    size_t fileSize = 0;
+};
+
+/// FatFsFileWriter's coalescing, over SimFat
+class BlockWriter
+{
+public:
+    BlockWriter(SimFat &fat) : fat(fat), position(fat.size()) {}
+
+    void write(const uint8_t *src, size_t len)
+    {
+        while (len > 0)
+        {
+            size_t limit = IoBufferSize - position % IoBufferSize;
+            if (buffer.empty() && len >= limit)
+            {
+                size_t n = limit + (len - limit) / IoBufferSize * IoBufferSize;
+                fat.write(position, src, n);
+                position += n;
+                src += n;
+                len -= n;
+                continue;
+            }
+            size_t n = std::min(len, limit - buffer.size());
+            buffer.insert(buffer.end(), src, src + n);
+            src += n;
+            len -= n;
+            if (buffer.size() == limit)
+                flush();
+        }
+    }
+
+    void close()
+    {
+        flush();
+        fat.close();
+    }
+
+private:
+    void flush()
+    {
+        fat.write(position, buffer.data(), buffer.size());
+        position += buffer.size();
+        buffer.clear();
+    }
+
+    SimFat &fat;
+    size_t position;
+    std::vector<uint8_t> buffer;
+};
+
+static void report(const char *label, const FileBlockDevice &dev, size_t bytes)
+{
+    printf("  %-34s %6llu reads %6llu writes %7.2f MB/s card  %8.1f MB/s host\n", label,
+           static_cast<unsigned long long>(dev.counters.reads), static_cast<unsigned long long>(dev.counters.writes),
+           bytes / dev.counters.cardUs, dev.counters.hostSeconds > 0 ? bytes / dev.counters.hostSeconds / 1e6 : 0.0);
+}
+
+static bool verify(FileBlockDevice &dev, const std::vector<uint8_t> &expected)
+{
+    std::vector<uint8_t> got((expected.size() + SectorSize - 1) / SectorSize * SectorSize);
+    FileBlockDevice::Counters saved = dev.counters; // checking is not part of the workload
+    dev.read(0, got.size() / SectorSize, got.data());
+    dev.counters = saved;
+    return memcmp(got.data(), expected.data(), expected.size()) == 0;
+}
+
+static void runStream(const std::vector<uint8_t> &data)
+{
+    printf("streamFile, %zu KB:\n", data.size() / 1024);
+    for (size_t chunk : {HttpBufferSize, IoBufferSize})
+    {
+        FileBlockDevice dev;
+        SimFat fat(dev);
+        fat.write(0, data.data(), data.size());
+        fat.close();
+        dev.reset();
+
+        std::vector<uint8_t> buffer(chunk);
+        std::vector<uint8_t> out;
+        for (size_t pos = 0, n; (n = fat.read(pos, buffer.data(), chunk)) > 0; pos += n)
+            out.insert(out.end(), buffer.begin(), buffer.begin() + n);
+
+        char label[64];
+        snprintf(label, sizeof(label), "%zu-byte reads%s", chunk, out == data ? "" : " MISMATCH");
+        report(label, dev, data.size());
+    }
+}
+
+static void runWriter(const std::vector<uint8_t> &data)
+{
+    printf("openWriter, %zu KB in %zu-byte writes:\n", data.size() / 1024, HttpBufferSize);
+    for (bool coalesce : {false, true})
+    {
+        FileBlockDevice dev;
+        SimFat fat(dev);
+        BlockWriter writer(fat);
+        for (size_t pos = 0; pos < data.size(); pos += HttpBufferSize)
+        {
+            size_t n = std::min(HttpBufferSize, data.size() - pos);
+            if (coalesce)
+                writer.write(data.data() + pos, n);
+            else
+                fat.write(pos, data.data() + pos, n);
+        }
+        if (coalesce)
+            writer.close();
+        else
+            fat.close();
+
+        char label[64];
+        snprintf(label, sizeof(label), "%s%s", coalesce ? "4096-byte aligned blocks" : "ff_fwrite per call",
+                 verify(dev, data) ? "" : " MISMATCH");
+        report(label, dev, data.size());
+    }
+}
+
+static void runAppends(const std::vector<uint8_t> &data, size_t record, size_t perHold)
+{
+    printf("appendToFile, %zu records of %zu bytes:\n", data.size() / record, record);
+    for (size_t hold : {size_t(1), perHold})
+    {
+        FileBlockDevice dev;
+        SimFat fat(dev);
+        for (size_t pos = 0, n = 0; pos < data.size(); pos += record, ++n)
+        {
+            fat.write(pos, data.data() + pos, std::min(record, data.size() - pos));
+            if ((n + 1) % hold == 0)
+                fat.close();
+        }
+        fat.close();
+
+        char label[64];
+        if (hold == 1)
+            snprintf(label, sizeof(label), "open/close per append");
+        else
+            snprintf(label, sizeof(label), "held, closed every %zu appends", hold);
+        if (!verify(dev, data))
+            strncat(label, " MISMATCH", sizeof(label) - strlen(label) - 1);
+        report(label, dev, data.size());
+    }
+}
+
+int main()
+{
+    std::mt19937 rng(7);
+    std::vector<uint8_t> data(1024 * 1024);
+    for (auto &b : data)
+        b = static_cast<uint8_t>(rng());
+
+    runStream(data);
+    runWriter(data);
+    runAppends(std::vector<uint8_t>(data.begin(), data.begin() + 200 * 1000), 200, 50);
+    return 0;
+}
@@ -0,0 +1,163 @@
+/**
+ * @file JsonPool_Bench.cpp
+ * @brief Host soak test for the JSON size-class pool and scratch arena.
+ *
+ * Simulates a long-running device: a model document that is repeatedly edited
+ * (records added, patched and removed) alongside short-lived per-request documents
+ * built inside a JsonScratchScope. Pool statistics are printed periodically; the
+ * slab count should stop growing once the working set has been reached.
+ * Build with UNIT_TEST defined so JsonPool uses malloc/free.
+ */
+
+#include "json/JsonPool.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <string>
+
+using Clock = std::chrono::steady_clock;
+
+template <typename Json>
+static Json makeRecord(int id)
+{
+    Json zones = Json::array();
+    for (int z = 0; z < 3; ++z)
+    {
+        zones.push_back({{"zone", "Zone " + std::to_string(z + 1)}, {"duration", 60 * (z + 1)}});
+    }
+    return Json{{"id", std::to_string(id)},
+                {"name", "Program " + std::to_string(id)},
+                {"start", "06:30"},
+                {"days", 62},
+                {"active", (id % 2) == 0},
+                {"zones", zones}};
+}
+
+/// One simulated request: parse a body, build a response from the model, serialize it
+template <typename Json, typename Model>
+static size_t handleRequest(const Model &model, int cycle)
+{
+    Json body = Json::parse("{\"name\":\"Program " + std::to_string(cycle) + "\",\"days\":" + std::to_string(cycle % 127) + "}");
+    Json response = {{"success", true}, {"data", Json::array()}};
+    for (const auto &item : model["items"])
+    {
+        if (response["data"].size() < 4 && (item.value("days", 0) == body.value("days", 0) || item.value("active", false)))
+        {
+            response["data"].push_back(Json(item));
+        }
+    }
+    return response.dump().size();
+}
+
+/// One simulated edit of the persistent model
+template <typename Json>
+static void editModel(Json &model, int cycle)
+{
+    Json &items = model["items"];
+    items.push_back(makeRecord<Json>(1000 + cycle));
+    items[cycle % items.size()]["days"] = cycle % 127;
+    if (items.size() > 40)
+    {
+        items.erase(items.begin() + (cycle % items.size()));
+    }
+}
+
+static void printStats(int cycle)
+{
+    JsonPoolStats stats;
+    JsonPool::getStats(stats);
+    size_t inUse = 0;
+    size_t free = 0;
+    for (size_t i = 0; i < JsonPoolStats::NumClasses; ++i)
+    {
+        inUse += stats.blocksInUse[i];
+        free += stats.blocksFree[i];
+    }
+    printf("  cycle %7d   slabs %4zu (%6zu bytes)   blocks in use %6zu   free %6zu   large %3zu   scratch overflow %zu\n",
+           cycle, stats.slabs, stats.slabBytes, inUse, free, stats.largeAllocs, stats.scratchFallbacks);
+}
+
+int main()
+{
+    const int cycles = 50000;
+    const int reportEvery = 5000;
+
+    printf("Soak: pooled model + scratch requests (%d cycles)\n", cycles);
+    size_t slabsAtFirstReport = 0;
+    size_t checksum = 0;
+    auto start = Clock::now();
+    {
+        PooledJson model = {{"items", PooledJson::array()}};
+        for (int i = 0; i < 20; ++i)
+        {
+            model["items"].push_back(makeRecord<PooledJson>(i));
+        }
+
+        JsonScratch scratch(16 * 1024); // 64-bit host nodes are about twice the size they are on target
+        for (int cycle = 1; cycle <= cycles; ++cycle)
+        {
+            editModel(model, cycle);
+            {
+                JsonScratchScope scope(scratch);
+                checksum += handleRequest<ScratchJson>(model, cycle);
+            }
+            if (cycle % reportEvery == 0)
+            {
+                printStats(cycle);
+                if (cycle == reportEvery)
+                {
+                    JsonPoolStats stats;
+                    JsonPool::getStats(stats);
+                    slabsAtFirstReport = stats.slabs;
+                }
+            }
+        }
+        printf("  scratch high water %zu bytes\n", scratch.highWater());
+    }
+    double pooledMs = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count() / 1000.0;
+
+    JsonPoolStats end;
+    JsonPool::getStats(end);
+    size_t leaked = 0;
+    for (size_t i = 0; i < JsonPoolStats::NumClasses; ++i)
+    {
+        leaked += end.blocksInUse[i];
+    }
+
+    printf("Baseline: nlohmann::json with the default allocator\n");
+    size_t baselineChecksum = 0;
+    start = Clock::now();
+    {
+        nlohmann::json model = {{"items", nlohmann::json::array()}};
+        for (int i = 0; i < 20; ++i)
+        {
+            model["items"].push_back(makeRecord<nlohmann::json>(i));
+        }
+        for (int cycle = 1; cycle <= cycles; ++cycle)
+        {
+            editModel(model, cycle);
+            baselineChecksum += handleRequest<nlohmann::json>(model, cycle);
+        }
+    }
+    double baselineMs = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count() / 1000.0;
+
+    printf("  pooled %.1f ms, default %.1f ms\n", pooledMs, baselineMs);
+    printf("  slabs after first report %zu, at end %zu\n", slabsAtFirstReport, end.slabs);
+
+    if (checksum != baselineChecksum)
+    {
+        printf("Output mismatch between pooled and default documents\n");
+        return 1;
+    }
+    if (leaked != 0 || end.largeAllocs != 0)
+    {
+        printf("Pool blocks still in use after all documents were destroyed: %zu (+%zu large)\n", leaked, end.largeAllocs);
+        return 1;
+    }
+    if (end.slabs > slabsAtFirstReport)
+    {
+        printf("Slab count kept growing after warm-up\n");
+        return 1;
+    }
+    return 0;
+}
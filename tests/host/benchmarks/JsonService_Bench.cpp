@@ -0,0 +1,108 @@
+/**
+ * @file JsonService_Bench.cpp
+ * @brief Host benchmark comparing JsonService storage formats.
+ *
+ * Builds sprinkler-style model documents of increasing size and reports encoded
+ * size plus encode/decode time for pretty text, compact text, CBOR and MessagePack.
+ * Decoding uses the same non-throwing parser calls as JsonService::load().
+ */
+
+#include <nlohmann/json.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using json = nlohmann::json;
+using Clock = std::chrono::steady_clock;
+
+static json makeModel(int records)
+{
+    json items = json::array();
+    for (int i = 0; i < records; ++i)
+    {
+        json zones = json::array();
+        for (int z = 0; z < 3; ++z)
+        {
+            zones.push_back({{"zone", "Zone " + std::to_string(z + 1)}, {"duration", 60 * (z + 1)}});
+        }
+        items.push_back({{"id", std::to_string(i + 1)},
+                         {"name", "Program " + std::to_string(i + 1)},
+                         {"start", "06:30"},
+                         {"days", 62},
+                         {"active", (i % 2) == 0},
+                         {"zones", zones}});
+    }
+    return json{{"items", items}};
+}
+
+template <typename Fn>
+static double timeUs(int iterations, Fn fn)
+{
+    auto start = Clock::now();
+    for (int i = 0; i < iterations; ++i)
+    {
+        fn();
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+    return static_cast<double>(elapsed) / 1000.0 / iterations;
+}
+
+static void report(const char *name, size_t size, double encodeUs, double decodeUs)
+{
+    printf("  %-14s %8zu bytes   encode %9.1f us   decode %9.1f us\n", name, size, encodeUs, decodeUs);
+}
+
+int main()
+{
+    const int sizes[] = {3, 20, 100, 400};
+
+    for (int records : sizes)
+    {
+        json model = makeModel(records);
+        int iterations = records >= 100 ? 50 : 500;
+        printf("Model with %d records (%d iterations)\n", records, iterations);
+
+        std::string pretty;
+        double prettyEnc = timeUs(iterations, [&] { pretty = model.dump(2); });
+        std::vector<uint8_t> prettyBuf(pretty.begin(), pretty.end());
+        double prettyDec = timeUs(iterations, [&] {
+            json j = json::parse(prettyBuf.begin(), prettyBuf.end(), nullptr, false);
+            (void)j;
+        });
+        report("text (indent)", prettyBuf.size(), prettyEnc, prettyDec);
+
+        std::string compact;
+        double compactEnc = timeUs(iterations, [&] { compact = model.dump(); });
+        std::vector<uint8_t> compactBuf(compact.begin(), compact.end());
+        double compactDec = timeUs(iterations, [&] {
+            json j = json::parse(compactBuf.begin(), compactBuf.end(), nullptr, false);
+            (void)j;
+        });
+        report("text", compactBuf.size(), compactEnc, compactDec);
+
+        std::vector<uint8_t> cbor;
+        double cborEnc = timeUs(iterations, [&] { cbor = json::to_cbor(model); });
+        double cborDec = timeUs(iterations, [&] {
+            json j = json::from_cbor(cbor, true, false);
+            (void)j;
+        });
+        report("cbor", cbor.size(), cborEnc, cborDec);
+
+        std::vector<uint8_t> msgpack;
+        double msgpackEnc = timeUs(iterations, [&] { msgpack = json::to_msgpack(model); });
+        double msgpackDec = timeUs(iterations, [&] {
+            json j = json::from_msgpack(msgpack, true, false);
+            (void)j;
+        });
+        report("msgpack", msgpack.size(), msgpackEnc, msgpackDec);
+
+        if (json::from_cbor(cbor, true, false) != model || json::from_msgpack(msgpack, true, false) != model)
+        {
+            printf("Round trip mismatch\n");
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,256 @@
+/**
+ * @file KvStore_Bench.cpp
+ * @brief Host simulation of KvLog flash wear and latency for a settings workload.
+ *
+ * KvLog runs on a simulated NOR part that enforces page-aligned programs, only lets bits go
+ * from 1 to 0, and charges typical W25Q16 timings (0.4 ms page program, 45 ms sector erase).
+ * A skewed stream of setting updates is applied and checked against a std::map, with the
+ * log remounted every so often. Compaction is run "in the background" (between puts, as the
+ * KvStore task does) and its cost is reported apart from the put latency.
+ *
+ * For comparison, a JsonService-style save is modelled as LittleFS rewriting the whole
+ * document: a block erase, its pages and two metadata pages per change.
+ *
+ * A last pass cuts the power in the middle of a page program at many points and checks that
+ * every acknowledged put survives the remount.
+ */
+
+#include "storage/KvLog.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+static constexpr double ProgramMs = 0.4;
+static constexpr double EraseMs = 45.0;
+
+class SimFlash : public KvFlash
+{
+public:
+    explicit SimFlash(size_t bytes) : data(bytes, 0xFF), erases(bytes / SectorSize, 0) {}
+
+    size_t size() const override { return data.size(); }
+
+    bool read(uint32_t offset, void *dst, size_t len) override
+    {
+        if (offset + len > data.size())
+            return false;
+        memcpy(dst, data.data() + offset, len);
+        return true;
+    }
+
+    bool program(uint32_t offset, const void *src, size_t len) override
+    {
+        if (offset % PageSize || len % PageSize || offset + len > data.size())
+        {
+            printf("  unaligned program at 0x%x (%zu bytes)\n", offset, len);
+            violations++;
+            return false;
+        }
+        if (cutAfter >= 0 && programs >= static_cast<uint64_t>(cutAfter))
+        {
+            // Power lost part way through: only some bytes of the page make it
+            const uint8_t *p = static_cast<const uint8_t *>(src);
+            for (size_t i = 0; i < len / 2; ++i)
+                data[offset + i] &= p[i];
+            dead = true;
+            return false;
+        }
+        const uint8_t *p = static_cast<const uint8_t *>(src);
+        for (size_t i = 0; i < len; ++i)
+            data[offset + i] &= p[i]; // NOR: programming can only clear bits
+        programs += len / PageSize;
+        busyMs += ProgramMs * (len / PageSize);
+        return true;
+    }
+
+    bool erase(uint32_t offset) override
+    {
+        if (offset % SectorSize || offset + SectorSize > data.size() || dead)
+            return false;
+        memset(data.data() + offset, 0xFF, SectorSize);
+        erases[offset / SectorSize]++;
+        eraseCount++;
+        busyMs += EraseMs;
+        return true;
+    }
+
+    std::vector<uint8_t> data;
+    std::vector<uint32_t> erases;
+    uint64_t programs = 0;
+    uint64_t eraseCount = 0;
+    double busyMs = 0;
+    int violations = 0;
+    long cutAfter = -1; ///< Fail the program after this many, simulating power loss
+    bool dead = false;
+};
+
+static std::string valueFor(std::mt19937 &rng, const std::string &key)
+{
+    std::uniform_int_distribution<int> len(4, 48);
+    std::string v = key + "=";
+    int n = len(rng);
+    for (int i = 0; i < n; ++i)
+        v.push_back(static_cast<char>(rng() & 0xFF)); // binary values
+    return v;
+}
+
+static bool check(KvLog &log, const std::map<std::string, std::string> &model)
+{
+    if (log.keys().size() != model.size())
+        return false;
+    for (const auto &kv : model)
+    {
+        std::vector<uint8_t> out;
+        if (!log.get(kv.first, out) || std::string(out.begin(), out.end()) != kv.second)
+            return false;
+    }
+    return true;
+}
+
+static void runWorkload(size_t sectors, int keys, int updates)
+{
+    SimFlash flash(sectors * KvFlash::SectorSize);
+    KvLog log(flash);
+    log.mount();
+    double mountMs = flash.busyMs;
+
+    std::mt19937 rng(12345);
+    std::map<std::string, std::string> model;
+    // A few settings change all the time, most rarely (Zipf-like)
+    std::vector<double> weights;
+    for (int k = 0; k < keys; ++k)
+        weights.push_back(1.0 / (k + 1));
+    std::discrete_distribution<int> pick(weights.begin(), weights.end());
+
+    double worstPutMs = 0;
+    double putMs = 0;
+    double backgroundMs = 0;
+    uint64_t putPrograms = 0;
+    uint64_t putErases = 0;
+    size_t docBytes = 0;
+    bool ok = true;
+
+    for (int i = 0; i < updates && ok; ++i)
+    {
+        std::string key = "setting." + std::to_string(pick(rng));
+        double before = flash.busyMs;
+        uint64_t programs = flash.programs;
+        uint64_t erases = flash.eraseCount;
+
+        if (rng() % 20 == 0)
+        {
+            ok = log.remove(key);
+            model.erase(key);
+        }
+        else
+        {
+            std::string v = valueFor(rng, key);
+            ok = log.put(key, v.data(), v.size());
+            model[key] = v;
+        }
+
+        double ms = flash.busyMs - before;
+        putMs += ms;
+        worstPutMs = std::max(worstPutMs, ms);
+        putPrograms += flash.programs - programs;
+        putErases += flash.eraseCount - erases;
+
+        before = flash.busyMs;
+        while (log.needsCompaction() && log.compactStep())
+        {
+        }
+        backgroundMs += flash.busyMs - before;
+
+        if (i % 997 == 0)
+        {
+            ok = ok && log.mount() && check(log, model);
+        }
+
+        docBytes = 2;
+        for (const auto &kv : model)
+            docBytes += kv.first.size() + kv.second.size() * 2 + 6; // text JSON, binary as hex-ish
+    }
+    ok = ok && log.mount() && check(log, model);
+
+    KvLog::Stats st = log.stats();
+    uint32_t minWear = *std::min_element(flash.erases.begin(), flash.erases.end());
+    uint32_t maxWear = *std::max_element(flash.erases.begin(), flash.erases.end());
+
+    size_t docPages = (docBytes + KvFlash::PageSize - 1) / KvFlash::PageSize + 2;
+    double docMs = EraseMs + docPages * ProgramMs;
+
+    printf("%zu sectors, %d keys, %d updates: %s\n", sectors, keys, updates, ok && !flash.violations ? "OK" : "MISMATCH");
+    printf("  KvLog:   %.2f page programs + %.4f erases per update, %.2f ms flash time (worst %.1f ms)\n",
+           double(putPrograms) / updates, double(putErases) / updates, putMs / updates, worstPutMs);
+    printf("           background compaction %.2f ms per update, mount %.1f ms\n", backgroundMs / updates, mountMs);
+    printf("           sector erases min %u max %u, %zu live / %zu dead bytes, %zu free sectors\n",
+           minWear, maxWear, st.liveBytes, st.deadBytes, st.freeSectors);
+    printf("  Rewrite: %zu byte document, ~%zu page programs + 1 erase per update, ~%.1f ms\n",
+           docBytes, docPages, docMs);
+    printf("  Erases per sector per 10k updates: KvLog %.1f, rewrite (spread over the same sectors) %.1f\n",
+           double(maxWear) * 10000 / updates, 10000.0 / sectors);
+}
+
+static void runPowerCuts(int cuts)
+{
+    int failures = 0;
+    for (int cut = 0; cut < cuts; ++cut)
+    {
+        SimFlash flash(6 * KvFlash::SectorSize);
+        KvLog log(flash);
+        log.mount();
+        flash.cutAfter = static_cast<long>(flash.programs) + 1 + cut * 7;
+
+        std::mt19937 rng(cut);
+        std::map<std::string, std::string> acked;
+        std::string pendingKey;
+        std::string pendingValue;
+        for (int i = 0; i < 5000 && !flash.dead; ++i)
+        {
+            std::string key = "k" + std::to_string(rng() % 24);
+            std::string v = valueFor(rng, key);
+            if (log.put(key, v.data(), v.size()))
+            {
+                acked[key] = v;
+            }
+            else
+            {
+                pendingKey = key;
+                pendingValue = v;
+            }
+            while (!flash.dead && log.needsCompaction() && log.compactStep())
+            {
+            }
+        }
+
+        // Power back: the interrupted put may have landed or not, everything acknowledged must be there
+        flash.cutAfter = -1;
+        flash.dead = false;
+        KvLog after(flash);
+        bool ok = after.mount();
+        for (const auto &kv : acked)
+        {
+            std::vector<uint8_t> out;
+            bool found = after.get(kv.first, out);
+            std::string got(out.begin(), out.end());
+            ok = ok && found && (got == kv.second || (kv.first == pendingKey && got == pendingValue));
+        }
+        std::string v = "after";
+        ok = ok && after.put("fresh", v.data(), v.size());
+        failures += !ok;
+    }
+    printf("Power cut at %d points: %d failures\n", cuts, failures);
+}
+
+int main()
+{
+    runWorkload(8, 40, 20000);
+    runWorkload(16, 100, 50000);
+    runPowerCuts(300);
+    return 0;
+}
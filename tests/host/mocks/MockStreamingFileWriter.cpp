@@ -0,0 +1,42 @@
+// Host stand-in for StreamingFileWriter: there is no writer task in the host
+// tests, so each write goes straight to the StorageFileWriter.
+
+#include "storage/StreamingFileWriter.h"
+#include "storage/StorageManager.h"
+
+StreamingFileWriter::StreamingFileWriter() {}
+
+StreamingFileWriter::~StreamingFileWriter() { close(); }
+
+bool StreamingFileWriter::open(StorageManager *storage, const std::string &path, bool append)
+{
+    close();
+    if (!storage)
+        return false;
+    file_ = storage->openWriter(path, append);
+    written_ = 0;
+    failed_ = false;
+    return file_ != nullptr;
+}
+
+bool StreamingFileWriter::write(const void *data, size_t len)
+{
+    if (!file_ || failed_)
+        return false;
+    if (!file_->write(data, len))
+    {
+        failed_ = true;
+        return false;
+    }
+    written_ += len;
+    return true;
+}
+
+bool StreamingFileWriter::close()
+{
+    if (!file_)
+        return true;
+    bool ok = file_->close() && !failed_;
+    file_.reset();
+    return ok;
+}
@@ -0,0 +1,5 @@
+#pragma once
+#include "FreeRTOS.h"
+
+typedef void* QueueHandle_t;
+typedef struct { int dummy; } StaticQueue_t;
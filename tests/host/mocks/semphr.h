@@ -1,2 +1,15 @@
 #pragma once
+#include "FreeRTOS.h"
+
 typedef void* SemaphoreHandle_t;
+typedef struct { int dummy; } StaticSemaphore_t;
+
+#ifndef portMAX_DELAY
+#define portMAX_DELAY 0xFFFFFFFFu
+#endif
+
+// Single-threaded host tests: mutexes always succeed
+inline SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t* buffer) { return buffer; }
+inline SemaphoreHandle_t xSemaphoreCreateMutex() { static StaticSemaphore_t m; return &m; }
+inline int xSemaphoreTake(SemaphoreHandle_t, unsigned) { return pdTRUE; }
+inline int xSemaphoreGive(SemaphoreHandle_t) { return pdTRUE; }
@@ -0,0 +1,178 @@
+#!/usr/bin/env python3
+"""
+Decode PicoFramework deferred trace records (TRACE_DEFERRED=1) back into text.
+
+The device stores the addresses of each trace call's module name and format string
+plus the raw argument values (see framework/include/DeferredTrace.h). This tool reads
+those strings out of the application's ELF file and formats the messages.
+
+Input is either the binary trace file written through the trace LogSink, or a captured
+console log containing the `TRC <hex>` lines printed by traceDumpDeferred(). Rotated
+trace files can be decoded together, oldest first:
+
+    tools/trace_decode.py build/app.elf framework_trace.log.2 framework_trace.log.1 framework_trace.log
+    tools/trace_decode.py build/app.elf console.txt
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+SYNC = 0xA5
+HEADER = struct.Struct("<BBBBIIIH")
+LEVELS = {0: "INFO", 1: "WARN", 2: "ERROR"}
+CONVERSION = re.compile(r"%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d+))?(hh|h|ll|l|z|j|t|L)?([diouxXcsfFeEgGaAp%])")
+
+SHF_ALLOC = 0x2
+SHT_NOBITS = 8
+
+
+class Elf:
+    """Minimal ELF reader: maps allocated, initialised sections so strings can be read by address."""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+        if self.data[:4] != b"\x7fELF":
+            raise ValueError(f"{path} is not an ELF file")
+        is64 = self.data[4] == 2
+        endian = "<" if self.data[5] == 1 else ">"
+        if is64:
+            shoff, = struct.unpack_from(endian + "Q", self.data, 0x28)
+            shentsize, shnum = struct.unpack_from(endian + "HH", self.data, 0x3A)
+            section = struct.Struct(endian + "IIQQQQIIQQ")
+        else:
+            shoff, = struct.unpack_from(endian + "I", self.data, 0x20)
+            shentsize, shnum = struct.unpack_from(endian + "HH", self.data, 0x2E)
+            section = struct.Struct(endian + "IIIIIIIIII")
+
+        self.sections = []
+        for i in range(shnum):
+            _, sh_type, flags, addr, offset, size = section.unpack_from(self.data, shoff + i * shentsize)[:6]
+            if flags & SHF_ALLOC and sh_type != SHT_NOBITS and size:
+                self.sections.append((addr, size, offset))
+
+    def string_at(self, address):
+        for addr, size, offset in self.sections:
+            # Compare on 32 bits: the device records addresses as uint32_t
+            base = addr & 0xFFFFFFFF
+            if base <= address < base + size:
+                start = offset + (address - base)
+                end = self.data.find(b"\0", start, offset + size)
+                return self.data[start:end if end >= 0 else offset + size].decode("utf-8", "replace")
+        return None
+
+
+def records_from_binary(data):
+    """Yield records from a byte stream, resynchronising on the sync byte after damage."""
+    i = 0
+    while i + HEADER.size <= len(data):
+        if data[i] != SYNC or data[i + 1] < HEADER.size or i + data[i + 1] > len(data):
+            i += 1
+            continue
+        length = data[i + 1]
+        yield data[i:i + length]
+        i += length
+
+
+def records_from_text(text):
+    for line in text.splitlines():
+        match = re.search(r"TRC ([0-9a-fA-F]+)\s*$", line)
+        if match:
+            yield bytes.fromhex(match.group(1))
+        elif "TRC dropped" in line:
+            print(line.strip()[line.find("TRC"):])
+
+
+def format_message(fmt, args):
+    """Apply a C format string to the packed argument bytes."""
+    out = []
+    pos = 0
+    offset = 0
+
+    def take(size, code):
+        nonlocal offset
+        if offset + size > len(args):
+            raise IndexError
+        value, = struct.unpack_from("<" + code, args, offset)
+        offset += size
+        return value
+
+    def take_string():
+        nonlocal offset
+        if offset >= len(args):
+            raise IndexError
+        n = args[offset]
+        value = args[offset + 1:offset + 1 + n].decode("utf-8", "replace")
+        offset += 1 + n
+        return value
+
+    for match in CONVERSION.finditer(fmt):
+        out.append(fmt[pos:match.start()])
+        pos = match.end()
+        flags, width, precision, length, conv = match.groups()
+        if conv == "%":
+            out.append("%")
+            continue
+        try:
+            if width == "*":
+                width = str(take(4, "i"))
+            if precision == "*":
+                precision = str(take(4, "i"))
+            spec = "%" + flags + (width or "") + ("." + precision if precision else "")
+            if conv == "s":
+                out.append((spec + "s") % take_string())
+            elif conv in "fFeEgGaA":
+                out.append((spec + ("f" if conv in "aA" else conv)) % take(8, "d"))
+            elif conv == "p":
+                out.append("0x%08x" % take(4, "I"))
+            elif conv == "c":
+                out.append((spec + "c") % chr(take(4, "I") & 0xFF))
+            else:
+                wide = length in ("ll", "j")
+                signed = conv in "di"
+                value = take(8, "q" if signed else "Q") if wide else take(4, "i" if signed else "I")
+                out.append((spec + ("d" if conv in "diu" else conv)) % value)
+        except IndexError:
+            out.append("<missing>")
+    out.append(fmt[pos:])
+    return "".join(out)
+
+
+def decode(elf, record):
+    if len(record) < HEADER.size:
+        return None
+    sync, length, level, flags, module_addr, fmt_addr, timestamp, line = HEADER.unpack_from(record)
+    module = elf.string_at(module_addr) or "0x%08x" % module_addr
+    fmt = elf.string_at(fmt_addr)
+    if fmt is None:
+        message = "<format @0x%08x not in ELF>" % fmt_addr
+    else:
+        message = format_message(fmt, record[HEADER.size:length]).rstrip("\n")
+    if flags & 1:
+        message += " <arguments truncated>"
+    return "%10.6f [%s] [%s] line %d: %s" % (timestamp / 1e6, LEVELS.get(level, "???"), module, line, message)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode deferred PicoFramework traces")
+    parser.add_argument("elf", help="application ELF file the traces were recorded with")
+    parser.add_argument("inputs", nargs="+", help="binary trace files or console captures with TRC lines")
+    args = parser.parse_args()
+
+    elf = Elf(args.elf)
+    for path in args.inputs:
+        with open(path, "rb") as f:
+            data = f.read()
+        looks_textual = b"TRC " in data and data.count(bytes([SYNC])) < data.count(b"TRC ")
+        records = records_from_text(data.decode("utf-8", "replace")) if looks_textual else records_from_binary(data)
+        for record in records:
+            text = decode(elf, record)
+            if text:
+                print(text)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())